@@ -48,4 +48,7 @@
 // which are sometime too long. A policy should be set for this name length.
 #define CM_KEY_MAX_LENGTH 128
 
+// maximum number of values of an ints attribute, such as axes, pads or strides.
+#define CM_ATT_INTS_MAX_COUNT 16
+
 #endif
\ No newline at end of file
@@ -1,18 +1,32 @@
 #ifndef _CM_ACTIVATION_
 #define _CM_ACTIVATION_
 
+#include <atomic>
+
 #include "math/cm_tensor.hpp"
 #include "concurrent/cm_concurrent.hpp"
+#include "cm_profiler.hpp"
 
 namespace CyanMycelium
 {
+#define CM_ACTIVATION_SUCCESS 0
+// the engine queue had no room for a new inference within the admission timeout.
+#define CM_ACTIVATION_REJECTED 100
+// the topology of the model cannot be compiled, see Graph::Compile.
+#define CM_ACTIVATION_INVALID_MODEL 101
+// the shapes of the inputs do not fit the model, see ShapePlan.
+#define CM_ACTIVATION_INVALID_SHAPE 102
+
     // forward declaration
     class Operator;
     class Link;
     class Node;
     class Graph;
+    class GraphTopology;
     class InferenceEngine;
     class ActivationContext;
+    class ShapePlan;
+    class ShapePlanCache;
 
     /// @brief TensorRef is the tensor reference used by the ActivationContext. This is a key element of the inference session.
     class TensorRef
@@ -31,6 +45,7 @@ namespace CyanMycelium
         {
             Count = 0;
             Flags.Value = 0;
+            Base = nullptr;
         }
 
         ~TensorRef()
@@ -38,7 +53,7 @@ namespace CyanMycelium
         }
 
         Tensor Value; // the tensor value
-        int Count;    // the number of links using this tensor
+        int Count;    // the number of links using this tensor, the tensors of the context are freed when it drops to 0
         union
         {
             struct
@@ -49,6 +64,7 @@ namespace CyanMycelium
             } Bits;
             unsigned char Value;
         } Flags;
+        TensorRef *Base; // the tensor this one is a slice of, which the slice keeps alive, see Link::InSlice.
 
         /// @brief Lock the tensor reference. Locking the tensor reference is mandatory to modify the tensor value, flags and the reference count.
         /// @param timeoutMillis the timeout in milliseconds, default is CM_INFINITE
@@ -64,28 +80,17 @@ namespace CyanMycelium
 
     typedef TensorRef *TensorRefPtr;
 
-    /// @brief LinkState is the current state of a link. It holds the tensor reference and the link flags.
-    class LinkState
+    /// @brief LinkFlags are the flags of a link within an ActivationContext.
+    /// A link is either activ or inactiv. Activ link means it ready to be processed by the next Operator.
+    union LinkFlags
     {
-    public:
-        LinkState() : Ref(nullptr)
+        struct
         {
-            Flags.Value = 0;
-        };
-
-        TensorRef *Ref;
-
-        /// @brief the flags of the link.
-        /// A link is either activ or inactiv. Activ link means it ready to be processed by the next Operator.
-        union
-        {
-            struct
-            {
-                unsigned char Activ : 1;    // The link is activ, which mean it hold an input waiting to be processed.
-                unsigned char Reserved : 7; // reserved
-            } Bits;
-            unsigned char Value;
-        } Flags;
+            unsigned char Activ : 1;    // The link is activ, which mean it hold an input waiting to be processed.
+            unsigned char Bound : 1;    // The tensor of the link is a buffer bound by the user.
+            unsigned char Reserved : 6; // reserved
+        } Bits;
+        unsigned char Value;
     };
 
     using HandlerFunction = void (*)(ActivationContext *ctx, void *userData);
@@ -126,11 +131,21 @@ namespace CyanMycelium
             this->_handlers = handlers;
             this->_engine = engine;
             this->_model = model;
+            this->_profiler = nullptr;
+            this->_profile = nullptr;
+            this->_inference = 0;
+            this->_started = 0;
+            this->_ended.store(false, std::memory_order_relaxed);
+            this->_error = CM_ACTIVATION_SUCCESS;
             _buildTensorRefs();
         }
 
         /// @brief Destroy the Activation Context object
-        virtual ~ActivationContext() { _clearTensorRefs(); }
+        virtual ~ActivationContext()
+        {
+            _clearTensorRefs();
+            delete[] this->_profile;
+        }
 
         InferenceEngine *GetEngine() { return _engine; }
 
@@ -138,8 +153,28 @@ namespace CyanMycelium
         // @return the topology
         Graph *GetModel() { return _model; }
 
+        /// @brief Attach a profiler recording the execution of every node, or detach it with null.
+        /// Without profiler, the instrumentation costs a single test per node. The profiler may be shared by several contexts.
+        /// Must not be called while an inference is running.
+        /// @param profiler the profiler, owned by the caller.
+        void SetProfiler(Profiler *profiler);
+
+        Profiler *GetProfiler() { return _profiler; }
+
         void SetInput(const char *name, void *buffer);
 
+        /// @brief Bind a buffer to an input with a symbolic dimension, giving the shape of its value.
+        /// Every Run then uses the plan of the shapes of the inputs, built once per set of shapes and kept by the context.
+        /// @param name the name of the input
+        /// @param buffer the buffer, owned by the caller.
+        /// @param shape the shape of the value, with the size of every dimension.
+        /// @param dimension the number of axes, which is the one declared by the model.
+        void SetInput(const char *name, void *buffer, const uint64_t *shape, int dimension);
+
+        /// @brief Bind a buffer to an output. The operator producing the output writes its result straight into the buffer
+        /// when the size and type match, the result is copied into the buffer otherwise.
+        /// @param name the name of the output
+        /// @param buffer the buffer, owned by the caller.
         void SetOutput(const char *name, void *buffer);
 
         Tensor *GetInput(const char *name);
@@ -148,8 +183,17 @@ namespace CyanMycelium
 
         /// @brief Run the inference with the given input tensors.
         /// The input tensors are supposed to be binded previously with the input links.
-        /// @return true if the operation is successful, false otherwise.
-        bool Run();
+        /// @return true if the operation is successful, false otherwise. GetError tells why.
+        virtual bool Run();
+
+        /// @brief the error of the last Run, CM_ACTIVATION_SUCCESS if none.
+        int GetError() { return _error; }
+
+        /// @brief the plan of the last Run, null if the model has no symbolic dimension.
+        ShapePlan *GetPlan() { return _plan; }
+
+        /// @brief the plans kept by the context, null if the model has no symbolic dimension.
+        ShapePlanCache *GetPlanCache() { return _plans; }
 
         /// @brief Activate the operator. Operator activation means to gather data from input links, then process the data within the operator logic.
         /// Additionally, the operator activation will forward the output tensor to the next operator and deactivate the inputs links.
@@ -168,7 +212,7 @@ namespace CyanMycelium
         /// @return true if the operation is successful, false otherwise.
         virtual bool Deactivate(Operator *);
 
-        /// @brief Deactivate the link.
+        /// @brief Deactivate the link, releasing its tensor.
         /// @param l  the link
         /// @return true if the operation is successful, false otherwise.
         virtual bool Deactivate(Link *);
@@ -176,7 +220,7 @@ namespace CyanMycelium
         /// @brief Get the Payload Ref object
         /// @param id  the id of the link
         /// @return the tensor reference pointer
-        virtual TensorRefPtr GetPayloadRef(int id) { return this->_states[id].Ref; }
+        virtual TensorRefPtr GetPayloadRef(int id);
 
         /// @brief Clone a tensor reference. This is usefull when the tensor need to be shared by multiple mutable node or branches
         /// TensorRef cloning is done with the support of the memory manager for the data copy.
@@ -185,6 +229,42 @@ namespace CyanMycelium
         /// @return the new tensor reference
         virtual TensorRefPtr CloneRef(TensorRef &);
 
+        /// @brief Create a new tensor reference with a freshly allocated buffer. This is used by the operators which produce a result
+        /// with a shape different from their inputs. The buffer is allocated with the support of the memory manager and is NOT initialized.
+        /// The new TensorRef is owned by the ActivationContext and consequently its Flags.Internal is set to 1.
+        /// @param shape the shape as an array of the size of each dimension
+        /// @param dimension the number of axes
+        /// @param type the type of the underlying elements
+        /// @return the new tensor reference, or nullptr if the allocation failed.
+        virtual TensorRefPtr CreateRef(const uint64_t *shape, int dimension, tensor_data_type_t type);
+
+        /// @brief Create the tensor of an operator's result. When the user bound a buffer of the same size and type to one of the
+        /// outgoing links, the result is written straight into it, otherwise this is CreateRef.
+        /// @param op the operator
+        /// @param shape the shape as an array of the size of each dimension
+        /// @param dimension the number of axes
+        /// @param type the type of the underlying elements
+        /// @param index the index of the outgoing link, or -1 when the result is forwarded to every outgoing link.
+        /// @return the tensor reference, or nullptr if the allocation failed.
+        virtual TensorRefPtr CreateOutputRef(Operator *op, const uint64_t *shape, int dimension, tensor_data_type_t type, int index = -1);
+
+        /// @brief Take the tensor the inputs of an operator were written into, see Link::InSlice. It is created with the first
+        /// result written into one of its slices, as CreateOutputRef creates the result of the operator.
+        /// @param op the operator
+        /// @return the tensor, owned by the caller as a result of CreateOutputRef, or nullptr if no input was written into a slice.
+        TensorRefPtr TakeSliceRef(Operator *op);
+
+        /// @brief Give back the tensor of an operator's result which is not forwarded, when the operator fails after CreateOutputRef
+        /// or TakeSliceRef. A bound buffer stays with the user, a slice lets the tensor it belongs to go with its last reference.
+        /// @param ref the tensor, may be null.
+        void DiscardOutputRef(TensorRefPtr ref);
+
+        /// @brief Get the tensor bound by the user to an outgoing link of an operator.
+        /// @param op the operator
+        /// @param index the index of the outgoing link, or -1 for any of them.
+        /// @return the tensor reference, or nullptr if none is bound.
+        TensorRefPtr GetBoundRef(Operator *op, int index = -1);
+
         /// @brief Forward the operator's result to the next operator.
         //  The context is concurrent, trying to hold the tensor ownership to avoid memory waste.
         /// @param outputValue  the output tensor
@@ -192,25 +272,102 @@ namespace CyanMycelium
         /// @return true if the operation is successful. false otherwise.
         virtual bool Forward(Operator *op, TensorRefPtr outputValue);
 
+        /// @brief Forward the operator's results to the next operators, when the operator produces one distinct tensor per outgoing link.
+        /// @param op  the operator
+        /// @param outputValues  the output tensors, indexed as the outgoing links of the operator. A null entry leaves the link untouched.
+        /// @param count  the number of output tensors
+        /// @return true if the operation is successful. false otherwise.
+        virtual bool Forward(Operator *op, TensorRefPtr *outputValues, int count);
+
         /// @brief Forward the link's value to the next operator.
         /// @param l  the link
         /// @return true if the operation is successful, false otherwise.
         virtual bool Forward(Link *l);
 
-        LinkState *_states; // tensor references
+    protected:
+        Profiler *_profiler;     // the optional profiler
+        ProfileRecord **_profile; // the record of every node for the current inference, indexed by node id
+        int _inference;          // the index of the current inference within the profiler
+        cm_uint64_t _started;    // cm_time_ns() when the current inference started
+        std::atomic<bool> _ended; // set by the first worker which sees every output of the current inference
+        int _error;              // the error of the last Run
+
+        /// @brief set the error and raise the OnError handler.
+        void _setError(int error);
+
+        /// @brief the record slot of a node, or null if the node cannot be profiled.
+        ProfileRecord **_getProfileSlot(Operator *op);
+
+        /// @brief record the node is posted to the engine queue.
+        void _profileQueued(Operator *op);
+
+        /// @brief record the node starts its execution.
+        /// @return the record, or null if it cannot be recorded.
+        ProfileRecord *_profileStarted(Operator *op);
+
+        /// @brief record the node ends its execution, the outputs are then added to the record while being forwarded.
+        /// @return the record, or null if it cannot be recorded.
+        ProfileRecord *_profileEnded(Operator *op);
 
     private:
         InferenceEngine *_engine; // the inference engine
         Graph *_model;            // the model
+        GraphTopology *_topology; // the compiled topology of the model, walked by the activation
 
         ActivationContextHandlers *_handlers;
 
+        // the state of the inference as a structure of arrays, laid out by the topology so the chains of operators
+        // which may run in parallel do not write into the same cache lines. See GraphTopology::GetRefSlot.
+        void *_stateBlock;              // the single block holding the arrays
+        TensorRefPtr *_refs;            // the tensor of every link, by ref slot
+        LinkFlags *_flags;              // the flags of every link, by flag slot
+        std::atomic<int32_t> *_pending; // the number of links a node still waits for, by pending slot
+        TensorRefPtr *_slices;          // the tensor the inputs of a node are written into, by node id, null without Link::InSlice
+
+        // the plans of the models with symbolic dimensions, keyed by the infos of the inputs.
+        ShapePlanCache *_plans;
+        ShapePlan *_plan;          // the plan of the current inference
+        TensorInfos **_planInputs; // the infos of the inputs of the current inference, as Graph::Inputs
+
+        /// @brief get the plan of the shapes of the bound inputs, then give the planned shapes to the bound outputs.
+        /// @return false if the inputs do not fit the model.
+        bool _planShapes();
+
+        TensorRefPtr &_refOf(int32_t link);
+        LinkFlags &_flagsOf(int32_t link);
+
+        /// @brief set the counters of the nodes to the number of links they read.
+        void _resetPending();
+
+        /// @brief clear the Activ flag of the outputs, which no node deactivates, so the end of the inference waits for all of them.
+        void _resetOutputs();
+
+        /// @brief create the result of an operator as a slice of the result of the destination of the link, see Link::InSlice.
+        /// @return the slice, or null if the destination cannot place it.
+        TensorRefPtr _createSliceRef(Link *l, const uint64_t *shape, int dimension, tensor_data_type_t type);
+
+        /// @brief release the tensors of the slices which were not taken, after a failed inference.
+        void _releaseSlices();
+
         /// @brief Build the tensor references at construct time
         virtual void _buildTensorRefs();
 
         /// @brief Clear the tensor references at destruct time
         virtual void _clearTensorRefs();
 
+        /// @brief Give the tensor to the link, without activating it. A tensor bound by the user is kept and receives
+        /// a copy of the value. The tensor must be locked.
+        void _hold(int32_t link, TensorRefPtr tensor);
+
+        /// @brief the implementations of Activate, Deactivate and Forward for the links, by link id.
+        bool _activate(int32_t link);
+        void _deactivate(int32_t link);
+        bool _forward(int32_t link);
+
+        /// @brief Release a reference to a tensor. The tensors of the context are freed with their last reference,
+        /// so the memory held by an inference is the live intermediates rather than all of them.
+        void _release(TensorRefPtr ref);
+
         void _bind(Link *link, void *buffer);
         Tensor *_get(Link *l);
 
@@ -4,6 +4,9 @@
 #include "memory/cm_memory_manager.hpp"
 #include "cm_session.hpp"
 #include "concurrent/cm_task.hpp"
+#include "cm_metrics.hpp"
+#include "cm_scheduler.hpp"
+#include "cm_plan.hpp"
 
 namespace CyanMycelium
 {
@@ -12,24 +15,48 @@ namespace CyanMycelium
 #define CM_DEFAULT_CQ_STACKSIZE 0
 #define CM_DEFAULT_CQ_PRIORITY Thread ::Priority::MEDIUM
 #define CM_DEFAULT_CQ_CAPACITY 32
+// slots of the queue kept for the continuations of the running inferences.
+#define CM_DEFAULT_CQ_RESERVED_CAPACITY 16
+// time a new inference waits for room in the queue before being rejected.
+#define CM_DEFAULT_CQ_ADMISSION_TIMEOUT CM_DEFAULT_CQ_TIMEOUT
+// below this size in bytes, a kernel is not worth splitting across the workers.
+#define CM_DEFAULT_PARALLEL_THRESHOLD (256 * 1024)
+// size in bytes of a chunk of work, chosen to fit into the L1 data cache.
+#define CM_DEFAULT_PARALLEL_CHUNK_SIZE (32 * 1024)
+
+  /// @brief function processing the items [from, to) of a parallel loop.
+  typedef void (*ParallelForFunction)(size_t from, size_t to, void *userData);
 
   struct InferenceEngineOptions
   {
     int QueueCapacity = CM_DEFAULT_CQ_CAPACITY;
+    int ReservedCapacity = CM_DEFAULT_CQ_RESERVED_CAPACITY;
+    int AdmissionTimeout = CM_DEFAULT_CQ_ADMISSION_TIMEOUT;
     int ThreadCount = CM_DEFAULT_CQ_NTHREAD;
     int WaitTimeout = CM_DEFAULT_CQ_TIMEOUT;
     int StackSize = CM_DEFAULT_CQ_STACKSIZE;
     Thread ::Priority Priority = CM_DEFAULT_CQ_PRIORITY;
     IRunnable *Runtime = nullptr;
     IMemoryManagerPtr MemoryManager = nullptr;
+    size_t ParallelThreshold = CM_DEFAULT_PARALLEL_THRESHOLD;
+    size_t ParallelChunkSize = CM_DEFAULT_PARALLEL_CHUNK_SIZE;
+    SchedulingPolicy Scheduling = CM_SCHEDULING_FIFO;
+    // the share of the workers of each priority class under CM_SCHEDULING_WEIGHTED.
+    int ClassWeights[CM_SCHEDULING_CLASS_COUNT] = {1, 4, 16, 64};
+    // the number of input shapes whose plan is kept by each context, for the models with symbolic dimensions.
+    int PlanCacheCapacity = CM_DEFAULT_PLAN_CACHE_CAPACITY;
   };
 
   class InferenceEngine : IRunnable
   {
   public:
-    InferenceEngine(InferenceEngineOptions options, boolean autoStart = true) : _queue(options.QueueCapacity, sizeof(ActivationEvent)), _lock()
+    InferenceEngine(InferenceEngineOptions options, boolean autoStart = true) : _queue(options.QueueCapacity + options.ReservedCapacity, sizeof(ActivationEvent)), _lock(), _threads(nullptr), _started(false), _scheduler(nullptr)
     {
       _options = options;
+      if (options.Scheduling != CM_SCHEDULING_FIFO)
+      {
+        _scheduler = new ActivationScheduler(options.Scheduling, options.ClassWeights, options.QueueCapacity + options.ReservedCapacity);
+      }
       if (autoStart)
       {
         this->Start();
@@ -39,6 +66,7 @@ namespace CyanMycelium
     virtual ~InferenceEngine()
     {
       Stop();
+      delete _scheduler;
     };
 
     IMemoryManagerPtr GetMemoryManager()
@@ -55,12 +83,49 @@ namespace CyanMycelium
     unsigned long Run(void *) override;
     void Consume(ActivationEvent &e);
 
+    /// @brief Send an event to the workers.
+    /// @param e the event, copied into the queue
+    /// @param timeoutMs the time to wait for room in the queue
+    /// @param scheduling the scheduling metadata of a node activation, which then goes through the scheduler of the engine, if any.
+    /// @return false if the queue is full. With a scheduler, e then receives the most urgent pending event, which the caller must run.
+    bool Post(ActivationEvent &e, unsigned int timeoutMs = CM_INFINITE, SchedulingInfos *scheduling = nullptr);
+
+    /// @brief Wait until the queue has room for a new inference beyond the reserved capacity, up to the admission timeout.
+    /// @return false if the inference is rejected.
+    bool Admit();
+
+    /// @brief the runtime statistics of the engine, updated without lock.
+    EngineMetrics &GetMetrics() { return _metrics; }
+
+    /// @brief the number of plans kept by each context, see ShapePlanCache.
+    int GetPlanCacheCapacity() { return _options.PlanCacheCapacity; }
+
+    /// @brief copy the runtime statistics, cheap enough to be polled periodically.
+    void GetMetricsSnapshot(EngineMetricsSnapshot &snapshot);
+
+    /// @brief Split the processing of count items of elementSize bytes into cache sized chunks shared with the workers.
+    /// The calling thread takes part to the loop and returns once every chunk is processed, so it is safe to call it
+    /// from an operator running on a worker. Below the parallel threshold, or without any other worker, the loop stays serial.
+    /// @param count the number of items
+    /// @param elementSize the size of an item in bytes, used to size the chunks.
+    /// @param fn the function processing a range of items
+    /// @param userData the user data passed to the function
+    void ParallelFor(size_t count, size_t elementSize, ParallelForFunction fn, void *userData);
+
+    /// @brief return true if a loop over count items of elementSize bytes will be split across the workers.
+    bool IsParallel(size_t count, size_t elementSize);
+
+    /// @brief return the number of items of elementSize bytes processed by a single chunk of a parallel loop.
+    size_t GetParallelGrain(size_t elementSize);
+
   private:
     Queue _queue;
     Mutex _lock;
     InferenceEngineOptions _options;
     ThreadPtr *_threads;
     bool _started;
+    EngineMetrics _metrics;
+    ActivationSchedulerPtr _scheduler;
   };
 
   typedef InferenceEngine *InferenceEnginePtr;
@@ -26,6 +26,17 @@ namespace CyanMycelium
     };
     typedef GraphItem *GraphItemPtr;
 
+    /// @brief The quantization parameters of a link, real = (q - ZeroPoint) * Scale.
+    /// Scale and ZeroPoint are the links of the parameter tensors, which hold a single value for a per tensor quantization
+    /// or one value per channel along Axis. They are set from the graph quantization annotations and from the
+    /// QuantizeLinear/DequantizeLinear nodes.
+    struct QuantizationInfos
+    {
+        Link *Scale = nullptr;
+        Link *ZeroPoint = nullptr; // optional, the zero point is 0 when null.
+        int Axis = 1;
+    };
+
     /// @brief The base class for all links.
     class Link : public GraphItem
     {
@@ -36,6 +47,7 @@ namespace CyanMycelium
             Oini = nullptr;
             Ofin = nullptr;
         };
+        virtual ~Link() {}
 
         /// @brief Activate the link.
         /// @param ctx the activation context
@@ -53,6 +65,27 @@ namespace CyanMycelium
         /// @param data the data to be set. Default is null.
         virtual void SetPayloadInfos(const uint64_t *shape, int dimension, tensor_data_type_t type, void *data = nullptr) { this->_payloadInfos.Set(shape, dimension, type, data); }
 
+        /// @brief true if the type and the shape of the link are known at load time, from the model or from Graph::InferShapes.
+        /// The links with a symbolic dimension are known once the shapes of the inputs are given, see ShapePlan.
+        bool HasShape() { return this->_payloadInfos.Type != TDT_UNDEFINED && !this->_payloadInfos.IsDynamic(); }
+
+        /// @brief true if the link carries quantized values.
+        bool IsQuantized() { return this->Quantization.Scale != nullptr; }
+
+        /// @brief true if the link is quantized with one scale per channel.
+        bool IsPerChannel() { return this->IsQuantized() && this->Quantization.Scale->GetPayloadInfos()->Count > 1; }
+
+        /// @brief the quantization parameters. Scale is null for links which are not quantized.
+        QuantizationInfos Quantization;
+
+        /// @brief true if the destination operator may write its result over the tensor of the link.
+        /// Set at load time by Graph::AnalyzeInPlace, the operators write into a fresh tensor otherwise.
+        bool InPlace = false;
+
+        /// @brief true if the source operator may write its result straight into a slice of the result of the destination,
+        /// which then reads it without any copy (see Operator::GetInputSlice). Set at load time by Graph::AnalyzeInPlace.
+        bool InSlice = false;
+
         /// @brief the operator that is the source of the link. May be null for input links.
         Operator *Oini;
         /// @brief the operator that is the destination of the link. May be null for output links.
@@ -70,6 +103,28 @@ namespace CyanMycelium
         cm_float_t f;
         cm_int64_t i;
         TensorPtr t;
+        const char *s; // only valid during the TrySetAtt call.
+        struct
+        {
+            const cm_int64_t *v;
+            int n;
+        } ints; // only valid during the TrySetAtt call.
+    };
+
+    /// @brief The kind of an attribute value, which tells the member of Att_value_t holding it.
+    enum class AttKind
+    {
+        FLOAT,
+        INT,
+        STRING,
+        INTS
+    };
+
+    /// @brief Receives the attributes of a node when the node is saved, see Node::GetAtts.
+    class AttWriter
+    {
+    public:
+        virtual void Write(const char *n, AttKind kind, Att_value_t value) = 0;
     };
 
     /// @brief The base class for all nodes.
@@ -81,7 +136,7 @@ namespace CyanMycelium
         }
         virtual ~Node() {}
 
-        /// @brief List of Incoming links.
+        /// @brief List of Incoming links, by input index. A blank optional input followed by a given one is a null slot.
         Collection<Link *> Opsc;
 
         /// @brief List of Outgoing links.
@@ -106,6 +161,11 @@ namespace CyanMycelium
         /// @return true if the attribute is bound and false otherwise.
         virtual bool TrySetAtt(int i, Att_value_t value) { return true; }
 
+        /// @brief Give the attributes of the node, by name as TrySetAtt expects them to build the node again.
+        /// The nodes without attributes give nothing.
+        /// @param writer the writer receiving every attribute.
+        virtual void GetAtts(AttWriter *writer) {}
+
     private:
         /// @brief the lock used to protect the node.
         Mutex _lock;
@@ -122,16 +182,93 @@ namespace CyanMycelium
         /// @return true if the activation is successful and false otherwise.
         virtual bool Activate(ActivationContext *ctx) = 0;
 
-        /// @brief return true if the operator is mutable, which mean it will change the input data
-        /// @return true if the operator is mutable and false otherwise.
-        virtual bool IsMutable() { return true; }
+        /// @brief return true if the operator is able to write its result over an input, when this input is not used by anybody else.
+        /// @param index the index of the input link
+        virtual bool SupportsInPlace(int index) { return false; }
+
+        /// @brief return true if the operator reads the input as a slice of its own result, so the operator producing the input
+        /// may write into the result of this one, see Link::InSlice.
+        /// @param index the index of the input link
+        virtual bool SupportsInputSlice(int index) { return false; }
+
+        /// @brief Locate the slice of the result an input is read from, when the input is written in place by its source.
+        /// Called by the context while the source creates its result, so the shapes are the planned ones.
+        /// @param index the index of the input link
+        /// @param plan the plan of the current inference, null if the graph has no symbolic dimension.
+        /// @param output receives the infos of the result of the operator.
+        /// @param offset receives the offset of the slice into the result, in bytes.
+        /// @return false if the slice is not contiguous or the shapes are not known, the input is then a tensor of its own.
+        virtual bool GetInputSlice(int index, ShapePlan *plan, TensorInfos *output, size_t *offset) { return false; }
+
+        /// @brief return true if the outputs of the operator are views on its inputs or on the graph, rather than tensors of the context.
+        virtual bool IsView() { return false; }
+
+        /// @brief Load time hook called by the graph builder with the version of the default ONNX domain imported by the model,
+        /// for the operators whose semantic changed along the opsets. The model gives its opsets after the graph, so this is
+        /// called once every node is read, before the patterns are rewritten.
+        /// @param version the opset version
+        /// @return false if the operator does not support this version.
+        virtual bool SetOpset(int version) { return true; }
+
+        /// @brief Load time hook called by the graph builder, before Prepack, to fold the operator consuming the single output
+        /// of this one into it, so the result of both is computed in a single pass. On success the builder removes the folded
+        /// operator with its incoming link, and this operator produces its output.
+        /// @param next the operator consuming the output, with a single input and a single output.
+        /// @return true if next is folded.
+        virtual bool Fuse(Operator *next) { return false; }
+
+        /// @brief Load time hook called by the graph builder once the node is linked and the initializers are read.
+        /// It let the operator transform its constant inputs (weights, biases) into a kernel specific layout.
+        /// The result is cached on the node, so it is shared by every ActivationContext.
+        /// @return true if the operation is successful and false otherwise.
+        virtual bool Prepack() { return true; }
+
+        /// @brief Save the data built by Prepack, so a compiled model restores the node without preparing it again.
+        /// @param buffer the buffer receiving the data, or null to get its size.
+        /// @return the size of the data, 0 if there is nothing to save.
+        virtual size_t SavePacked(void *buffer) { return 0; }
+
+        /// @brief Restore the data saved by SavePacked, in place of Prepack. The data is not copied, so it must outlive the node.
+        /// @param data the data saved by SavePacked
+        /// @param size the size of the data
+        /// @return true if the data is restored and false otherwise.
+        virtual bool LoadPacked(const void *data, size_t size) { return false; }
+
+        /// @brief Hook inferring the type and the shape of the outgoing links, called by Graph::InferShapes once the incoming
+        /// links are known, at load time and for every new set of input shapes (see ShapePlan). The operator reads its inputs
+        /// with _inferredInput and reports every output with _inferOutput, it never reads the links directly.
+        /// @param infos the infos of the links, indexed by link id.
+        /// @return false if the operator cannot process its inputs, true otherwise. The outputs depending on runtime values are left unknown.
+        virtual bool InferShapes(Tensor **infos) { return true; }
+
+        /// @brief the name of the operator type as registered into the NodeRegistry, null for the operators created by hand.
+        const char *TypeName = nullptr;
 
     protected:
+        /// @brief the infos of an incoming link during InferShapes, null if the input is missing.
+        Tensor *_inferredInput(Tensor **infos, int index) { return this->_hasInput(index) ? infos[this->Opsc[index]->Id] : nullptr; }
+
+        /// @brief true if the input is given, false if it is missing or left blank by the model.
+        bool _hasInput(int index) { return index < this->Opsc.Count() && this->Opsc[index]; }
+
+        /// @brief Report the inferred type and shape of an outgoing link. An unknown link takes them, while a link declared by the model
+        /// must match them, a symbolic dimension matching any size.
+        /// @param infos the infos of the links, as given to InferShapes.
+        /// @param index the index of the outgoing link, the missing links are ignored.
+        /// @return false if the declared link does not match and true otherwise.
+        bool _inferOutput(Tensor **infos, int index, const uint64_t *shape, int dimension, tensor_data_type_t type);
+
         /// @brief Push the outgoing result to the next operator by settting the payload of the outgoing link.
         /// @param output the outgoing link
         /// @param ctx the activation context
         /// @return true if the activation is successful and false otherwise.
         bool _forward(Tensor *output, ActivationContext *ctx);
+
+        /// @brief Get the value of an input, the runtime value first, then the initializer.
+        /// @param ctx the activation context
+        /// @param index the index of the input link
+        /// @return the tensor, or null if the input is missing or holds no data.
+        Tensor *_getValue(ActivationContext *ctx, int index);
     };
 
     typedef Operator *OperatorPtr;
@@ -144,6 +281,8 @@ namespace CyanMycelium
     public:
         UnaryOperator(const UnaryFunctionPtr typedFn[TDT_COUNT]) : Operator() { _typedFn = typedFn; }
         bool Activate(ActivationContext *ctx) override;
+        bool SupportsInPlace(int index) override { return true; }
+        bool InferShapes(Tensor **infos) override;
 
     protected:
         const UnaryFunctionPtr *_typedFn;
@@ -158,12 +297,107 @@ namespace CyanMycelium
     public:
         BinaryOperator(const BinaryFunctionPtr typedFn[TDT_COUNT]) : Operator() { this->_typedFn = typedFn; }
         bool Activate(ActivationContext *ctx) override;
+        bool SupportsInPlace(int index) override { return true; }
+        bool InferShapes(Tensor **infos) override;
 
     protected:
         const BinaryFunctionPtr *_typedFn;
     };
     typedef BinaryOperator *BinaryOperatorPtr;
 
+    class Graph;
+
+#ifndef CM_STATE_CACHE_LINE_SIZE
+// the cache line size used to lay out the state of the contexts, 0 keeps the states packed by link id.
+#define CM_STATE_CACHE_LINE_SIZE 64
+#endif
+
+    /// @brief The compiled, immutable view of the topology of a graph, used by the activation hot path.
+    /// Nodes and links are indexed by their id and the adjacency is stored in compressed sparse row form,
+    /// so walking the inputs or the outputs of a node is a loop over a dense range of link ids. Everything lives into a single block.
+    ///
+    /// The topology also lays out the state of the ActivationContext, which is a set of arrays indexed by slot.
+    /// The nodes of a chain run one after the other, so the states of their links share the same cache lines,
+    /// while every chain which may run in parallel with the others starts on a line of its own.
+    class GraphTopology
+    {
+    public:
+        ~GraphTopology() { cm_free(this->_block); }
+
+        /// @brief Compile the topology of a graph. The nodes are numbered by their index in the graph.
+        /// @param graph the graph
+        /// @param lineSize the cache line size used to lay out the state of the contexts, 0 keeps the slots of the links as their id.
+        /// @return the topology, or null if a link is not part of the graph or the memory cannot be allocated.
+        static GraphTopology *Compile(Graph *graph, int lineSize = CM_STATE_CACHE_LINE_SIZE);
+
+        int GetNodeCount() const { return this->_nodeCount; }
+        int GetLinkCount() const { return this->_linkCount; }
+        Operator *GetNode(int32_t node) const { return this->_nodes[node]; }
+        Link *GetLink(int32_t link) const { return this->_links[link]; }
+
+        /// @brief the ids of the incoming links of a node, in the order of the node inputs.
+        const int32_t *GetInputs(int32_t node) const { return this->_inputs + this->_inputOffsets[node]; }
+        int GetInputCount(int32_t node) const { return this->_inputOffsets[node + 1] - this->_inputOffsets[node]; }
+
+        /// @brief the ids of the outgoing links of a node.
+        const int32_t *GetOutputs(int32_t node) const { return this->_outputs + this->_outputOffsets[node]; }
+        int GetOutputCount(int32_t node) const { return this->_outputOffsets[node + 1] - this->_outputOffsets[node]; }
+
+        /// @brief the id of the source node of a link, -1 for the inputs and the initializers.
+        int32_t GetSource(int32_t link) const { return this->_sources[link]; }
+
+        /// @brief the id of the destination node of a link, -1 for the outputs.
+        int32_t GetTarget(int32_t link) const { return this->_targets[link]; }
+
+        /// @brief the slot of the tensor of a link into the state of the contexts.
+        int32_t GetRefSlot(int32_t link) const { return this->_refSlots[link]; }
+
+        /// @brief the slot of the flags of a link into the state of the contexts.
+        int32_t GetFlagSlot(int32_t link) const { return this->_flagSlots[link]; }
+
+        /// @brief the slot of the counter of the inputs a node waits for, -1 if the node reads a single link.
+        int32_t GetPendingSlot(int32_t node) const { return this->_pendingSlots[node]; }
+
+        /// @brief the number of distinct links read by a node, which is the initial value of its counter.
+        int GetPendingCount(int32_t node) const { return this->_pendingCounts[node]; }
+
+        /// @brief the number of slots of each array of the state of the contexts, padding included.
+        int GetRefSlotCount() const { return this->_refSlotCount; }
+        int GetFlagSlotCount() const { return this->_flagSlotCount; }
+        int GetPendingSlotCount() const { return this->_pendingSlotCount; }
+
+        /// @brief the cache line size the state is laid out for, 0 if the states are packed by link id.
+        int GetLineSize() const { return this->_lineSize; }
+
+    private:
+        GraphTopology() {}
+
+        /// @brief lay out the state of the contexts, once the adjacency is built.
+        /// @return false if the memory cannot be allocated.
+        bool _layout(int lineSize);
+
+        void *_block;
+        int _nodeCount;
+        int _linkCount;
+        Operator **_nodes;
+        Link **_links;
+        int32_t *_inputOffsets; // _nodeCount + 1 entries
+        int32_t *_inputs;
+        int32_t *_outputOffsets; // _nodeCount + 1 entries
+        int32_t *_outputs;
+        int32_t *_sources;
+        int32_t *_targets;
+        int32_t *_refSlots;
+        int32_t *_flagSlots;
+        int32_t *_pendingSlots;
+        int32_t *_pendingCounts;
+        int _refSlotCount;
+        int _flagSlotCount;
+        int _pendingSlotCount;
+        int _lineSize;
+    };
+    typedef GraphTopology *GraphTopologyPtr;
+
 #ifndef CM_DEFAULT_GRAPH_COLLECTION_CAPACITY
 #define CM_DEFAULT_GRAPH_COLLECTION_CAPACITY 16
 #endif
@@ -179,8 +413,11 @@ namespace CyanMycelium
         Graph(int initialNodesCollectionSize = CM_DEFAULT_GRAPH_COLLECTION_CAPACITY, int initialLinkCollectionSize = CM_DEFAULT_GRAPH_COLLECTION_CAPACITY) : Nodes(max(initialNodesCollectionSize, CM_DEFAULT_COLLECTION_CAPACITY)),
                                                                                                                                                              Links(max(initialLinkCollectionSize, CM_DEFAULT_COLLECTION_CAPACITY))
         {
+            this->_topology = nullptr;
+            this->_arena = nullptr;
+            this->_arenaSize = 0;
         }
-        ~Graph() {}
+        ~Graph();
 
         /// @brief list of nodes.
         Collection<Operator *> Nodes;
@@ -191,6 +428,54 @@ namespace CyanMycelium
         KeyValueCollection<Link *> Outputs;
 
         bool Activate(ActivationContext *ctx) override;
+
+        /// @brief Mark the links whose destination may run in place. A link qualifies when its tensor belongs to the context
+        /// (neither a graph input nor an initializer nor a view), is read by a single operator which reads it once,
+        /// and this operator supports running in place on it. The other operators write into a fresh tensor,
+        /// so the tensors are never copied and the user buffers are never modified.
+        /// The links qualifying the same way, but whose destination reads them as a slice of its result, are marked InSlice.
+        /// @return the number of links marked in place or in slice.
+        int AnalyzeInPlace();
+
+        /// @brief Compile the topology once the graph is complete. The graph must not be modified afterward,
+        /// or compiled again while any ActivationContext is using it.
+        /// @param lineSize the cache line size used to lay out the state of the contexts, see GraphTopology::Compile.
+        /// @return true if the operation is successful and false otherwise.
+        bool Compile(int lineSize = CM_STATE_CACHE_LINE_SIZE);
+
+        /// @brief Infer the type and the shape of the links from the inputs and the initializers, visiting the operators
+        /// in topological order through their InferShapes hook. An operator is visited once all its incoming links are known,
+        /// so the links depending on runtime values stay unknown. The graph must be compiled.
+        /// @param failed receives the operator rejecting its inputs, when the inference fails.
+        /// @return the number of links whose infos are inferred, or -1 if an operator rejects its inputs.
+        int InferShapes(Operator **failed = nullptr);
+
+        /// @brief Infer the infos of the links as InferShapes does, on a copy of them rather than on the links, see ShapePlan.
+        /// @param infos the infos of the links, indexed by link id. The infos of the inputs are set by the caller.
+        /// @param failed receives the operator rejecting its inputs, when the inference fails.
+        /// @return the number of infos inferred, or -1 if an operator rejects its inputs.
+        int InferShapes(Tensor **infos, Operator **failed);
+
+        /// @brief true if an input of the graph has a symbolic dimension, the contexts then plan every inference for the shapes of the inputs.
+        bool IsDynamic();
+
+        /// @brief the compiled topology, or null if the graph is not compiled.
+        GraphTopology *GetTopology() { return this->_topology; }
+
+        /// @brief Give the graph the block holding its nodes, links and initializers, as placed by the builder.
+        /// The objects found into the block are destroyed with the graph and the block is released with a single free.
+        void SetArena(void *arena, size_t size)
+        {
+            this->_arena = (cm_byte_t *)arena;
+            this->_arenaSize = size;
+        }
+
+    private:
+        GraphTopology *_topology;
+        cm_byte_t *_arena;
+        size_t _arenaSize;
+
+        bool _inArena(void *p) { return (cm_byte_t *)p >= this->_arena && (cm_byte_t *)p < this->_arena + this->_arenaSize; }
     };
     typedef Graph *GraphPtr;
 }
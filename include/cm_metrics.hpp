@@ -0,0 +1,182 @@
+#ifndef _CM_METRICS__
+#define _CM_METRICS__
+
+#include <atomic>
+
+#include "cm.h"
+
+namespace CyanMycelium
+{
+// the workers above this count share the statistics of the last one.
+#define CM_METRICS_MAX_WORKERS 32
+// 2^(bits - 1) sub buckets per power of 2, the relative error of a bucket is below 2^(1 - bits), about 6% with 5 bits.
+#define CM_HISTOGRAM_SUB_BUCKET_BITS 5
+#define CM_HISTOGRAM_HALF_COUNT (1 << (CM_HISTOGRAM_SUB_BUCKET_BITS - 1))
+#define CM_HISTOGRAM_BUCKET_COUNT ((64 - CM_HISTOGRAM_SUB_BUCKET_BITS + 2) * CM_HISTOGRAM_HALF_COUNT)
+#define CM_METRICS_CACHE_LINE_SIZE 64
+
+  /// @brief Histogram of durations in nanoseconds with log-linear buckets (HDR style), so the memory is fixed
+  /// whatever the range of the values while the relative precision stays constant. Record is lock-free.
+  class LatencyHistogram
+  {
+  public:
+    LatencyHistogram() { this->Reset(); }
+
+    /// @brief add a value.
+    void Record(cm_uint64_t ns);
+
+    /// @brief the number of values.
+    cm_uint64_t GetCount() { return this->_count.load(std::memory_order_relaxed); }
+
+    /// @brief the mean of the values.
+    cm_uint64_t GetMean();
+
+    /// @brief the largest value.
+    cm_uint64_t GetMax() { return this->_max.load(std::memory_order_relaxed); }
+
+    /// @brief the value below which the given percentage of the values fall, as the upper bound of its bucket.
+    /// @param percentile the percentage, from 0 to 100.
+    cm_uint64_t GetValueAt(double percentile);
+
+    /// @brief remove every value. Not atomic with Record.
+    void Reset();
+
+    /// @brief the bucket of a value.
+    static int BucketOf(cm_uint64_t ns);
+
+    /// @brief the smallest value of a bucket.
+    static cm_uint64_t LowestOf(int bucket);
+
+  private:
+    std::atomic<cm_uint64_t> _buckets[CM_HISTOGRAM_BUCKET_COUNT];
+    std::atomic<cm_uint64_t> _count;
+    std::atomic<cm_uint64_t> _sum;
+    std::atomic<cm_uint64_t> _max;
+  };
+
+  /// @brief the percentiles of the inference latency, in nanoseconds.
+  struct LatencySummary
+  {
+    cm_uint64_t Count;
+    cm_uint64_t Mean;
+    cm_uint64_t P50;
+    cm_uint64_t P90;
+    cm_uint64_t P99;
+    cm_uint64_t P999;
+    cm_uint64_t Max;
+  };
+
+  /// @brief the times of a worker in nanoseconds, since the engine started.
+  struct WorkerMetrics
+  {
+    cm_uint64_t Busy;   // running the activations of the nodes
+    cm_uint64_t Steal;  // running the chunks of the parallel loops posted by other threads
+    cm_uint64_t Idle;   // waiting for an event
+    cm_uint64_t Events; // the number of events processed
+  };
+
+  /// @brief A copy of the engine metrics at a given time. Rates are computed from two snapshots.
+  struct EngineMetricsSnapshot
+  {
+    cm_uint64_t Timestamp; // cm_time_ns() at the time of the snapshot
+    int QueueCapacity;
+    int QueueDepth;     // the number of pending events
+    int QueueHighWater; // the largest depth observed
+    cm_uint64_t Sent;
+    cm_uint64_t SendFailures; // the events rejected because the queue was full
+    cm_uint64_t Admitted;     // the inferences admitted by the engine
+    cm_uint64_t Rejected;     // the inferences rejected after the admission timeout
+    cm_uint64_t Inlined;      // the activations run by the caller because the queue was full
+    cm_uint64_t Activations;  // the node activations processed by the workers
+    int WorkerCount;
+    WorkerMetrics Workers[CM_METRICS_MAX_WORKERS];
+    LatencySummary Latency; // from Run to the end of the inference
+
+    /// @brief the number of activations per second since a previous snapshot.
+    double GetActivationRate(const EngineMetricsSnapshot &previous)
+    {
+      cm_uint64_t elapsed = this->Timestamp - previous.Timestamp;
+      return elapsed ? (double)(this->Activations - previous.Activations) * 1e9 / elapsed : 0;
+    }
+  };
+
+  /// @brief The runtime statistics of an InferenceEngine. Every counter is updated with relaxed atomics,
+  /// the workers only write their own cache line, so the cost on the hot path is a few uncontended increments.
+  class EngineMetrics
+  {
+  public:
+    EngineMetrics() { this->Reset(); }
+
+    /// @brief give a slot to the calling worker.
+    /// @return the index of the worker.
+    int RegisterWorker();
+
+    /// @brief forget the workers, called when the engine starts.
+    void ResetWorkers() { this->_workerCount.store(0, std::memory_order_relaxed); }
+
+    /// @brief record the result of a Send to the engine queue.
+    void OnSent(bool sent)
+    {
+      if (!sent)
+      {
+        this->_sendFailures.fetch_add(1, std::memory_order_relaxed);
+        return;
+      }
+      this->_sent.fetch_add(1, std::memory_order_relaxed);
+      int depth = this->_depth.fetch_add(1, std::memory_order_relaxed) + 1;
+      int highWater = this->_highWater.load(std::memory_order_relaxed);
+      while (depth > highWater && !this->_highWater.compare_exchange_weak(highWater, depth, std::memory_order_relaxed))
+      {
+      }
+    }
+
+    /// @brief record the admission of an inference.
+    void OnAdmission(bool admitted) { (admitted ? this->_admitted : this->_rejected).fetch_add(1, std::memory_order_relaxed); }
+
+    /// @brief record an activation run by the caller.
+    void OnInlined() { this->_inlined.fetch_add(1, std::memory_order_relaxed); }
+
+    /// @brief record an event is taken from the engine queue.
+    void OnReceived() { this->_depth.fetch_sub(1, std::memory_order_relaxed); }
+
+    /// @brief record a node activation.
+    void OnActivation() { this->_activations.fetch_add(1, std::memory_order_relaxed); }
+
+    /// @brief record the times of a worker.
+    void OnWorker(int worker, cm_uint64_t idle, cm_uint64_t busy, cm_uint64_t steal);
+
+    /// @brief record the latency of an inference.
+    void OnInference(cm_uint64_t ns) { this->_latency.Record(ns); }
+
+    /// @brief copy the metrics. The snapshot is not atomic as a whole, but every counter is.
+    void GetSnapshot(EngineMetricsSnapshot &snapshot);
+
+    /// @brief reset the high water mark of the queue to its current depth.
+    void ResetHighWater() { this->_highWater.store(this->_depth.load(std::memory_order_relaxed), std::memory_order_relaxed); }
+
+    /// @brief reset every counter but the queue depth.
+    void Reset();
+
+  private:
+    struct alignas(CM_METRICS_CACHE_LINE_SIZE) _Worker
+    {
+      std::atomic<cm_uint64_t> Busy;
+      std::atomic<cm_uint64_t> Steal;
+      std::atomic<cm_uint64_t> Idle;
+      std::atomic<cm_uint64_t> Events;
+    };
+
+    _Worker _workers[CM_METRICS_MAX_WORKERS];
+    alignas(CM_METRICS_CACHE_LINE_SIZE) std::atomic<int> _depth{0};
+    std::atomic<int> _highWater;
+    std::atomic<int> _workerCount{0};
+    std::atomic<cm_uint64_t> _sent;
+    std::atomic<cm_uint64_t> _sendFailures;
+    std::atomic<cm_uint64_t> _admitted;
+    std::atomic<cm_uint64_t> _rejected;
+    std::atomic<cm_uint64_t> _inlined;
+    std::atomic<cm_uint64_t> _activations;
+    LatencyHistogram _latency;
+  };
+}
+#endif
@@ -0,0 +1,93 @@
+#ifndef _CM_PLAN__
+#define _CM_PLAN__
+
+#include "cm_graph.hpp"
+
+namespace CyanMycelium
+{
+#ifndef CM_DEFAULT_PLAN_CACHE_CAPACITY
+// the number of plans kept by a context, one per set of input shapes.
+#define CM_DEFAULT_PLAN_CACHE_CAPACITY 8
+#endif
+
+  /// @brief The plan of a graph specialized for one set of input shapes: the type, the shape and the size of every link,
+  /// inferred through the InferShapes hooks of the operators as Graph::InferShapes does at load time. The plan is immutable
+  /// once built, the shapes of the inputs are its key into the ShapePlanCache.
+  class ShapePlan
+  {
+  public:
+    ~ShapePlan() { cm_free(this->_block); }
+
+    /// @brief Build the plan of a compiled graph.
+    /// @param graph the graph
+    /// @param inputs the infos of the inputs, as Graph::Inputs. Every symbolic dimension of an input must be given a size.
+    /// @param failed receives the operator rejecting its inputs, when the inference fails.
+    /// @return the plan, or null if the inputs do not fit the graph, an operator rejects them or the memory cannot be allocated.
+    static ShapePlan *Build(Graph *graph, TensorInfos **inputs, Operator **failed = nullptr);
+
+    /// @brief the key of a set of input shapes, which is the first test of Matches.
+    static cm_uint64_t Hash(TensorInfos **inputs, int count);
+
+    /// @brief true if the plan is built for these input shapes.
+    bool Matches(TensorInfos **inputs, int count, cm_uint64_t hash);
+
+    /// @brief the planned infos of a link, by link id. A link depending on runtime values stays unknown, or keeps its symbolic dimensions.
+    Tensor *GetInfos(int32_t link) { return this->_infos + link; }
+
+    /// @brief the number of bytes of the tensors produced by the operators for one inference, as far as they are known.
+    size_t GetSize() { return this->_size; }
+
+  private:
+    friend class ShapePlanCache;
+
+    ShapePlan() {}
+
+    void *_block;
+    Tensor *_infos;      // by link id
+    TensorInfos *_inputs; // the key, as Graph::Inputs
+    int _inputCount;
+    cm_uint64_t _hash;
+    size_t _size;
+    ShapePlan *_previous; // the more recently used plan of the cache
+    ShapePlan *_next;     // the less recently used plan of the cache
+  };
+  typedef ShapePlan *ShapePlanPtr;
+
+  /// @brief The plans of a graph built so far by a context, the most recently used first. The repeated shapes find their plan
+  /// with a hash and a few compares, while the least recently used plan is released once the capacity is reached.
+  class ShapePlanCache
+  {
+  public:
+    ShapePlanCache(int capacity = CM_DEFAULT_PLAN_CACHE_CAPACITY) : _first(nullptr), _last(nullptr), _count(0), _hits(0), _misses(0) { this->SetCapacity(capacity); }
+    ~ShapePlanCache() { this->Clear(); }
+
+    /// @brief Get the plan of a set of input shapes, built on a miss. The plan stays valid until the next call.
+    /// @param graph the compiled graph
+    /// @param inputs the infos of the inputs, as Graph::Inputs
+    /// @param failed receives the operator rejecting its inputs, when the plan cannot be built.
+    /// @return the plan, or null if it cannot be built.
+    ShapePlan *Get(Graph *graph, TensorInfos **inputs, Operator **failed = nullptr);
+
+    /// @brief set the number of plans kept, at least one.
+    void SetCapacity(int capacity);
+
+    /// @brief release every plan.
+    void Clear();
+
+    int GetCount() { return this->_count; }
+    cm_uint64_t GetHits() { return this->_hits; }
+    cm_uint64_t GetMisses() { return this->_misses; }
+
+  private:
+    ShapePlan *_first;
+    ShapePlan *_last;
+    int _count;
+    int _capacity;
+    cm_uint64_t _hits;
+    cm_uint64_t _misses;
+
+    void _unlink(ShapePlan *plan);
+    void _pushFront(ShapePlan *plan);
+  };
+}
+#endif
@@ -0,0 +1,79 @@
+#ifndef _CM_PROFILER__
+#define _CM_PROFILER__
+
+#include <atomic>
+
+#include "cm.h"
+
+namespace CyanMycelium
+{
+#define CM_DEFAULT_PROFILER_CAPACITY 4096
+// maximum size of a line of the reports.
+#define CM_PROFILER_LINE_SIZE 512
+
+  // forward declaration
+  class Operator;
+
+  /// @brief The measures of a node for one inference. Timestamps are given by cm_time_ns().
+  struct ProfileRecord
+  {
+    const Operator *Node;
+    int Inference;        // the index of the inference within the profiler
+    cm_uint32_t ThreadId; // the thread which executed the node
+    cm_uint64_t Queued;   // the node was posted to the engine queue, equal to Started for the synchronous contexts
+    cm_uint64_t Started;  // the node started its execution
+    cm_uint64_t Ended;    // the node forwarded its result, or failed. 0 while the node is running.
+    size_t BytesIn;       // size of the inputs, initializers included
+    size_t BytesOut;      // size of the forwarded outputs
+    int Allocs;           // output tensors allocated by the node
+  };
+
+  /// @brief function receiving the text of the profiler reports, one line at a time.
+  typedef void (*ProfilerWriteFunction)(const char *text, void *userData);
+
+  /// @brief Opt-in recorder of the node executions, attached to one or more ActivationContext with SetProfiler.
+  /// Records are claimed from a fixed buffer without lock, once the buffer is full the next ones are dropped.
+  /// The reports and Clear are meant to be called once the inferences ended.
+  class Profiler
+  {
+  public:
+    Profiler(int capacity = CM_DEFAULT_PROFILER_CAPACITY);
+    ~Profiler();
+
+    /// @brief start a new inference.
+    /// @return the index of the inference
+    int BeginInference() { return this->_inferences.fetch_add(1, std::memory_order_relaxed); }
+
+    /// @brief claim a record for the activation of a node.
+    /// @return the zeroed record, or null if the buffer is full.
+    ProfileRecord *Claim(int inference, const Operator *node);
+
+    /// @brief the number of records.
+    int Count();
+
+    /// @brief the number of records lost because the buffer was full.
+    int GetDropped();
+
+    /// @brief the record at index i.
+    ProfileRecord *Get(int i) { return this->_records + i; }
+
+    /// @brief discard the records and the inferences.
+    void Clear();
+
+    /// @brief write the records in the Chrome trace event format (chrome://tracing, Perfetto).
+    /// Nodes are complete events on the thread which executed them, the queue wait and the counts are in their args.
+    void WriteChromeTrace(ProfilerWriteFunction fn, void *userData = nullptr);
+
+    /// @brief write a table of the records aggregated by operator type, most expensive first.
+    void WriteSummary(ProfilerWriteFunction fn, void *userData = nullptr);
+
+  private:
+    ProfileRecord *_records;
+    int _capacity;
+    std::atomic<int> _next;
+    std::atomic<int> _inferences;
+  };
+
+  typedef Profiler *ProfilerPtr;
+}
+#endif
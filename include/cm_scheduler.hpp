@@ -0,0 +1,52 @@
+#ifndef _CM_SCHEDULER__
+#define _CM_SCHEDULER__
+
+#include "cm_session.hpp"
+
+namespace CyanMycelium
+{
+  /// @brief Orders the pending node activations by deadline or by weighted fair queuing of the priority classes.
+  /// The scheduler only holds the events, the engine queue carries one CM_ACTIVATION_SCHEDULED token per event
+  /// to wake a worker, which then takes the most urgent event. So the capacity and the admission of the queue still apply.
+  class ActivationScheduler
+  {
+  public:
+    /// @param policy CM_SCHEDULING_EDF or CM_SCHEDULING_WEIGHTED
+    /// @param weights the weights of the priority classes, ignored by EDF
+    /// @param initialCapacity the initial number of events, the scheduler grows as needed
+    ActivationScheduler(SchedulingPolicy policy, const int *weights, int initialCapacity);
+    ~ActivationScheduler();
+
+    /// @brief add an event.
+    /// @return false if the memory cannot be allocated.
+    bool Push(ActivationEvent &e, SchedulingInfos *infos);
+
+    /// @brief take the most urgent event.
+    /// @return false if there is no event.
+    bool Pop(ActivationEvent &e);
+
+  private:
+    struct _Entry
+    {
+      cm_uint64_t Key;
+      cm_uint64_t Sequence;
+      ActivationEvent Event;
+    };
+
+    static inline bool _before(const _Entry &a, const _Entry &b) { return a.Key != b.Key ? a.Key < b.Key : a.Sequence < b.Sequence; }
+
+    Mutex _lock;
+    SchedulingPolicy _policy;
+    _Entry *_heap;
+    int _count;
+    int _capacity;
+    cm_uint64_t _sequence;
+    // weighted fair queuing: the virtual time and the virtual finish time of the last event of each class.
+    cm_uint64_t _virtual;
+    cm_uint64_t _finish[CM_SCHEDULING_CLASS_COUNT];
+    cm_uint64_t _stride[CM_SCHEDULING_CLASS_COUNT];
+  };
+
+  typedef ActivationScheduler *ActivationSchedulerPtr;
+}
+#endif
@@ -9,10 +9,35 @@ namespace CyanMycelium
 {
 #define CM_SESSION_WAIT_QUEUE_SIZE 8
 
+#define CM_SCHEDULING_CLASS_COUNT 4
+#define CM_SCHEDULING_DEFAULT_CLASS 1
+// the default latency budget of an inference, 1s, so the sessions without deadline still age under EDF.
+#define CM_SCHEDULING_DEFAULT_BUDGET 1000000000ULL
+// the virtual time consumed by an activation of weight 1.
+#define CM_SCHEDULING_STRIDE_UNIT (1 << 20)
+
+  /// @brief the order in which the workers serve the node activations.
+  enum SchedulingPolicy
+  {
+    CM_SCHEDULING_FIFO,     // arrival order, the activations go straight to the engine queue.
+    CM_SCHEDULING_EDF,      // earliest deadline first.
+    CM_SCHEDULING_WEIGHTED, // each priority class gets a share of the workers proportional to its weight.
+  };
+
+  /// @brief the scheduling metadata of a session.
+  struct SchedulingInfos
+  {
+    int Class = CM_SCHEDULING_DEFAULT_CLASS; // the priority class, from 0 to CM_SCHEDULING_CLASS_COUNT - 1
+    cm_uint64_t Budget = 0;                  // the latency budget in ns, the default budget when 0
+    cm_uint64_t Deadline = 0;                // cm_time_ns() at the start of the inference plus the budget, set by Run
+  };
+
   enum ActivationEventType
   {
     CM_ACTIVATION_LINK,
     CM_ACTIVATION_NODE,
+    CM_ACTIVATION_PARALLEL,
+    CM_ACTIVATION_SCHEDULED,
     CM_ACTIVATION_STOP
   };
 
@@ -23,19 +48,31 @@ namespace CyanMycelium
     void *Content;
   };
 
+  /// @brief ActivationContext running the operators on the workers of the engine.
+  /// A new inference is admitted only when the queue has room beyond the capacity reserved for the running ones,
+  /// it waits up to the admission timeout of the engine, then Run fails with CM_ACTIVATION_REJECTED.
+  /// Once admitted, an activation is never dropped: when the queue is full, the operator runs on the calling thread.
   class AsyncActivationContext : public ActivationContext
   {
   public:
-    AsyncActivationContext(InferenceEngine *engine, GraphPtr model, Queue *queue, ActivationContextHandlersPtr handlers = nullptr) : ActivationContext(engine, model, handlers)
-    {
-      _queue = queue;
-    };
+    AsyncActivationContext(InferenceEngine *engine, GraphPtr model, ActivationContextHandlersPtr handlers = nullptr) : ActivationContext(engine, model, handlers){};
+
+    bool Run() override;
+
+    /// @brief set the priority class of the session, used by the CM_SCHEDULING_WEIGHTED policy.
+    void SetPriority(int priorityClass) { _scheduling.Class = min(max(priorityClass, 0), CM_SCHEDULING_CLASS_COUNT - 1); }
+
+    /// @brief set the latency budget of the inferences, used by the CM_SCHEDULING_EDF policy.
+    /// @param budget the time in ns from Run to the deadline, 0 for the default budget.
+    void SetDeadline(cm_uint64_t budget) { _scheduling.Budget = budget; }
+
+    SchedulingInfos *GetSchedulingInfos() { return &_scheduling; }
 
   protected:
     bool Activate(OperatorPtr) override;
 
   private:
-    Queue *_queue;
+    SchedulingInfos _scheduling;
   };
 }
 #endif
\ No newline at end of file
@@ -84,8 +84,8 @@ namespace CyanMycelium
     Collection(unsigned int initialCapacity = CM_DEFAULT_COLLECTION_CAPACITY)
     {
       _items = nullptr;
-      SetCapacity(max(initialCapacity, CM_DEFAULT_COLLECTION_CAPACITY));
       _count = 0;
+      SetCapacity(max(initialCapacity, CM_DEFAULT_COLLECTION_CAPACITY));
     };
 
     ~Collection()
@@ -158,6 +158,20 @@ namespace CyanMycelium
       return false;
     };
 
+    /// @brief remove the item at the given index, the following items are moved down by one.
+    void RemoveAt(int i)
+    {
+      if (i < 0 || i >= _count)
+      {
+        return;
+      }
+      _count--;
+      if (i != _count)
+      {
+        cm_memmove(_items + i, _items + i + 1, (_count - i) * sizeof(T));
+      }
+    };
+
     Iterator<T> GetIterator() { return Iterator<T>(this); };
 
     void EnsureEnoughRoomFor(int n)
@@ -211,33 +225,30 @@ namespace CyanMycelium
     T operator[](const char *key) { return Get(key); }
     T Get(const char *key)
     {
-      if (this->_count)
+      int i = IndexOf(key);
+      return i < 0 ? nullptr : this->_items[i].Value;
+    };
+
+    /// @brief the index of the entry with the given key, -1 if none.
+    int IndexOf(const char *key)
+    {
+      for (int i = 0; i < this->_count; ++i)
       {
-        for (int i = 0; i != this->_count; ++i)
+        if (strcmp(key, this->_items[i].Key) == 0)
         {
-          KeyValue<T> *current = this->_items + i;
-          if (strcmp(key, current->Key) == 0)
-          {
-            return current->Value;
-          }
+          return i;
         }
       }
-      return nullptr;
+      return -1;
     };
 
     void Set(const char *key, T value)
     {
-      if (this->_count)
+      int i = IndexOf(key);
+      if (i >= 0)
       {
-        for (int i = 0; i != this->_count; ++i)
-        {
-          KeyValue<T> *current = this->_items + i;
-          if (strcmp(key, current->Key) == 0)
-          {
-            current->Value = value;
-            return;
-          }
-        }
+        this->_items[i].Value = value;
+        return;
       }
       if (this->_count == this->_capacity)
       {
@@ -20,6 +20,10 @@ namespace CyanMycelium
         unsigned int Size();
         bool ISR_Send(void *item);
 
+        /// @brief wait until the queue has room for size items, without reserving them.
+        /// @return false if the timeout expired.
+        boolean WaitForFreeSize(unsigned int size, unsigned int timeoutMs = CM_INFINITE);
+
     private:
         cm_queue_handle_t _queue;
     };
@@ -0,0 +1,161 @@
+#ifndef _CM_FLAT_GRAPH__
+#define _CM_FLAT_GRAPH__
+
+#include "cm_graph.hpp"
+
+namespace CyanMycelium
+{
+#define FLAT_MAGIC "CMFG"
+#define FLAT_VERSION 1
+#define FLAT_BYTE_ORDER 0x01020304
+// the alignment of the initializers and of the packed data within the image.
+#define FLAT_ALIGNMENT 64
+// the alignment of the nodes and of the links into the arena of the loaded graph.
+#define FLAT_ARENA_ALIGNMENT 16
+
+#define FLAT_SUCCESS 0
+#define FLAT_UNSUPPORTED_NODE 100
+#define FLAT_UNSUPPORTED_ATTRIBUTE 101
+#define FLAT_INVALID_GRAPH 102
+#define FLAT_INVALID_IMAGE 110
+#define FLAT_UNSUPPORTED_VERSION 111
+#define FLAT_BUFFER_TOO_SMALL 200
+#define FLAT_SYSTEM_ERROR 300
+
+// the link is marked in place, see Graph::AnalyzeInPlace.
+#define FLAT_LINK_IN_PLACE 0x01
+// the link is written into a slice of the result of its destination, see Link::InSlice.
+#define FLAT_LINK_IN_SLICE 0x02
+
+    /// @brief The image of a compiled graph starts with this header. Every reference is an offset from the start of the image,
+    /// so the image does not depend on its address and may be mapped read only, then shared by several processes.
+    struct FlatHeader
+    {
+        char Magic[4];
+        uint32_t Version;
+        uint32_t ByteOrder; // FLAT_BYTE_ORDER as written by the host, the image is not portable across byte orders.
+        uint32_t Alignment; // FLAT_ALIGNMENT
+        uint64_t Size;      // the size of the image
+        uint32_t NodeCount;
+        uint32_t LinkCount;
+        uint32_t EdgeCount; // the number of link ids read and written by the nodes
+        uint32_t InputCount;
+        uint32_t OutputCount;
+        uint32_t AttCount;
+        uint64_t Nodes; // FlatNode[NodeCount]
+        uint64_t Links; // FlatLink[LinkCount]
+        uint64_t Edges; // int32_t[EdgeCount], -1 for a blank input
+        uint64_t Names; // FlatName[InputCount + OutputCount], the inputs then the outputs
+        uint64_t Atts;  // FlatAtt[AttCount]
+    };
+
+    struct FlatNode
+    {
+        uint64_t Type;        // the type name as registered into the NodeRegistry
+        uint32_t FirstEdge;   // the ids of the incoming links, then the ids of the outgoing links
+        uint32_t InputCount;  // the number of incoming links
+        uint32_t OutputCount; // the number of outgoing links
+        uint32_t FirstAtt;
+        uint32_t AttCount;
+        uint32_t Reserved;
+        uint64_t Packed; // the data saved by Operator::SavePacked, 0 if none
+        uint64_t PackedSize;
+    };
+
+    struct FlatLink
+    {
+        uint64_t Shape[TENSOR_MAX_DIMENSION];
+        uint32_t Dimension;
+        uint32_t Type;
+        uint64_t Data;     // the value of the initializer, 0 if none
+        int32_t Scale;     // the id of the link of the quantization scale, -1 if none
+        int32_t ZeroPoint; // the id of the link of the quantization zero point, -1 if none
+        int32_t Axis;
+        uint32_t Flags;
+    };
+
+    struct FlatName
+    {
+        uint64_t Name;
+        int32_t Link;
+        uint32_t Reserved;
+    };
+
+    struct FlatAtt
+    {
+        uint64_t Name;
+        uint32_t Kind;  // AttKind
+        uint32_t Count; // the number of values of an INTS attribute
+        union
+        {
+            double F;
+            int64_t I;
+            uint64_t Offset; // the string or the ints
+        } Value;
+    };
+
+    /// @brief Write a graph into a flat image: the topology, the attributes of the operators, the initializers and the data
+    /// prepared by the operators at load time, each one aligned on FLAT_ALIGNMENT, and the links marked in place.
+    /// FlatGraphBuilder restores the graph from the image without any parsing.
+    class FlatGraphWriter
+    {
+    public:
+        /// @brief Write the image of a graph.
+        /// @param graph the graph, every node must be created by the NodeRegistry.
+        /// @param buffer the buffer receiving the image, or null to get its size.
+        /// @param size the size of the buffer.
+        /// @return the size of the image, or 0 if the image cannot be written, see GetError.
+        size_t Write(Graph *graph, void *buffer, size_t size);
+
+        int GetError() { return _error; }
+
+    private:
+        class _AttEmitter : public AttWriter
+        {
+        public:
+            FlatGraphWriter *Writer;
+            void Write(const char *n, AttKind kind, Att_value_t value) override;
+        };
+
+        int _error = FLAT_SUCCESS;
+        // the image, null while the sections are sized.
+        cm_byte_t *_image;
+        uint64_t _atts;
+        uint32_t _attCount;
+        uint64_t _strings;
+        uint64_t _data;
+
+        bool _check(Graph *graph);
+        /// @brief write the sections from their start, or size them when there is no image.
+        void _emit(Graph *graph, FlatHeader *header);
+        uint64_t _putString(const char *s);
+        uint64_t _putData(const void *data, size_t size);
+        uint64_t _reserveData(size_t size);
+    };
+
+    /// @brief Build a graph from an image written by FlatGraphWriter. The image is checked, then the nodes and the links
+    /// are placed into a single arena owned by the graph. The initializers and the packed data are read from the image
+    /// without any copy, so the image must outlive the graph.
+    class FlatGraphBuilder
+    {
+    public:
+        FlatGraphBuilder &WithImage(const void *image, size_t size);
+
+        Graph *Build(Graph *target = nullptr);
+        int GetError() { return _error; }
+        const char *GetErrorInfos() { return _errorInfos; }
+
+    private:
+        const cm_byte_t *_image = nullptr;
+        size_t _size = 0;
+        int _error = FLAT_SUCCESS;
+        char _errorInfos[CM_KEY_MAX_LENGTH];
+
+        bool _checkHeader(const FlatHeader *header);
+        bool _isRange(uint64_t offset, uint64_t size) { return offset <= this->_size && size <= this->_size - offset; }
+        bool _isData(const FlatLink *link);
+        const char *_getString(uint64_t offset);
+        void _setError(int error, const char *infos = nullptr);
+    };
+}
+#endif
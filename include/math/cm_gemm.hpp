@@ -0,0 +1,110 @@
+#ifndef _CM_GEMM__
+#define _CM_GEMM__
+
+#include "cm.h"
+#include "math/cm_half.hpp"
+
+namespace CyanMycelium
+{
+  /// @brief Single precision matrix multiplication with a transposed right operand, C = A.Bt (+ bias) (+ C).
+  /// This is the natural layout of the ONNX weights (W, R of LSTM, B of Gemm with transB) which are stored as [N x K] row major.
+  /// @param m the number of rows of A and C
+  /// @param n the number of rows of B and the number of columns of C
+  /// @param k the number of columns of A and B
+  /// @param a the left operand [m x k]
+  /// @param lda the row stride of a
+  /// @param b the right operand [n x k]
+  /// @param ldb the row stride of b
+  /// @param c the result [m x n]
+  /// @param ldc the row stride of c
+  /// @param bias optional vector of n values added to every row of C. May be null.
+  /// @param accumulate when true, the product is added to the current content of C.
+  void cm_sgemm_nt(int m, int n, int k,
+                   const float *a, int lda,
+                   const float *b, int ldb,
+                   float *c, int ldc,
+                   const float *bias = nullptr, bool accumulate = false);
+
+  /// @brief Number of floats required to hold a right operand [n x k] packed by cm_sgemm_pack_b.
+  size_t cm_sgemm_packed_size(int n, int k);
+
+  /// @brief Pack a right operand stored as [n x k] row major (the layout consumed by cm_sgemm_nt) into
+  /// panels of CM_SIMD_WIDTH rows interleaved along k. The last panel is zero padded.
+  /// This is done once, at model load, for the constant weights.
+  /// @param packed the target buffer of cm_sgemm_packed_size(n, k) floats.
+  void cm_sgemm_pack_b(int n, int k, const float *b, int ldb, float *packed);
+
+  /// @brief Same as cm_sgemm_nt with a right operand previously packed by cm_sgemm_pack_b.
+  void cm_sgemm_packed(int m, int n, int k,
+                       const float *a, int lda,
+                       const float *packed,
+                       float *c, int ldc,
+                       const float *bias = nullptr, bool accumulate = false);
+
+  /// @brief Same as cm_sgemm_nt with operands and result stored as half. The operands are converted to float by cache sized tiles,
+  /// the products are accumulated in float and C is rounded once at the end.
+  /// @return false if the working memory cannot be allocated.
+  bool cm_hgemm_nt(int m, int n, int k,
+                   const cm_half_t *a, int lda,
+                   const cm_half_t *b, int ldb,
+                   cm_half_t *c, int ldc,
+                   const float *bias = nullptr);
+
+  /// @brief Same as cm_hgemm_nt with C kept in float, for the products accumulated further as the gates of LSTM.
+  bool cm_hgemm_nt(int m, int n, int k,
+                   const cm_half_t *a, int lda,
+                   const cm_half_t *b, int ldb,
+                   float *c, int ldc,
+                   const float *bias = nullptr, bool accumulate = false);
+
+  /// @brief Same as cm_sgemm_packed with a left operand stored as half, converted to float by blocks of rows.
+  /// The constant weights are converted once when they are packed, see cm_sgemm_pack_b.
+  bool cm_hgemm_packed(int m, int n, int k,
+                       const cm_half_t *a, int lda,
+                       const float *packed,
+                       float *c, int ldc,
+                       const float *bias = nullptr, bool accumulate = false);
+
+  /// @brief Same as cm_hgemm_nt for bfloat16 storage.
+  bool cm_bgemm_nt(int m, int n, int k,
+                   const cm_bfloat16_t *a, int lda,
+                   const cm_bfloat16_t *b, int ldb,
+                   cm_bfloat16_t *c, int ldc,
+                   const float *bias = nullptr);
+
+  /// @brief Same as cm_hgemm_nt with C kept in float, for bfloat16 storage.
+  bool cm_bgemm_nt(int m, int n, int k,
+                   const cm_bfloat16_t *a, int lda,
+                   const cm_bfloat16_t *b, int ldb,
+                   float *c, int ldc,
+                   const float *bias = nullptr, bool accumulate = false);
+
+  /// @brief Same as cm_hgemm_packed for bfloat16 storage.
+  bool cm_bgemm_packed(int m, int n, int k,
+                       const cm_bfloat16_t *a, int lda,
+                       const float *packed,
+                       float *c, int ldc,
+                       const float *bias = nullptr, bool accumulate = false);
+
+  /// @brief 8 bits integer matrix multiplication with a transposed right operand, C = (A - za).(B - zb)t accumulated in int32.
+  /// A is unsigned and B is signed, which is the operand order of the u8 x s8 dot product instructions (VNNI vpdpbusd).
+  /// The other sign combinations are mapped onto this one with cm_qgemm_flip_sign, which shifts the values and the zero point by 128.
+  /// The raw products are accumulated without the zero points, then corrected with the row sums of A and B.
+  /// @param za the zero point of A
+  /// @param zb optional vector of n zero points, one per row of B (per channel quantization). May be null.
+  /// @param bSums optional vector of the n row sums of B, as computed by cm_qgemm_sum_b. May be null.
+  /// @return false if the working memory cannot be allocated.
+  bool cm_qgemm_nt(int m, int n, int k,
+                   const uint8_t *a, int lda, int32_t za,
+                   const int8_t *b, int ldb, const int32_t *zb,
+                   int32_t *c, int ldc,
+                   const int32_t *bSums = nullptr);
+
+  /// @brief Sum the k values of every row of a right operand [n x k]. This is done once, at model load, for the constant weights.
+  void cm_qgemm_sum_b(int n, int k, const int8_t *b, int ldb, int32_t *sums);
+
+  /// @brief Flip the sign bit of n bytes, which maps int8 onto uint8 (x + 128) and uint8 onto int8 (x - 128).
+  /// The zero point is shifted by the same amount, so (x - z) is unchanged.
+  void cm_qgemm_flip_sign(const void *src, void *dst, size_t n);
+}
+#endif
\ No newline at end of file
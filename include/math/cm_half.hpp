@@ -0,0 +1,125 @@
+#ifndef _CM_HALF__
+#define _CM_HALF__
+
+#include "cm.h"
+#include "math/cm_tensor.hpp"
+
+namespace CyanMycelium
+{
+  /// @brief convert IEEE754 half bits to float.
+  inline float cm_half_to_float(uint16_t h)
+  {
+    uint32_t sign = (uint32_t)(h & 0x8000) << 16;
+    uint32_t em = h & 0x7fff;
+    uint32_t bits;
+    if (em >= 0x7c00)
+    {
+      // inf & nan
+      bits = 0x7f800000 | ((em & 0x3ff) << 13);
+    }
+    else if (em >= 0x400)
+    {
+      // normal, rebias the exponent from 15 to 127
+      bits = (em << 13) + 0x38000000;
+    }
+    else
+    {
+      // subnormal, em * 2^-24 is exact in float
+      float f = (float)em * 5.9604644775390625e-8f;
+      cm_memcpy(&bits, &f, sizeof(float));
+    }
+    bits |= sign;
+    float f;
+    cm_memcpy(&f, &bits, sizeof(float));
+    return f;
+  }
+
+  /// @brief convert float to IEEE754 half bits, rounding to nearest even.
+  inline uint16_t cm_float_to_half(float f)
+  {
+    uint32_t x;
+    cm_memcpy(&x, &f, sizeof(float));
+    uint16_t sign = (uint16_t)((x >> 16) & 0x8000);
+    x &= 0x7fffffff;
+    if (x >= 0x7f800000)
+    {
+      return sign | (x > 0x7f800000 ? 0x7e00 : 0x7c00);
+    }
+    // 65520 and above round to inf
+    if (x >= 0x477ff000)
+    {
+      return sign | 0x7c00;
+    }
+    if (x < 0x38800000)
+    {
+      // below 2^-14 the result is subnormal, adding 0.5 aligns the mantissa on the half ulp and lets the FPU round.
+      float a;
+      cm_memcpy(&a, &x, sizeof(float));
+      a += 0.5f;
+      uint32_t r;
+      cm_memcpy(&r, &a, sizeof(float));
+      return sign | (uint16_t)(r - 0x3f000000);
+    }
+    // rebias the exponent from 127 to 15 and round the 13 dropped bits to nearest even.
+    x += 0xc8000fff + ((x >> 13) & 1);
+    return sign | (uint16_t)(x >> 13);
+  }
+
+  /// @brief convert bfloat16 bits to float.
+  inline float cm_bfloat16_to_float(uint16_t h)
+  {
+    uint32_t bits = (uint32_t)h << 16;
+    float f;
+    cm_memcpy(&f, &bits, sizeof(float));
+    return f;
+  }
+
+  /// @brief convert float to bfloat16 bits, rounding to nearest even.
+  inline uint16_t cm_float_to_bfloat16(float f)
+  {
+    uint32_t x;
+    cm_memcpy(&x, &f, sizeof(float));
+    if ((x & 0x7fffffff) > 0x7f800000)
+    {
+      // keep nan quiet
+      return (uint16_t)((x >> 16) | 0x40);
+    }
+    return (uint16_t)((x + 0x7fff + ((x >> 16) & 1)) >> 16);
+  }
+
+  /// @brief TDT_FLOAT16 storage. Arithmetic is done in float.
+  struct cm_half_t
+  {
+    uint16_t Bits;
+    cm_half_t() = default;
+    cm_half_t(float f) : Bits(cm_float_to_half(f)) {}
+    operator float() const { return cm_half_to_float(Bits); }
+  };
+
+  /// @brief TDT_BFLOAT16 storage. Arithmetic is done in float.
+  struct cm_bfloat16_t
+  {
+    uint16_t Bits;
+    cm_bfloat16_t() = default;
+    cm_bfloat16_t(float f) : Bits(cm_float_to_bfloat16(f)) {}
+    operator float() const { return cm_bfloat16_to_float(Bits); }
+  };
+
+  /// @brief true if the type is a 16 bits float storage computed in float.
+  inline bool cm_is_half(tensor_data_type_t type) { return type == TDT_FLOAT16 || type == TDT_BFLOAT16; }
+
+  // Bulk conversions, vectorized with F16C and AVX512-BF16 when the target supports them.
+  void cm_to_float(const cm_half_t *src, float *dst, size_t n);
+  void cm_to_float(const cm_bfloat16_t *src, float *dst, size_t n);
+  void cm_from_float(const float *src, cm_half_t *dst, size_t n);
+  void cm_from_float(const float *src, cm_bfloat16_t *dst, size_t n);
+
+  /// @brief convert n items of a half type to float.
+  /// @return false if the type is not a half type.
+  bool cm_to_float(tensor_data_type_t type, const void *src, float *dst, size_t n);
+
+  /// @brief convert n floats to a half type.
+  /// @return false if the type is not a half type.
+  bool cm_from_float(tensor_data_type_t type, const float *src, void *dst, size_t n);
+}
+#endif
@@ -0,0 +1,76 @@
+#ifndef _CM_SIMD__
+#define _CM_SIMD__
+
+#include "cm.h"
+
+namespace CyanMycelium
+{
+  // Number of float lanes processed together by the math kernels.
+  // The vector type relies on the GCC vector extension, which is lowered to
+  // SSE/AVX/NEON when available and to plain scalar code on micro-controllers.
+#ifndef CM_SIMD_WIDTH
+#if defined(__AVX__)
+#define CM_SIMD_WIDTH 8
+#else
+#define CM_SIMD_WIDTH 4
+#endif
+#endif
+
+  typedef float cm_vfloat_t __attribute__((vector_size(CM_SIMD_WIDTH * sizeof(float))));
+  // the type of the float comparisons, and of the bit operations on the floats.
+  typedef int32_t cm_vint_t __attribute__((vector_size(CM_SIMD_WIDTH * sizeof(int32_t))));
+
+  /// @brief load CM_SIMD_WIDTH floats from a possibly unaligned address.
+  inline cm_vfloat_t cm_vload(const float *p)
+  {
+    cm_vfloat_t v;
+    __builtin_memcpy(&v, p, sizeof(v));
+    return v;
+  }
+
+  /// @brief store CM_SIMD_WIDTH floats to a possibly unaligned address.
+  inline void cm_vstore(float *p, cm_vfloat_t v) { __builtin_memcpy(p, &v, sizeof(v)); }
+
+  /// @brief load the n < CM_SIMD_WIDTH first floats from p, the other lanes being 0, for the tail of the loops.
+  inline cm_vfloat_t cm_vload_partial(const float *p, size_t n)
+  {
+    cm_vfloat_t v = {};
+    for (size_t i = 0; i != n; i++)
+    {
+      v[i] = p[i];
+    }
+    return v;
+  }
+
+  /// @brief store the n < CM_SIMD_WIDTH first lanes to p.
+  inline void cm_vstore_partial(float *p, cm_vfloat_t v, size_t n)
+  {
+    for (size_t i = 0; i != n; i++)
+    {
+      p[i] = v[i];
+    }
+  }
+
+  /// @brief broadcast a scalar over all the lanes.
+  inline cm_vfloat_t cm_vset1(float a)
+  {
+    cm_vfloat_t v = {};
+    return v + a;
+  }
+
+  inline cm_vfloat_t cm_vmax(cm_vfloat_t a, cm_vfloat_t b) { return a > b ? a : b; }
+
+  inline cm_vfloat_t cm_vmin(cm_vfloat_t a, cm_vfloat_t b) { return a < b ? a : b; }
+
+  /// @brief horizontal sum of the lanes.
+  inline float cm_vsum(cm_vfloat_t v)
+  {
+    float s = 0;
+    for (int i = 0; i != CM_SIMD_WIDTH; i++)
+    {
+      s += v[i];
+    }
+    return s;
+  }
+}
+#endif
@@ -4,7 +4,9 @@
 
 namespace CyanMycelium
 {
-#define TENSOR_MAX_DIMENSION 3
+#define TENSOR_MAX_DIMENSION 4
+// the size of a dimension known at runtime only, as the symbolic dimensions (batch, sequence length) of a model.
+#define TENSOR_DYNAMIC_DIM 0
 
     typedef enum
     {
@@ -65,6 +67,9 @@ namespace CyanMycelium
         uint64_t Shape[TENSOR_MAX_DIMENSION]; // shape of tensor.
 
         bool AreShapesEqual(TensorInfos *other);
+
+        /// @brief true if the size of a dimension is TENSOR_DYNAMIC_DIM, so the shape is only known at runtime.
+        bool IsDynamic();
     };
 
     class Tensor : public TensorInfos
@@ -76,7 +81,7 @@ namespace CyanMycelium
         /// @brief build a tensor using shape and dimension
         /// @param shape the shape as an array of the size of each dimension
         /// @param dimension the number of axes or indices required to access the elements of the tensor.
-        Tensor(const uint64_t *shape, int dimension, tensor_data_type_t type = TDT_UNDEFINED) : TensorInfos(shape, dimension, type)
+        Tensor(const uint64_t *shape, int dimension, tensor_data_type_t type = TDT_UNDEFINED) : TensorInfos(shape, dimension, type), Data(nullptr)
         {
         }
 
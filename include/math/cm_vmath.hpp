@@ -0,0 +1,170 @@
+#ifndef _CM_VMATH__
+#define _CM_VMATH__
+
+#include "math/cm_simd.hpp"
+
+namespace CyanMycelium
+{
+  // The transcendental functions over the lanes of a vector. They are range reductions and polynomial approximations
+  // written with the vector operators only, so they are lowered to SSE/AVX/NEON as the other kernels, and to scalar code
+  // on the micro-controllers. The errors are the largest ones measured against the double precision libm over the valid
+  // range, see samples/bench_vmath.cpp. NaN is propagated and the subnormal results are flushed to zero.
+
+  /// @brief select a where the mask is set, b otherwise.
+  inline cm_vfloat_t cm_vselect(cm_vint_t mask, cm_vfloat_t a, cm_vfloat_t b) { return (cm_vfloat_t)((mask & (cm_vint_t)a) | (~mask & (cm_vint_t)b)); }
+
+  /// @brief e^x, 1 ULP. x = n ln2 + r with |r| <= ln2 / 2, e^r is a degree 6 polynomial and 2^n is built into the exponent.
+  /// x is clamped to [-88, 89] first, where n is in [-127, 128]: 2^-127 is built as 0, which flushes the subnormal results,
+  /// and 2^128 as 2^127 * 2, which overflows to +inf.
+  inline cm_vfloat_t cm_vexp(cm_vfloat_t x)
+  {
+    // the comparisons are false for NaN, which goes through the whole computation.
+    cm_vfloat_t c = x < -88.0f ? cm_vset1(-88.0f) : x;
+    c = c > 89.0f ? cm_vset1(89.0f) : c;
+    // adding 1.5 * 2^23 rounds to the nearest integer, which is then in the low bits of t.
+    cm_vfloat_t t = c * 1.44269504088896341f + 12582912.0f;
+    cm_vfloat_t n = t - 12582912.0f;
+    cm_vint_t k = (cm_vint_t)t - 0x4b400000;
+    // ln2 is split in two, so n * ln2 is exact enough to keep the bits of r.
+    cm_vfloat_t r = c - n * 0.693359375f + n * 2.12194440e-4f;
+    cm_vfloat_t p = cm_vset1(1.9875691500e-4f);
+    p = p * r + 1.3981999507e-3f;
+    p = p * r + 8.3334519073e-3f;
+    p = p * r + 4.1665795894e-2f;
+    p = p * r + 1.6666665459e-1f;
+    p = p * r + 5.0000001201e-1f;
+    cm_vint_t high = k > 127;
+    cm_vfloat_t scale = (cm_vfloat_t)(((high ? k - 1 : k) + 127) << 23);
+    cm_vfloat_t y = (p * (r * r) + r + 1.0f) * scale;
+    return high ? y + y : y;
+  }
+
+  /// @brief the natural logarithm, 1 ULP. x = 2^e m with sqrt(1/2) <= m < sqrt(2), log(m) is a degree 9 polynomial of m - 1.
+  /// log(0) is -inf, log(+inf) is +inf and the negative values give NaN.
+  inline cm_vfloat_t cm_vlog(cm_vfloat_t x)
+  {
+    // the subnormals are scaled into the normal range first.
+    cm_vint_t tiny = x < 1.17549435e-38f;
+    cm_vfloat_t s = cm_vselect(tiny, x * 8388608.0f, x);
+    cm_vint_t bits = (cm_vint_t)s;
+    cm_vfloat_t e = __builtin_convertvector(((bits >> 23) & 0xff) - 126, cm_vfloat_t);
+    e = cm_vselect(tiny, e - 23.0f, e);
+    // m in [0.5, 1), then in [sqrt(1/2), sqrt(2)) - 1.
+    cm_vfloat_t m = (cm_vfloat_t)((bits & 0x007fffff) | 0x3f000000);
+    cm_vint_t low = m < 0.707106781186547524f;
+    e = cm_vselect(low, e - 1.0f, e);
+    m = cm_vselect(low, m + m, m) - 1.0f;
+    cm_vfloat_t z = m * m;
+    cm_vfloat_t p = cm_vset1(7.0376836292e-2f);
+    p = p * m - 1.1514610310e-1f;
+    p = p * m + 1.1676998740e-1f;
+    p = p * m - 1.2420140846e-1f;
+    p = p * m + 1.4249322787e-1f;
+    p = p * m - 1.6668057665e-1f;
+    p = p * m + 2.0000714765e-1f;
+    p = p * m - 2.4999993993e-1f;
+    p = p * m + 3.3333331174e-1f;
+    cm_vfloat_t y = p * m * z - e * 2.12194440e-4f - 0.5f * z;
+    y = m + y + e * 0.693359375f;
+    y = x == 0.0f ? cm_vset1(-__builtin_inff()) : y;
+    y = x == __builtin_inff() ? x : y;
+    y = x < 0.0f ? cm_vset1(__builtin_nanf("")) : y;
+    return x == x ? y : x;
+  }
+
+  /// @brief the hyperbolic tangent, 2 ULP. An odd polynomial below 0.625, where 1 - 2 / (e^2|x| + 1) would cancel, and the
+  /// exponential above it.
+  inline cm_vfloat_t cm_vtanh(cm_vfloat_t x)
+  {
+    cm_vint_t sign = (cm_vint_t)x & (int32_t)0x80000000;
+    cm_vfloat_t a = (cm_vfloat_t)((cm_vint_t)x & 0x7fffffff);
+    cm_vfloat_t z = x * x;
+    cm_vfloat_t p = cm_vset1(-5.70498872745e-3f);
+    p = p * z + 2.06390887954e-2f;
+    p = p * z - 5.37397155531e-2f;
+    p = p * z + 1.33314422036e-1f;
+    p = p * z - 3.33332819422e-1f;
+    cm_vfloat_t small = p * z * x + x;
+    // e^2|x| overflows to +inf for the large values, which gives 1.
+    cm_vfloat_t large = 1.0f - 2.0f / (cm_vexp(a + a) + 1.0f);
+    large = (cm_vfloat_t)((cm_vint_t)large | sign);
+    return a < 0.625f ? small : large;
+  }
+
+  /// @brief the logistic function 1 / (1 + e^-x), 2.5 ULP.
+  inline cm_vfloat_t cm_vsigmoid(cm_vfloat_t x) { return 1.0f / (1.0f + cm_vexp(-x)); }
+
+  /// @brief the error function, 2 ULP. x P(x^2) below 1, and 1 - e^-x^2 Q(x) above it, where erfc(x) e^x^2 is smooth. erf is 1
+  /// to the float precision above 3.92, x is clamped to 4.
+  inline cm_vfloat_t cm_verf(cm_vfloat_t x)
+  {
+    cm_vfloat_t a = (cm_vfloat_t)((cm_vint_t)x & 0x7fffffff);
+    a = a > 4.0f ? cm_vset1(4.0f) : a;
+    cm_vfloat_t z = a * a;
+    cm_vfloat_t p = cm_vset1(-5.6480598655e-4f);
+    p = p * z + 4.9217620279e-3f;
+    p = p * z - 2.6715054232e-2f;
+    p = p * z + 1.1280316653e-1f;
+    p = p * z - 3.7612343775e-1f;
+    p = p * z + 1.283791262e-1f;
+    // a + a p rather than a (1 + p), the rounding of p is scaled by 0.128.
+    cm_vfloat_t small = a + a * p;
+    // Q is a polynomial of a mapped from [1, 4] to [-1, 1].
+    cm_vfloat_t t = a * 0.666666667f - 1.66666667f;
+    cm_vfloat_t q = cm_vset1(9.2949742990e-5f);
+    q = q * t - 2.4518645151e-4f;
+    q = q * t + 3.7647727472e-4f;
+    q = q * t - 9.1627260265e-4f;
+    q = q * t + 2.4183842292e-3f;
+    q = q * t - 5.6112336366e-3f;
+    q = q * t + 1.2486699636e-2f;
+    q = q * t - 2.6997937418e-2f;
+    q = q * t + 5.6110627994e-2f;
+    q = q * t - 1.1152139054e-1f;
+    q = q * t + 2.1080636406e-1f;
+    cm_vfloat_t large = 1.0f - cm_vexp(-z) * q;
+    cm_vfloat_t y = a < 1.0f ? small : large;
+    y = (cm_vfloat_t)((cm_vint_t)y | ((cm_vint_t)x & (int32_t)0x80000000));
+    return x == x ? y : x;
+  }
+
+  /// @brief the gaussian error linear unit x / 2 (1 + erf(x / sqrt(2))). 1 + erf cancels for the negative values, where the
+  /// error is absolute, 5e-7 at most over [-10, 10].
+  inline cm_vfloat_t cm_vgelu(cm_vfloat_t x) { return 0.5f * x * (1.0f + cm_verf(x * 0.707106781186547524f)); }
+
+  /// @brief the tanh approximation of GELU, x / 2 (1 + tanh(sqrt(2 / pi) (x + 0.044715 x^3))), as the exporters emit it.
+  inline cm_vfloat_t cm_vgelu_tanh(cm_vfloat_t x) { return 0.5f * x * (1.0f + cm_vtanh(0.797884560802865356f * (x + 0.044715f * x * x * x))); }
+
+  /// @brief y = f(x) over n contiguous floats, y may be x. Two vectors per iteration, so the latency of a polynomial is hidden
+  /// by the other one. The tail is computed on a partial vector, so every item gets the same rounding whatever its position.
+  template <typename F>
+  inline void cm_vmap(const float *x, float *y, size_t n, F f)
+  {
+    size_t i = 0;
+    for (; i + 2 * CM_SIMD_WIDTH <= n; i += 2 * CM_SIMD_WIDTH)
+    {
+      cm_vfloat_t a = f(cm_vload(x + i));
+      cm_vfloat_t b = f(cm_vload(x + i + CM_SIMD_WIDTH));
+      cm_vstore(y + i, a);
+      cm_vstore(y + i + CM_SIMD_WIDTH, b);
+    }
+    for (; i + CM_SIMD_WIDTH <= n; i += CM_SIMD_WIDTH)
+    {
+      cm_vstore(y + i, f(cm_vload(x + i)));
+    }
+    if (i != n)
+    {
+      cm_vstore_partial(y + i, f(cm_vload_partial(x + i, n - i)), n - i);
+    }
+  }
+
+  // The functions over n contiguous floats, y may be x.
+  void cm_exp(const float *x, float *y, size_t n);
+  void cm_log(const float *x, float *y, size_t n);
+  void cm_tanh(const float *x, float *y, size_t n);
+  void cm_sigmoid(const float *x, float *y, size_t n);
+  void cm_erf(const float *x, float *y, size_t n);
+  void cm_gelu(const float *x, float *y, size_t n);
+  void cm_gelu_tanh(const float *x, float *y, size_t n);
+}
+#endif
@@ -12,7 +12,7 @@ namespace CyanMycelium
 #define LESS Less
 #define MAX Max
 #define MIN Min
-#define MULT Mult
+#define MUL Mul
 #define OR Or
 #define POW Pow
 #define SUB Sub
@@ -27,7 +27,7 @@ namespace CyanMycelium
   BINARY_OP_DECL(LESS)
   BINARY_OP_DECL(MAX)
   BINARY_OP_DECL(MIN)
-  BINARY_OP_DECL(MULT)
+  BINARY_OP_DECL(MUL)
   BINARY_OP_DECL(OR)
   BINARY_OP_DECL(POW)
   BINARY_OP_DECL(SUB)
@@ -1,24 +1,40 @@
 #ifndef __CM_NODES_REGISTRY__
 #define __CM_NODES_REGISTRY__
 
+#include <new>
+
 #include "cm_graph.hpp"
 
 namespace CyanMycelium
 {
 #define CM_NODE_REGISTRY_INITIAL_CAPACITY 128
-#define __REGISTER__NODE(n) _types.Set(#n, []() -> Operator * { return new n(); })
+#define __REGISTER__NODE(n) _types.Set(#n, NodeType{[](void *p) -> Operator * { Operator *op = p ? new (p) n() : new n(); op->TypeName = #n; return op; }, sizeof(n)})
+
+    /// @brief build an operator into the given memory, or into a new one when null.
+    typedef Operator *(*NodeInitializer_fn)(void *placement);
 
-    typedef Operator *(*NodeInitializer_fn)();
+    struct NodeType
+    {
+        NodeInitializer_fn Initializer;
+        size_t Size; // the size of the operator object
+    };
 
     class NodeRegistry
     {
     public:
         NodeRegistry(int initialCapacity = CM_NODE_REGISTRY_INITIAL_CAPACITY);
-        static Operator *ForName(const char *);
+
+        /// @brief create an operator by type name.
+        /// @param placement the memory receiving the operator, of SizeOf bytes at least, or null to allocate it.
+        /// @return the operator, or null if the type is unknown.
+        static Operator *ForName(const char *, void *placement = nullptr);
+
+        /// @brief the size of the operator object of a type, 0 if the type is unknown.
+        static size_t SizeOf(const char *);
 
     private:
         static NodeRegistry __Shared;
-        KeyValueCollection<NodeInitializer_fn> _types;
+        KeyValueCollection<NodeType> _types;
     };
 }
 #endif
\ No newline at end of file
@@ -1,10 +1,17 @@
 #ifndef _CM_NODE_MEAN__
 #define _CM_NODE_MEAN__
-#include "cm_graph.hpp"
+#include "nodes/math/cm_reduce.hpp"
 
 namespace CyanMycelium
 {
 #define MEAN Mean
-   UNARY_OP_DECL(MEAN)
+
+   /// @brief Mean of all the items of the input, as a scalar.
+   class Mean : public ReduceOperator
+   {
+   public:
+      Mean() : ReduceOperator(ReduceKind::Mean) { this->KeepDims = 0; }
+   };
+   typedef Mean *MeanPtr;
 }
-#endif
\ No newline at end of file
+#endif
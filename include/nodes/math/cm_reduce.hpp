@@ -0,0 +1,92 @@
+#ifndef _CM_NODE_REDUCE__
+#define _CM_NODE_REDUCE__
+#include "cm_graph.hpp"
+
+namespace CyanMycelium
+{
+#define REDUCE_MEAN ReduceMean
+#define REDUCE_SUM ReduceSum
+#define REDUCE_MAX ReduceMax
+#define REDUCE_MIN ReduceMin
+#define REDUCE_L2 ReduceL2
+
+#define REDUCE_DATA_INDEX 0
+#define REDUCE_AXES_INDEX 1
+
+   enum class ReduceKind
+   {
+      Sum,
+      Mean,
+      Max,
+      Min,
+      L2
+   };
+
+   /// @brief The reduction of a tensor, once the size 1 axes are removed and the adjacent axes of the same kind are merged.
+   /// A reduction over axes {1,2} of a [2,3,4,5] tensor is planned as [2,12,5] with the middle group reduced.
+   struct ReducePlan
+   {
+      int Count;                              // number of groups
+      size_t Sizes[TENSOR_MAX_DIMENSION + 1]; // number of items of each group
+      bool Reduced[TENSOR_MAX_DIMENSION + 1]; // true if the group is reduced
+      size_t ReducedCount;                    // number of input items reduced into every output item
+   };
+
+   typedef bool (*ReduceFunctionPtr)(ActivationContext *ctx, ReduceKind kind, ReducePlan *plan, Tensor *x, Tensor *out);
+
+   extern const ReduceFunctionPtr ReduceFunctionArray[TDT_COUNT];
+
+   /// @brief Reduce x over the flagged axes into out, which must already hold the reduced shape.
+   /// Integers are accumulated into 64 bits and floats into double, float inputs use several independent SIMD accumulators
+   /// flushed by blocks. Reductions over the inner axes read contiguous rows, reductions over the outer axes accumulate
+   /// cache sized tiles of consecutive columns. The reduction of an empty x is the identity of the operation, NaN for Mean.
+   /// @param ctx the activation context providing the engine and the memory manager
+   /// @param kind the reduction
+   /// @param x the input
+   /// @param reduced for every axis of x, true if the axis is reduced
+   /// @param out the output
+   /// @return true if succeed
+   bool Reduce(ActivationContext *ctx, ReduceKind kind, Tensor *x, const bool *reduced, Tensor *out);
+
+   /// @brief The ONNX ReduceXXX operators. Axes are read from the attribute (opset < 18) or from the optional second input.
+   class ReduceOperator : public Operator
+   {
+   public:
+      ReduceOperator(ReduceKind kind) : Operator() { this->_kind = kind; }
+
+      int Axes[TENSOR_MAX_DIMENSION];
+      int AxesCount = 0;
+      int KeepDims = 1;
+      int NoopWithEmptyAxes = 0;
+
+      bool Activate(ActivationContext *ctx) override;
+      bool TrySetAtt(const char *n, Att_value_t v) override;
+      void GetAtts(AttWriter *writer) override;
+      bool InferShapes(Tensor **infos) override;
+
+   protected:
+      ReduceKind _kind;
+
+      /// @brief the axes of the input when it holds a value, or of the attribute otherwise.
+      /// @return false if there are more axes than a tensor has dimensions.
+      bool _getAxes(Tensor *input, int *axes, int *count);
+      /// @brief flag the reduced axes of x and compute the shape of the output.
+      /// @return false if an axis is out of range.
+      bool _getReducedShape(Tensor *x, const int *axes, int axesCount, bool *reduced, uint64_t *shape, int *dimension);
+   };
+
+#define REDUCE_OP_DECL(name, kind)                        \
+   class name : public ReduceOperator                     \
+   {                                                      \
+   public:                                                \
+      name() : ReduceOperator(ReduceKind::kind){};        \
+   };                                                     \
+   typedef name *name##Ptr;
+
+   REDUCE_OP_DECL(REDUCE_MEAN, Mean)
+   REDUCE_OP_DECL(REDUCE_SUM, Sum)
+   REDUCE_OP_DECL(REDUCE_MAX, Max)
+   REDUCE_OP_DECL(REDUCE_MIN, Min)
+   REDUCE_OP_DECL(REDUCE_L2, L2)
+}
+#endif
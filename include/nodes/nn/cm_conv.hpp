@@ -0,0 +1,143 @@
+#ifndef _CM_NODE_CONV__
+#define _CM_NODE_CONV__
+#include "cm_graph.hpp"
+
+namespace CyanMycelium
+{
+#define CONV_X_INDEX 0
+#define CONV_W_INDEX 1
+#define CONV_B_INDEX 2
+
+// the number of spatial axes supported, 1D and 2D.
+#define CONV_MAX_SPATIAL_RANK 2
+// up to this number of multiply-adds per output value (C / group x kernel size), the direct kernel beats im2col + GEMM
+// on the rows of stride 1.
+#define CONV_DIRECT_MAX_DEPTH 32
+// the number of output channels computed together by the direct kernel, so every input row is read once for all of them.
+#define CONV_DIRECT_BLOCK 4
+// Winograd pays off once the products of the 16 transformed positions are deep enough, per group.
+#define CONV_WINOGRAD_MIN_CHANNELS 16
+// size in bytes of the unfolded patches processed at once by im2col and Winograd, or of the input band gathered by the
+// grouped kernel, which bounds their working memory.
+#define CONV_TILE_SIZE (128 * 1024)
+// the number of output pixels accumulated together by the grouped kernel, every vector of W being read once for all of them.
+#define CONV_GROUPED_PIXELS 4
+// up to this number of output channels per group, the grouped kernel beats a GEMM per group (measured with bench_conv).
+#define CONV_GROUPED_MAX_FEATURES 8
+
+   enum class ConvAutoPad
+   {
+      NOTSET,
+      SAME_UPPER,
+      SAME_LOWER,
+      VALID
+   };
+
+   /// @brief The algorithms of the convolution. The algorithm is chosen per shape at load time by Prepack,
+   /// which also prepares W into the layout of the algorithm.
+   enum class ConvAlgorithm
+   {
+      AUTO,     // chosen by Prepack from the shapes of W and X
+      IM2COL,   // the patches of X are unfolded into rows, then multiplied by W with the packed GEMM
+      DIRECT,   // a kernel accumulating the window over several output channels at once, for the small channel counts
+      WINOGRAD, // F(2x2, 3x3) for the 3x3 kernels with stride and dilation 1, 16 multiplies per 2x2 outputs instead of 36
+      GROUPED,  // depthwise and grouped convolutions: the output channels are the lanes of the vectors, their inputs being
+                // gathered into a blocked layout where the channels of a pixel are contiguous
+   };
+
+   /// @brief The activation applied to the outputs as they are stored.
+   enum class ConvActivation
+   {
+      NONE,
+      RELU
+   };
+
+   /// @brief The geometry of a convolution. A 1D convolution is seen as a 2D one of height 1.
+   struct ConvGeometry
+   {
+      int Rank; // the number of spatial axes of X
+      int Batch;
+      int Channels;
+      int Height; // 0 when the shape of X is unknown
+      int Width;
+      int Features;
+      int KernelHeight;
+      int KernelWidth;
+      int Group;
+      int StrideH;
+      int StrideW;
+      int DilationH;
+      int DilationW;
+      int PadTop;
+      int PadLeft;
+      int PadBottom;
+      int PadRight;
+      int OutHeight;
+      int OutWidth;
+   };
+
+   /// @brief Y = X * W + B over X [N, C, (H,) W] and W [M, C / group, (kH,) kW], with strides, padding, dilations and groups.
+   /// The tensors are float, or half: X is then unfolded by im2col as is and multiplied in float, Y being rounded as it is stored.
+   /// @link https://onnx.ai/onnx/operators/onnx__Conv.html
+   class Conv : public Operator
+   {
+   public:
+      Conv() : Operator(), Group(1), KernelRank(0), StrideCount(0), DilationCount(0), PadCount(0), AutoPad(ConvAutoPad::NOTSET),
+               Algorithm(ConvAlgorithm::AUTO), Activation(ConvActivation::NONE), _packed(nullptr), _packedExternal(false){};
+      ~Conv() override;
+
+      int Group;
+      int KernelShape[CONV_MAX_SPATIAL_RANK];
+      int KernelRank; // 0 when the kernel shape is read from W
+      int Strides[CONV_MAX_SPATIAL_RANK];
+      int StrideCount;
+      int Dilations[CONV_MAX_SPATIAL_RANK];
+      int DilationCount;
+      int Pads[2 * CONV_MAX_SPATIAL_RANK]; // the beginning of every axis, then their end
+      int PadCount;
+      ConvAutoPad AutoPad;
+
+      /// @brief the algorithm, AUTO until Prepack chooses one. Setting it before Prepack forces the algorithm when the shape allows it.
+      ConvAlgorithm Algorithm;
+
+      /// @brief the activation fused with the bias, folded from the Relu following the node at load time.
+      /// Saved as the "activation" attribute.
+      ConvActivation Activation;
+
+      bool Activate(ActivationContext *ctx) override;
+      bool TrySetAtt(const char *n, Att_value_t v) override;
+      void GetAtts(AttWriter *writer) override;
+      bool InferShapes(Tensor **infos) override;
+
+      /// @brief Fold a following Relu into the activation.
+      bool Fuse(Operator *next) override;
+
+      /// @brief Choose the algorithm from the shapes of W and X, then prepare W for it when W is an initializer:
+      /// packed per group for im2col, transformed then packed per group and per position for Winograd, interleaved by
+      /// blocks of output channels for the grouped kernel. A half W is converted to float as it is packed.
+      bool Prepack() override;
+
+      /// @brief Save the algorithm and the prepared W.
+      size_t SavePacked(void *buffer) override;
+      bool LoadPacked(const void *data, size_t size) override;
+
+      /// @brief Get the geometry of the convolution of x by w.
+      /// @param x the infos of X, or null when only W is known. The spatial sizes are then 0.
+      /// @return false if the shapes do not fit the attributes or each other.
+      bool GetGeometry(TensorInfos *x, TensorInfos *w, ConvGeometry *g);
+
+      /// @brief the algorithm of a geometry, the one requested when the geometry allows it.
+      static ConvAlgorithm Choose(ConvGeometry *g, ConvAlgorithm requested = ConvAlgorithm::AUTO);
+
+   private:
+      // the W prepared by Prepack, null if W is a runtime input or the algorithm uses W as is.
+      float *_packed;
+      // the packed data belongs to a compiled model, see LoadPacked.
+      bool _packedExternal;
+
+      /// @brief the size in floats of the W prepared for an algorithm.
+      static size_t _getPackedSize(ConvGeometry *g, ConvAlgorithm algorithm);
+   };
+   typedef Conv *ConvPtr;
+}
+#endif
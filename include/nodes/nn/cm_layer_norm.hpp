@@ -0,0 +1,42 @@
+#ifndef _CM_NODE_LAYER_NORM__
+#define _CM_NODE_LAYER_NORM__
+#include "cm_graph.hpp"
+
+namespace CyanMycelium
+{
+#define LAYER_NORM_X_INDEX 0
+#define LAYER_NORM_SCALE_INDEX 1
+#define LAYER_NORM_B_INDEX 2
+
+#define LAYER_NORM_Y_INDEX 0
+#define LAYER_NORM_MEAN_INDEX 1
+#define LAYER_NORM_INV_STD_DEV_INDEX 2
+
+   /// @brief The normalization of X over the axes [Axis, rank), X being seen as rows of the normalized size. Every row is
+   /// read twice: the first pass sums the items and their squares, shifted by the first item of the row so the variance does
+   /// not cancel out, the second one writes (x - mean) / sqrt(var + Epsilon) * Scale + B. The scale is optional so the
+   /// decomposed graphs without affine transform can be folded, see OnnxGraphBuilder. Only float tensors are supported.
+   class LayerNormalization : public Operator
+   {
+   public:
+      LayerNormalization() : Operator(), Axis(-1), Epsilon(1e-5f), StashType(1){};
+
+      int Axis;
+      float Epsilon;
+      /// @brief the type of the mean and inverse standard deviation, the statistics are always computed in double.
+      int StashType;
+
+      bool Activate(ActivationContext *ctx) override;
+      bool TrySetAtt(const char *n, Att_value_t v) override;
+      void GetAtts(AttWriter *writer) override;
+      bool InferShapes(Tensor **infos) override;
+
+   protected:
+      /// @brief the number of rows and their size, and the shape of the statistics.
+      /// @return false if the axis is out of range.
+      bool _getRows(Tensor *x, size_t *rows, size_t *size, uint64_t *statShape);
+   };
+
+   typedef LayerNormalization *LayerNormalizationPtr;
+}
+#endif
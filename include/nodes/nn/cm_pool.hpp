@@ -0,0 +1,107 @@
+#ifndef _CM_NODE_POOL__
+#define _CM_NODE_POOL__
+#include "nodes/math/cm_reduce.hpp"
+#include "nodes/nn/cm_conv.hpp"
+
+namespace CyanMycelium
+{
+#define POOL_X_INDEX 0
+
+#define POOL_Y_INDEX 0
+#define POOL_INDICES_INDEX 1
+
+// size in bytes of the input band gathered at once for a block of planes, which bounds the working memory of the pools.
+#define POOL_TILE_SIZE (64 * 1024)
+// the number of output pixels computed together, so the windows of neighbour pixels are reduced in parallel.
+#define POOL_PIXELS 4
+
+   enum class PoolKind
+   {
+      MAX,
+      AVERAGE
+   };
+
+   /// @brief The sliding window pools over X [N, C, (H,) W], with kernel, strides, padding, dilations and ceil mode.
+   /// The N x C planes are pooled by blocks of CM_SIMD_WIDTH: a band of output rows gathers the input rows it reads with
+   /// their padding, the planes of the block being the lanes of the vectors, so the windows are read without any test.
+   /// Only float tensors are supported.
+   class PoolOperator : public Operator
+   {
+   public:
+      PoolOperator(PoolKind kind) : Operator(), KernelRank(0), StrideCount(0), DilationCount(0), PadCount(0), AutoPad(ConvAutoPad::NOTSET),
+                                    CeilMode(0), CountIncludePad(0), StorageOrder(0), _kind(kind){};
+
+      int KernelShape[CONV_MAX_SPATIAL_RANK];
+      int KernelRank;
+      int Strides[CONV_MAX_SPATIAL_RANK];
+      int StrideCount;
+      int Dilations[CONV_MAX_SPATIAL_RANK];
+      int DilationCount;
+      int Pads[2 * CONV_MAX_SPATIAL_RANK]; // the beginning of every axis, then their end
+      int PadCount;
+      ConvAutoPad AutoPad;
+      /// @brief 1 if the output size is rounded up, the last window then overlapping the end of the input.
+      int CeilMode;
+      /// @brief AveragePool only, 1 if the padding is counted into the divisor.
+      int CountIncludePad;
+      /// @brief MaxPool only, 1 if the indices are computed in column major order.
+      int StorageOrder;
+
+      bool Activate(ActivationContext *ctx) override;
+      bool TrySetAtt(const char *n, Att_value_t v) override;
+      void GetAtts(AttWriter *writer) override;
+      bool InferShapes(Tensor **infos) override;
+
+      /// @brief Get the geometry of the pooling of x, seen as a depthwise convolution: Channels, Features and Group are C.
+      /// @return false if the shape of x does not fit the attributes.
+      bool GetGeometry(TensorInfos *x, ConvGeometry *g);
+
+   protected:
+      PoolKind _kind;
+   };
+
+#define POOL_OP_DECL(name, kind)               \
+   class name : public PoolOperator            \
+   {                                           \
+   public:                                     \
+      name() : PoolOperator(PoolKind::kind){}; \
+   };                                          \
+   typedef name *name##Ptr;
+
+   /// @link https://onnx.ai/onnx/operators/onnx__MaxPool.html
+   POOL_OP_DECL(MaxPool, MAX)
+   /// @link https://onnx.ai/onnx/operators/onnx__AveragePool.html
+   POOL_OP_DECL(AveragePool, AVERAGE)
+
+   /// @brief The pools over the whole spatial axes of X [N, C, ...], into Y [N, C, 1, ...]. They are the reductions of the
+   /// spatial axes, so they share the kernels of ReduceMean and ReduceMax.
+   class GlobalPoolOperator : public Operator
+   {
+   public:
+      GlobalPoolOperator(ReduceKind kind) : Operator() { this->_kind = kind; }
+
+      bool Activate(ActivationContext *ctx) override;
+      bool InferShapes(Tensor **infos) override;
+
+   protected:
+      ReduceKind _kind;
+
+      /// @brief flag the spatial axes of x and compute the shape of the output.
+      /// @return false if x has no spatial axis.
+      bool _getReducedShape(Tensor *x, bool *reduced, uint64_t *shape);
+   };
+
+#define GLOBAL_POOL_OP_DECL(name, kind)                \
+   class name : public GlobalPoolOperator              \
+   {                                                   \
+   public:                                             \
+      name() : GlobalPoolOperator(ReduceKind::kind){}; \
+   };                                                  \
+   typedef name *name##Ptr;
+
+   /// @link https://onnx.ai/onnx/operators/onnx__GlobalAveragePool.html
+   GLOBAL_POOL_OP_DECL(GlobalAveragePool, Mean)
+   /// @link https://onnx.ai/onnx/operators/onnx__GlobalMaxPool.html
+   GLOBAL_POOL_OP_DECL(GlobalMaxPool, Max)
+}
+#endif
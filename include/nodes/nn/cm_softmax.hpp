@@ -0,0 +1,53 @@
+#ifndef _CM_NODE_SOFTMAX__
+#define _CM_NODE_SOFTMAX__
+#include "cm_graph.hpp"
+
+namespace CyanMycelium
+{
+#define SOFTMAX_X_INDEX 0
+#define SOFTMAX_Y_INDEX 0
+
+// the number of consecutive columns normalized together when the axis is not the innermost one.
+#define SOFTMAX_TILE_SIZE 256
+// the first opset normalizing along Axis alone, the former ones coerce X into 2D around it.
+#define SOFTMAX_OPSET_SINGLE_AXIS 13
+
+   /// @brief Softmax and LogSoftmax of X along Axis, X being seen as [outer, n, inner] around the axis (opset 13 semantic).
+   /// A first pass finds the maximum, which is subtracted from every item so exp never overflows. The second pass stores
+   /// exp(x - max) and sums it, then the row, still in cache, is scaled by the inverse of the sum. LogSoftmax only sums the
+   /// exponentials and writes x - max - log(sum). Only float tensors are supported.
+   /// Below opset 13, X is coerced into [outer, n] where n covers every axis from Axis onward, and Axis defaults to 1.
+   class SoftmaxOperator : public Operator
+   {
+   public:
+      SoftmaxOperator(bool log) : Operator(), Axis(-1), Coerced(false), _log(log), _hasAxis(false){};
+
+      int Axis;
+      /// @brief true if X is coerced into 2D around Axis (opset 12 and before). Saved as the "coerced" attribute.
+      bool Coerced;
+
+      bool Activate(ActivationContext *ctx) override;
+      bool TrySetAtt(const char *n, Att_value_t v) override;
+      void GetAtts(AttWriter *writer) override;
+      bool InferShapes(Tensor **infos) override;
+      bool SetOpset(int version) override;
+
+   protected:
+      bool _log;
+      bool _hasAxis; // the model gives the axis, otherwise its default depends on the opset
+   };
+
+#define SOFTMAX_OP_DECL(name, log)               \
+   class name : public SoftmaxOperator           \
+   {                                             \
+   public:                                       \
+      name() : SoftmaxOperator(log){};           \
+   };                                            \
+   typedef name *name##Ptr;
+
+   /// @link https://onnx.ai/onnx/operators/onnx__Softmax.html
+   SOFTMAX_OP_DECL(Softmax, false)
+   /// @link https://onnx.ai/onnx/operators/onnx__LogSoftmax.html
+   SOFTMAX_OP_DECL(LogSoftmax, true)
+}
+#endif
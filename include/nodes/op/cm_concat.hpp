@@ -1,15 +1,29 @@
 #ifndef _CM_NODE_CONCAT_
-#define _CM_NODECONCAT_
+#define _CM_NODE_CONCAT_
 #include "cm_graph.hpp"
 
 namespace CyanMycelium
 {
+#define CONCAT_Y_INDEX 0
+
+    /// @brief The concatenation of the inputs along Axis. When the slices of the inputs are contiguous into the result
+    /// (every axis before Axis has a size of 1), the operators producing the inputs write straight into them, see Link::InSlice,
+    /// and the concatenation costs nothing. Otherwise every input is copied to its place, one contiguous block per outer index.
+    /// @link https://onnx.ai/onnx/operators/onnx__Concat.html
     class Concat : public Operator
     {
     public:
-        Concat() : Operator(){};
-        bool Activate(ActivationContext *ctx) override { return true; }
-    };
+        Concat() : Operator(), Axis(0){};
 
+        int Axis;
+
+        bool Activate(ActivationContext *ctx) override;
+        bool TrySetAtt(const char *n, Att_value_t v) override;
+        void GetAtts(AttWriter *writer) override;
+        bool InferShapes(Tensor **infos) override;
+        bool SupportsInputSlice(int index) override { return true; }
+        bool GetInputSlice(int index, ShapePlan *plan, TensorInfos *output, size_t *offset) override;
+    };
+    typedef Concat *ConcatPtr;
 }
-#endif
\ No newline at end of file
+#endif
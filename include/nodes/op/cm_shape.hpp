@@ -1,5 +1,5 @@
-#ifndef _CM_NODE_RESHAPE_
-#define _CM_NODE_RESHAPE_
+#ifndef _CM_NODE_SHAPE_
+#define _CM_NODE_SHAPE_
 #include "cm_graph.hpp"
 
 namespace CyanMycelium
@@ -15,6 +15,8 @@ namespace CyanMycelium
 
         bool Activate(ActivationContext *ctx) override;
         bool TrySetAtt(const char *n, Att_value_t v) override;
+        bool IsView() override { return true; }
+        bool InferShapes(Tensor **infos) override;
 
     private:
         union
@@ -28,6 +30,9 @@ namespace CyanMycelium
         } _mask;
         int _start;
         int _end;
+
+        // the first axis of the slice, and its length.
+        int _getRange(int dimension, int *start);
     };
 }
 #endif
\ No newline at end of file
@@ -0,0 +1,91 @@
+#ifndef _CM_NODE_MATMUL_INTEGER__
+#define _CM_NODE_MATMUL_INTEGER__
+#include "cm_graph.hpp"
+
+namespace CyanMycelium
+{
+#define MATMUL_INTEGER MatMulInteger
+#define QLINEAR_MATMUL QLinearMatMul
+
+#define MATMUL_INTEGER_A_INDEX 0
+#define MATMUL_INTEGER_B_INDEX 1
+#define MATMUL_INTEGER_A_ZERO_POINT_INDEX 2
+#define MATMUL_INTEGER_B_ZERO_POINT_INDEX 3
+
+#define QLINEAR_MATMUL_A_INDEX 0
+#define QLINEAR_MATMUL_A_SCALE_INDEX 1
+#define QLINEAR_MATMUL_A_ZERO_POINT_INDEX 2
+#define QLINEAR_MATMUL_B_INDEX 3
+#define QLINEAR_MATMUL_B_SCALE_INDEX 4
+#define QLINEAR_MATMUL_B_ZERO_POINT_INDEX 5
+#define QLINEAR_MATMUL_Y_SCALE_INDEX 6
+#define QLINEAR_MATMUL_Y_ZERO_POINT_INDEX 7
+
+   /// @brief A right operand [K x N] prepared for cm_qgemm_nt: transposed to int8 [N x K], with its row sums and one zero point per row.
+   struct QuantizedMatrix
+   {
+      int N;
+      int K;
+      int8_t *Data;
+      int32_t *Sums;
+      int32_t *ZeroPoints;
+   };
+
+   /// @brief Base class of the 8 bits integer matrix products, A [..., M, K] x B [K, N] accumulated in int32.
+   /// uint8 and int8 operands are mapped onto the uint8 x int8 form of cm_qgemm_nt. B is prepared once at load time
+   /// when B and its zero point are initializers, and for every activation otherwise.
+   class QuantizedMatMul : public Operator
+   {
+   public:
+      QuantizedMatMul(int aZeroPointIndex, int bIndex, int bZeroPointIndex) : Operator(), _aZeroPointIndex(aZeroPointIndex), _bIndex(bIndex), _bZeroPointIndex(bZeroPointIndex), _packedB(nullptr){};
+      ~QuantizedMatMul() override;
+
+      /// @brief Prepare B for the integer kernel, when it is an initializer.
+      bool Prepack() override;
+
+      /// @brief Save the row sums, the zero points and the transposed data of the prepared B.
+      size_t SavePacked(void *buffer) override;
+      bool LoadPacked(const void *data, size_t size) override;
+
+   protected:
+      /// @brief Compute C = (A - za).(B - zb) with the zero points read from the inputs.
+      /// @param a the left operand [..., M, K]
+      /// @param b the right operand [K, N]
+      /// @param c the int32 result [rows of A x N]
+      /// @return false if the operands are not 8 bits integers, do not match or the memory cannot be allocated.
+      bool _multiply(ActivationContext *ctx, Tensor *a, Tensor *b, int32_t *c);
+
+      /// @brief infer the output of the product of A [..., M, K] by B [K, N], which is [..., M, N].
+      bool _inferProduct(Tensor **infos, int aIndex, tensor_data_type_t type);
+
+   private:
+      int _aZeroPointIndex;
+      int _bIndex;
+      int _bZeroPointIndex;
+      QuantizedMatrix *_packedB;
+   };
+
+   /// @brief Y = (A - a_zero_point).(B - b_zero_point) as int32. b_zero_point may hold one value per column of B.
+   /// @link https://onnx.ai/onnx/operators/onnx__MatMulInteger.html
+   class MatMulInteger : public QuantizedMatMul
+   {
+   public:
+      MatMulInteger() : QuantizedMatMul(MATMUL_INTEGER_A_ZERO_POINT_INDEX, MATMUL_INTEGER_B_INDEX, MATMUL_INTEGER_B_ZERO_POINT_INDEX){};
+      bool Activate(ActivationContext *ctx) override;
+      bool InferShapes(Tensor **infos) override { return this->_inferProduct(infos, MATMUL_INTEGER_A_INDEX, TDT_INT32); }
+   };
+   typedef MatMulInteger *MatMulIntegerPtr;
+
+   /// @brief Quantized matrix product, the int32 product is requantized with a_scale * b_scale / y_scale and y_zero_point.
+   /// b_scale and b_zero_point may hold one value per column of B.
+   /// @link https://onnx.ai/onnx/operators/onnx__QLinearMatMul.html
+   class QLinearMatMul : public QuantizedMatMul
+   {
+   public:
+      QLinearMatMul() : QuantizedMatMul(QLINEAR_MATMUL_A_ZERO_POINT_INDEX, QLINEAR_MATMUL_B_INDEX, QLINEAR_MATMUL_B_ZERO_POINT_INDEX){};
+      bool Activate(ActivationContext *ctx) override;
+      bool InferShapes(Tensor **infos) override;
+   };
+   typedef QLinearMatMul *QLinearMatMulPtr;
+}
+#endif
@@ -0,0 +1,81 @@
+#ifndef _CM_NODE_QUANTIZE__
+#define _CM_NODE_QUANTIZE__
+#include "cm_graph.hpp"
+
+namespace CyanMycelium
+{
+#define QUANTIZE_LINEAR QuantizeLinear
+#define DEQUANTIZE_LINEAR DequantizeLinear
+
+#define QLINEAR_X_INDEX 0
+#define QLINEAR_SCALE_INDEX 1
+#define QLINEAR_ZERO_POINT_INDEX 2
+
+   /// @brief The float scale and the optional zero point of a linear quantization, bound to the layout of the quantized tensor.
+   /// The scale holds a single value (per tensor) or one value per channel of the axis (per channel),
+   /// so the item i of the tensor uses the parameters of the channel (i / Inner) % Channels.
+   struct QuantizationParameters
+   {
+      const float *Scale;
+      const void *ZeroPoint;            // may be null, the zero point is then 0
+      tensor_data_type_t ZeroPointType; // the quantized type
+      size_t Channels;
+      size_t Inner;
+
+      /// @brief bind the parameter tensors to x.
+      /// @return false if the parameters are not float scales or do not match the channels of x along axis.
+      bool Bind(Tensor *x, int axis, Tensor *scale, Tensor *zeroPoint);
+
+      /// @brief the zero point of a channel as int32.
+      int32_t GetZeroPoint(size_t channel);
+   };
+
+   /// @brief Base class of the QuantizeLinear and DequantizeLinear operators.
+   class QuantizationOperator : public Operator
+   {
+   public:
+      /// @brief the axis of the per channel quantization, ignored by the per tensor quantization.
+      int Axis = 1;
+
+      bool TrySetAtt(const char *n, Att_value_t v) override;
+      void GetAtts(AttWriter *writer) override;
+
+      /// @brief Record the scale, the zero point and the axis on the quantized link.
+      bool Prepack() override;
+
+   protected:
+      /// @brief the link holding the quantized values.
+      virtual Link *_getQuantizedLink() = 0;
+
+      /// @brief check the infos of the scale and of the zero point against x, as QuantizationParameters::Bind does with their values.
+      bool _checkParameters(Tensor **infos, Tensor *x);
+   };
+
+   /// @brief y = saturate(round(x / y_scale) + y_zero_point), rounding half to even.
+   /// The output type is the type of the zero point, uint8 when it is omitted.
+   /// @link https://onnx.ai/onnx/operators/onnx__QuantizeLinear.html
+   class QuantizeLinear : public QuantizationOperator
+   {
+   public:
+      bool Activate(ActivationContext *ctx) override;
+      bool InferShapes(Tensor **infos) override;
+
+   protected:
+      Link *_getQuantizedLink() override { return this->Onsc.Count() ? this->Onsc[0] : nullptr; }
+   };
+   typedef QuantizeLinear *QuantizeLinearPtr;
+
+   /// @brief y = (x - x_zero_point) * x_scale, as float.
+   /// @link https://onnx.ai/onnx/operators/onnx__DequantizeLinear.html
+   class DequantizeLinear : public QuantizationOperator
+   {
+   public:
+      bool Activate(ActivationContext *ctx) override;
+      bool InferShapes(Tensor **infos) override;
+
+   protected:
+      Link *_getQuantizedLink() override { return this->Opsc.Count() ? this->Opsc[QLINEAR_X_INDEX] : nullptr; }
+   };
+   typedef DequantizeLinear *DequantizeLinearPtr;
+}
+#endif
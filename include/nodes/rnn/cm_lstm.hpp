@@ -8,15 +8,46 @@ namespace CyanMycelium
 #define LSTM_W_INDEX 1
 #define LSTM_R_INDEX 2
 #define LSTM_B_INDEX 3
+#define LSTM_SEQUENCE_LENS_INDEX 4
+#define LSTM_INITIAL_H_INDEX 5
+#define LSTM_INITIAL_C_INDEX 6
+#define LSTM_P_INDEX 7
+
+#define LSTM_Y_INDEX 0
+#define LSTM_Y_H_INDEX 1
+#define LSTM_Y_C_INDEX 2
+#define LSTM_OUTPUT_COUNT 3
+
+#define LSTM_GATE_COUNT 4
+
+  enum class LSTMDirection
+  {
+    FORWARD,
+    REVERSE,
+    BIDIRECTIONAL
+  };
 
   /// @class LSTMNode
   /// @brief Represents an LSTM node within an ONNX graph.
   /// The LSTMNode class models the behavior of an LSTM layer or cell in an ONNX graph.
   /// It takes input data and associated parameters, performs computations, and produces outputs.
+  /// sequence_lens, the peepholes P, the batch first layout and the custom activations are not supported, such models fail to load.
+  /// The inputs and the outputs are float or half, the half ones being converted to float by the GEMM and the state kept in float.
+  /// @link https://onnx.ai/onnx/operators/onnx__LSTM.html
   class LSTM : public Operator
   {
   public:
-    LSTM() : Operator(){};
+    LSTM() : Operator(), HiddenSize(0), Direction(LSTMDirection::FORWARD), Clip(0), InputForget(0),
+             _packedW(nullptr), _packedR(nullptr), _packedBias(nullptr), _packedExternal(false){};
+    ~LSTM() override;
+
+    /// @brief Number of neurons in the hidden layer. When 0, it is deduced from R.
+    int HiddenSize;
+    LSTMDirection Direction;
+    /// @brief Cell clip threshold applied to the gates pre-activation. 0 means no clipping.
+    float Clip;
+    /// @brief Couple the input and forget gates if 1.
+    int InputForget;
 
     /// @brief The input data (usually a sequence of vectors or embeddings).
     /// @return corresponding tensor reference
@@ -31,15 +62,38 @@ namespace CyanMycelium
     Tensor *R() { return this->Opsc[LSTM_R_INDEX]->GetPayloadInfos(); }
 
     /// @brief Biases for the LSTM gates.
-    /// @return corresponding tensor
-    Tensor *B() { return this->Opsc[LSTM_B_INDEX]->GetPayloadInfos(); }
+    /// @return corresponding tensor, or null if B is blank
+    Tensor *B() { return this->_hasInput(LSTM_B_INDEX) ? this->Opsc[LSTM_B_INDEX]->GetPayloadInfos() : nullptr; }
 
     /// @brief  Performs forward propagation for the LSTM node.
-    /// This method executes the computations associated with the LSTM node.
-    /// It processes the input data and produces output sequences and states.
+    /// The input projection X.Wt is computed for all the timesteps at once, then each step
+    /// adds the recurrent projection and runs the gates and the cell update in a single pass.
+    /// Outputs are Y [seq_length, num_directions, batch_size, hidden_size], Y_h and Y_c [num_directions, batch_size, hidden_size].
     /// @param ctx
     /// @return
-    bool Activate(ActivationContext *ctx) override { return true; }
+    bool Activate(ActivationContext *ctx) override;
+
+    bool TrySetAtt(const char *n, Att_value_t v) override;
+    void GetAtts(AttWriter *writer) override;
+
+    /// @brief Pack W and R into the GEMM panel layout and fold Wb + Rb, when they are initializers. Half weights are packed as floats.
+    bool Prepack() override;
+    bool InferShapes(Tensor **infos) override;
+
+    /// @brief Save the packed W and R, then the folded bias if any.
+    size_t SavePacked(void *buffer) override;
+    bool LoadPacked(const void *data, size_t size) override;
+
+  private:
+    // load time copies of the constant inputs, one block per direction.
+    float *_packedW;
+    float *_packedR;
+    float *_packedBias;
+    // the packed data belongs to a compiled model, see LoadPacked.
+    bool _packedExternal;
+
+    /// @brief the sizes in floats of the packed W and R, and of the folded bias, from the shapes of W and R.
+    void _getPackedSizes(size_t *w, size_t *r, size_t *bias);
   };
 }
-#endif
\ No newline at end of file
+#endif
@@ -8,20 +8,27 @@ namespace CyanMycelium
 
    extern const UnaryFunctionPtr CeluFunctionArray[TDT_COUNT];
 
+   /// @link https://onnx.ai/onnx/operators/onnx__Celu.html
    class Celu : public UnaryOperator
    {
    public:
       float Alpha;
-      Celu() : UnaryOperator(CeluFunctionArray){};
-      bool TrySetAtt(const char *n, Att_value_t v)
+      Celu() : UnaryOperator(CeluFunctionArray), Alpha(1.0f){};
+      bool TrySetAtt(const char *n, Att_value_t v) override
       {
-         if (strcmp(n, "Alpha"))
+         if (strcmp(n, "alpha") == 0)
          {
             Alpha = v.f;
             return true;
          }
          return false;
       }
+      void GetAtts(AttWriter *writer) override
+      {
+         Att_value_t v;
+         v.f = Alpha;
+         writer->Write("alpha", AttKind::FLOAT, v);
+      }
    };
    typedef Celu *CeluPtr;
 
@@ -0,0 +1,37 @@
+#ifndef _CM_NODE_ELU__
+#define _CM_NODE_ELU__
+#include "cm_graph.hpp"
+
+namespace CyanMycelium
+{
+#define ELU Elu
+
+   extern const UnaryFunctionPtr EluFunctionArray[TDT_COUNT];
+
+   /// @link https://onnx.ai/onnx/operators/onnx__Elu.html
+   class Elu : public UnaryOperator
+   {
+   public:
+      float Alpha;
+      Elu() : UnaryOperator(EluFunctionArray), Alpha(1.0f){};
+      bool TrySetAtt(const char *n, Att_value_t v) override
+      {
+         if (strcmp(n, "alpha") == 0)
+         {
+            Alpha = v.f;
+            return true;
+         }
+         return false;
+      }
+      void GetAtts(AttWriter *writer) override
+      {
+         Att_value_t v;
+         v.f = Alpha;
+         writer->Write("alpha", AttKind::FLOAT, v);
+      }
+   };
+   typedef Elu *EluPtr;
+
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,38 @@
+#ifndef _CM_NODE_GELU__
+#define _CM_NODE_GELU__
+#include "cm_graph.hpp"
+
+namespace CyanMycelium
+{
+#define GELU Gelu
+
+   extern const UnaryFunctionPtr GeluFunctionArray[TDT_COUNT];
+
+   /// @brief x / 2 (1 + erf(x / sqrt(2))), or its tanh approximation when Approximate is set (opset 20 semantic).
+   /// @link https://onnx.ai/onnx/operators/onnx__Gelu.html
+   class Gelu : public UnaryOperator
+   {
+   public:
+      bool Approximate;
+      Gelu() : UnaryOperator(GeluFunctionArray), Approximate(false){};
+      bool TrySetAtt(const char *n, Att_value_t v) override
+      {
+         if (strcmp(n, "approximate") == 0)
+         {
+            Approximate = strcmp(v.s, "tanh") == 0;
+            return true;
+         }
+         return false;
+      }
+      void GetAtts(AttWriter *writer) override
+      {
+         Att_value_t v;
+         v.s = Approximate ? "tanh" : "none";
+         writer->Write("approximate", AttKind::STRING, v);
+      }
+   };
+   typedef Gelu *GeluPtr;
+
+}
+
+#endif
\ No newline at end of file
@@ -15,9 +15,14 @@ namespace CyanMycelium
 #define CELU Celu
 #define COS Cos
 #define COSH Cosh
-#define ELU Elu
+#define ERF Erf
 #define EXP Exp
 #define FLOOR Floor
+#define LOG Log
+#define RELU Relu
+#define SIGMOID Sigmoid
+#define SQRT Sqrt
+#define TANH Tanh
 
    UNARY_OP_DECL(ABS)
    UNARY_OP_DECL(ACOS)
@@ -29,9 +34,14 @@ namespace CyanMycelium
    UNARY_OP_DECL(CEIL)
    UNARY_OP_DECL(COS)
    UNARY_OP_DECL(COSH)
-   UNARY_OP_DECL(ELU)
+   UNARY_OP_DECL(ERF)
    UNARY_OP_DECL(EXP)
    UNARY_OP_DECL(FLOOR)
+   UNARY_OP_DECL(LOG)
+   UNARY_OP_DECL(RELU)
+   UNARY_OP_DECL(SIGMOID)
+   UNARY_OP_DECL(SQRT)
+   UNARY_OP_DECL(TANH)
 }
 
 #endif
\ No newline at end of file
@@ -13,10 +13,16 @@ namespace CyanMycelium
 #define ONNX_GB_UNSUPPORTED_ATTRIBUTE 101
 #define ONNX_GB_UNSUPPORTED_TENSOR_DATA_TYPE 110
 #define ONNX_GB_UNSUPPORTED_TENSOR_DIM 111
+// not raised anymore, the unknown dimensions are read as TENSOR_DYNAMIC_DIM.
 #define ONNX_GB_UNSUPPORTED_TENSOR_UNKNOWN_DIM 112
+// the inputs of a node do not fit the operator, see Graph::InferShapes.
+#define ONNX_GB_INVALID_SHAPE 113
 #define ONNX_GB_READ_ERROR 200
 #define ONNX_GB_SYSTEM_ERROR 300
 
+// the alignment of the objects placed into the arena of the graph.
+#define ONNX_GB_ARENA_ALIGNMENT 16
+
     class OnnxGraphBuilder
     {
     public:
@@ -37,15 +43,53 @@ namespace CyanMycelium
         int _error;
         char _errorInfos[ERROR_INFOS_MAX_LENGTH];
 
+        // the block receiving the nodes, the links and the initializers, given to the graph once built.
+        lb_byte_t *_arena;
+        size_t _arenaSize;
+        size_t _arenaUsed;
+        // the opset version of the default domain, 0 if the model does not import it.
+        int _opset;
+
         bool _readGraph(BlueSteelLadyBug ::PBReader *);
+        /// @brief read an OperatorSetIdProto, keeping the version of the default domain.
+        bool _readOpsetImport(BlueSteelLadyBug ::PBReader *);
         bool _readNode(char *, BlueSteelLadyBug ::PBReader *);
         bool _readValueInfos(char *, BlueSteelLadyBug ::PBReader *);
         bool _readInitializer(char *, BlueSteelLadyBug ::PBReader *);
+        bool _readQuantizationAnnotation(char *, BlueSteelLadyBug ::PBReader *);
+        bool _readStringEntry(char *, char *, BlueSteelLadyBug ::PBReader *);
         bool _readTensorType(TensorInfos *, BlueSteelLadyBug ::PBReader *);
         bool _readTensorShape(TensorInfos *, BlueSteelLadyBug ::PBReader *);
+        /// @brief the first pass, which declares the link names and sizes the arena.
+        bool _countGraph(BlueSteelLadyBug ::PBReader *);
+        bool _countNode(char *, BlueSteelLadyBug ::PBReader *);
+        bool _countNames(char *, BlueSteelLadyBug ::PBReader *);
+        bool _countInitializer(char *, BlueSteelLadyBug ::PBReader *);
+        bool _countQuantizationAnnotation(char *, BlueSteelLadyBug ::PBReader *);
+        void _declareLink(const char *);
+        void *_fromArena(size_t);
+        bool _inArena(void *p) { return p >= this->_arena && p < this->_arena + this->_arenaSize; }
         Operator *_createNode(const char *);
         Link *_createLink();
         Link *_getOrCreateLink(const char *);
+        /// @brief the number of operators reading a link, the first capacity of them being stored into readers.
+        int _readersOf(Link *l, Operator **readers = nullptr, int capacity = 0);
+        /// @brief remove an operator from the nodes and destroy it.
+        /// @return the position the operator had into the nodes, or -1.
+        int _destroyNode(Operator *);
+        /// @brief remove a link from the links, keeping its name, and destroy it with the data of an initializer.
+        void _destroyLink(Link *);
+        /// @brief fold the operators into the one producing their single input, see Operator::Fuse.
+        void _fuseNodes();
+        /// @brief rewrite the chains of elementary operators exported for Softmax, LogSoftmax and LayerNormalization into
+        /// the fused operators, see cm_onnx_graph_patterns.cpp.
+        void _rewritePatterns();
+        bool _rewriteSoftmax(Operator *);
+        bool _rewriteLayerNorm(Operator *);
+        /// @brief replace the operators of a matched pattern by a single new operator, built in place of the first one.
+        /// The links between the operators are destroyed, as the initializers they were the only readers of.
+        /// @return the new operator, or null if the type is unknown, the graph being left untouched.
+        Operator *_replaceNodes(const char *typeName, Operator **nodes, int count, Link **inputs, int inputCount, Link *output);
         virtual void *_malloc(size_t s) { return cm_malloc(s); }
         virtual void _free(void *p) { return cm_free(p); }
     };
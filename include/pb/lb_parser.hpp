@@ -78,6 +78,8 @@ namespace BlueSteelLadyBug
         bool readPacked(lb_int64_t *v, WireType wt);
         bool readPacked(lb_uint32_t *v, WireType wt);
         bool readPacked(lb_uint64_t *v, WireType wt);
+        /// @brief read at most max packed values, count receives the number of values read.
+        bool readPacked(lb_uint64_t *v, WireType wt, size_t max, size_t *count);
         bool readPacked(lb_float_t *v);
         bool readPacked(lb_double_t *v);
 
@@ -121,7 +123,7 @@ namespace BlueSteelLadyBug
         bool _readValue(lb_double_t *, WireType);
 
         template <typename T>
-        bool _readPacked(T *, WireType);
+        bool _readPacked(T *, WireType, size_t max = (size_t)-1, size_t *count = nullptr);
 
         void _invalidateLengthReaded() { _status.lengthReaded = false; }
     };
@@ -30,6 +30,52 @@ extern "C"
 
 #define cm_clock() clock();
 
+    /// @brief monotonic timestamp in nanoseconds, used by the profiler.
+    static inline cm_uint64_t cm_time_ns()
+    {
+        LARGE_INTEGER counter, frequency;
+        QueryPerformanceCounter(&counter);
+        QueryPerformanceFrequency(&frequency);
+        cm_uint64_t c = (cm_uint64_t)counter.QuadPart;
+        cm_uint64_t f = (cm_uint64_t)frequency.QuadPart;
+        // split to avoid the overflow of c * 1e9
+        return (c / f) * 1000000000ULL + (c % f) * 1000000000ULL / f;
+    }
+
+    /// @brief map a file read only into memory, the pages are loaded on first access and shared between the processes.
+    /// @param path the path of the file
+    /// @param size receives the size of the file
+    /// @return the address of the view, or null if the file cannot be mapped. The view is released by cm_unmap_file.
+    static inline const void *cm_map_file(const char *path, size_t *size)
+    {
+        const void *view = NULL;
+        LARGE_INTEGER length;
+        HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+        if (file == INVALID_HANDLE_VALUE)
+        {
+            return NULL;
+        }
+        if (GetFileSizeEx(file, &length) && length.QuadPart)
+        {
+            HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+            if (mapping)
+            {
+                view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+                // the view holds the mapping once the handles are closed.
+                CloseHandle(mapping);
+            }
+        }
+        CloseHandle(file);
+        *size = view ? (size_t)length.QuadPart : 0;
+        return view;
+    }
+
+#define cm_unmap_file(view, size) UnmapViewOfFile((view))
+
+#define cm_thread_id() ((cm_uint32_t)GetCurrentThreadId())
+
+#define cm_yield() SwitchToThread()
+
 #define CM_INFINITE 0xFFFFFFFF
 #define CM_POLL 0x00000000
 
@@ -41,6 +87,7 @@ extern "C"
 #define cm_rand rand
 
 #define cm_memcpy(copy, ptr, size) memcpy((copy), (ptr), (size))
+#define cm_memmove(copy, ptr, size) memmove((copy), (ptr), (size))
 #define cm_malloc(size) malloc((size))
 #define cm_realloc(ptr, size) realloc((ptr), (size))
 #define cm_free(ptr) free((ptr))
@@ -26,11 +26,13 @@ namespace CyanMycelium
         unsigned int FreeSize();
         unsigned int Size();
         bool ISR_Send(void *item);
+        bool WaitForFreeSize(unsigned int size, unsigned int timeoutMs = INFINITE);
 
     private:
         Fifo _queue;
         std::mutex _mtx;
-        std::condition_variable _cv;
+        std::condition_variable _cv;      // signaled when an item is sent
+        std::condition_variable _notFull; // signaled when an item is received
     };
 
     typedef EmbeddedQueue *EmbeddedQueuePtr;
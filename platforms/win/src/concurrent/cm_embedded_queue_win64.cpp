@@ -24,7 +24,13 @@ void EmbeddedQueue::Reset()
 bool EmbeddedQueue::Send(void *item, unsigned int timeoutMs)
 {
     {
-        std::lock_guard lk(_mtx);
+        std::unique_lock lk(_mtx);
+        // wait for a free slot, a zero timeout fails immediately when the queue is full.
+        if (!_notFull.wait_for(lk, std::chrono::milliseconds(timeoutMs), [this]() -> bool
+                               { return !this->_queue.IsFull(); }))
+        {
+            return false;
+        }
         if (!_queue.TryEnqueue(item))
         {
             return false;
@@ -36,13 +42,28 @@ bool EmbeddedQueue::Send(void *item, unsigned int timeoutMs)
 
 bool EmbeddedQueue::Receive(void *o_item, unsigned int timeoutMs)
 {
-    std::unique_lock lk(_mtx);
-    if (_cv.wait_for(lk, std::chrono::milliseconds(timeoutMs), [this]() -> bool
-                     { return this->_queue.HasItems(); }))
+    bool received = false;
     {
-        return _queue.TryDequeue(o_item);
+        std::unique_lock lk(_mtx);
+        if (_cv.wait_for(lk, std::chrono::milliseconds(timeoutMs), [this]() -> bool
+                         { return this->_queue.HasItems(); }))
+        {
+            received = _queue.TryDequeue(o_item);
+        }
     }
-    return false;
+    if (received)
+    {
+        // senders and admissions wait for different amounts of room.
+        _notFull.notify_all();
+    }
+    return received;
+}
+
+bool EmbeddedQueue::WaitForFreeSize(unsigned int size, unsigned int timeoutMs)
+{
+    std::unique_lock lk(_mtx);
+    return _notFull.wait_for(lk, std::chrono::milliseconds(timeoutMs), [this, size]() -> bool
+                             { return (unsigned int)(this->_queue.Capacity() - this->_queue.Count()) >= size; });
 }
 
 bool EmbeddedQueue::Peek(void *o_item, unsigned int timeoutMs)
@@ -47,3 +47,7 @@ bool Queue::ISR_Send(void *item)
 {
     return _queue->ISR_Send(item);
 }
+boolean Queue::WaitForFreeSize(unsigned int size, unsigned int timeoutMs)
+{
+    return _queue->WaitForFreeSize(size, timeoutMs);
+}
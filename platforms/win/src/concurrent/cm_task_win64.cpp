@@ -4,6 +4,7 @@ using namespace CyanMycelium;
 
 Thread ::Thread(IRunnable *target, int stack_size, void *params, Priority priority)
 {
+    _joined = false;
     Params *p = new Params();
     p->Target = target;
     p->Parameters = params;
@@ -0,0 +1,124 @@
+#include "cm_bench.hpp"
+
+#include "cm_engine.hpp"
+#include "nodes/cm_nodes_registry.hpp"
+
+using namespace CyanMycelium;
+
+struct BenchCase
+{
+    const char *Op; // Add, Sub, Mul or Div
+    size_t Count;
+};
+
+static float Reference(const char *op, float a, float b)
+{
+    switch (op[0])
+    {
+    case 'A':
+        return a + b;
+    case 'S':
+        return a - b;
+    case 'M':
+        return a * b;
+    default:
+        return a / b;
+    }
+}
+
+/// @brief run the operator on a runtime input and a second operand, which is an initializer read from its link when constant is
+/// set, a runtime input otherwise. The initializer is the first operand when first is set. Return the time in milliseconds and
+/// whether the result is right.
+static double Bench(InferenceEngine *engine, const BenchCase &c, std::vector<float> &x, std::vector<float> &k, bool constant, bool first, bool *valid)
+{
+    std::vector<float> y(c.Count);
+    uint64_t shape[2] = {1, (uint64_t)c.Count};
+    Graph graph;
+    Link *links[3];
+    for (int i = 0; i != 3; i++)
+    {
+        links[i] = new Link();
+        links[i]->Id = i;
+        links[i]->SetPayloadInfos(shape, 2, TDT_FLOAT);
+        graph.Links.Add(links[i]);
+    }
+    // the operand K is the initializer, it keeps its data on the link as the builder does.
+    Link *in = links[0];
+    Link *constLink = links[1];
+    if (constant)
+    {
+        constLink->GetPayloadInfos()->Data = k.data();
+    }
+    Operator *op = NodeRegistry::ForName(c.Op);
+    Link *a = first ? constLink : in;
+    Link *b = first ? in : constLink;
+    a->Ofin = op;
+    op->Opsc.Add(a);
+    b->Ofin = op;
+    op->Opsc.Add(b);
+    links[2]->Oini = op;
+    op->Onsc.Add(links[2]);
+    graph.Nodes.Add(op);
+    graph.Inputs.Set("X", in);
+    graph.Inputs.Set("K", constLink);
+    graph.Outputs.Set("Y", links[2]);
+
+    ActivationContextHandlers handlers;
+    ActivationContext ctx(engine, &graph, &handlers);
+    ctx.SetInput("X", x.data());
+    if (!constant)
+    {
+        ctx.SetInput("K", k.data());
+    }
+    ctx.SetOutput("Y", y.data());
+    bool run = true;
+    double ms = Measure([&]()
+                        { run = ctx.Run() && run; });
+
+    *valid = run;
+    for (size_t i = 0; i != c.Count; i++)
+    {
+        float expected = first ? Reference(c.Op, k[i], x[i]) : Reference(c.Op, x[i], k[i]);
+        *valid = *valid && y[i] == expected;
+    }
+    constLink->GetPayloadInfos()->Data = nullptr;
+    delete op;
+    for (Link *l : links)
+    {
+        delete l;
+    }
+    return ms;
+}
+
+int main()
+{
+    InferenceEngineOptions options;
+    InferenceEngine engine(options, false);
+
+    // the element-wise operators applied to a constant of the model, as the scales and the biases of the exported graphs.
+    BenchCase cases[] = {
+        {"Add", 1 << 12},
+        {"Sub", 1 << 12},
+        {"Mul", 1 << 16},
+        {"Div", 1 << 16},
+        {"Sub", 1 << 20},
+        {"Div", 1 << 20},
+    };
+
+    BenchReport report("op,count,order,inputs_ms,initializer_ms,valid");
+    for (const BenchCase &c : cases)
+    {
+        // x in [0.5, 1.5] and k in [1, 2], so the divisions stay away from zero.
+        std::vector<float> x = RandomBuffer(c.Count, 1.0f, 1.0f);
+        std::vector<float> k = RandomBuffer(c.Count, 1.0f, 1.5f);
+        for (int first = 0; first != 2; first++)
+        {
+            bool inputsValid, constantValid;
+            double inputs = Bench(&engine, c, x, k, false, first != 0, &inputsValid);
+            double constant = Bench(&engine, c, x, k, true, first != 0, &constantValid);
+            bool valid = inputsValid && constantValid;
+            report.Row(valid, c.Op, c.Count, first ? "k,x" : "x,k", inputs, constant, valid ? "yes" : "no");
+        }
+    }
+    return report.End();
+}
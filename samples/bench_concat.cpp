@@ -0,0 +1,136 @@
+#include <cstdio>
+
+#include "cm_bench.hpp"
+
+#include "cm_engine.hpp"
+#include "nodes/cm_nodes_registry.hpp"
+#include "nodes/op/cm_concat.hpp"
+
+using namespace CyanMycelium;
+
+#define BENCH_MAX_BRANCHES 4
+
+struct BenchShape
+{
+    const char *Name;
+    int Branches;
+    int Channels[BENCH_MAX_BRANCHES]; // the channels of every branch, concatenated along the channel axis
+    int Height;
+    int Width;
+};
+
+/// @brief run the branches, a Relu each, and their concatenation. Return the time in milliseconds and whether the result is
+/// right. The sources of the branches write into their slice of the result when inSlice is set, the result is a copy of the
+/// branches otherwise.
+static double Bench(InferenceEngine *engine, const BenchShape &s, std::vector<std::vector<float>> &x, bool inSlice, bool *valid)
+{
+    size_t plane = (size_t)s.Height * s.Width;
+    int channels = 0;
+    for (int i = 0; i != s.Branches; i++)
+    {
+        channels += s.Channels[i];
+    }
+    std::vector<float> y(channels * plane);
+
+    Graph graph;
+    std::vector<Link *> links;
+    auto link = [&](int c)
+    {
+        uint64_t shape[4] = {1, (uint64_t)c, (uint64_t)s.Height, (uint64_t)s.Width};
+        Link *l = new Link();
+        l->Id = (int32_t)links.size();
+        l->SetPayloadInfos(shape, 4, TDT_FLOAT);
+        graph.Links.Add(l);
+        links.push_back(l);
+        return l;
+    };
+    Operator *concat = NodeRegistry::ForName("Concat");
+    ((ConcatPtr)concat)->Axis = 1;
+    for (int i = 0; i != s.Branches; i++)
+    {
+        Link *in = link(s.Channels[i]);
+        Link *out = link(s.Channels[i]);
+        Operator *relu = NodeRegistry::ForName("Relu");
+        in->Ofin = relu;
+        relu->Opsc.Add(in);
+        out->Oini = relu;
+        relu->Onsc.Add(out);
+        out->Ofin = concat;
+        concat->Opsc.Add(out);
+        graph.Nodes.Add(relu);
+        char name[16];
+        snprintf(name, sizeof(name), "X%d", i);
+        graph.Inputs.Set(name, in);
+    }
+    Link *result = link(channels);
+    result->Oini = concat;
+    concat->Onsc.Add(result);
+    graph.Nodes.Add(concat);
+    graph.Outputs.Set("Y", result);
+    graph.AnalyzeInPlace();
+    for (Link *l : links)
+    {
+        l->InSlice = l->InSlice && inSlice;
+    }
+
+    ActivationContextHandlers handlers;
+    ActivationContext ctx(engine, &graph, &handlers);
+    for (int i = 0; i != s.Branches; i++)
+    {
+        char name[16];
+        snprintf(name, sizeof(name), "X%d", i);
+        ctx.SetInput(name, x[i].data());
+    }
+    ctx.SetOutput("Y", y.data());
+    double ms = Measure([&]()
+                        { ctx.Run(); });
+
+    *valid = true;
+    const float *p = y.data();
+    for (int i = 0; i != s.Branches; i++)
+    {
+        for (size_t j = 0; j != x[i].size(); j++)
+        {
+            *valid = *valid && *p++ == max(x[i][j], 0.0f);
+        }
+    }
+    for (int i = 0; i != graph.Nodes.Count(); i++)
+    {
+        delete graph.Nodes[i];
+    }
+    for (Link *l : links)
+    {
+        delete l;
+    }
+    return ms;
+}
+
+int main()
+{
+    InferenceEngineOptions options;
+    InferenceEngine engine(options, false);
+
+    // the concatenations along the channels of the common image models.
+    BenchShape shapes[] = {
+        {"inception_3a", 4, {64, 128, 32, 32}, 28, 28},
+        {"inception_5b", 4, {384, 384, 128, 128}, 7, 7},
+        {"densenet_block1", 2, {256, 32}, 56, 56},
+        {"yolo_route", 2, {256, 512}, 26, 26},
+        {"unet_skip", 2, {64, 64}, 256, 256},
+    };
+
+    BenchReport report("layer,copy_ms,ms,speedup");
+    for (const BenchShape &s : shapes)
+    {
+        std::vector<std::vector<float>> x(s.Branches);
+        for (int i = 0; i != s.Branches; i++)
+        {
+            x[i] = RandomBuffer((size_t)s.Channels[i] * s.Height * s.Width);
+        }
+        bool copyValid, sliceValid;
+        double copy = Bench(&engine, s, x, false, &copyValid);
+        double ms = Bench(&engine, s, x, true, &sliceValid);
+        report.Row(copyValid && sliceValid, s.Name, copy, ms, copy / ms);
+    }
+    return report.End();
+}
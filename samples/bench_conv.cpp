@@ -0,0 +1,206 @@
+#include "cm_bench.hpp"
+
+#include "cm_engine.hpp"
+#include "nodes/nn/cm_conv.hpp"
+
+using namespace CyanMycelium;
+
+#define BENCH_MAX_ERROR 1e-3f
+
+struct BenchShape
+{
+    const char *Name;
+    int Rank; // 1 or 2 spatial axes
+    int Channels;
+    int Height;
+    int Width;
+    int Features;
+    int Kernel;
+    int Stride;
+    int Pad;
+    int Dilation;
+    int Group;
+};
+
+static const char *AlgorithmName(ConvAlgorithm algorithm)
+{
+    switch (algorithm)
+    {
+    case ConvAlgorithm::IM2COL:
+        return "im2col";
+    case ConvAlgorithm::DIRECT:
+        return "direct";
+    case ConvAlgorithm::WINOGRAD:
+        return "winograd";
+    case ConvAlgorithm::GROUPED:
+        return "grouped";
+    default:
+        return "auto";
+    }
+}
+
+static int OutSize(int in, const BenchShape &s) { return (in + 2 * s.Pad - (s.Kernel - 1) * s.Dilation - 1) / s.Stride + 1; }
+
+/// @brief the plain definition of the convolution, as the reference of the kernels.
+static void Reference(const BenchShape &s, const float *x, const float *w, const float *b, float *y)
+{
+    int kh = s.Rank == 2 ? s.Kernel : 1;
+    int oh = s.Rank == 2 ? OutSize(s.Height, s) : 1;
+    int ow = OutSize(s.Width, s);
+    int pad = s.Rank == 2 ? s.Pad : 0;
+    int depth = s.Channels / s.Group;
+    for (int m = 0; m != s.Features; m++)
+        for (int i = 0; i != oh; i++)
+            for (int j = 0; j != ow; j++)
+            {
+                double sum = b[m];
+                int c0 = m / (s.Features / s.Group) * depth;
+                for (int c = c0; c != c0 + depth; c++)
+                    for (int u = 0; u != kh; u++)
+                        for (int v = 0; v != s.Kernel; v++)
+                        {
+                            int ih = i * (s.Rank == 2 ? s.Stride : 1) + u * s.Dilation - pad;
+                            int iw = j * s.Stride + v * s.Dilation - s.Pad;
+                            if (ih >= 0 && ih < s.Height && iw >= 0 && iw < s.Width)
+                            {
+                                sum += (double)x[((size_t)c * s.Height + ih) * s.Width + iw] * w[(((size_t)m * depth + c - c0) * kh + u) * s.Kernel + v];
+                            }
+                        }
+                y[((size_t)m * oh + i) * ow + j] = (float)sum;
+            }
+}
+
+/// @brief run a single Conv layer with the given algorithm, return its time in milliseconds and the largest error against the reference.
+static double Bench(InferenceEngine *engine, const BenchShape &s, ConvAlgorithm algorithm, float *x, float *w, float *b, const float *expected, float *error, ConvAlgorithm *chosen)
+{
+    int kh = s.Rank == 2 ? s.Kernel : 1;
+    int oh = s.Rank == 2 ? OutSize(s.Height, s) : 1;
+    int ow = OutSize(s.Width, s);
+    uint64_t xShape[4] = {1, (uint64_t)s.Channels, (uint64_t)s.Height, (uint64_t)s.Width};
+    uint64_t wShape[4] = {(uint64_t)s.Features, (uint64_t)(s.Channels / s.Group), (uint64_t)kh, (uint64_t)s.Kernel};
+    uint64_t bShape[1] = {(uint64_t)s.Features};
+    if (s.Rank == 1)
+    {
+        xShape[2] = s.Width;
+        wShape[2] = s.Kernel;
+    }
+    std::vector<float> y((size_t)s.Features * oh * ow);
+
+    Graph graph;
+    Link *links[4];
+    for (int i = 0; i != 4; i++)
+    {
+        links[i] = new Link();
+        links[i]->Id = i;
+        graph.Links.Add(links[i]);
+    }
+    links[0]->SetPayloadInfos(xShape, 2 + s.Rank, TDT_FLOAT);
+    links[1]->SetPayloadInfos(wShape, 2 + s.Rank, TDT_FLOAT, w);
+    links[2]->SetPayloadInfos(bShape, 1, TDT_FLOAT, b);
+
+    Conv *conv = new Conv();
+    conv->Algorithm = algorithm;
+    conv->Group = s.Group;
+    for (int a = 0; a != s.Rank; a++)
+    {
+        conv->Strides[a] = s.Stride;
+        conv->Dilations[a] = s.Dilation;
+        conv->Pads[a] = conv->Pads[s.Rank + a] = s.Pad;
+    }
+    conv->StrideCount = conv->DilationCount = s.Rank;
+    conv->PadCount = 2 * s.Rank;
+    for (int i = 0; i != 3; i++)
+    {
+        links[i]->Ofin = conv;
+        conv->Opsc.Add(links[i]);
+    }
+    links[3]->Oini = conv;
+    conv->Onsc.Add(links[3]);
+    Operator *op = conv;
+    graph.Nodes.Add(op);
+    graph.Inputs.Set("X", links[0]);
+    graph.Outputs.Set("Y", links[3]);
+    // as the graph builder does once the node is linked.
+    conv->Prepack();
+    *chosen = conv->Algorithm;
+
+    ActivationContextHandlers handlers;
+    double ms = Measure([&]()
+                        {
+                            ActivationContext ctx(engine, &graph, &handlers);
+                            ctx.SetInput("X", x);
+                            ctx.SetOutput("Y", y.data());
+                            ctx.Activate(op); });
+
+    *error = MaxError(y.data(), expected, y.size());
+    delete conv;
+    for (int i = 0; i != 4; i++)
+    {
+        delete links[i];
+    }
+    return ms;
+}
+
+int main()
+{
+    InferenceEngineOptions options;
+    InferenceEngine engine(options, false);
+
+    // the layers of the common image and sequence models.
+    BenchShape shapes[] = {
+        {"resnet_stem_7x7s2", 2, 3, 224, 224, 64, 7, 2, 3, 1, 1},
+        {"mobilenet_stem_3x3s2", 2, 3, 224, 224, 32, 3, 2, 1, 1, 1},
+        {"lenet_5x5", 2, 1, 64, 64, 16, 5, 1, 2, 1, 1},
+        {"resnet_3x3_64", 2, 64, 56, 56, 64, 3, 1, 1, 1, 1},
+        {"resnet_3x3_128", 2, 128, 28, 28, 128, 3, 1, 1, 1, 1},
+        {"resnet_3x3_256", 2, 256, 14, 14, 256, 3, 1, 1, 1, 1},
+        {"resnet_3x3s2_64_128", 2, 64, 56, 56, 128, 3, 2, 1, 1, 1},
+        {"resnet_1x1_256_64", 2, 256, 56, 56, 64, 1, 1, 0, 1, 1},
+        {"resnet_1x1_16_64", 2, 16, 56, 56, 64, 1, 1, 0, 1, 1},
+        {"tcn_1d_k5_d2", 1, 64, 1, 1024, 64, 5, 1, 4, 2, 1},
+        // the depthwise layers of MobileNet v1/v2, then grouped ones as in ResNeXt and ShuffleNet.
+        {"mobilenet_dw_3x3_32", 2, 32, 112, 112, 32, 3, 1, 1, 1, 32},
+        {"mobilenet_dw_3x3s2_64", 2, 64, 112, 112, 64, 3, 2, 1, 1, 64},
+        {"mobilenet_dw_3x3_128", 2, 128, 56, 56, 128, 3, 1, 1, 1, 128},
+        {"mobilenet_dw_3x3_256", 2, 256, 28, 28, 256, 3, 1, 1, 1, 256},
+        {"mobilenet_dw_3x3_512", 2, 512, 14, 14, 512, 3, 1, 1, 1, 512},
+        {"mobilenet_dw_3x3s2_512", 2, 512, 14, 14, 512, 3, 2, 1, 1, 512},
+        {"mnasnet_dw_5x5_240", 2, 240, 14, 14, 240, 5, 1, 2, 1, 240},
+        {"resnext_g32_3x3_128", 2, 128, 56, 56, 128, 3, 1, 1, 1, 32},
+        {"resnext_g32_3x3_256", 2, 256, 28, 28, 256, 3, 1, 1, 1, 32},
+        {"grouped_g8_3x3_128", 2, 128, 28, 28, 128, 3, 1, 1, 1, 8},
+        {"shufflenet_g3_1x1_240", 2, 240, 28, 28, 240, 1, 1, 0, 1, 3},
+        {"tcn_dw_1d_k5", 1, 128, 1, 1024, 128, 5, 1, 2, 1, 128},
+    };
+    ConvAlgorithm algorithms[] = {ConvAlgorithm::IM2COL, ConvAlgorithm::DIRECT, ConvAlgorithm::WINOGRAD, ConvAlgorithm::GROUPED};
+
+    BenchReport report("layer,algorithm,ms,gflops,max_error,auto");
+    for (const BenchShape &s : shapes)
+    {
+        int kh = s.Rank == 2 ? s.Kernel : 1;
+        int oh = s.Rank == 2 ? OutSize(s.Height, s) : 1;
+        int ow = OutSize(s.Width, s);
+        std::vector<float> x = RandomBuffer((size_t)s.Channels * s.Height * s.Width);
+        std::vector<float> w = RandomBuffer((size_t)s.Features * s.Channels / s.Group * kh * s.Kernel);
+        std::vector<float> b = RandomBuffer(s.Features);
+        std::vector<float> expected((size_t)s.Features * oh * ow);
+        Reference(s, x.data(), w.data(), b.data(), expected.data());
+        double flops = 2.0 * s.Features * oh * ow * s.Channels / s.Group * kh * s.Kernel;
+
+        ConvAlgorithm automatic;
+        float error;
+        Bench(&engine, s, ConvAlgorithm::AUTO, x.data(), w.data(), b.data(), expected.data(), &error, &automatic);
+        for (ConvAlgorithm algorithm : algorithms)
+        {
+            ConvAlgorithm chosen;
+            double ms = Bench(&engine, s, algorithm, x.data(), w.data(), b.data(), expected.data(), &error, &chosen);
+            // Winograd and the grouped kernel do not apply to every shape.
+            if (chosen != algorithm)
+            {
+                continue;
+            }
+            report.Row(error < BENCH_MAX_ERROR, s.Name, AlgorithmName(algorithm), ms, flops / ms / 1e6, error, algorithm == automatic ? "*" : "");
+        }
+    }
+    return report.End();
+}
@@ -0,0 +1,171 @@
+#include <iostream>
+#include <fstream>
+#include <chrono>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include "onnx/cm_onnx_graph_builder.hpp"
+#include "flat/cm_flat_graph.hpp"
+#include "pb/lb_memory_stream.hpp"
+#include "cm_engine.hpp"
+
+using namespace BlueSteelLadyBug;
+using namespace CyanMycelium;
+
+#define BENCH_ITERATIONS 1000
+
+static char *ReadFileIntoMemory(const char *filename, size_t *fileSize)
+{
+    std::ifstream file(filename, std::ios::binary | std::ios::ate);
+    if (!file.is_open())
+    {
+        return nullptr;
+    }
+    *fileSize = file.tellg();
+    char *buffer = new char[*fileSize];
+    file.seekg(0, std::ios::beg);
+    file.read(buffer, *fileSize);
+    return buffer;
+}
+
+static Graph *BuildOnnx(char *model, size_t size)
+{
+    MemoryStream input((lb_byte_t *)model, size);
+    PBReader reader(&input);
+    OnnxGraphBuilder builder;
+    Graph *graph = builder.WithReader(&reader).Build();
+    if (!graph)
+    {
+        std::cerr << "onnx error [" << builder.GetError() << "]:" << builder.GetErrorInfos() << std::endl;
+    }
+    return graph;
+}
+
+static Graph *BuildFlat(const void *image, size_t size)
+{
+    FlatGraphBuilder builder;
+    Graph *graph = builder.WithImage(image, size).Build();
+    if (!graph)
+    {
+        std::cerr << "flat error [" << builder.GetError() << "]:" << builder.GetErrorInfos() << std::endl;
+    }
+    return graph;
+}
+
+/// @brief run both graphs on the same random inputs, the outputs must be equal byte for byte.
+static bool SameOutputs(Graph *expected, Graph *actual)
+{
+    InferenceEngineOptions options;
+    options.ThreadCount = 1;
+    InferenceEngine *engine = new InferenceEngine(options, false);
+    ActivationContextHandlers handlers;
+    ActivationContext *a = new ActivationContext(engine, expected, &handlers);
+    ActivationContext *b = new ActivationContext(engine, actual, &handlers);
+    std::vector<std::vector<unsigned char>> inputs;
+    KeyValueCollection<Link *>::Iterator<KeyValue<Link *>> i = expected->Inputs.GetIterator();
+    while (i.MoveNext())
+    {
+        Tensor *t = i.Current()->Value->GetPayloadInfos();
+        if (t->Data)
+        {
+            // an initializer
+            continue;
+        }
+        // the symbolic dimensions are given a size of 1.
+        uint64_t shape[TENSOR_MAX_DIMENSION];
+        for (int d = 0; d != t->Dimension; d++)
+        {
+            shape[d] = t->Shape[d] == TENSOR_DYNAMIC_DIM ? 1 : t->Shape[d];
+        }
+        TensorInfos infos(shape, t->Dimension, t->Type);
+        std::vector<unsigned char> buffer(infos.Size);
+        for (size_t j = 0; j != infos.Size; j++)
+        {
+            buffer[j] = (unsigned char)(t->Type == TDT_FLOAT && (j & 3) == 3 ? 0x3f + (rand() & 0x80) : rand());
+        }
+        inputs.push_back(buffer);
+        a->SetInput(i.Current()->Key, inputs.back().data(), shape, t->Dimension);
+        b->SetInput(i.Current()->Key, inputs.back().data(), shape, t->Dimension);
+    }
+    bool same = a->Run() && b->Run() && expected->Outputs.Count() == actual->Outputs.Count();
+    KeyValueCollection<Link *>::Iterator<KeyValue<Link *>> o = expected->Outputs.GetIterator();
+    while (same && o.MoveNext())
+    {
+        Tensor *x = a->GetOutput(o.Current()->Key);
+        Tensor *y = b->GetOutput(o.Current()->Key);
+        // an output may be missing when the inputs are not typed by the model.
+        same = (!x && !y) || (x && y && x->Size == y->Size && memcmp(x->Data, y->Data, x->Size) == 0);
+    }
+    delete a;
+    delete b;
+    delete engine;
+    return same;
+}
+
+int main(int argc, char **argv)
+{
+    const char *filename = argc > 1 ? argv[1] : "models/Abs/abs.onnx";
+    std::string imageName = argc > 2 ? argv[2] : std::string(filename) + ".cmf";
+    size_t modelSize;
+    char *model = ReadFileIntoMemory(filename, &modelSize);
+    if (!model)
+    {
+        std::cerr << "Failed to open file: " << filename << std::endl;
+        return 1;
+    }
+    Graph *graph = BuildOnnx(model, modelSize);
+    if (!graph)
+    {
+        return 1;
+    }
+
+    // write the image of the loaded graph, the operators have prepared their constants.
+    FlatGraphWriter writer;
+    size_t imageSize = writer.Write(graph, nullptr, 0);
+    std::vector<char> image(imageSize);
+    if (!imageSize || writer.Write(graph, image.data(), imageSize) != imageSize)
+    {
+        std::cerr << "write error [" << writer.GetError() << "]" << std::endl;
+        return 1;
+    }
+    std::ofstream(imageName, std::ios::binary).write(image.data(), imageSize);
+
+    size_t mappedSize;
+    const void *mapped = cm_map_file(imageName.c_str(), &mappedSize);
+    if (!mapped)
+    {
+        std::cerr << "Failed to map file: " << imageName << std::endl;
+        return 1;
+    }
+    Graph *flat = BuildFlat(mapped, mappedSize);
+    if (!flat)
+    {
+        return 1;
+    }
+    bool same = SameOutputs(graph, flat);
+    delete flat;
+    delete graph;
+
+    // the time from the bytes in memory to a graph ready to run.
+    auto start = std::chrono::high_resolution_clock::now();
+    for (int i = 0; i != BENCH_ITERATIONS; i++)
+    {
+        delete BuildOnnx(model, modelSize);
+    }
+    double onnx = std::chrono::duration<double, std::micro>(std::chrono::high_resolution_clock::now() - start).count() / BENCH_ITERATIONS;
+
+    start = std::chrono::high_resolution_clock::now();
+    for (int i = 0; i != BENCH_ITERATIONS; i++)
+    {
+        delete BuildFlat(mapped, mappedSize);
+    }
+    double flatTime = std::chrono::duration<double, std::micro>(std::chrono::high_resolution_clock::now() - start).count() / BENCH_ITERATIONS;
+
+    std::cout << "model,onnx_bytes,image_bytes,onnx_build_us,flat_build_us,speedup,same_outputs" << std::endl;
+    std::cout << filename << "," << modelSize << "," << imageSize << "," << onnx << "," << flatTime << "," << onnx / flatTime << "," << (same ? "yes" : "no") << std::endl;
+
+    cm_unmap_file(mapped, mappedSize);
+    delete[] model;
+    return same ? 0 : 1;
+}
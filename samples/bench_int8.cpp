@@ -0,0 +1,180 @@
+#include <iostream>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+
+#include "cm.h"
+#include "math/cm_gemm.hpp"
+
+using namespace CyanMycelium;
+
+#define BENCH_ITERATIONS 50
+
+// the projections of the LSTM layers, X [M x K] by W [N x K].
+// The first one is the layer of models/LSTM (input 2, hidden 3, 12 gates),
+// the others are the layers of bench_lstm (sequence of 32 tokens of 64 features).
+struct BenchShape
+{
+    const char *Name;
+    int M;
+    int N;
+    int K;
+};
+
+static BenchShape Shapes[] = {
+    {"lstm_model_w", 1, 12, 2},
+    {"lstm_model_r", 1, 12, 3},
+    {"lstm64_w", 32, 256, 64},
+    {"lstm128_w", 32, 512, 64},
+    {"lstm256_r", 32, 1024, 256},
+    {"lstm512_r", 32, 2048, 512},
+};
+
+static float *RandomBuffer(size_t count, float amplitude)
+{
+    float *buffer = new float[count];
+    for (size_t i = 0; i != count; i++)
+    {
+        buffer[i] = ((float)rand() / RAND_MAX - 0.5f) * 2 * amplitude;
+    }
+    return buffer;
+}
+
+/// @brief dynamic asymmetric uint8 quantization of the activations, as done by DynamicQuantizeLinear.
+static void QuantizeActivations(const float *x, size_t count, uint8_t *q, float *scale, int32_t *zero)
+{
+    float lo = 0, hi = 0;
+    for (size_t i = 0; i != count; i++)
+    {
+        lo = x[i] < lo ? x[i] : lo;
+        hi = x[i] > hi ? x[i] : hi;
+    }
+    *scale = hi > lo ? (hi - lo) / 255 : 1;
+    *zero = (int32_t)nearbyintf(-lo / *scale);
+    for (size_t i = 0; i != count; i++)
+    {
+        float v = nearbyintf(x[i] / *scale) + *zero;
+        q[i] = (uint8_t)(v < 0 ? 0 : v > 255 ? 255 : v);
+    }
+}
+
+/// @brief symmetric int8 quantization of the weights, with one scale per output channel or a single scale.
+static void QuantizeWeights(const float *w, int n, int k, bool perChannel, int8_t *q, float *scales)
+{
+    float tensorMax = 0;
+    for (int j = 0; j != n; j++)
+    {
+        float rowMax = 0;
+        for (int p = 0; p != k; p++)
+        {
+            rowMax = fmaxf(rowMax, fabsf(w[j * k + p]));
+        }
+        scales[j] = rowMax > 0 ? rowMax / 127 : 1;
+        tensorMax = fmaxf(tensorMax, rowMax);
+    }
+    for (int j = 0; j != n; j++)
+    {
+        if (!perChannel)
+        {
+            scales[j] = tensorMax > 0 ? tensorMax / 127 : 1;
+        }
+        for (int p = 0; p != k; p++)
+        {
+            q[j * k + p] = (int8_t)nearbyintf(w[j * k + p] / scales[j]);
+        }
+    }
+}
+
+static void Bench(BenchShape &s)
+{
+    int m = s.M, n = s.N, k = s.K;
+    float *x = RandomBuffer((size_t)m * k, 1.0f);
+    // the magnitude of the output channels varies, which is where the per channel scales help.
+    float *w = new float[(size_t)n * k];
+    for (int j = 0; j != n; j++)
+    {
+        float amplitude = 0.01f + 0.5f * (float)rand() / RAND_MAX;
+        for (int p = 0; p != k; p++)
+        {
+            w[j * k + p] = ((float)rand() / RAND_MAX - 0.5f) * 2 * amplitude;
+        }
+    }
+    float *yf = new float[(size_t)m * n];
+    float *yq = new float[(size_t)m * n];
+    uint8_t *xq = new uint8_t[(size_t)m * k];
+    int8_t *wq = new int8_t[(size_t)n * k];
+    int32_t *acc = new int32_t[(size_t)m * n];
+    int32_t *sums = new int32_t[n];
+    float *scales = new float[n];
+
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i != BENCH_ITERATIONS; i++)
+    {
+        cm_sgemm_nt(m, n, k, x, k, w, k, yf, n);
+    }
+    std::chrono::duration<double> floatElapsed = std::chrono::steady_clock::now() - start;
+    double ops = 2.0 * m * n * k * BENCH_ITERATIONS;
+
+    for (int perChannel = 0; perChannel != 2; perChannel++)
+    {
+        // the weights are prepared once, as the QuantizedMatMul prepack does.
+        QuantizeWeights(w, n, k, perChannel != 0, wq, scales);
+        cm_qgemm_sum_b(n, k, wq, k, sums);
+
+        // activations are quantized at every run, the cost is part of the measure.
+        float xScale;
+        int32_t xZero;
+        start = std::chrono::steady_clock::now();
+        for (int i = 0; i != BENCH_ITERATIONS; i++)
+        {
+            QuantizeActivations(x, (size_t)m * k, xq, &xScale, &xZero);
+            cm_qgemm_nt(m, n, k, xq, k, xZero, wq, k, nullptr, acc, n, sums);
+            for (int r = 0; r != m; r++)
+            {
+                for (int j = 0; j != n; j++)
+                {
+                    yq[r * n + j] = acc[r * n + j] * xScale * scales[j];
+                }
+            }
+        }
+        std::chrono::duration<double> int8Elapsed = std::chrono::steady_clock::now() - start;
+
+        double errorNorm = 0, norm = 0, maxError = 0;
+        for (size_t i = 0; i != (size_t)m * n; i++)
+        {
+            double e = fabs((double)yq[i] - yf[i]);
+            errorNorm += e * e;
+            norm += (double)yf[i] * yf[i];
+            maxError = e > maxError ? e : maxError;
+        }
+
+        std::cout << s.Name << "," << m << "," << n << "," << k << ","
+                  << (perChannel ? "per_channel" : "per_tensor") << ","
+                  << ops / floatElapsed.count() * 1e-9 << ","
+                  << ops / int8Elapsed.count() * 1e-9 << ","
+                  << floatElapsed.count() / int8Elapsed.count() << ","
+                  << sqrt(errorNorm / (norm > 0 ? norm : 1)) << ","
+                  << maxError << std::endl;
+    }
+
+    delete[] x;
+    delete[] w;
+    delete[] yf;
+    delete[] yq;
+    delete[] xq;
+    delete[] wq;
+    delete[] acc;
+    delete[] sums;
+    delete[] scales;
+}
+
+int main()
+{
+    // dynamic uint8 activations by int8 weights against the float GEMM, single thread.
+    std::cout << "layer,m,n,k,weights,float_gops,int8_gops,speedup,rel_rms_error,max_abs_error" << std::endl;
+    for (BenchShape &s : Shapes)
+    {
+        Bench(s);
+    }
+    return 0;
+}
@@ -0,0 +1,101 @@
+#include <iostream>
+#include <chrono>
+#include <cstdlib>
+
+#include "cm_engine.hpp"
+#include "nodes/rnn/cm_lstm.hpp"
+
+using namespace CyanMycelium;
+
+#define BENCH_INPUT_SIZE 64
+#define BENCH_SEQ_LENGTH 32
+#define BENCH_BATCH_SIZE 1
+#define BENCH_ITERATIONS 20
+
+static float *RandomBuffer(size_t count)
+{
+    float *buffer = new float[count];
+    for (size_t i = 0; i != count; i++)
+    {
+        buffer[i] = ((float)rand() / RAND_MAX - 0.5f) * 0.2f;
+    }
+    return buffer;
+}
+
+/// @brief run a single LSTM layer and return the number of tokens processed per second.
+static double Bench(InferenceEngine *engine, int hidden)
+{
+    uint64_t xShape[3] = {BENCH_SEQ_LENGTH, BENCH_BATCH_SIZE, BENCH_INPUT_SIZE};
+    uint64_t wShape[3] = {1, (uint64_t)4 * hidden, BENCH_INPUT_SIZE};
+    uint64_t rShape[3] = {1, (uint64_t)4 * hidden, (uint64_t)hidden};
+    uint64_t bShape[2] = {1, (uint64_t)8 * hidden};
+
+    float *x = RandomBuffer(BENCH_SEQ_LENGTH * BENCH_BATCH_SIZE * BENCH_INPUT_SIZE);
+    float *w = RandomBuffer(4 * hidden * BENCH_INPUT_SIZE);
+    float *r = RandomBuffer(4 * hidden * hidden);
+    float *b = RandomBuffer(8 * hidden);
+
+    Graph graph;
+    Link *links[5];
+    for (int i = 0; i != 5; i++)
+    {
+        links[i] = new Link();
+        links[i]->Id = i;
+        graph.Links.Add(links[i]);
+    }
+    links[0]->SetPayloadInfos(xShape, 3, TDT_FLOAT);
+    links[1]->SetPayloadInfos(wShape, 3, TDT_FLOAT, w);
+    links[2]->SetPayloadInfos(rShape, 3, TDT_FLOAT, r);
+    links[3]->SetPayloadInfos(bShape, 2, TDT_FLOAT, b);
+
+    LSTM *lstm = new LSTM();
+    lstm->HiddenSize = hidden;
+    for (int i = 0; i != 4; i++)
+    {
+        links[i]->Ofin = lstm;
+        lstm->Opsc.Add(links[i]);
+    }
+    links[4]->Oini = lstm;
+    lstm->Onsc.Add(links[4]);
+    Operator *op = lstm;
+    graph.Nodes.Add(op);
+    graph.Inputs.Set("X", links[0]);
+    graph.Outputs.Set("Y", links[4]);
+    // as the graph builder does once the node is linked.
+    lstm->Prepack();
+
+    ActivationContextHandlers handlers;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i != BENCH_ITERATIONS; i++)
+    {
+        ActivationContext ctx(engine, &graph, &handlers);
+        ctx.SetInput("X", x);
+        ctx.Activate(op);
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+    delete lstm;
+    for (int i = 0; i != 5; i++)
+    {
+        delete links[i];
+    }
+    delete[] x;
+    delete[] w;
+    delete[] r;
+    delete[] b;
+    return (double)BENCH_SEQ_LENGTH * BENCH_BATCH_SIZE * BENCH_ITERATIONS / elapsed.count();
+}
+
+int main()
+{
+    InferenceEngineOptions options;
+    InferenceEngine engine(options, false);
+
+    int hiddenSizes[] = {32, 64, 128, 256, 512};
+    std::cout << "hidden_size,tokens_per_sec" << std::endl;
+    for (int hidden : hiddenSizes)
+    {
+        std::cout << hidden << "," << Bench(&engine, hidden) << std::endl;
+    }
+    return 0;
+}
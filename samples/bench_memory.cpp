@@ -0,0 +1,143 @@
+#include <iostream>
+#include <atomic>
+
+#include "cm_engine.hpp"
+#include "nodes/unary/cm_unary.hpp"
+
+using namespace CyanMycelium;
+
+#define BENCH_CHAIN_LENGTH 16
+#define BENCH_ELEMENT_COUNT (1 << 20)
+#define BENCH_HEADER_SIZE 16
+
+/// @brief a memory manager counting the live bytes, the size of every block is stored in front of it.
+class CountingMemoryManager : public IMemoryManager
+{
+public:
+    std::atomic<size_t> Live{0};
+    std::atomic<size_t> Peak{0};
+    std::atomic<size_t> Total{0};
+
+    void *Clone(void *ptr, const size_t size, int heap_id = 0) override
+    {
+        void *copy = this->Malloc(size, heap_id);
+        if (copy)
+        {
+            cm_memcpy(copy, ptr, size);
+        }
+        return copy;
+    }
+
+    void *Malloc(const size_t size, int heap_id = 0) override
+    {
+        char *block = (char *)cm_malloc(size + BENCH_HEADER_SIZE);
+        if (!block)
+        {
+            return nullptr;
+        }
+        *(size_t *)block = size;
+        size_t live = this->Live += size;
+        this->Total += size;
+        size_t peak = this->Peak;
+        while (live > peak && !this->Peak.compare_exchange_weak(peak, live))
+        {
+        }
+        return block + BENCH_HEADER_SIZE;
+    }
+
+    void *Realloc(void *ptr, const size_t size, int heap_id = 0) override
+    {
+        void *copy = this->Malloc(size, heap_id);
+        if (copy && ptr)
+        {
+            size_t old = *(size_t *)((char *)ptr - BENCH_HEADER_SIZE);
+            cm_memcpy(copy, ptr, min(old, size));
+            this->Free(ptr, heap_id);
+        }
+        return copy;
+    }
+
+    void Free(void *ptr, int heap_id = 0) override
+    {
+        if (ptr)
+        {
+            char *block = (char *)ptr - BENCH_HEADER_SIZE;
+            this->Live -= *(size_t *)block;
+            cm_free(block);
+        }
+    }
+};
+
+/// @brief a chain of element-wise operators, every operator produces an intermediate tensor.
+static Graph *BuildChain(Operator **ops, Link **links)
+{
+    uint64_t shape = BENCH_ELEMENT_COUNT;
+    Graph *graph = new Graph();
+    for (int i = 0; i <= BENCH_CHAIN_LENGTH; i++)
+    {
+        links[i] = new Link();
+        links[i]->Id = i;
+        links[i]->SetPayloadInfos(&shape, 1, TDT_FLOAT);
+        graph->Links.Add(links[i]);
+    }
+    for (int i = 0; i != BENCH_CHAIN_LENGTH; i++)
+    {
+        ops[i] = new Abs();
+        links[i]->Ofin = ops[i];
+        ops[i]->Opsc.Add(links[i]);
+        links[i + 1]->Oini = ops[i];
+        ops[i]->Onsc.Add(links[i + 1]);
+        graph->Nodes.Add(ops[i]);
+    }
+    graph->Inputs.Set("X", links[0]);
+    graph->Outputs.Set("Y", links[BENCH_CHAIN_LENGTH]);
+    return graph;
+}
+
+static void Bench(const char *name, bool inPlace)
+{
+    CountingMemoryManager memory;
+    InferenceEngineOptions options;
+    options.ThreadCount = 1;
+    options.MemoryManager = &memory;
+    InferenceEngine *engine = new InferenceEngine(options, false);
+
+    Operator *ops[BENCH_CHAIN_LENGTH];
+    Link *links[BENCH_CHAIN_LENGTH + 1];
+    Graph *graph = BuildChain(ops, links);
+    if (inPlace)
+    {
+        graph->AnalyzeInPlace();
+    }
+
+    float *x = new float[BENCH_ELEMENT_COUNT]();
+    ActivationContextHandlers handlers;
+    ActivationContext *ctx = new ActivationContext(engine, graph, &handlers);
+    ctx->SetInput("X", x);
+    ctx->Run();
+
+    // the allocated bytes are what the context held until its destruction when nothing was released.
+    std::cout << name << "," << memory.Total / 1024 << "," << memory.Peak / 1024 << "," << memory.Live / 1024 << std::endl;
+
+    delete ctx;
+    delete[] x;
+    for (int i = 0; i != BENCH_CHAIN_LENGTH; i++)
+    {
+        delete ops[i];
+    }
+    for (int i = 0; i <= BENCH_CHAIN_LENGTH; i++)
+    {
+        delete links[i];
+    }
+    delete graph;
+    delete engine;
+}
+
+int main()
+{
+    // one inference through BENCH_CHAIN_LENGTH element-wise operators of BENCH_ELEMENT_COUNT floats.
+    std::cout << "mode,allocated_kb,peak_kb,live_after_run_kb" << std::endl;
+    Bench("out_of_place", false);
+    Bench("in_place", true);
+    return 0;
+}
@@ -0,0 +1,99 @@
+#include <iostream>
+#include <chrono>
+#include <cstdlib>
+
+#include "cm_engine.hpp"
+#include "nodes/binary/cm_binary.hpp"
+#include "nodes/math/cm_mean.hpp"
+
+using namespace CyanMycelium;
+
+#define BENCH_ELEMENT_COUNT 10000000
+#define BENCH_ITERATIONS 20
+#define BENCH_MAX_THREADS 16
+
+static float *RandomBuffer(size_t count)
+{
+    float *buffer = new float[count];
+    for (size_t i = 0; i != count; i++)
+    {
+        buffer[i] = (float)rand() / RAND_MAX;
+    }
+    return buffer;
+}
+
+/// @brief run the operator on inputs of BENCH_ELEMENT_COUNT floats and return the average time in milliseconds.
+static double Bench(InferenceEngine *engine, Operator *op, int inputCount, float **inputs)
+{
+    uint64_t shape = BENCH_ELEMENT_COUNT;
+    const char *names[2] = {"X", "Y"};
+
+    Graph graph;
+    Link *links[3];
+    for (int i = 0; i <= inputCount; i++)
+    {
+        links[i] = new Link();
+        links[i]->Id = i;
+        graph.Links.Add(links[i]);
+    }
+    for (int i = 0; i != inputCount; i++)
+    {
+        links[i]->SetPayloadInfos(&shape, 1, TDT_FLOAT);
+        links[i]->Ofin = op;
+        op->Opsc.Add(links[i]);
+        graph.Inputs.Set(names[i], links[i]);
+    }
+    links[inputCount]->Oini = op;
+    op->Onsc.Add(links[inputCount]);
+    graph.Nodes.Add(op);
+    graph.Outputs.Set("Z", links[inputCount]);
+
+    ActivationContextHandlers handlers;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i != BENCH_ITERATIONS; i++)
+    {
+        ActivationContext ctx(engine, &graph, &handlers);
+        for (int j = 0; j != inputCount; j++)
+        {
+            ctx.SetInput(names[j], inputs[j]);
+        }
+        ctx.Activate(op);
+    }
+    std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+
+    delete op;
+    for (int i = 0; i <= inputCount; i++)
+    {
+        delete links[i];
+    }
+    return elapsed.count() / BENCH_ITERATIONS;
+}
+
+int main()
+{
+    float *inputs[2] = {RandomBuffer(BENCH_ELEMENT_COUNT), RandomBuffer(BENCH_ELEMENT_COUNT)};
+    double addSerial = 0;
+    double meanSerial = 0;
+
+    std::cout << "threads,add_ms,add_speedup,mean_ms,mean_speedup" << std::endl;
+    for (int threads = 1; threads <= BENCH_MAX_THREADS; threads++)
+    {
+        InferenceEngineOptions options;
+        options.ThreadCount = threads;
+        // the engine is never deleted, the stopped workers simply exit with the process.
+        InferenceEngine *engine = new InferenceEngine(options);
+
+        double addMs = Bench(engine, new Add(), 2, inputs);
+        double meanMs = Bench(engine, new Mean(), 1, inputs);
+        if (threads == 1)
+        {
+            addSerial = addMs;
+            meanSerial = meanMs;
+        }
+        std::cout << threads << "," << addMs << "," << addSerial / addMs << "," << meanMs << "," << meanSerial / meanMs << std::endl;
+        engine->Stop();
+    }
+    delete[] inputs[0];
+    delete[] inputs[1];
+    return 0;
+}
@@ -0,0 +1,93 @@
+#include <iostream>
+#include <chrono>
+#include <cstdlib>
+#include <vector>
+
+#include "cm_engine.hpp"
+#include "nodes/cm_nodes_registry.hpp"
+
+using namespace CyanMycelium;
+
+#define BENCH_FEATURES 4
+#define BENCH_CHAIN_LENGTH 32
+#define BENCH_BUCKET_COUNT 4
+#define BENCH_ITERATIONS 2000
+
+/// @brief run a chain of Abs over X [seq_length, BENCH_FEATURES], seq_length being symbolic, cycling over a few sequence
+/// lengths as a server batching its requests into buckets. Return the time of a Run in microseconds.
+static double Bench(int capacity, Graph *graph, float *x)
+{
+    InferenceEngineOptions options;
+    options.PlanCacheCapacity = capacity;
+    InferenceEngine engine(options, false);
+    ActivationContextHandlers handlers;
+    ActivationContext *ctx = new ActivationContext(&engine, graph, &handlers);
+    // short sequences, so the time of the planning is not hidden by the kernels.
+    uint64_t lengths[BENCH_BUCKET_COUNT] = {1, 2, 3, 4};
+
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i != BENCH_ITERATIONS; i++)
+    {
+        uint64_t shape[2] = {lengths[i % BENCH_BUCKET_COUNT], BENCH_FEATURES};
+        ctx->SetInput("X", x, shape, 2);
+        if (!ctx->Run())
+        {
+            std::cerr << "run error [" << ctx->GetError() << "]" << std::endl;
+            break;
+        }
+    }
+    std::chrono::duration<double, std::micro> elapsed = std::chrono::steady_clock::now() - start;
+    std::cout << capacity << "," << BENCH_BUCKET_COUNT << "," << elapsed.count() / BENCH_ITERATIONS << ","
+              << ctx->GetPlanCache()->GetHits() << "," << ctx->GetPlanCache()->GetMisses() << std::endl;
+    delete ctx;
+    return elapsed.count() / BENCH_ITERATIONS;
+}
+
+int main()
+{
+    // X [seq_length, BENCH_FEATURES] -> Abs -> ... -> Abs -> Y
+    uint64_t xShape[2] = {TENSOR_DYNAMIC_DIM, BENCH_FEATURES};
+    std::vector<float> x(4 * BENCH_FEATURES);
+    for (size_t i = 0; i != x.size(); i++)
+    {
+        x[i] = (float)rand() / RAND_MAX - 0.5f;
+    }
+    Graph graph;
+    std::vector<Link *> links;
+    for (int i = 0; i != BENCH_CHAIN_LENGTH + 1; i++)
+    {
+        Link *l = new Link();
+        l->Id = i;
+        links.push_back(l);
+        graph.Links.Add(l);
+    }
+    links[0]->SetPayloadInfos(xShape, 2, TDT_FLOAT);
+    for (int i = 0; i != BENCH_CHAIN_LENGTH; i++)
+    {
+        Operator *op = NodeRegistry::ForName("Abs");
+        links[i]->Ofin = op;
+        op->Opsc.Add(links[i]);
+        links[i + 1]->Oini = op;
+        op->Onsc.Add(links[i + 1]);
+        graph.Nodes.Add(op);
+    }
+    graph.Inputs.Set("X", links[0]);
+    graph.Outputs.Set("Y", links[BENCH_CHAIN_LENGTH]);
+    graph.AnalyzeInPlace();
+
+    // a single plan is built again on every Run, while a plan per bucket keeps the shapes hot.
+    std::cout << "plan_cache_capacity,buckets,run_us,hits,misses" << std::endl;
+    double replanned = Bench(1, &graph, x.data());
+    double cached = Bench(BENCH_BUCKET_COUNT, &graph, x.data());
+    std::cout << "speedup," << replanned / cached << std::endl;
+
+    for (int i = 0; i != graph.Nodes.Count(); i++)
+    {
+        delete graph.Nodes[i];
+    }
+    for (Link *l : links)
+    {
+        delete l;
+    }
+    return 0;
+}
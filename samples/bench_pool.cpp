@@ -0,0 +1,138 @@
+#include "cm_bench.hpp"
+
+#include "cm_engine.hpp"
+#include "nodes/cm_nodes_registry.hpp"
+#include "nodes/nn/cm_pool.hpp"
+
+using namespace CyanMycelium;
+
+#define BENCH_MAX_ERROR 1e-5f
+
+struct BenchShape
+{
+    const char *Name;
+    const char *Type; // MaxPool, AveragePool or GlobalAveragePool
+    int Channels;
+    int Height;
+    int Width;
+    int Kernel;
+    int Stride;
+    int Pad;
+};
+
+static int OutSize(int in, const BenchShape &s) { return s.Kernel ? (in + 2 * s.Pad - s.Kernel) / s.Stride + 1 : 1; }
+
+/// @brief the plain loops over every plane, as the baseline and the reference of the kernels. The padding is not counted
+/// by the average.
+static void Reference(const BenchShape &s, const float *x, float *y)
+{
+    bool isMax = s.Type[0] == 'M';
+    int kernel = s.Kernel ? s.Kernel : s.Height;
+    int kernelW = s.Kernel ? s.Kernel : s.Width;
+    int oh = OutSize(s.Height, s);
+    int ow = OutSize(s.Width, s);
+    for (int c = 0; c != s.Channels; c++)
+        for (int i = 0; i != oh; i++)
+            for (int j = 0; j != ow; j++)
+            {
+                float acc = isMax ? -INFINITY : 0.0f;
+                int count = 0;
+                for (int u = 0; u != kernel; u++)
+                    for (int v = 0; v != kernelW; v++)
+                    {
+                        int ih = i * s.Stride + u - s.Pad;
+                        int iw = j * s.Stride + v - s.Pad;
+                        if (ih >= 0 && ih < s.Height && iw >= 0 && iw < s.Width)
+                        {
+                            float value = x[((size_t)c * s.Height + ih) * s.Width + iw];
+                            acc = isMax ? (value > acc ? value : acc) : acc + value;
+                            count++;
+                        }
+                    }
+                y[((size_t)c * oh + i) * ow + j] = isMax ? acc : acc / count;
+            }
+}
+
+/// @brief run a single pool layer, return its time in milliseconds and the largest error against the reference.
+static double Bench(InferenceEngine *engine, const BenchShape &s, float *x, const float *expected, float *error)
+{
+    uint64_t xShape[4] = {1, (uint64_t)s.Channels, (uint64_t)s.Height, (uint64_t)s.Width};
+    std::vector<float> y((size_t)s.Channels * OutSize(s.Height, s) * OutSize(s.Width, s));
+
+    Graph graph;
+    Link *links[2];
+    for (int i = 0; i != 2; i++)
+    {
+        links[i] = new Link();
+        links[i]->Id = i;
+        graph.Links.Add(links[i]);
+    }
+    links[0]->SetPayloadInfos(xShape, 4, TDT_FLOAT);
+
+    Operator *op = NodeRegistry::ForName(s.Type);
+    if (s.Kernel)
+    {
+        PoolOperator *pool = (PoolOperator *)op;
+        pool->KernelShape[0] = pool->KernelShape[1] = s.Kernel;
+        pool->Strides[0] = pool->Strides[1] = s.Stride;
+        pool->Pads[0] = pool->Pads[1] = pool->Pads[2] = pool->Pads[3] = s.Pad;
+        pool->KernelRank = pool->StrideCount = 2;
+        pool->PadCount = 4;
+    }
+    links[0]->Ofin = op;
+    op->Opsc.Add(links[0]);
+    links[1]->Oini = op;
+    op->Onsc.Add(links[1]);
+    graph.Nodes.Add(op);
+    graph.Inputs.Set("X", links[0]);
+    graph.Outputs.Set("Y", links[1]);
+
+    ActivationContextHandlers handlers;
+    double ms = Measure([&]()
+                        {
+                            ActivationContext ctx(engine, &graph, &handlers);
+                            ctx.SetInput("X", x);
+                            ctx.SetOutput("Y", y.data());
+                            ctx.Activate(op); });
+
+    *error = MaxError(y.data(), expected, y.size());
+    delete op;
+    for (int i = 0; i != 2; i++)
+    {
+        delete links[i];
+    }
+    return ms;
+}
+
+int main()
+{
+    InferenceEngineOptions options;
+    InferenceEngine engine(options, false);
+
+    // the pools of the common image models, a kernel of 0 is global.
+    BenchShape shapes[] = {
+        {"resnet_maxpool_3x3s2", "MaxPool", 64, 112, 112, 3, 2, 1},
+        {"vgg_maxpool_2x2s2_64", "MaxPool", 64, 224, 224, 2, 2, 0},
+        {"vgg_maxpool_2x2s2_512", "MaxPool", 512, 28, 28, 2, 2, 0},
+        {"yolo_maxpool_5x5s1", "MaxPool", 256, 20, 20, 5, 1, 2},
+        {"inception_avgpool_3x3s1", "AveragePool", 192, 35, 35, 3, 1, 1},
+        {"densenet_avgpool_2x2s2", "AveragePool", 128, 56, 56, 2, 2, 0},
+        {"resnet_global_avgpool", "GlobalAveragePool", 2048, 7, 7, 0, 1, 0},
+        {"mobilenet_global_avgpool", "GlobalAveragePool", 1280, 7, 7, 0, 1, 0},
+    };
+
+    BenchReport report("layer,naive_ms,ms,speedup,gbytes_per_s,max_error");
+    for (const BenchShape &s : shapes)
+    {
+        std::vector<float> x = RandomBuffer((size_t)s.Channels * s.Height * s.Width);
+        std::vector<float> expected((size_t)s.Channels * OutSize(s.Height, s) * OutSize(s.Width, s));
+        double naive = Measure([&]()
+                               { Reference(s, x.data(), expected.data()); });
+
+        float error;
+        double ms = Bench(&engine, s, x.data(), expected.data(), &error);
+        double bytes = (double)(x.size() + expected.size()) * sizeof(float);
+        report.Row(error < BENCH_MAX_ERROR, s.Name, naive, ms, naive / ms, bytes / ms / 1e6, error);
+    }
+    return report.End();
+}
@@ -0,0 +1,192 @@
+#include <iostream>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include "cm_engine.hpp"
+#include "nodes/unary/cm_unary.hpp"
+
+using namespace CyanMycelium;
+
+#define BENCH_CHAIN_LENGTH 8
+#define BENCH_ELEMENT_COUNT 16384
+#define BENCH_BULK_SESSIONS 16
+#define BENCH_DURATION_MS 2000
+#define BENCH_INTERACTIVE_PERIOD_US 2000
+#define BENCH_INTERACTIVE_BUDGET_NS 1000000ULL
+#define BENCH_THREADS 2
+
+// a session slot, the bulk slots are resubmitted as soon as they end.
+struct BenchSlot
+{
+    ActivationContextHandlers Handlers;
+    std::atomic<bool> Done;
+    cm_uint64_t Started;
+    bool Interactive;
+    float *Buffer;
+};
+
+static LatencyHistogram *InteractiveLatency;
+static std::atomic<int> BulkEnded;
+
+/// @brief a chain of element-wise operators, each one is a node activation going through the engine queue.
+static Graph *BuildChain(Operator **ops, Link **links)
+{
+    uint64_t shape = BENCH_ELEMENT_COUNT;
+    Graph *graph = new Graph();
+    for (int i = 0; i <= BENCH_CHAIN_LENGTH; i++)
+    {
+        links[i] = new Link();
+        links[i]->Id = i;
+        links[i]->SetPayloadInfos(&shape, 1, TDT_FLOAT);
+        graph->Links.Add(links[i]);
+    }
+    for (int i = 0; i != BENCH_CHAIN_LENGTH; i++)
+    {
+        ops[i] = new Abs();
+        links[i]->Ofin = ops[i];
+        ops[i]->Opsc.Add(links[i]);
+        links[i + 1]->Oini = ops[i];
+        ops[i]->Onsc.Add(links[i + 1]);
+        graph->Nodes.Add(ops[i]);
+    }
+    graph->Inputs.Set("X", links[0]);
+    graph->Outputs.Set("Y", links[BENCH_CHAIN_LENGTH]);
+    return graph;
+}
+
+static void OnEnded(ActivationContext *ctx, void *userData)
+{
+    BenchSlot *slot = (BenchSlot *)userData;
+    if (slot->Interactive)
+    {
+        InteractiveLatency->Record(cm_time_ns() - slot->Started);
+    }
+    else
+    {
+        BulkEnded++;
+    }
+    slot->Done = true;
+}
+
+static void Submit(InferenceEngine *engine, Graph *graph, BenchSlot *slot, std::vector<AsyncActivationContext *> &sessions)
+{
+    // the sessions are released at the end, a worker may still be unwinding the last activation.
+    AsyncActivationContext *session = engine->CreateInferenceSession(graph, &slot->Handlers);
+    if (slot->Interactive)
+    {
+        session->SetPriority(CM_SCHEDULING_CLASS_COUNT - 1);
+        session->SetDeadline(BENCH_INTERACTIVE_BUDGET_NS);
+    }
+    else
+    {
+        session->SetPriority(0);
+    }
+    sessions.push_back(session);
+    session->SetInput("X", slot->Buffer);
+    slot->Done = false;
+    slot->Started = cm_time_ns();
+    session->Run();
+}
+
+static void Bench(const char *name, SchedulingPolicy policy)
+{
+    InferenceEngineOptions options;
+    options.ThreadCount = BENCH_THREADS;
+    options.QueueCapacity = 64;
+    options.ReservedCapacity = 64;
+    options.AdmissionTimeout = CM_INFINITE;
+    // keep the kernels on a single worker, the bench measures the scheduling of the activations.
+    options.ParallelThreshold = (size_t)-1;
+    options.Scheduling = policy;
+    InferenceEngine *engine = new InferenceEngine(options);
+
+    Operator *ops[BENCH_CHAIN_LENGTH];
+    Link *links[BENCH_CHAIN_LENGTH + 1];
+    Graph *graph = BuildChain(ops, links);
+
+    InteractiveLatency = new LatencyHistogram();
+    BulkEnded = 0;
+    BenchSlot slots[BENCH_BULK_SESSIONS + 1];
+    std::vector<AsyncActivationContext *> sessions;
+    for (int i = 0; i <= BENCH_BULK_SESSIONS; i++)
+    {
+        slots[i].Handlers.UserData = slots + i;
+        slots[i].Handlers.OnEnded = OnEnded;
+        slots[i].Interactive = i == BENCH_BULK_SESSIONS;
+        slots[i].Buffer = new float[BENCH_ELEMENT_COUNT]();
+        slots[i].Done = true;
+    }
+
+    cm_uint64_t start = cm_time_ns();
+    cm_uint64_t end = start + BENCH_DURATION_MS * 1000000ULL;
+    cm_uint64_t nextInteractive = start;
+    cm_uint64_t now;
+    while ((now = cm_time_ns()) < end)
+    {
+        for (int i = 0; i != BENCH_BULK_SESSIONS; i++)
+        {
+            if (slots[i].Done)
+            {
+                Submit(engine, graph, slots + i, sessions);
+            }
+        }
+        BenchSlot *interactive = slots + BENCH_BULK_SESSIONS;
+        if (now >= nextInteractive && interactive->Done)
+        {
+            Submit(engine, graph, interactive, sessions);
+            nextInteractive = now + BENCH_INTERACTIVE_PERIOD_US * 1000ULL;
+        }
+        std::this_thread::sleep_for(std::chrono::microseconds(50));
+    }
+    double elapsed = (cm_time_ns() - start) * 1e-9;
+    int bulk = BulkEnded;
+
+    // wait for the running inferences before releasing anything.
+    for (int i = 0; i <= BENCH_BULK_SESSIONS; i++)
+    {
+        while (!slots[i].Done)
+        {
+            std::this_thread::sleep_for(std::chrono::microseconds(100));
+        }
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+
+    std::cout << name << "," << InteractiveLatency->GetCount() << ","
+              << InteractiveLatency->GetValueAt(50) / 1000.0 << ","
+              << InteractiveLatency->GetValueAt(99) / 1000.0 << ","
+              << InteractiveLatency->GetMax() / 1000.0 << ","
+              << bulk / elapsed << std::endl;
+
+    for (AsyncActivationContext *session : sessions)
+    {
+        delete session;
+    }
+    for (int i = 0; i <= BENCH_BULK_SESSIONS; i++)
+    {
+        delete[] slots[i].Buffer;
+    }
+    for (int i = 0; i != BENCH_CHAIN_LENGTH; i++)
+    {
+        delete ops[i];
+    }
+    for (int i = 0; i <= BENCH_CHAIN_LENGTH; i++)
+    {
+        delete links[i];
+    }
+    delete graph;
+    delete InteractiveLatency;
+    // the engine is not released, the workers may still be waiting on the queue.
+    engine->Stop();
+}
+
+int main()
+{
+    // BENCH_BULK_SESSIONS sessions keep the workers busy while an interactive session is submitted every
+    // BENCH_INTERACTIVE_PERIOD_US, the latency of the interactive inferences is measured from Run to the end.
+    std::cout << "policy,interactive_count,interactive_p50_us,interactive_p99_us,interactive_max_us,bulk_inferences_per_sec" << std::endl;
+    Bench("fifo", CM_SCHEDULING_FIFO);
+    Bench("edf", CM_SCHEDULING_EDF);
+    Bench("weighted", CM_SCHEDULING_WEIGHTED);
+    return 0;
+}
@@ -0,0 +1,173 @@
+#include <cstring>
+
+#include "cm_bench.hpp"
+
+#include "cm_engine.hpp"
+#include "nodes/cm_nodes_registry.hpp"
+#include "nodes/nn/cm_softmax.hpp"
+#include "nodes/nn/cm_layer_norm.hpp"
+
+using namespace CyanMycelium;
+
+#define BENCH_MAX_ERROR 1e-4f
+
+struct BenchShape
+{
+    const char *Name;
+    const char *Type; // Softmax, LogSoftmax or LayerNormalization
+    int Rows;
+    int Size;
+};
+
+/// @brief the decomposed form exported by the frameworks, one pass and one intermediate tensor per elementary operator:
+/// ReduceMax, Sub, Exp, ReduceSum and Div (or Log and Sub), or ReduceMean, Sub, Pow, ReduceMean, Add, Sqrt, Div, Mul and Add.
+/// It is the baseline and the reference of the fused kernels.
+static void Decomposed(const BenchShape &s, const float *x, const float *scale, const float *bias, float *y, std::vector<float> &t0, std::vector<float> &t1)
+{
+    size_t count = (size_t)s.Rows * s.Size;
+    std::vector<float> r0(s.Rows), r1(s.Rows);
+    if (s.Type[0] == 'L' && s.Type[1] == 'a')
+    {
+        for (int r = 0; r != s.Rows; r++)
+        {
+            double acc = 0;
+            for (int i = 0; i != s.Size; i++)
+                acc += x[(size_t)r * s.Size + i];
+            r0[r] = (float)(acc / s.Size);
+        }
+        for (size_t i = 0; i != count; i++)
+            t0[i] = x[i] - r0[i / s.Size];
+        for (size_t i = 0; i != count; i++)
+            t1[i] = powf(t0[i], 2.0f);
+        for (int r = 0; r != s.Rows; r++)
+        {
+            double acc = 0;
+            for (int i = 0; i != s.Size; i++)
+                acc += t1[(size_t)r * s.Size + i];
+            r1[r] = (float)(acc / s.Size);
+        }
+        for (int r = 0; r != s.Rows; r++)
+            r1[r] = sqrtf(r1[r] + 1e-5f);
+        for (size_t i = 0; i != count; i++)
+            t1[i] = t0[i] / r1[i / s.Size];
+        for (size_t i = 0; i != count; i++)
+            t0[i] = t1[i] * scale[i % s.Size];
+        for (size_t i = 0; i != count; i++)
+            y[i] = t0[i] + bias[i % s.Size];
+        return;
+    }
+    bool log = s.Type[0] == 'L';
+    for (int r = 0; r != s.Rows; r++)
+    {
+        float m = -INFINITY;
+        for (int i = 0; i != s.Size; i++)
+            m = max(m, x[(size_t)r * s.Size + i]);
+        r0[r] = m;
+    }
+    for (size_t i = 0; i != count; i++)
+        t0[i] = x[i] - r0[i / s.Size];
+    for (size_t i = 0; i != count; i++)
+        t1[i] = expf(t0[i]);
+    for (int r = 0; r != s.Rows; r++)
+    {
+        double acc = 0;
+        for (int i = 0; i != s.Size; i++)
+            acc += t1[(size_t)r * s.Size + i];
+        r1[r] = (float)acc;
+    }
+    if (log)
+    {
+        for (int r = 0; r != s.Rows; r++)
+            r1[r] = logf(r1[r]);
+        for (size_t i = 0; i != count; i++)
+            y[i] = t0[i] - r1[i / s.Size];
+        return;
+    }
+    for (size_t i = 0; i != count; i++)
+        y[i] = t1[i] / r1[i / s.Size];
+}
+
+/// @brief run a single fused layer, return its time in milliseconds and the largest error against the reference.
+static double Bench(InferenceEngine *engine, const BenchShape &s, float *x, float *scale, float *bias, const float *expected, float *error)
+{
+    uint64_t xShape[2] = {(uint64_t)s.Rows, (uint64_t)s.Size};
+    uint64_t pShape[1] = {(uint64_t)s.Size};
+    std::vector<float> y((size_t)s.Rows * s.Size);
+    bool norm = strcmp(s.Type, "LayerNormalization") == 0;
+    int inputCount = norm ? 3 : 1;
+
+    Graph graph;
+    Link *links[4];
+    for (int i = 0; i != 4; i++)
+    {
+        links[i] = new Link();
+        links[i]->Id = i;
+        graph.Links.Add(links[i]);
+    }
+    links[0]->SetPayloadInfos(xShape, 2, TDT_FLOAT);
+    links[1]->SetPayloadInfos(pShape, 1, TDT_FLOAT, scale);
+    links[2]->SetPayloadInfos(pShape, 1, TDT_FLOAT, bias);
+
+    Operator *op = NodeRegistry::ForName(s.Type);
+    for (int i = 0; i != inputCount; i++)
+    {
+        links[i]->Ofin = op;
+        op->Opsc.Add(links[i]);
+    }
+    links[3]->Oini = op;
+    op->Onsc.Add(links[3]);
+    graph.Nodes.Add(op);
+    graph.Inputs.Set("X", links[0]);
+    graph.Outputs.Set("Y", links[3]);
+
+    ActivationContextHandlers handlers;
+    double ms = Measure([&]()
+                        {
+                            ActivationContext ctx(engine, &graph, &handlers);
+                            ctx.SetInput("X", x);
+                            ctx.SetOutput("Y", y.data());
+                            ctx.Activate(op); });
+
+    *error = MaxError(y.data(), expected, y.size());
+    delete op;
+    for (int i = 0; i != 4; i++)
+    {
+        delete links[i];
+    }
+    return ms;
+}
+
+int main()
+{
+    InferenceEngineOptions options;
+    InferenceEngine engine(options, false);
+
+    // the attention scores and the classifier heads, then the layer norms of the transformer encoders.
+    BenchShape shapes[] = {
+        {"bert_attention_softmax_128", "Softmax", 12 * 128, 128},
+        {"bert_attention_softmax_512", "Softmax", 12 * 512, 512},
+        {"imagenet_classifier_softmax", "Softmax", 8, 1000},
+        {"lm_head_logsoftmax", "LogSoftmax", 4, 32000},
+        {"bert_base_layernorm", "LayerNormalization", 128, 768},
+        {"bert_large_layernorm", "LayerNormalization", 512, 1024},
+        {"vit_tiny_layernorm", "LayerNormalization", 197, 192},
+    };
+
+    BenchReport report("layer,decomposed_ms,ms,speedup,gbytes_per_s,max_error");
+    for (const BenchShape &s : shapes)
+    {
+        size_t count = (size_t)s.Rows * s.Size;
+        std::vector<float> x = RandomBuffer(count, 8.0f);
+        std::vector<float> scale = RandomBuffer(s.Size, 2.0f);
+        std::vector<float> bias = RandomBuffer(s.Size, 2.0f);
+        std::vector<float> expected(count), t0(count), t1(count);
+        double decomposed = Measure([&]()
+                                    { Decomposed(s, x.data(), scale.data(), bias.data(), expected.data(), t0, t1); });
+
+        float error;
+        double ms = Bench(&engine, s, x.data(), scale.data(), bias.data(), expected.data(), &error);
+        double bytes = 2.0 * count * sizeof(float);
+        report.Row(error < BENCH_MAX_ERROR, s.Name, decomposed, ms, decomposed / ms, bytes / ms / 1e6, error);
+    }
+    return report.End();
+}
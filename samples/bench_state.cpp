@@ -0,0 +1,120 @@
+#include <iostream>
+#include <chrono>
+#include <thread>
+#include <vector>
+#include <string>
+
+#include "cm_engine.hpp"
+#include "nodes/unary/cm_unary.hpp"
+
+using namespace CyanMycelium;
+
+#define BENCH_CHAIN_LENGTH 32
+#define BENCH_ITERATIONS 20000
+#define BENCH_MAX_THREADS 8
+
+/// @brief parallel chains of element-wise operators on a single value, so the time goes to the activation rather than to the kernels.
+/// The links are numbered level by level, as a builder reading the nodes of parallel branches in turn does,
+/// so the neighbouring link ids belong to different chains.
+static Graph *BuildChains(int chains, std::vector<Operator *> &ops, std::vector<Link *> &links)
+{
+    uint64_t shape = 1;
+    Graph *graph = new Graph(chains * BENCH_CHAIN_LENGTH, chains * (BENCH_CHAIN_LENGTH + 1));
+    for (int i = 0; i <= BENCH_CHAIN_LENGTH; i++)
+    {
+        for (int c = 0; c != chains; c++)
+        {
+            Link *l = new Link();
+            l->Id = graph->Links.Count();
+            l->SetPayloadInfos(&shape, 1, TDT_FLOAT);
+            graph->Links.Add(l);
+            links.push_back(l);
+            if (i)
+            {
+                Link *previous = links[(i - 1) * chains + c];
+                Operator *op = new Abs();
+                previous->Ofin = op;
+                op->Opsc.Add(previous);
+                l->Oini = op;
+                op->Onsc.Add(l);
+                graph->Nodes.Add(op);
+                ops.push_back(op);
+            }
+        }
+    }
+    for (int c = 0; c != chains; c++)
+    {
+        graph->Inputs.Set(("X" + std::to_string(c)).c_str(), links[c]);
+        graph->Outputs.Set(("Y" + std::to_string(c)).c_str(), links[BENCH_CHAIN_LENGTH * chains + c]);
+    }
+    graph->AnalyzeInPlace();
+    return graph;
+}
+
+// every thread drives its own chain, as the workers of the engine do with the parallel branches of a model.
+static void RunChain(ActivationContext *ctx, Link *input)
+{
+    for (int i = 0; i != BENCH_ITERATIONS; i++)
+    {
+        ctx->Activate(input);
+    }
+}
+
+// the wall time of a node activation within a chain.
+static double Bench(InferenceEngine *engine, Graph *graph, int chains, int lineSize)
+{
+    graph->Compile(lineSize);
+    ActivationContextHandlers handlers;
+    ActivationContext *ctx = new ActivationContext(engine, graph, &handlers);
+    std::vector<float> inputs(chains, -1.0f);
+    for (int c = 0; c != chains; c++)
+    {
+        ctx->SetInput(("X" + std::to_string(c)).c_str(), &inputs[c]);
+    }
+
+    std::vector<std::thread> threads;
+    auto start = std::chrono::high_resolution_clock::now();
+    for (int c = 0; c != chains; c++)
+    {
+        threads.emplace_back(RunChain, ctx, graph->Links[c]);
+    }
+    for (std::thread &t : threads)
+    {
+        t.join();
+    }
+    double elapsed = std::chrono::duration<double, std::nano>(std::chrono::high_resolution_clock::now() - start).count();
+    delete ctx;
+    return elapsed / ((double)BENCH_ITERATIONS * BENCH_CHAIN_LENGTH);
+}
+
+int main()
+{
+    InferenceEngineOptions options;
+    options.ThreadCount = 1;
+    InferenceEngine *engine = new InferenceEngine(options, false);
+    int maxThreads = (int)std::thread::hardware_concurrency();
+    maxThreads = min(max(maxThreads, 1), BENCH_MAX_THREADS);
+
+    // the states packed by link id, then laid out by chain with each chain on its own cache lines.
+    std::cout << "threads,packed_ns_per_node,lanes_ns_per_node,speedup" << std::endl;
+    for (int threads = 1; threads <= maxThreads; threads *= 2)
+    {
+        std::vector<Operator *> ops;
+        std::vector<Link *> links;
+        Graph *graph = BuildChains(threads, ops, links);
+        double packed = Bench(engine, graph, threads, 0);
+        double lanes = Bench(engine, graph, threads, CM_STATE_CACHE_LINE_SIZE);
+        std::cout << threads << "," << packed << "," << lanes << "," << packed / lanes << std::endl;
+        for (Operator *op : ops)
+        {
+            delete op;
+        }
+        for (Link *l : links)
+        {
+            delete l;
+        }
+        delete graph;
+    }
+    delete engine;
+    return 0;
+}
@@ -0,0 +1,146 @@
+#include <iostream>
+#include <chrono>
+#include <cstdlib>
+
+#include "cm_graph.hpp"
+#include "nodes/unary/cm_unary.hpp"
+#include "nodes/binary/cm_binary.hpp"
+
+using namespace CyanMycelium;
+
+#define BENCH_NODE_COUNT 10000
+#define BENCH_ITERATIONS 200
+// the inputs of a node are taken among the outputs of the previous nodes of this window.
+#define BENCH_WINDOW 64
+
+/// @brief a random DAG of unary and binary operators, every edge is a link as built by the ONNX builder.
+static Graph *BuildGraph()
+{
+    Graph *graph = new Graph(BENCH_NODE_COUNT, BENCH_NODE_COUNT * 2);
+    Link *input = new Link();
+    input->Id = 0;
+    graph->Links.Add(input);
+    graph->Inputs.Set("X", input);
+    for (int i = 0; i != BENCH_NODE_COUNT; i++)
+    {
+        Operator *op = (i & 1) ? (Operator *)new Add() : (Operator *)new Abs();
+        int inputs = (i & 1) ? 2 : 1;
+        for (int j = 0; j != inputs; j++)
+        {
+            Link *l = new Link();
+            l->Id = graph->Links.Count();
+            if (i)
+            {
+                int from = i - 1 - rand() % BENCH_WINDOW;
+                from = max(from, 0);
+                l->Oini = graph->Nodes[from];
+                l->Oini->Onsc.Add(l);
+            }
+            l->Ofin = op;
+            op->Opsc.Add(l);
+            graph->Links.Add(l);
+        }
+        graph->Nodes.Add(op);
+    }
+    return graph;
+}
+
+static void DeleteGraph(Graph *graph)
+{
+    for (int i = 0; i != graph->Nodes.Count(); i++)
+    {
+        delete graph->Nodes[i];
+    }
+    for (int i = 0; i != graph->Links.Count(); i++)
+    {
+        delete graph->Links[i];
+    }
+    delete graph;
+}
+
+// the walk of the activation: check the inputs of every node, then visit its outputs and their destinations.
+static long WalkCollections(Graph *graph, const unsigned char *activ)
+{
+    long sum = 0;
+    int count = graph->Nodes.Count();
+    for (int n = 0; n != count; n++)
+    {
+        Operator *op = graph->Nodes[n];
+        int inputs = op->Opsc.Count();
+        for (int i = 0; i != inputs; i++)
+        {
+            sum += activ[op->Opsc[i]->Id];
+        }
+        int outputs = op->Onsc.Count();
+        for (int i = 0; i != outputs; i++)
+        {
+            Link *l = op->Onsc[i];
+            sum += l->Ofin ? l->Ofin->Opsc.Count() : 0;
+        }
+    }
+    return sum;
+}
+
+static long WalkTopology(const GraphTopology *t, const unsigned char *activ)
+{
+    long sum = 0;
+    int count = t->GetNodeCount();
+    for (int n = 0; n != count; n++)
+    {
+        const int32_t *inputs = t->GetInputs(n);
+        int inputCount = t->GetInputCount(n);
+        for (int i = 0; i != inputCount; i++)
+        {
+            sum += activ[inputs[i]];
+        }
+        const int32_t *outputs = t->GetOutputs(n);
+        int outputCount = t->GetOutputCount(n);
+        for (int i = 0; i != outputCount; i++)
+        {
+            int32_t next = t->GetTarget(outputs[i]);
+            sum += next >= 0 ? t->GetInputCount(next) : 0;
+        }
+    }
+    return sum;
+}
+
+int main()
+{
+    srand(1);
+    Graph *graph = BuildGraph();
+    if (!graph->Compile())
+    {
+        std::cout << "compile failed" << std::endl;
+        return 1;
+    }
+    int links = graph->Links.Count();
+    unsigned char *activ = new unsigned char[links];
+    for (int i = 0; i != links; i++)
+    {
+        activ[i] = rand() & 1;
+    }
+
+    // the same walk over the per node collections and over the compiled topology.
+    std::cout << "walk,nodes,links,checksum,ns_per_node" << std::endl;
+    long checksum = 0;
+    auto start = std::chrono::high_resolution_clock::now();
+    for (int i = 0; i != BENCH_ITERATIONS; i++)
+    {
+        checksum += WalkCollections(graph, activ);
+    }
+    double elapsed = std::chrono::duration<double, std::nano>(std::chrono::high_resolution_clock::now() - start).count();
+    std::cout << "collections," << BENCH_NODE_COUNT << "," << links << "," << checksum << "," << elapsed / BENCH_ITERATIONS / BENCH_NODE_COUNT << std::endl;
+
+    checksum = 0;
+    start = std::chrono::high_resolution_clock::now();
+    for (int i = 0; i != BENCH_ITERATIONS; i++)
+    {
+        checksum += WalkTopology(graph->GetTopology(), activ);
+    }
+    elapsed = std::chrono::duration<double, std::nano>(std::chrono::high_resolution_clock::now() - start).count();
+    std::cout << "topology," << BENCH_NODE_COUNT << "," << links << "," << checksum << "," << elapsed / BENCH_ITERATIONS / BENCH_NODE_COUNT << std::endl;
+
+    delete[] activ;
+    DeleteGraph(graph);
+    return 0;
+}
@@ -0,0 +1,156 @@
+#include <cstring>
+
+#include "cm_bench.hpp"
+
+#include "math/cm_vmath.hpp"
+
+using namespace CyanMycelium;
+
+// the number of floats of the throughput measures.
+#define BENCH_COUNT (1 << 16)
+// the number of floats checked by the accuracy sweeps, evenly spread over the bits of the range.
+#define BENCH_SWEEP_COUNT (1 << 24)
+
+typedef void (*ArrayFunction)(const float *x, float *y, size_t n);
+
+struct BenchFunction
+{
+    const char *Name;
+    ArrayFunction Vector;
+    double (*Reference)(double);
+    float (*Libm)(float); // the scalar float libm, the baseline of the throughput
+    float From; // the range of the accuracy sweep
+    float To;
+    double MaxUlp;      // the documented bound, see cm_vmath.hpp
+    double MaxAbsError; // the absolute bound, for the functions which cancel
+};
+
+static double Sigmoid(double x) { return 1.0 / (1.0 + exp(-x)); }
+static float Sigmoidf(float x) { return 1.0f / (1.0f + expf(-x)); }
+static double Gelu(double x) { return 0.5 * x * (1.0 + erf(x * M_SQRT1_2)); }
+static float Geluf(float x) { return 0.5f * x * (1.0f + erff(x * (float)M_SQRT1_2)); }
+static double GeluTanh(double x) { return 0.5 * x * (1.0 + tanh(0.797884560802865356 * (x + 0.044715 * x * x * x))); }
+static float GeluTanhf(float x) { return 0.5f * x * (1.0f + tanhf(0.797884560802865356f * (x + 0.044715f * x * x * x))); }
+
+/// @brief the distance between y and the exact value, in units of the last place of the exact value rounded to float.
+static double Ulp(float y, double exact)
+{
+    if (std::isnan(exact) || std::isnan(y))
+    {
+        return std::isnan(exact) == std::isnan(y) ? 0 : INFINITY;
+    }
+    if (std::isinf(exact) || std::fabs(exact) > 3.4028234663852886e38)
+    {
+        return std::isinf(y) && (y > 0) == (exact > 0) ? 0 : INFINITY;
+    }
+    // the subnormal results are flushed to zero.
+    if (std::fabs(exact) < 1.17549435e-38)
+    {
+        return std::fabs(y) < 1.17549435e-38f ? 0 : INFINITY;
+    }
+    int e;
+    std::frexp(exact, &e);
+    return std::fabs((double)y - exact) / std::ldexp(1.0, e - 24);
+}
+
+static uint32_t Bits(float f)
+{
+    uint32_t b;
+    memcpy(&b, &f, sizeof(b));
+    return b;
+}
+
+static float Float(uint32_t b)
+{
+    float f;
+    memcpy(&f, &b, sizeof(f));
+    return f;
+}
+
+/// @brief sweep the floats of [From, To], the negative and the positive sides separately as their bits go in
+/// opposite directions.
+static void Sweep(const BenchFunction &f, double *ulp, double *absError)
+{
+    std::vector<float> x, y;
+    float bounds[2][2] = {{min(f.From, 0.0f), min(f.To, 0.0f)}, {max(f.From, 0.0f), max(f.To, 0.0f)}};
+    for (int side = 0; side != 2; side++)
+    {
+        uint32_t a = Bits(bounds[side][0]);
+        uint32_t b = Bits(bounds[side][1]);
+        uint32_t lo = min(a, b);
+        uint32_t hi = max(a, b);
+        uint32_t step = max(1u, (hi - lo) / (BENCH_SWEEP_COUNT / 2));
+        for (uint32_t i = lo; i < hi; i += step)
+        {
+            x.push_back(Float(i));
+        }
+        x.push_back(Float(hi));
+    }
+    y.resize(x.size());
+    f.Vector(x.data(), y.data(), x.size());
+    *ulp = 0;
+    *absError = 0;
+    for (size_t i = 0; i != x.size(); i++)
+    {
+        double exact = f.Reference(x[i]);
+        *ulp = max(*ulp, Ulp(y[i], exact));
+        *absError = max(*absError, std::fabs((double)y[i] - exact));
+    }
+}
+
+static bool Specials(const BenchFunction &f)
+{
+    float x[] = {0.0f, -0.0f, INFINITY, -INFINITY, NAN, 1e-40f, -1e-40f, 100.0f, -100.0f};
+    const int count = sizeof(x) / sizeof(float);
+    float y[count];
+    f.Vector(x, y, count);
+    bool ok = true;
+    for (int i = 0; i != count; i++)
+    {
+        double exact = f.Reference(x[i]);
+        // the subnormal inputs may be flushed, which only matters for the functions going through the origin.
+        ok = ok && (Ulp(y[i], exact) <= f.MaxUlp || std::fabs(y[i] - exact) <= 1e-38 || std::fabs(x[i]) < 1e-38f);
+    }
+    return ok;
+}
+
+int main()
+{
+    BenchFunction functions[] = {
+        {"exp", cm_exp, exp, expf, -87.3f, 88.7f, 1, 0},
+        {"log", cm_log, log, logf, 1.17549435e-38f, 3.4e38f, 1, 0},
+        {"tanh", cm_tanh, tanh, tanhf, -10.0f, 10.0f, 2, 0},
+        {"sigmoid", cm_sigmoid, Sigmoid, Sigmoidf, -87.0f, 88.0f, 2.5, 0},
+        {"erf", cm_erf, erf, erff, -5.0f, 5.0f, 2, 0},
+        {"gelu", cm_gelu, Gelu, Geluf, -10.0f, 10.0f, INFINITY, 5e-7},
+        {"gelu_tanh", cm_gelu_tanh, GeluTanh, GeluTanhf, -10.0f, 10.0f, INFINITY, 5e-7},
+    };
+
+    std::vector<float> x(BENCH_COUNT), y(BENCH_COUNT);
+    BenchReport report("function,max_ulp,max_abs_error,specials,libm_ns,ns,speedup");
+    for (const BenchFunction &f : functions)
+    {
+        double ulp, absError;
+        Sweep(f, &ulp, &absError);
+        bool specials = Specials(f);
+
+        // the throughput over a range without the saturated values, in nanoseconds per item.
+        float from = max(f.From, -20.0f);
+        float to = min(f.To, 20.0f);
+        for (size_t i = 0; i != x.size(); i++)
+        {
+            x[i] = from + (to - from) * ((float)rand() / RAND_MAX);
+        }
+        double libm = Measure([&]()
+                              {
+                                  for (size_t i = 0; i != x.size(); i++)
+                                  {
+                                      y[i] = f.Libm(x[i]);
+                                  } }) * 1e6 / BENCH_COUNT;
+        double ns = Measure([&]()
+                            { f.Vector(x.data(), y.data(), x.size()); }) * 1e6 / BENCH_COUNT;
+        report.Row(ulp <= f.MaxUlp && (f.MaxAbsError == 0 || absError <= f.MaxAbsError) && specials,
+                   f.Name, ulp, absError, specials ? "yes" : "no", libm, ns, libm / ns);
+    }
+    return report.End();
+}
@@ -0,0 +1,90 @@
+#ifndef _CM_BENCH__
+#define _CM_BENCH__
+
+#include <iostream>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <vector>
+
+// The helpers shared by the benches of the samples: the random inputs, the timing loop, the error against a reference and
+// the csv output. Every bench keeps its own cases, its reference and its columns.
+
+// every measure runs for at least this time, in seconds.
+#define BENCH_MIN_TIME 0.3
+
+/// @brief count values spread over [offset - scale / 2, offset + scale / 2].
+static inline std::vector<float> RandomBuffer(size_t count, float scale = 1.0f, float offset = 0.0f)
+{
+    std::vector<float> buffer(count);
+    for (size_t i = 0; i != count; i++)
+    {
+        buffer[i] = ((float)rand() / RAND_MAX - 0.5f) * scale + offset;
+    }
+    return buffer;
+}
+
+/// @brief call fn again and again for BENCH_MIN_TIME, and twice at least.
+/// @return the time of a call, in milliseconds.
+template <typename F>
+static double Measure(F fn)
+{
+    int iterations = 0;
+    std::chrono::duration<double> elapsed(0);
+    auto start = std::chrono::steady_clock::now();
+    while (elapsed.count() < BENCH_MIN_TIME || iterations < 2)
+    {
+        fn();
+        iterations++;
+        elapsed = std::chrono::steady_clock::now() - start;
+    }
+    return elapsed.count() * 1000 / iterations;
+}
+
+/// @brief the largest absolute difference between y and expected.
+static inline float MaxError(const float *y, const float *expected, size_t count)
+{
+    float error = 0;
+    for (size_t i = 0; i != count; i++)
+    {
+        error = std::fmax(error, std::fabs(y[i] - expected[i]));
+    }
+    return error;
+}
+
+/// @brief the csv output of a bench: the header, a row per case, then the valid row which gathers the checks of every case.
+class BenchReport
+{
+public:
+    BenchReport(const char *header) { std::cout << header << std::endl; }
+
+    template <typename... T>
+    void Row(bool valid, const T &...columns)
+    {
+        this->_valid = this->_valid && valid;
+        _write(columns...);
+        std::cout << std::endl;
+    }
+
+    /// @return the exit code of the bench, 0 if every case is valid.
+    int End()
+    {
+        std::cout << "valid," << (this->_valid ? "yes" : "no") << std::endl;
+        return this->_valid ? 0 : 1;
+    }
+
+private:
+    bool _valid = true;
+
+    template <typename T>
+    static void _write(const T &column) { std::cout << column; }
+
+    template <typename T, typename... R>
+    static void _write(const T &column, const R &...columns)
+    {
+        std::cout << column << ",";
+        _write(columns...);
+    }
+};
+
+#endif
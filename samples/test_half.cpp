@@ -0,0 +1,197 @@
+#include <cstdint>
+
+#include "cm_bench.hpp"
+
+#include "cm_engine.hpp"
+#include "math/cm_half.hpp"
+#include "nodes/cm_nodes_registry.hpp"
+#include "nodes/nn/cm_conv.hpp"
+#include "nodes/rnn/cm_lstm.hpp"
+
+using namespace CyanMycelium;
+
+// X [seq, channels, length] -> Conv 1D -> Relu -> LSTM, the outputs of the Conv being the batch of the LSTM.
+#define TEST_SEQ_LENGTH 6
+#define TEST_CHANNELS 4
+#define TEST_LENGTH 20
+#define TEST_FEATURES 8
+#define TEST_KERNEL 3
+#define TEST_HIDDEN 16
+
+// the values of the model, as floats. The half runs round them, so the float reference reads them rounded as well.
+struct TestModel
+{
+    std::vector<float> X;
+    std::vector<float> ConvW;
+    std::vector<float> ConvB;
+    std::vector<float> W;
+    std::vector<float> R;
+    std::vector<float> B;
+};
+
+// the buffer of the values stored as type, a half type taking 2 bytes per item.
+static std::vector<uint8_t> Store(tensor_data_type_t type, const std::vector<float> &values)
+{
+    std::vector<uint8_t> buffer(values.size() * sizeof(float));
+    if (!cm_from_float(type, values.data(), buffer.data(), values.size()))
+    {
+        cm_memcpy(buffer.data(), values.data(), buffer.size());
+    }
+    return buffer;
+}
+
+// the values as read back from type.
+static std::vector<float> Round(tensor_data_type_t type, const std::vector<float> &values)
+{
+    std::vector<uint8_t> stored = Store(type, values);
+    std::vector<float> rounded(values.size());
+    if (!cm_to_float(type, stored.data(), rounded.data(), values.size()))
+    {
+        return values;
+    }
+    return rounded;
+}
+
+/// @brief run the model with its tensors stored as type. The weights are packed at load time when prepack is set, read
+/// from their links at every inference otherwise.
+/// @return the Y of the LSTM as floats, empty if the inference failed.
+static std::vector<float> Run(InferenceEngine *engine, const TestModel &m, tensor_data_type_t type, bool prepack)
+{
+    uint64_t xShape[3] = {TEST_SEQ_LENGTH, TEST_CHANNELS, TEST_LENGTH};
+    uint64_t convWShape[3] = {TEST_FEATURES, TEST_CHANNELS, TEST_KERNEL};
+    uint64_t convBShape[1] = {TEST_FEATURES};
+    uint64_t convYShape[3] = {TEST_SEQ_LENGTH, TEST_FEATURES, TEST_LENGTH};
+    uint64_t wShape[3] = {1, 4 * TEST_HIDDEN, TEST_LENGTH};
+    uint64_t rShape[3] = {1, 4 * TEST_HIDDEN, TEST_HIDDEN};
+    uint64_t bShape[2] = {1, 8 * TEST_HIDDEN};
+    uint64_t yShape[4] = {TEST_SEQ_LENGTH, 1, TEST_FEATURES, TEST_HIDDEN};
+
+    std::vector<uint8_t> x = Store(type, m.X);
+    std::vector<uint8_t> convW = Store(type, m.ConvW);
+    std::vector<uint8_t> convB = Store(type, m.ConvB);
+    std::vector<uint8_t> w = Store(type, m.W);
+    std::vector<uint8_t> r = Store(type, m.R);
+    std::vector<uint8_t> b = Store(type, m.B);
+    std::vector<float> y((size_t)TEST_SEQ_LENGTH * TEST_FEATURES * TEST_HIDDEN);
+    std::vector<uint8_t> yStored(y.size() * sizeof(float));
+
+    Graph graph;
+    Link *links[9];
+    for (int i = 0; i != 9; i++)
+    {
+        links[i] = new Link();
+        links[i]->Id = i;
+        graph.Links.Add(links[i]);
+    }
+    links[0]->SetPayloadInfos(xShape, 3, type);
+    links[1]->SetPayloadInfos(convWShape, 3, type, convW.data());
+    links[2]->SetPayloadInfos(convBShape, 1, type, convB.data());
+    links[3]->SetPayloadInfos(convYShape, 3, type);
+    links[4]->SetPayloadInfos(convYShape, 3, type);
+    links[5]->SetPayloadInfos(wShape, 3, type, w.data());
+    links[6]->SetPayloadInfos(rShape, 3, type, r.data());
+    links[7]->SetPayloadInfos(bShape, 2, type, b.data());
+    links[8]->SetPayloadInfos(yShape, 4, type);
+
+    Conv *conv = new Conv();
+    conv->Pads[0] = conv->Pads[1] = TEST_KERNEL / 2;
+    conv->PadCount = 2;
+    Operator *relu = NodeRegistry::ForName("Relu");
+    LSTM *lstm = new LSTM();
+    lstm->HiddenSize = TEST_HIDDEN;
+    Operator *nodes[3] = {conv, relu, lstm};
+    // the inputs and the outputs of every node, by link index.
+    int inputs[3][4] = {{0, 1, 2, -1}, {3, -1}, {4, 5, 6, 7}};
+    int outputs[3] = {3, 4, 8};
+    for (int n = 0; n != 3; n++)
+    {
+        for (int i = 0; i != 4 && inputs[n][i] >= 0; i++)
+        {
+            links[inputs[n][i]]->Ofin = nodes[n];
+            nodes[n]->Opsc.Add(links[inputs[n][i]]);
+        }
+        links[outputs[n]]->Oini = nodes[n];
+        nodes[n]->Onsc.Add(links[outputs[n]]);
+        graph.Nodes.Add(nodes[n]);
+    }
+    // the initializers are inputs of the graph holding their data, as the builder declares them.
+    const char *names[] = {"X", "conv_w", "conv_b", nullptr, nullptr, "w", "r", "b"};
+    for (int i = 0; i != 8; i++)
+    {
+        if (names[i])
+        {
+            graph.Inputs.Set(names[i], links[i]);
+        }
+    }
+    graph.Outputs.Set("Y", links[8]);
+    if (prepack)
+    {
+        // as the graph builder does once the nodes are linked.
+        conv->Prepack();
+        lstm->Prepack();
+    }
+
+    ActivationContextHandlers handlers;
+    bool run;
+    {
+        ActivationContext ctx(engine, &graph, &handlers);
+        ctx.SetInput("X", x.data());
+        ctx.SetOutput("Y", yStored.data());
+        run = ctx.Run() && ctx.GetError() == CM_ACTIVATION_SUCCESS;
+    }
+    if (!cm_to_float(type, yStored.data(), y.data(), y.size()))
+    {
+        cm_memcpy(y.data(), yStored.data(), y.size() * sizeof(float));
+    }
+
+    for (Operator *node : nodes)
+    {
+        delete node;
+    }
+    for (Link *l : links)
+    {
+        delete l;
+    }
+    return run ? y : std::vector<float>();
+}
+
+int main()
+{
+    InferenceEngineOptions options;
+    InferenceEngine engine(options, false);
+
+    TestModel model;
+    model.X = RandomBuffer((size_t)TEST_SEQ_LENGTH * TEST_CHANNELS * TEST_LENGTH, 2.0f);
+    model.ConvW = RandomBuffer((size_t)TEST_FEATURES * TEST_CHANNELS * TEST_KERNEL, 1.0f);
+    model.ConvB = RandomBuffer(TEST_FEATURES, 0.5f);
+    model.W = RandomBuffer((size_t)4 * TEST_HIDDEN * TEST_LENGTH, 0.5f);
+    model.R = RandomBuffer((size_t)4 * TEST_HIDDEN * TEST_HIDDEN, 0.5f);
+    model.B = RandomBuffer((size_t)8 * TEST_HIDDEN, 0.5f);
+
+    struct
+    {
+        tensor_data_type_t Type;
+        const char *Name;
+        bool Prepack;
+        float Tolerance; // a few ulps of the storage, the states staying within [-1, 1]
+    } cases[] = {
+        {TDT_FLOAT16, "float16", true, 4e-3f},
+        {TDT_FLOAT16, "float16", false, 4e-3f},
+        {TDT_BFLOAT16, "bfloat16", true, 3e-2f},
+        {TDT_BFLOAT16, "bfloat16", false, 3e-2f},
+    };
+
+    BenchReport report("type,prepack,max_error,valid");
+    for (auto &c : cases)
+    {
+        // the reference runs in float on the values the half run reads.
+        TestModel rounded = {Round(c.Type, model.X), Round(c.Type, model.ConvW), Round(c.Type, model.ConvB),
+                             Round(c.Type, model.W), Round(c.Type, model.R), Round(c.Type, model.B)};
+        std::vector<float> expected = Run(&engine, rounded, TDT_FLOAT, true);
+        std::vector<float> y = Run(&engine, model, c.Type, c.Prepack);
+        float error = y.size() == expected.size() && !y.empty() ? MaxError(y.data(), expected.data(), y.size()) : INFINITY;
+        bool ok = error <= c.Tolerance;
+        report.Row(ok, c.Name, c.Prepack ? "yes" : "no", error, ok ? "yes" : "no");
+    }
+    return report.End();
+}
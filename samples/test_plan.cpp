@@ -0,0 +1,89 @@
+#include <iostream>
+#include <vector>
+
+#include "cm_engine.hpp"
+#include "nodes/cm_nodes_registry.hpp"
+
+using namespace CyanMycelium;
+
+#define TEST_FEATURES 4
+#define TEST_ROWS 2
+
+struct TestCase
+{
+    const char *Name;
+    uint64_t X[2]; // the shape given to X [seq_length, TEST_FEATURES]
+    uint64_t Z[2]; // the shape given to Z [TEST_ROWS, TEST_FEATURES]
+    int ZDimension;
+    bool Fits;
+};
+
+int main()
+{
+    // X [seq_length, TEST_FEATURES] -> Abs -> Y and Z [TEST_ROWS, TEST_FEATURES] -> Abs -> W, seq_length being symbolic.
+    uint64_t xShape[2] = {TENSOR_DYNAMIC_DIM, TEST_FEATURES};
+    uint64_t zShape[2] = {TEST_ROWS, TEST_FEATURES};
+    std::vector<float> x(8 * TEST_FEATURES, -1.0f);
+    std::vector<float> z(8 * TEST_FEATURES, -1.0f);
+    Graph graph;
+    Link *links[4];
+    for (int i = 0; i != 4; i++)
+    {
+        links[i] = new Link();
+        links[i]->Id = i;
+        graph.Links.Add(links[i]);
+    }
+    links[0]->SetPayloadInfos(xShape, 2, TDT_FLOAT);
+    links[2]->SetPayloadInfos(zShape, 2, TDT_FLOAT);
+    Operator *nodes[2];
+    for (int i = 0; i != 2; i++)
+    {
+        nodes[i] = NodeRegistry::ForName("Abs");
+        links[2 * i]->Ofin = nodes[i];
+        nodes[i]->Opsc.Add(links[2 * i]);
+        links[2 * i + 1]->Oini = nodes[i];
+        nodes[i]->Onsc.Add(links[2 * i + 1]);
+        graph.Nodes.Add(nodes[i]);
+    }
+    graph.Inputs.Set("X", links[0]);
+    graph.Inputs.Set("Z", links[2]);
+    graph.Outputs.Set("Y", links[1]);
+    graph.Outputs.Set("W", links[3]);
+
+    // every input is checked against its declared shape, the static ones as the symbolic ones.
+    TestCase cases[] = {
+        {"fits", {3, TEST_FEATURES}, {TEST_ROWS, TEST_FEATURES}, 2, true},
+        {"other_length", {5, TEST_FEATURES}, {TEST_ROWS, TEST_FEATURES}, 2, true},
+        {"wrong_features", {3, TEST_FEATURES + 1}, {TEST_ROWS, TEST_FEATURES}, 2, false},
+        {"wrong_static_rows", {3, TEST_FEATURES}, {TEST_ROWS + 1, TEST_FEATURES}, 2, false},
+        {"wrong_static_rank", {3, TEST_FEATURES}, {TEST_ROWS * TEST_FEATURES, 0}, 1, false},
+    };
+
+    InferenceEngineOptions options;
+    InferenceEngine engine(options, false);
+    ActivationContextHandlers handlers;
+    ActivationContext ctx(&engine, &graph, &handlers);
+    std::cout << "case,run,error,valid" << std::endl;
+    bool valid = true;
+    for (const TestCase &c : cases)
+    {
+        ctx.SetInput("X", x.data(), c.X, 2);
+        ctx.SetInput("Z", z.data(), c.Z, c.ZDimension);
+        bool run = ctx.Run();
+        int error = ctx.GetError();
+        bool ok = c.Fits ? run && error == CM_ACTIVATION_SUCCESS : !run && error == CM_ACTIVATION_INVALID_SHAPE;
+        valid = valid && ok;
+        std::cout << c.Name << "," << run << "," << error << "," << (ok ? "yes" : "no") << std::endl;
+    }
+    std::cout << "valid," << (valid ? "yes" : "no") << std::endl;
+
+    for (Operator *node : nodes)
+    {
+        delete node;
+    }
+    for (Link *l : links)
+    {
+        delete l;
+    }
+    return valid ? 0 : 1;
+}
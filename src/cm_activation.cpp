@@ -1,3 +1,5 @@
+#include <new>
+
 #include "cm_graph.hpp"
 #include "cm_engine.hpp"
 
@@ -5,6 +7,17 @@ using namespace CyanMycelium;
 
 void ActivationContext ::SetInput(const char *name, void *buffer) { this->_bind(this->GetModel()->Inputs[name], buffer); }
 
+void ActivationContext ::SetInput(const char *name, void *buffer, const uint64_t *shape, int dimension)
+{
+    Link *l = this->GetModel()->Inputs[name];
+    this->_bind(l, buffer);
+    if (l && this->_topology)
+    {
+        TensorRefPtr ref = this->_refOf(l->Id);
+        ref->Value.Set(shape, dimension, ref->Value.Type, buffer);
+    }
+}
+
 void ActivationContext ::SetOutput(const char *name, void *buffer) { this->_bind(this->GetModel()->Outputs[name], buffer); }
 
 Tensor *ActivationContext ::GetInput(const char *name)
@@ -48,9 +61,274 @@ TensorRefPtr ActivationContext::CloneRef(TensorRef &other)
     return t;
 }
 
+TensorRefPtr ActivationContext::CreateRef(const uint64_t *shape, int dimension, tensor_data_type_t type)
+{
+    TensorRefPtr t = new TensorRef(shape, dimension, type);
+    t->Flags.Bits.Internal = 1;
+    t->Value.Data = this->Malloc(t->Value.Size);
+    if (!t->Value.Data)
+    {
+        delete t;
+        return nullptr;
+    }
+    return t;
+}
+
+// the buffer bound by the user may receive a value. Without declared type, the link does not tell the size of the buffer
+// and the user is trusted, as for the inputs.
+static inline bool _fits(TensorRefPtr bound, TensorInfos *value)
+{
+    return bound->Value.Type == TDT_UNDEFINED || (bound->Value.Type == value->Type && bound->Value.Size == value->Size);
+}
+
+TensorRefPtr ActivationContext::GetBoundRef(Operator *op, int index)
+{
+    int count = op->Onsc.Count();
+    for (int i = max(index, 0); i < count; i++)
+    {
+        int32_t link = op->Onsc[i]->Id;
+        if (this->_flagsOf(link).Bits.Bound)
+        {
+            return this->_refOf(link);
+        }
+        if (index >= 0)
+        {
+            break;
+        }
+    }
+    return nullptr;
+}
+
+TensorRefPtr ActivationContext::CreateOutputRef(Operator *op, const uint64_t *shape, int dimension, tensor_data_type_t type, int index)
+{
+    TensorRefPtr bound = this->GetBoundRef(op, index);
+    if (bound)
+    {
+        TensorInfos infos(shape, dimension, type);
+        // the result is written straight into the buffer of the user, which saves the copy of the output.
+        if (_fits(bound, &infos))
+        {
+            bound->Value.Set(shape, dimension, type, bound->Value.Data);
+            return bound;
+        }
+    }
+    // the result read by the next operator as a slice of its own result is written there, which saves the copy of the slice.
+    Link *l = index >= 0 ? (index < op->Onsc.Count() ? op->Onsc[index] : nullptr) : (op->Onsc.Count() == 1 ? op->Onsc[0] : nullptr);
+    if (l && l->InSlice && this->_slices)
+    {
+        TensorRefPtr slice = this->_createSliceRef(l, shape, dimension, type);
+        if (slice)
+        {
+            return slice;
+        }
+    }
+    return this->CreateRef(shape, dimension, type);
+}
+
+void ActivationContext::DiscardOutputRef(TensorRefPtr ref)
+{
+    if (!ref)
+    {
+        return;
+    }
+    // the result is released as Forward releases it, without any link holding it.
+    ref->Lock();
+    ref->Count++;
+    ref->Unlock();
+    this->_release(ref);
+}
+
+TensorRefPtr ActivationContext::_createSliceRef(Link *l, const uint64_t *shape, int dimension, tensor_data_type_t type)
+{
+    Operator *consumer = l->Ofin;
+    int index = 0;
+    while (consumer->Opsc[index] != l)
+    {
+        index++;
+    }
+    TensorInfos infos(shape, dimension, type);
+    TensorInfos output(nullptr, 1);
+    size_t offset;
+    if (!consumer->GetInputSlice(index, this->_plan, &output, &offset) || output.Type != type || offset + infos.Size > output.Size)
+    {
+        return nullptr;
+    }
+    // the sources of the inputs may run in parallel, the first one creates the result of the consumer, which may itself be a
+    // slice of the result of the next one. The slot holds a reference until the consumer takes the result.
+    consumer->Lock();
+    TensorRefPtr &slot = this->_slices[consumer->Id];
+    if (!slot && (slot = this->CreateOutputRef(consumer, output.Shape, output.Dimension, output.Type)))
+    {
+        slot->Lock();
+        slot->Count++;
+        slot->Unlock();
+    }
+    TensorRefPtr base = slot;
+    consumer->Unlock();
+    if (!base)
+    {
+        return nullptr;
+    }
+    TensorRefPtr slice = new TensorRef(shape, dimension, type);
+    slice->Value.Data = (cm_byte_t *)base->Value.Data + offset;
+    slice->Base = base;
+    base->Lock();
+    base->Count++;
+    base->Unlock();
+    return slice;
+}
+
+TensorRefPtr ActivationContext::TakeSliceRef(Operator *op)
+{
+    if (!this->_slices || op->Id < 0 || op->Id >= this->_topology->GetNodeCount())
+    {
+        return nullptr;
+    }
+    op->Lock();
+    TensorRefPtr base = this->_slices[op->Id];
+    this->_slices[op->Id] = nullptr;
+    op->Unlock();
+    // the caller takes over the reference of the slot, the slices keep the tensor alive until the inputs are released.
+    if (base)
+    {
+        base->Lock();
+        base->Count--;
+        base->Unlock();
+    }
+    return base;
+}
+
+void ActivationContext::_releaseSlices()
+{
+    if (!this->_slices)
+    {
+        return;
+    }
+    int count = this->_topology->GetNodeCount();
+    for (int i = 0; i != count; i++)
+    {
+        if (this->_slices[i])
+        {
+            this->_release(this->_slices[i]);
+            this->_slices[i] = nullptr;
+        }
+    }
+}
+
+void ActivationContext ::SetProfiler(Profiler *profiler)
+{
+    Graph *model = this->GetModel();
+    int count = model->Nodes.Count();
+    delete[] this->_profile;
+    this->_profile = nullptr;
+    this->_profiler = profiler;
+    if (!profiler)
+    {
+        return;
+    }
+    // the builder numbers the nodes, do the same for the graphs built by hand.
+    for (int i = 0; i != count; i++)
+    {
+        Operator *op = model->Nodes[i];
+        if (op->Id < 0 || op->Id >= count)
+        {
+            op->Id = i;
+        }
+    }
+    this->_profile = new ProfileRecord *[count]();
+}
+
+ProfileRecord **ActivationContext ::_getProfileSlot(Operator *op)
+{
+    return op->Id >= 0 && op->Id < this->_model->Nodes.Count() ? this->_profile + op->Id : nullptr;
+}
+
+void ActivationContext ::_profileQueued(Operator *op)
+{
+    ProfileRecord **slot = this->_getProfileSlot(op);
+    if (slot && (*slot = this->_profiler->Claim(this->_inference, op)))
+    {
+        (*slot)->Queued = cm_time_ns();
+    }
+}
+
+ProfileRecord *ActivationContext ::_profileStarted(Operator *op)
+{
+    ProfileRecord **slot = this->_getProfileSlot(op);
+    if (!slot)
+    {
+        return nullptr;
+    }
+    ProfileRecord *r = *slot;
+    // the synchronous contexts run the node as soon as it is ready, without any queue.
+    bool queued = r != nullptr;
+    if (!queued && !(r = *slot = this->_profiler->Claim(this->_inference, op)))
+    {
+        return nullptr;
+    }
+    r->ThreadId = cm_thread_id();
+    int count = op->Opsc.Count();
+    for (int i = 0; i != count; i++)
+    {
+        // initializers are read from the link itself.
+        Link *l = op->Opsc[i];
+        if (!l)
+        {
+            continue;
+        }
+        TensorRefPtr ref = this->_refOf(l->Id);
+        r->BytesIn += ref ? ref->Value.Size : l->GetPayloadInfos()->Size;
+    }
+    r->Started = cm_time_ns();
+    r->Queued = queued ? r->Queued : r->Started;
+    return r;
+}
+
+ProfileRecord *ActivationContext ::_profileEnded(Operator *op)
+{
+    ProfileRecord **slot = this->_getProfileSlot(op);
+    ProfileRecord *r = slot ? *slot : nullptr;
+    if (r && !r->Ended)
+    {
+        r->Ended = cm_time_ns();
+    }
+    return r;
+}
+
+void ActivationContext ::_setError(int error)
+{
+    this->_error = error;
+    if (this->_handlers && this->_handlers->OnError)
+    {
+        this->_handlers->OnError(this, this->_handlers->UserData);
+    }
+}
+
 bool ActivationContext ::Run()
 {
     Graph *model = this->GetModel();
+    if (!this->_topology)
+    {
+        this->_setError(CM_ACTIVATION_INVALID_MODEL);
+        return false;
+    }
+    this->_error = CM_ACTIVATION_SUCCESS;
+    if (this->_plans && !this->_planShapes())
+    {
+        this->_setError(CM_ACTIVATION_INVALID_SHAPE);
+        return false;
+    }
+    this->_started = cm_time_ns();
+    this->_ended.store(false, std::memory_order_relaxed);
+    // a failed inference may have left some counters and some slices behind.
+    this->_resetPending();
+    this->_resetOutputs();
+    this->_releaseSlices();
+    if (this->_profiler)
+    {
+        this->_inference = this->_profiler->BeginInference();
+        cm_memset(this->_profile, 0, model->Nodes.Count() * sizeof(ProfileRecord *));
+    }
     int c = model->Inputs.Count();
     for (int i = 0; i != c; ++i)
     {
@@ -61,71 +339,168 @@ bool ActivationContext ::Run()
     return true;
 }
 
-bool ActivationContext::Forward(Operator *op, TensorRefPtr outputValue)
+bool ActivationContext ::_planShapes()
 {
-    // we deactivate the input links
-    int count = op->Opsc.Count();
+    Graph *model = this->GetModel();
+    int count = model->Inputs.Count();
     for (int i = 0; i != count; i++)
     {
-        Link *link = op->Opsc[i];
-        this->Deactivate(link);
+        Link *l = model->Inputs[i].Value;
+        TensorRefPtr ref = this->_refOf(l->Id);
+        this->_planInputs[i] = ref ? &ref->Value : l->GetPayloadInfos();
+    }
+    // the repeated shapes find their plan without any inference.
+    this->_plan = this->_plans->Get(model, this->_planInputs);
+    if (!this->_plan)
+    {
+        return false;
+    }
+    // the buffer bound to an output with a symbolic dimension still receives the result without any copy, when its shape is planned.
+    // Otherwise the user is trusted, as for the outputs without declared type.
+    count = model->Outputs.Count();
+    for (int i = 0; i != count; i++)
+    {
+        Link *l = model->Outputs[i].Value;
+        if (!this->_flagsOf(l->Id).Bits.Bound || !l->GetPayloadInfos()->IsDynamic())
+        {
+            continue;
+        }
+        TensorRefPtr ref = this->_refOf(l->Id);
+        Tensor *planned = this->_plan->GetInfos(l->Id);
+        bool known = planned->Type != TDT_UNDEFINED && !planned->IsDynamic();
+        ref->Value.Set(planned->Shape, planned->Dimension, known ? planned->Type : TDT_UNDEFINED, ref->Value.Data);
     }
+    return true;
+}
 
-    // we activate the output links
+bool ActivationContext::Forward(Operator *op, TensorRefPtr outputValue)
+{
+    // the execution ends here, the successors may run from this call.
+    ProfileRecord *r = this->_profiler ? this->_profileEnded(op) : nullptr;
+    if (r)
+    {
+        r->BytesOut += outputValue->Value.Size;
+        r->Allocs += outputValue->Flags.Bits.Internal && !outputValue->Count;
+    }
+
+    // the output links take the tensor before the inputs are released, it may be one of them when the operator runs in place.
+    // The tensor is shared without any copy, only the operators reading an in place link write over their input,
+    // and such a link is never shared (see Graph::AnalyzeInPlace).
+    const GraphTopology *t = this->_topology;
+    const int32_t *outputs = t->GetOutputs(op->Id);
+    int outputCount = t->GetOutputCount(op->Id);
     outputValue->Lock();
-    count = op->Onsc.Count();
+    outputValue->Count++;
+    for (int i = 0; i != outputCount; i++)
+    {
+        this->_hold(outputs[i], outputValue);
+    }
+    outputValue->Unlock();
+
+    // we deactivate the input links
+    const int32_t *inputs = t->GetInputs(op->Id);
+    int inputCount = t->GetInputCount(op->Id);
+    for (int i = 0; i != inputCount; i++)
+    {
+        this->_deactivate(inputs[i]);
+    }
+    // the synchronous contexts run the successors from here, so the inputs are gone before.
+    this->_release(outputValue);
+
+    // we activate the output links.
+    for (int i = 0; i != outputCount; i++)
+    {
+        this->_activate(outputs[i]);
+    }
+    return true;
+}
+
+bool ActivationContext::Forward(Operator *op, TensorRefPtr *outputValues, int count)
+{
+    ProfileRecord *r = this->_profiler ? this->_profileEnded(op) : nullptr;
+    for (int i = 0; r && i != count; i++)
+    {
+        if (outputValues[i])
+        {
+            r->BytesOut += outputValues[i]->Value.Size;
+            r->Allocs += outputValues[i]->Flags.Bits.Internal && !outputValues[i]->Count;
+        }
+    }
+
+    // every output is a distinct tensor, so there is no need to share (or clone) them.
+    // The links take their tensor before the inputs are released, the outputs without any link are released there.
+    const GraphTopology *t = this->_topology;
+    const int32_t *outputs = t->GetOutputs(op->Id);
+    int n = min(count, t->GetOutputCount(op->Id));
     for (int i = 0; i != count; i++)
     {
-        TensorRefPtr tensor = outputValue;
-        Link *link = op->Onsc[i];
-        if (tensor->Flags.Bits.ReadOnly || tensor->Count > 1)
+        if (outputValues[i])
         {
-            OperatorPtr nextOp = link->Ofin;
-            if (nextOp && nextOp->IsMutable())
+            outputValues[i]->Lock();
+            outputValues[i]->Count++;
+            if (i < n)
             {
-                // we need to copy the tensor value.
-                tensor = this->CloneRef(*outputValue);
+                this->_hold(outputs[i], outputValues[i]);
             }
+            outputValues[i]->Unlock();
         }
-        this->Activate(link, tensor);
     }
 
-    outputValue->Unlock();
+    // we deactivate the input links
+    const int32_t *inputs = t->GetInputs(op->Id);
+    int inputCount = t->GetInputCount(op->Id);
+    for (int i = 0; i != inputCount; i++)
+    {
+        this->_deactivate(inputs[i]);
+    }
+    for (int i = 0; i != count; i++)
+    {
+        if (outputValues[i])
+        {
+            this->_release(outputValues[i]);
+        }
+    }
+
+    for (int i = 0; i != n; i++)
+    {
+        if (outputValues[i])
+        {
+            this->_activate(outputs[i]);
+        }
+    }
     return true;
 }
 
 bool ActivationContext::Forward(Link *l)
 {
-    NodePtr nextNode = l->Ofin;
+    return this->_forward(l->Id);
+}
+
+bool ActivationContext::_forward(int32_t link)
+{
+    const GraphTopology *t = this->_topology;
+    int32_t next = t->GetTarget(link);
     // this is a terminal link ?
-    if (nextNode)
+    if (next >= 0)
     {
         // this is not a terminal link.
-        // let test the number of sibling and they states
-        if (nextNode->Opsc.Count() == 1)
+        OperatorPtr nextNode = t->GetNode(next);
+        int32_t slot = t->GetPendingSlot(next);
+        if (slot < 0)
         {
             // short track
-            this->Activate((Operator *)nextNode);
+            this->Activate(nextNode);
             return true;
         }
 
-        // we need to synchronize and potentially activate the node
-        nextNode->Lock();
-        // we check if the node is ready to be activated
-        Collection<Link *> &inputs = nextNode->Opsc;
-        int count = inputs.Count();
-        for (int i = 0; i != count; ++i)
+        // the last input to come activates the node, the counter is set back for the next inference before.
+        if (this->_pending[slot].fetch_sub(1, std::memory_order_acq_rel) != 1)
         {
-            Link *l = inputs[i];
-            if (!this->_states[l->Id].Flags.Bits.Activ)
-            {
-                // one of the input is not ready, so we do nothing
-                nextNode->Unlock();
-                return true;
-            }
+            // one of the input is not ready, so we do nothing
+            return true;
         }
-        this->Activate((Operator *)nextNode);
-        nextNode->Unlock();
+        this->_pending[slot].store(t->GetPendingCount(next), std::memory_order_relaxed);
+        this->Activate(nextNode);
         return true;
     }
     // this is a terminal link
@@ -136,7 +511,7 @@ bool ActivationContext::Forward(Link *l)
     {
         KeyValue<Link *> entry = outputs[i];
         Link *l = entry.Value;
-        if (!this->_states[l->Id].Flags.Bits.Activ)
+        if (!this->_flagsOf(l->Id).Bits.Activ)
         {
             // one of the input is not ready, so we do nothing
             ended = false;
@@ -146,8 +521,10 @@ bool ActivationContext::Forward(Link *l)
             this->_handlers->OnOutputReady(this, entry.Key, l->GetPayloadInfos(), this->_handlers->UserData);
         }
     }
-    if (ended)
+    // the last two outputs may be forwarded by two workers at once, which both see every output ready.
+    if (ended && !this->_ended.exchange(true, std::memory_order_acq_rel))
     {
+        this->_engine->GetMetrics().OnInference(cm_time_ns() - this->_started);
         if (this->_handlers->OnEnded)
         {
             this->_handlers->OnEnded(this, this->_handlers->UserData);
@@ -158,28 +535,100 @@ bool ActivationContext::Forward(Link *l)
 
 bool ActivationContext ::Activate(Link *l, TensorRefPtr tensor)
 {
-    LinkState *state = this->_states + l->Id;
-    state->Flags.Bits.Activ = 1;
     if (tensor)
     {
-        state->Ref = tensor;
-        tensor->Count++;
+        tensor->Lock();
+        this->_hold(l->Id, tensor);
+        tensor->Unlock();
     }
-    if (!l->Activate(this))
+    return this->_activate(l->Id);
+}
+
+bool ActivationContext ::_activate(int32_t link)
+{
+    this->_flagsOf(link).Bits.Activ = 1;
+    if (!this->_topology->GetLink(link)->Activate(this))
     {
         return false;
     }
-    return Forward(l);
+    return this->_forward(link);
 }
 
 bool ActivationContext ::Deactivate(Link *l)
 {
-    LinkState *state = this->_states + l->Id;
-    state->Flags.Bits.Activ = 0;
-    state->Ref->Count--;
+    this->_deactivate(l->Id);
     return true;
 }
 
+void ActivationContext ::_deactivate(int32_t link)
+{
+    LinkFlags &flags = this->_flagsOf(link);
+    flags.Bits.Activ = 0;
+    // initializers are read from the link itself and do not hold any reference.
+    TensorRefPtr &slot = this->_refOf(link);
+    TensorRefPtr ref = slot;
+    if (ref)
+    {
+        // the tensors bound by the user stay on their link for the next inference.
+        if (!flags.Bits.Bound)
+        {
+            slot = nullptr;
+        }
+        this->_release(ref);
+    }
+}
+
+void ActivationContext ::_hold(int32_t link, TensorRefPtr tensor)
+{
+    LinkFlags &flags = this->_flagsOf(link);
+    TensorRefPtr &slot = this->_refOf(link);
+    TensorRefPtr ref = slot;
+    if (ref && ref != tensor && flags.Bits.Bound)
+    {
+        // the operator did not write into the buffer of the user, so the value is copied there.
+        if (_fits(ref, &tensor->Value))
+        {
+            cm_memcpy(ref->Value.Data, tensor->Value.Data, tensor->Value.Size);
+            ref->Value.Set(tensor->Value.Shape, tensor->Value.Dimension, tensor->Value.Type, ref->Value.Data);
+            ref->Count++;
+            return;
+        }
+        // the buffer does not fit, the link gets the tensor instead.
+        flags.Bits.Bound = 0;
+        delete ref;
+        ref = nullptr;
+    }
+    tensor->Count++;
+    // the output links keep their tensor until the next inference.
+    if (ref && ref != tensor)
+    {
+        this->_release(ref);
+    }
+    slot = tensor;
+}
+
+void ActivationContext ::_release(TensorRefPtr ref)
+{
+    ref->Lock();
+    bool last = --ref->Count <= 0 && (ref->Flags.Bits.Internal || ref->Base);
+    ref->Unlock();
+    if (!last)
+    {
+        return;
+    }
+    // a slice goes with its last reference, then lets the tensor it belongs to go.
+    TensorRefPtr base = ref->Base;
+    if (base)
+    {
+        delete ref;
+        this->_release(base);
+        return;
+    }
+    // nobody else holds the tensor, so its buffer goes back to the memory manager as soon as possible.
+    this->Free(ref->Value.Data);
+    delete ref;
+}
+
 bool ActivationContext ::Deactivate(OperatorPtr node)
 {
     return true;
@@ -187,55 +636,208 @@ bool ActivationContext ::Deactivate(OperatorPtr node)
 
 bool ActivationContext ::Activate(OperatorPtr node)
 {
-    return node->Activate(this);
+    if (this->_handlers && this->_handlers->OnNodeActivated)
+    {
+        this->_handlers->OnNodeActivated(this, node, this->_handlers->UserData);
+    }
+    if (!this->_profiler)
+    {
+        return node->Activate(this);
+    }
+    ProfileRecord *r = this->_profileStarted(node);
+    bool res = node->Activate(this);
+    // the node failed before forwarding any result.
+    if (r && !r->Ended)
+    {
+        r->Ended = cm_time_ns();
+    }
+    return res;
+}
+
+// the first address of a line from a given address.
+static inline cm_byte_t *_align_line(cm_byte_t *p, size_t line)
+{
+    return line > 1 ? (cm_byte_t *)(((size_t)p + line - 1) / line * line) : p;
 }
 
 void ActivationContext::_buildTensorRefs()
 {
-    // we count the number of tensors
-    int count = this->_model->Links.Count();
-    // we allocate the array
-    this->_states = new LinkState[count];
+    this->_stateBlock = nullptr;
+    this->_refs = nullptr;
+    this->_flags = nullptr;
+    this->_pending = nullptr;
+    this->_slices = nullptr;
+    this->_plans = nullptr;
+    this->_plan = nullptr;
+    this->_planInputs = nullptr;
+    // the graphs built by hand are compiled by their first context.
+    if (!this->_model->GetTopology())
+    {
+        this->_model->Compile();
+    }
+    this->_topology = this->_model->GetTopology();
+    const GraphTopology *t = this->_topology;
+    if (!t)
+    {
+        return;
+    }
+    // the models with symbolic dimensions are planned for the shapes of their inputs.
+    if (this->_model->IsDynamic())
+    {
+        this->_plans = new ShapePlanCache(this->_engine->GetPlanCacheCapacity());
+        int inputCount = this->_model->Inputs.Count();
+        this->_planInputs = inputCount ? (TensorInfos **)cm_malloc(inputCount * sizeof(TensorInfos *)) : nullptr;
+        if (inputCount && !this->_planInputs)
+        {
+            this->_topology = nullptr;
+            return;
+        }
+    }
+    // every array starts on a line, the topology pads the lanes within them.
+    size_t line = t->GetLineSize();
+    size_t refSize = t->GetRefSlotCount() * sizeof(TensorRefPtr);
+    size_t flagSize = t->GetFlagSlotCount() * sizeof(LinkFlags);
+    size_t pendingSize = t->GetPendingSlotCount() * sizeof(std::atomic<int32_t>);
+    size_t padding = max(line, sizeof(void *));
+    cm_byte_t *block = (cm_byte_t *)cm_malloc(refSize + flagSize + pendingSize + 3 * padding);
+    if (!block)
+    {
+        this->_topology = nullptr;
+        return;
+    }
+    this->_stateBlock = block;
+    cm_byte_t *p = _align_line(block, padding);
+    this->_refs = (TensorRefPtr *)p;
+    p = _align_line(p + refSize, padding);
+    this->_flags = (LinkFlags *)p;
+    p = _align_line(p + flagSize, padding);
+    this->_pending = (std::atomic<int32_t> *)p;
+    cm_memset(this->_refs, 0, refSize);
+    cm_memset(this->_flags, 0, flagSize);
+    int count = t->GetPendingSlotCount();
+    for (int i = 0; i != count; i++)
+    {
+        new (this->_pending + i) std::atomic<int32_t>(0);
+    }
+    this->_resetPending();
+    // the results written into a slice of the result of the next operator meet there, by node.
+    count = t->GetLinkCount();
+    for (int i = 0; i != count; i++)
+    {
+        if (t->GetLink(i)->InSlice)
+        {
+            size_t size = t->GetNodeCount() * sizeof(TensorRefPtr);
+            this->_slices = (TensorRefPtr *)cm_malloc(size);
+            if (!this->_slices)
+            {
+                cm_free(this->_stateBlock);
+                this->_stateBlock = nullptr;
+                this->_topology = nullptr;
+                return;
+            }
+            cm_memset(this->_slices, 0, size);
+            break;
+        }
+    }
+}
+
+void ActivationContext::_resetPending()
+{
+    const GraphTopology *t = this->_topology;
+    int count = t->GetNodeCount();
+    for (int i = 0; i != count; i++)
+    {
+        int32_t slot = t->GetPendingSlot(i);
+        if (slot >= 0)
+        {
+            this->_pending[slot].store(t->GetPendingCount(i), std::memory_order_relaxed);
+        }
+    }
+}
+
+void ActivationContext::_resetOutputs()
+{
+    KeyValueCollection<Link *> &outputs = this->_model->Outputs;
+    int count = outputs.Count();
+    for (int i = 0; i != count; i++)
+    {
+        this->_flagsOf(outputs[i].Value->Id).Bits.Activ = 0;
+    }
 }
 
 void ActivationContext::_clearTensorRefs()
 {
-    int count = this->_model->Links.Count();
+    delete this->_plans;
+    cm_free(this->_planInputs);
+    if (!this->_stateBlock)
+    {
+        return;
+    }
+    int count = this->_topology->GetRefSlotCount();
     for (int i = 0; i != count; i++)
     {
-        TensorRef *ref = this->_states[i].Ref;
+        TensorRef *ref = this->_refs[i];
         if (ref)
         {
             if (ref->Flags.Bits.Internal)
             {
                 this->Free(ref->Value.Data);
             }
+            // a slice left by a failed inference still holds the tensor it belongs to.
+            if (ref->Base)
+            {
+                this->_release(ref->Base);
+            }
             // we assume we may have copy of the tensor
             // so we need to check if the tensor is not shared
             for (int j = i + 1; j != count; j++)
             {
-                if (this->_states[j].Ref == ref)
+                if (this->_refs[j] == ref)
                 {
-                    this->_states[j].Ref = nullptr;
+                    this->_refs[j] = nullptr;
                 }
             }
             delete ref;
         }
     }
-    delete[] this->_states;
+    this->_releaseSlices();
+    cm_free(this->_slices);
+    cm_free(this->_stateBlock);
+}
+
+TensorRefPtr &ActivationContext ::_refOf(int32_t link)
+{
+    return this->_refs[this->_topology->GetRefSlot(link)];
+}
+
+LinkFlags &ActivationContext ::_flagsOf(int32_t link)
+{
+    return this->_flags[this->_topology->GetFlagSlot(link)];
+}
+
+TensorRefPtr ActivationContext ::GetPayloadRef(int id)
+{
+    return this->_topology ? this->_refOf(id) : nullptr;
 }
 
 void ActivationContext ::_bind(Link *l, void *buffer)
 {
-    if (l)
+    if (l && this->_topology)
     {
-        LinkState state = this->_states[l->Id];
-        TensorRef *ref = state.Ref;
-        if (!ref)
+        LinkFlags &flags = this->_flagsOf(l->Id);
+        TensorRefPtr &slot = this->_refOf(l->Id);
+        TensorRef *ref = slot;
+        if (!flags.Bits.Bound)
         {
+            // the link may still hold the result of the previous inference.
+            if (ref)
+            {
+                this->_release(ref);
+            }
             Tensor *infos = l->GetPayloadInfos();
             ref = new TensorRef(*infos);
-            this->_states[l->Id].Ref = ref;
+            slot = ref;
+            flags.Bits.Bound = 1;
         }
         ref->Value.Data = buffer;
     }
@@ -243,10 +845,9 @@ void ActivationContext ::_bind(Link *l, void *buffer)
 
 Tensor *ActivationContext ::_get(Link *l)
 {
-    if (l)
+    if (l && this->_topology)
     {
-        LinkState state = this->_states[l->Id];
-        TensorRef *ref = state.Ref;
+        TensorRef *ref = this->_refOf(l->Id);
         return ref ? &ref->Value : nullptr;
     }
     return nullptr;
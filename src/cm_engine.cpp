@@ -1,14 +1,51 @@
+#include <atomic>
+
 #include "cm_engine.hpp"
 
 using namespace CyanMycelium;
 
+// Shared state of a parallel loop. The chunks are claimed through an atomic counter,
+// so a worker picking the job late simply finds nothing left to do.
+// The job is released by the last of the caller and the helpers.
+struct ParallelForJob
+{
+  ParallelForFunction Fn;
+  void *UserData;
+  size_t Count;
+  size_t Grain;
+  size_t Chunks;
+  std::atomic<size_t> Next;
+  std::atomic<size_t> Done;
+  std::atomic<int> Refs;
+};
+
+static void _run_parallel_job(ParallelForJob *job)
+{
+  size_t i;
+  while ((i = job->Next.fetch_add(1, std::memory_order_relaxed)) < job->Chunks)
+  {
+    size_t from = i * job->Grain;
+    size_t to = min(from + job->Grain, job->Count);
+    job->Fn(from, to, job->UserData);
+    job->Done.fetch_add(1, std::memory_order_release);
+  }
+}
+
+static void _release_parallel_job(ParallelForJob *job)
+{
+  if (job->Refs.fetch_sub(1, std::memory_order_acq_rel) == 1)
+  {
+    delete job;
+  }
+}
+
 AsyncActivationContext *InferenceEngine ::CreateInferenceSession(GraphPtr model, ActivationContextHandlersPtr handlers)
 {
   if (!model)
   {
     return nullptr;
   }
-  return new AsyncActivationContext(this, model, &(this->_queue), handlers);
+  return new AsyncActivationContext(this, model, handlers);
 }
 
 void InferenceEngine ::Start()
@@ -18,6 +55,7 @@ void InferenceEngine ::Start()
   if (!_started)
   {
     _started = true;
+    _metrics.ResetWorkers();
     _threads = new ThreadPtr[_options.ThreadCount];
     IRunnable *runnable = _options.Runtime ? _options.Runtime : this;
     for (int i = 0; i < _options.ThreadCount; i++)
@@ -56,13 +94,20 @@ void InferenceEngine::Join()
 
 void InferenceEngine ::Stop()
 {
+  if (!this->IsStarted())
+  {
+    return;
+  }
   ActivationEvent e = {CM_ACTIVATION_STOP, nullptr, nullptr};
   // we need to send a stop event to every threads
   for (int i = 0; i < _options.ThreadCount; i++)
   {
-    if (!this->_queue.Send(&e))
+    if (!this->Post(e, _options.WaitTimeout))
     {
-      // log error
+      // the queue stays full, or no worker is left to empty it. The engine is stopped from here,
+      // the workers still running leave at the end of their current wait.
+      this->Consume(e);
+      return;
     }
   }
 }
@@ -75,16 +120,122 @@ bool InferenceEngine ::IsStarted()
   return tmp;
 }
 
+bool InferenceEngine ::IsParallel(size_t count, size_t elementSize)
+{
+  size_t size = count * elementSize;
+  return this->_options.ThreadCount > 1 && size >= this->_options.ParallelThreshold && size > this->_options.ParallelChunkSize && this->IsStarted();
+}
+
+size_t InferenceEngine ::GetParallelGrain(size_t elementSize)
+{
+  return max(this->_options.ParallelChunkSize / max(elementSize, (size_t)1), (size_t)1);
+}
+
+void InferenceEngine ::ParallelFor(size_t count, size_t elementSize, ParallelForFunction fn, void *userData)
+{
+  if (!count)
+  {
+    return;
+  }
+  if (!this->IsParallel(count, elementSize))
+  {
+    fn(0, count, userData);
+    return;
+  }
+
+  ParallelForJob *job = new ParallelForJob();
+  job->Fn = fn;
+  job->UserData = userData;
+  job->Count = count;
+  job->Grain = this->GetParallelGrain(elementSize);
+  job->Chunks = (count + job->Grain - 1) / job->Grain;
+  job->Next.store(0, std::memory_order_relaxed);
+  job->Done.store(0, std::memory_order_relaxed);
+
+  // the caller is one of the participants, so we only need one helper per other worker.
+  int helpers = (int)min((size_t)(this->_options.ThreadCount - 1), job->Chunks - 1);
+  job->Refs.store(1 + helpers, std::memory_order_relaxed);
+
+  ActivationEvent e = {CM_ACTIVATION_PARALLEL, nullptr, job};
+  for (int i = 0; i != helpers; i++)
+  {
+    // a full queue is not an error, the caller processes the remaining chunks by itself.
+    if (!this->Post(e, 0))
+    {
+      job->Refs.fetch_sub(helpers - i, std::memory_order_relaxed);
+      break;
+    }
+  }
+
+  _run_parallel_job(job);
+  // every chunk is claimed, wait for the helpers still running theirs.
+  while (job->Done.load(std::memory_order_acquire) != job->Chunks)
+  {
+    cm_yield();
+  }
+  _release_parallel_job(job);
+}
+
+bool InferenceEngine ::Post(ActivationEvent &e, unsigned int timeoutMs, SchedulingInfos *scheduling)
+{
+  if (!scheduling || !this->_scheduler)
+  {
+    bool sent = this->_queue.Send(&e, timeoutMs);
+    this->_metrics.OnSent(sent);
+    return sent;
+  }
+  if (!this->_scheduler->Push(e, scheduling))
+  {
+    this->_metrics.OnSent(false);
+    return false;
+  }
+  // the token only wakes a worker, which takes the most urgent event.
+  ActivationEvent token = {CM_ACTIVATION_SCHEDULED, nullptr, nullptr};
+  bool sent = this->_queue.Send(&token, timeoutMs);
+  this->_metrics.OnSent(sent);
+  if (!sent)
+  {
+    // there must be one event per token, so the caller takes one back.
+    this->_scheduler->Pop(e);
+  }
+  return sent;
+}
+
+bool InferenceEngine ::Admit()
+{
+  bool admitted = this->_queue.WaitForFreeSize(this->_options.ReservedCapacity + 1, this->_options.AdmissionTimeout);
+  this->_metrics.OnAdmission(admitted);
+  return admitted;
+}
+
+void InferenceEngine ::GetMetricsSnapshot(EngineMetricsSnapshot &snapshot)
+{
+  this->_metrics.GetSnapshot(snapshot);
+  snapshot.QueueCapacity = this->_options.QueueCapacity + this->_options.ReservedCapacity;
+}
+
 unsigned long InferenceEngine ::Run(void *)
 {
   if (IsStarted())
   {
+    int worker = _metrics.RegisterWorker();
     ActivationEvent e;
     do
     {
+      cm_uint64_t waiting = cm_time_ns();
       if (_queue.Receive(&e, _options.WaitTimeout))
       {
+        _metrics.OnReceived();
+        cm_uint64_t started = cm_time_ns();
         Consume(e);
+        cm_uint64_t elapsed = cm_time_ns() - started;
+        // the chunks of a parallel loop are work taken over from another thread.
+        bool stolen = e.Type == CM_ACTIVATION_PARALLEL;
+        _metrics.OnWorker(worker, started - waiting, stolen ? 0 : elapsed, stolen ? elapsed : 0);
+      }
+      else
+      {
+        _metrics.OnWorker(worker, cm_time_ns() - waiting, 0, 0);
       }
     } while (IsStarted());
   }
@@ -102,10 +253,27 @@ void InferenceEngine ::Consume(ActivationEvent &e)
     OperatorPtr node = (OperatorPtr)e.Content;
     if (node)
     {
+      _metrics.OnActivation();
       context->ActivationContext::Activate(node);
     }
     break;
   }
+  case CM_ACTIVATION_SCHEDULED:
+  {
+    ActivationEvent next;
+    if (_scheduler && _scheduler->Pop(next))
+    {
+      Consume(next);
+    }
+    break;
+  }
+  case CM_ACTIVATION_PARALLEL:
+  {
+    ParallelForJob *job = (ParallelForJob *)e.Content;
+    _run_parallel_job(job);
+    _release_parallel_job(job);
+    break;
+  }
   case CM_ACTIVATION_STOP:
   {
     _lock.Take();
@@ -1,11 +1,133 @@
-#include "cm_graph.hpp"
+#include "cm_engine.hpp"
+#include "math/cm_half.hpp"
 
 using namespace CyanMycelium;
 
+// number of half items converted to float at once, small enough to keep the 3 tiles into L1.
+#define CM_HALF_TILE_SIZE 512
+
+// element-wise kernels are split into contiguous 1-D views of the tensors.
+struct _ElementWiseJob
+{
+  UnaryFunctionPtr UnaryFn;
+  BinaryFunctionPtr BinaryFn;
+  Operator *Op;
+  Tensor *X;
+  Tensor *Y;
+  Tensor *Out;
+  size_t ElementSize;
+  // the storage type when the float kernel is used on half tensors, TDT_UNDEFINED otherwise.
+  tensor_data_type_t Half;
+};
+
+static inline void _slice(Tensor *view, Tensor *source, uint64_t from, uint64_t count, size_t elementSize)
+{
+  view->Set(&count, 1, source->Type, (uint8_t *)source->Data + from * elementSize);
+}
+
+// half tensors are converted by tiles, processed by the float kernel, then converted back.
+static void _element_wise_half_chunk(_ElementWiseJob *job, size_t from, size_t to)
+{
+  float xt[CM_HALF_TILE_SIZE];
+  float yt[CM_HALF_TILE_SIZE];
+  float ot[CM_HALF_TILE_SIZE];
+  Tensor x, y, out;
+  for (size_t i = from; i < to; i += CM_HALF_TILE_SIZE)
+  {
+    uint64_t n = min((size_t)CM_HALF_TILE_SIZE, to - i);
+    x.Set(&n, 1, TDT_FLOAT, xt);
+    out.Set(&n, 1, TDT_FLOAT, ot);
+    cm_to_float(job->Half, (uint8_t *)job->X->Data + i * job->ElementSize, xt, n);
+    if (job->UnaryFn)
+    {
+      job->UnaryFn(&x, &out, (UnaryOperator *)job->Op);
+    }
+    else
+    {
+      y.Set(&n, 1, TDT_FLOAT, yt);
+      cm_to_float(job->Half, (uint8_t *)job->Y->Data + i * job->ElementSize, yt, n);
+      job->BinaryFn(&x, &y, &out, (BinaryOperator *)job->Op);
+    }
+    cm_from_float(job->Half, ot, (uint8_t *)job->Out->Data + i * job->ElementSize, n);
+  }
+}
+
+static void _element_wise_chunk(size_t from, size_t to, void *userData)
+{
+  _ElementWiseJob *job = (_ElementWiseJob *)userData;
+  if (job->Half != TDT_UNDEFINED)
+  {
+    _element_wise_half_chunk(job, from, to);
+    return;
+  }
+  Tensor x, y, out;
+  _slice(&x, job->X, from, to - from, job->ElementSize);
+  _slice(&out, job->Out, from, to - from, job->ElementSize);
+  if (job->UnaryFn)
+  {
+    job->UnaryFn(&x, &out, (UnaryOperator *)job->Op);
+    return;
+  }
+  _slice(&y, job->Y, from, to - from, job->ElementSize);
+  job->BinaryFn(&x, &y, &out, (BinaryOperator *)job->Op);
+}
+
 bool Link ::Activate(ActivationContext *ctx)
 {
   return true;
 }
+
+Tensor *Operator ::_getValue(ActivationContext *ctx, int index)
+{
+  if (!this->_hasInput(index))
+  {
+    return nullptr;
+  }
+  Link *l = this->Opsc[index];
+  TensorRefPtr ref = ctx->GetPayloadRef(l->Id);
+  if (ref && ref->Value.Data)
+  {
+    return &ref->Value;
+  }
+  Tensor *infos = l->GetPayloadInfos();
+  return infos->Data ? infos : nullptr;
+}
+
+bool Operator ::_inferOutput(Tensor **infos, int index, const uint64_t *shape, int dimension, tensor_data_type_t type)
+{
+  if (index >= this->Onsc.Count())
+  {
+    return true;
+  }
+  Tensor *declared = infos[this->Onsc[index]->Id];
+  if (declared->Type != TDT_UNDEFINED)
+  {
+    if (declared->Type != type || declared->Dimension != dimension)
+    {
+      return false;
+    }
+    for (int d = 0; d != dimension; d++)
+    {
+      if (declared->Shape[d] != TENSOR_DYNAMIC_DIM && declared->Shape[d] != shape[d])
+      {
+        return false;
+      }
+    }
+    if (!declared->IsDynamic())
+    {
+      return true;
+    }
+  }
+  declared->Set(shape, dimension, type);
+  return true;
+}
+
+// the analysis allows it, and the tensor is still owned by the context.
+static inline bool _is_writable(Link *l, TensorRef *ref)
+{
+  return l->InPlace && ref->Flags.Bits.Internal && !ref->Flags.Bits.ReadOnly;
+}
+
 bool UnaryOperator::Activate(ActivationContext *ctx)
 {
   // we must have a single input
@@ -19,14 +141,45 @@ bool UnaryOperator::Activate(ActivationContext *ctx)
       TensorRef *output = input;
       int i = (int)input->Value.Type;
       // do not assume that the type is valid.
-      if (i < 0 && i >= TDT_COUNT)
+      if (i < 0 || i >= TDT_COUNT)
       {
         return false;
       }
       UnaryFunctionPtr w = this->_typedFn[i];
+      tensor_data_type_t half = TDT_UNDEFINED;
+      // half tensors are computed in float, unless the operator has a dedicated kernel.
+      if (!w && cm_is_half(input->Value.Type))
+      {
+        w = this->_typedFn[TDT_FLOAT];
+        half = input->Value.Type;
+      }
+      // a buffer bound by the user to the output is preferred to the input, it saves the copy of the result.
+      if (w && (!_is_writable(a, input) || ctx->GetBoundRef(this)))
+      {
+        output = ctx->CreateOutputRef(this, input->Value.Shape, input->Value.Dimension, input->Value.Type);
+        if (!output)
+        {
+          return false;
+        }
+      }
       if (w)
       {
-        w(&input->Value, &output->Value, this);
+        InferenceEngine *engine = ctx->GetEngine();
+        size_t n = input->Value.Count;
+        size_t elementSize = n ? input->Value.Size / n : 0;
+        _ElementWiseJob job = {w, nullptr, this, &input->Value, nullptr, &output->Value, elementSize, half};
+        if (engine && (half != TDT_UNDEFINED || engine->IsParallel(n, elementSize)))
+        {
+          engine->ParallelFor(n, elementSize, _element_wise_chunk, &job);
+        }
+        else if (half == TDT_UNDEFINED)
+        {
+          w(&input->Value, &output->Value, this);
+        }
+        else
+        {
+          _element_wise_chunk(0, n, &job);
+        }
       }
       return ctx->Forward(this, output);
     }
@@ -44,33 +197,66 @@ bool BinaryOperator::Activate(ActivationContext *ctx)
     Link *y = this->Opsc[1];
     if (x && y)
     {
-      TensorRef *refx = ctx->GetPayloadRef(x->Id);
-      TensorRef *refy = ctx->GetPayloadRef(y->Id);
-      if (!refy)
+      // an initializer is read from its link, it has no tensor in the context.
+      Tensor *vx = this->_getValue(ctx, 0);
+      Tensor *vy = this->_getValue(ctx, 1);
+      // the kernels have no broadcasting, so both shapes must be equal.
+      if (!vx || !vy || !vx->AreShapesEqual(vy))
       {
         return false;
       }
-      // bigger buffer in first, in order to beeing able to broadcast.
-      if (refy->Value.Size > refx->Value.Size)
-      {
-        TensorRef *tmp = refx;
-        refx = refy;
-        refy = tmp;
-      }
-
-      TensorRef *output = refx;
 
-      int i = (int)refx->Value.Type;
+      int i = (int)vx->Type;
       // do not assume that the type is valid.
-      if (i < 0 && i >= TDT_COUNT)
+      if (i < 0 || i >= TDT_COUNT)
       {
         return false;
       }
       BinaryFunctionPtr w = this->_typedFn[i];
-      if (w)
+      tensor_data_type_t half = TDT_UNDEFINED;
+      // half tensors are computed in float, unless the operator has a dedicated kernel.
+      if (!w && cm_is_half(vx->Type))
+      {
+        w = this->_typedFn[TDT_FLOAT];
+        half = vx->Type;
+      }
+      if (!w)
       {
-        // TODO -> build a strategy about the resulting tensor
-        w(&refx->Value, &refy->Value, &output->Value, this);
+        return false;
+      }
+
+      // the result goes into one of the inputs when it is written in place, unless the user bound a buffer to the output.
+      TensorRef *refx = ctx->GetPayloadRef(x->Id);
+      TensorRef *refy = ctx->GetPayloadRef(y->Id);
+      TensorRef *output = nullptr;
+      if (!ctx->GetBoundRef(this))
+      {
+        output = refx && _is_writable(x, refx) ? refx : (refy && _is_writable(y, refy) ? refy : nullptr);
+      }
+      if (!output)
+      {
+        output = ctx->CreateOutputRef(this, vx->Shape, vx->Dimension, vx->Type);
+        if (!output)
+        {
+          return false;
+        }
+      }
+
+      InferenceEngine *engine = ctx->GetEngine();
+      size_t n = vx->Count;
+      size_t elementSize = n ? vx->Size / n : 0;
+      _ElementWiseJob job = {nullptr, w, this, vx, vy, &output->Value, elementSize, half};
+      if (engine && (half != TDT_UNDEFINED || engine->IsParallel(n, elementSize)))
+      {
+        engine->ParallelFor(n, elementSize, _element_wise_chunk, &job);
+      }
+      else if (half == TDT_UNDEFINED)
+      {
+        w(vx, vy, &output->Value, this);
+      }
+      else
+      {
+        _element_wise_chunk(0, n, &job);
       }
       return ctx->Forward(this, output);
     }
@@ -78,7 +264,478 @@ bool BinaryOperator::Activate(ActivationContext *ctx)
   return false;
 };
 
+bool UnaryOperator::InferShapes(Tensor **infos)
+{
+  if (this->Opsc.Count() != 1)
+  {
+    return false;
+  }
+  Tensor *x = this->_inferredInput(infos, 0);
+  return this->_inferOutput(infos, 0, x->Shape, x->Dimension, x->Type);
+}
+
+bool BinaryOperator::InferShapes(Tensor **infos)
+{
+  if (this->Opsc.Count() != 2)
+  {
+    return false;
+  }
+  Tensor *x = this->_inferredInput(infos, 0);
+  Tensor *y = this->_inferredInput(infos, 1);
+  // the kernels have no broadcasting, so both shapes must be equal. A symbolic size takes the size of the other input.
+  if (!x || !y || x->Type != y->Type || x->Dimension != y->Dimension)
+  {
+    return false;
+  }
+  uint64_t shape[TENSOR_MAX_DIMENSION];
+  for (int d = 0; d != x->Dimension; d++)
+  {
+    uint64_t a = x->Shape[d];
+    uint64_t b = y->Shape[d];
+    if (a != b && a != TENSOR_DYNAMIC_DIM && b != TENSOR_DYNAMIC_DIM)
+    {
+      return false;
+    }
+    shape[d] = a == TENSOR_DYNAMIC_DIM ? b : a;
+  }
+  return this->_inferOutput(infos, 0, shape, x->Dimension, x->Type);
+}
+
+Graph ::~Graph()
+{
+  delete this->_topology;
+  if (!this->_arena)
+  {
+    return;
+  }
+  // the objects placed into the arena are destroyed, the memory goes with the arena.
+  for (int i = 0; i != this->Nodes.Count(); i++)
+  {
+    Operator *op = this->Nodes[i];
+    if (this->_inArena(op))
+    {
+      op->~Operator();
+    }
+  }
+  for (int i = 0; i != this->Links.Count(); i++)
+  {
+    Link *l = this->Links[i];
+    if (this->_inArena(l))
+    {
+      l->~Link();
+    }
+  }
+  cm_free(this->_arena);
+}
+
 bool Graph ::Activate(ActivationContext *ctx)
 {
   return true;
 }
+
+// the index of the link into the inputs of its destination, when the result of its source is a tensor of the context
+// read by nobody else, -1 otherwise.
+static int _exclusive_index(Link *l)
+{
+  Operator *consumer = l->Ofin;
+  Operator *producer = l->Oini;
+  // graph inputs are user buffers and initializers are shared by every context.
+  if (!consumer || !producer || l->GetPayloadInfos()->Data || producer->IsView())
+  {
+    return -1;
+  }
+  // the producer forwards the same tensor to every outgoing link.
+  if (producer->Onsc.Count() != 1)
+  {
+    return -1;
+  }
+  int index = -1;
+  int count = consumer->Opsc.Count();
+  for (int i = 0; i != count; i++)
+  {
+    if (consumer->Opsc[i] == l)
+    {
+      if (index >= 0)
+      {
+        return -1;
+      }
+      index = i;
+    }
+  }
+  return index;
+}
+
+int Graph ::AnalyzeInPlace()
+{
+  int marked = 0;
+  int count = this->Links.Count();
+  for (int i = 0; i != count; i++)
+  {
+    Link *l = this->Links[i];
+    int index = _exclusive_index(l);
+    l->InPlace = index >= 0 && l->Ofin->SupportsInPlace(index);
+    l->InSlice = index >= 0 && !l->InPlace && l->Ofin->SupportsInputSlice(index);
+    marked += l->InPlace || l->InSlice;
+  }
+  return marked;
+}
+
+bool Graph ::Compile(int lineSize)
+{
+  delete this->_topology;
+  this->_topology = GraphTopology::Compile(this, lineSize);
+  return this->_topology != nullptr;
+}
+
+int Graph ::InferShapes(Operator **failed)
+{
+  const GraphTopology *t = this->_topology;
+  if (!t)
+  {
+    return -1;
+  }
+  // the inference works on the links themselves.
+  int linkCount = t->GetLinkCount();
+  Tensor **infos = linkCount ? (Tensor **)cm_malloc(linkCount * sizeof(Tensor *)) : nullptr;
+  if (linkCount && !infos)
+  {
+    return -1;
+  }
+  for (int i = 0; i != linkCount; i++)
+  {
+    infos[i] = t->GetLink(i)->GetPayloadInfos();
+  }
+  int inferred = this->InferShapes(infos, failed);
+  cm_free(infos);
+  return inferred;
+}
+
+// the type and the shape are known, without any symbolic dimension.
+static inline bool _is_known(Tensor *infos)
+{
+  return infos->Type != TDT_UNDEFINED && !infos->IsDynamic();
+}
+
+int Graph ::InferShapes(Tensor **infos, Operator **failed)
+{
+  const GraphTopology *t = this->_topology;
+  if (!t)
+  {
+    return -1;
+  }
+  // the operators are visited in topological order, every one waits for the operators producing its inputs.
+  int nodeCount = t->GetNodeCount();
+  if (!nodeCount)
+  {
+    return 0;
+  }
+  int32_t *pending = (int32_t *)cm_malloc(2 * nodeCount * sizeof(int32_t));
+  if (!pending)
+  {
+    return -1;
+  }
+  int32_t *queue = pending + nodeCount;
+  int head = 0;
+  int tail = 0;
+  for (int n = 0; n != nodeCount; n++)
+  {
+    const int32_t *inputs = t->GetInputs(n);
+    int count = t->GetInputCount(n);
+    pending[n] = 0;
+    for (int i = 0; i != count; i++)
+    {
+      pending[n] += t->GetSource(inputs[i]) >= 0;
+    }
+    if (!pending[n])
+    {
+      queue[tail++] = n;
+    }
+  }
+
+  int inferred = 0;
+  while (head != tail)
+  {
+    int32_t n = queue[head++];
+    const int32_t *inputs = t->GetInputs(n);
+    int inputCount = t->GetInputCount(n);
+    const int32_t *outputs = t->GetOutputs(n);
+    int outputCount = t->GetOutputCount(n);
+    bool known = true;
+    for (int i = 0; i != inputCount; i++)
+    {
+      known = known && _is_known(infos[inputs[i]]);
+    }
+    if (known)
+    {
+      int unknown = 0;
+      for (int i = 0; i != outputCount; i++)
+      {
+        unknown += !_is_known(infos[outputs[i]]);
+      }
+      Operator *op = t->GetNode(n);
+      if (!op->InferShapes(infos))
+      {
+        if (failed)
+        {
+          *failed = op;
+        }
+        cm_free(pending);
+        return -1;
+      }
+      for (int i = 0; i != outputCount; i++)
+      {
+        unknown -= !_is_known(infos[outputs[i]]);
+      }
+      inferred += unknown;
+    }
+    for (int i = 0; i != outputCount; i++)
+    {
+      int32_t next = t->GetTarget(outputs[i]);
+      if (next < 0)
+      {
+        continue;
+      }
+      // a link read twice by the same operator counts twice.
+      const int32_t *nextInputs = t->GetInputs(next);
+      int nextCount = t->GetInputCount(next);
+      for (int j = 0; j != nextCount; j++)
+      {
+        if (nextInputs[j] == outputs[i] && --pending[next] == 0)
+        {
+          queue[tail++] = next;
+        }
+      }
+    }
+  }
+  cm_free(pending);
+  return inferred;
+}
+
+bool Graph ::IsDynamic()
+{
+  int count = this->Inputs.Count();
+  for (int i = 0; i != count; i++)
+  {
+    if (this->Inputs[i].Value->GetPayloadInfos()->IsDynamic())
+    {
+      return true;
+    }
+  }
+  return false;
+}
+
+// the id of a node of the graph, -1 for none.
+static inline int32_t _node_id(Graph *graph, Operator *op)
+{
+  return op && op->Id >= 0 && op->Id < graph->Nodes.Count() && graph->Nodes[op->Id] == op ? op->Id : -1;
+}
+
+// the id of a link of the graph, -1 if the link is not part of it.
+static inline int32_t _link_id(Graph *graph, Link *l)
+{
+  return l && l->Id >= 0 && l->Id < graph->Links.Count() && graph->Links[l->Id] == l ? l->Id : -1;
+}
+
+// the first slot of a line from a given slot.
+static inline int _align_slot(int slot, int perLine)
+{
+  return (slot + perLine - 1) / perLine * perLine;
+}
+
+GraphTopology *GraphTopology ::Compile(Graph *graph, int lineSize)
+{
+  int nodeCount = graph->Nodes.Count();
+  int linkCount = graph->Links.Count();
+  int inputCount = 0;
+  int outputCount = 0;
+  for (int i = 0; i != nodeCount; i++)
+  {
+    Operator *op = graph->Nodes[i];
+    op->Id = i;
+    for (int j = 0; j != op->Opsc.Count(); j++)
+    {
+      inputCount += op->Opsc[j] != nullptr;
+    }
+    outputCount += op->Onsc.Count();
+  }
+
+  // the pointers first, then the ids, so every array is aligned.
+  size_t size = (nodeCount * sizeof(Operator *)) + (linkCount * sizeof(Link *)) +
+                (2 * (nodeCount + 1) + inputCount + outputCount + 4 * linkCount + 2 * nodeCount) * sizeof(int32_t);
+  void *block = cm_malloc(size);
+  if (!block)
+  {
+    return nullptr;
+  }
+  GraphTopology *t = new GraphTopology();
+  t->_block = block;
+  t->_nodeCount = nodeCount;
+  t->_linkCount = linkCount;
+  t->_nodes = (Operator **)block;
+  t->_links = (Link **)(t->_nodes + nodeCount);
+  t->_inputOffsets = (int32_t *)(t->_links + linkCount);
+  t->_inputs = t->_inputOffsets + nodeCount + 1;
+  t->_outputOffsets = t->_inputs + inputCount;
+  t->_outputs = t->_outputOffsets + nodeCount + 1;
+  t->_sources = t->_outputs + outputCount;
+  t->_targets = t->_sources + linkCount;
+  t->_refSlots = t->_targets + linkCount;
+  t->_flagSlots = t->_refSlots + linkCount;
+  t->_pendingSlots = t->_flagSlots + linkCount;
+  t->_pendingCounts = t->_pendingSlots + nodeCount;
+
+  for (int i = 0; i != linkCount; i++)
+  {
+    Link *l = graph->Links[i];
+    // the link ids index the states of the contexts, they must match the position of the link.
+    if (_link_id(graph, l) != i)
+    {
+      delete t;
+      return nullptr;
+    }
+    t->_links[i] = l;
+    t->_sources[i] = _node_id(graph, l->Oini);
+    t->_targets[i] = _node_id(graph, l->Ofin);
+  }
+
+  int in = 0;
+  int out = 0;
+  for (int i = 0; i != nodeCount; i++)
+  {
+    Operator *op = graph->Nodes[i];
+    t->_nodes[i] = op;
+    t->_inputOffsets[i] = in;
+    t->_outputOffsets[i] = out;
+    int count = op->Opsc.Count();
+    for (int j = 0; j != count; j++)
+    {
+      // a blank input is never activated, the node does not wait for it.
+      if (!op->Opsc[j])
+      {
+        continue;
+      }
+      if ((t->_inputs[in++] = _link_id(graph, op->Opsc[j])) < 0)
+      {
+        delete t;
+        return nullptr;
+      }
+    }
+    count = op->Onsc.Count();
+    for (int j = 0; j != count; j++)
+    {
+      if ((t->_outputs[out++] = _link_id(graph, op->Onsc[j])) < 0)
+      {
+        delete t;
+        return nullptr;
+      }
+    }
+  }
+  t->_inputOffsets[nodeCount] = in;
+  t->_outputOffsets[nodeCount] = out;
+  if (!t->_layout(lineSize))
+  {
+    delete t;
+    return nullptr;
+  }
+  return t;
+}
+
+// the arrays of the state of a context hold the tensor pointers, the flags bytes and the 32 bits counters.
+bool GraphTopology ::_layout(int lineSize)
+{
+  int nodeCount = this->_nodeCount;
+  int linkCount = this->_linkCount;
+  // a node waits for every link it reads, a link read twice counts once.
+  for (int i = 0; i != nodeCount; i++)
+  {
+    const int32_t *inputs = this->GetInputs(i);
+    int count = this->GetInputCount(i);
+    int distinct = 0;
+    for (int j = 0; j != count; j++)
+    {
+      int k = 0;
+      while (k != j && inputs[k] != inputs[j])
+      {
+        k++;
+      }
+      distinct += k == j;
+    }
+    this->_pendingCounts[i] = distinct;
+  }
+
+  this->_lineSize = max(lineSize, 0);
+  int pendingPerLine = max(this->_lineSize / (int)sizeof(int32_t), 1);
+  int pending = 0;
+  for (int i = 0; i != nodeCount; i++)
+  {
+    // the nodes reading a single link are activated by it, without counter. Every counter has its own line,
+    // as the producers of the inputs decrement it from their own thread.
+    bool counted = this->_pendingCounts[i] > 1;
+    this->_pendingSlots[i] = counted ? _align_slot(pending, pendingPerLine) : -1;
+    pending = counted ? this->_pendingSlots[i] + 1 : pending;
+  }
+  this->_pendingSlotCount = _align_slot(pending, pendingPerLine);
+
+  if (!this->_lineSize)
+  {
+    for (int i = 0; i != linkCount; i++)
+    {
+      this->_refSlots[i] = i;
+      this->_flagSlots[i] = i;
+    }
+    this->_refSlotCount = linkCount;
+    this->_flagSlotCount = linkCount;
+    return true;
+  }
+
+  // the lanes: a node reading the single output of the previous node continues its lane, any other node starts a lane.
+  int32_t *lanes = (int32_t *)cm_malloc((nodeCount + 2 * (nodeCount + 1)) * sizeof(int32_t));
+  if (!lanes)
+  {
+    return false;
+  }
+  int32_t *refBases = lanes + nodeCount;
+  int32_t *flagBases = refBases + nodeCount + 1;
+  int laneCount = 0;
+  for (int i = 0; i != nodeCount; i++)
+  {
+    int32_t source = this->_pendingCounts[i] == 1 ? this->_sources[this->GetInputs(i)[0]] : -1;
+    lanes[i] = source >= 0 && source < i && this->GetOutputCount(source) == 1 ? lanes[source] : laneCount++;
+  }
+
+  // a link goes with its source, the inputs of the graph with their destination, and the others into a last lane.
+  for (int i = 0; i <= laneCount; i++)
+  {
+    refBases[i] = 0;
+  }
+  for (int i = 0; i != linkCount; i++)
+  {
+    int32_t node = this->_sources[i] >= 0 ? this->_sources[i] : this->_targets[i];
+    // the lane of the link for now, its slot below.
+    this->_refSlots[i] = node >= 0 ? lanes[node] : laneCount;
+    refBases[this->_refSlots[i]]++;
+  }
+
+  int refsPerLine = max(this->_lineSize / (int)sizeof(void *), 1);
+  int flagsPerLine = this->_lineSize;
+  int refs = 0;
+  int flags = 0;
+  for (int i = 0; i <= laneCount; i++)
+  {
+    int count = refBases[i];
+    refBases[i] = _align_slot(refs, refsPerLine);
+    flagBases[i] = _align_slot(flags, flagsPerLine);
+    refs = refBases[i] + count;
+    flags = flagBases[i] + count;
+  }
+  for (int i = 0; i != linkCount; i++)
+  {
+    int32_t lane = this->_refSlots[i];
+    this->_refSlots[i] = refBases[lane]++;
+    this->_flagSlots[i] = flagBases[lane]++;
+  }
+  this->_refSlotCount = _align_slot(refs, refsPerLine);
+  this->_flagSlotCount = _align_slot(flags, flagsPerLine);
+  cm_free(lanes);
+  return true;
+}
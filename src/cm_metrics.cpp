@@ -0,0 +1,172 @@
+#include "cm_metrics.hpp"
+
+using namespace CyanMycelium;
+
+#define CM_HISTOGRAM_SUB_BUCKET_COUNT (CM_HISTOGRAM_HALF_COUNT * 2)
+
+// index of the most significant bit, v must not be 0.
+static inline int _msb64(cm_uint64_t v)
+{
+  int n = 0;
+  for (int shift = 32; shift; shift >>= 1)
+  {
+    if (v >> shift)
+    {
+      v >>= shift;
+      n += shift;
+    }
+  }
+  return n;
+}
+
+static inline void _add(std::atomic<cm_uint64_t> &counter, cm_uint64_t value)
+{
+  counter.fetch_add(value, std::memory_order_relaxed);
+}
+
+static inline cm_uint64_t _get(std::atomic<cm_uint64_t> &counter)
+{
+  return counter.load(std::memory_order_relaxed);
+}
+
+// values below 2^bits have their own bucket, then every power of 2 is split into 2^(bits - 1) buckets.
+int LatencyHistogram ::BucketOf(cm_uint64_t ns)
+{
+  if (ns < CM_HISTOGRAM_SUB_BUCKET_COUNT)
+  {
+    return (int)ns;
+  }
+  int shift = _msb64(ns) - (CM_HISTOGRAM_SUB_BUCKET_BITS - 1);
+  return shift * CM_HISTOGRAM_HALF_COUNT + (int)(ns >> shift);
+}
+
+cm_uint64_t LatencyHistogram ::LowestOf(int bucket)
+{
+  if (bucket < CM_HISTOGRAM_SUB_BUCKET_COUNT)
+  {
+    return bucket;
+  }
+  int shift = bucket / CM_HISTOGRAM_HALF_COUNT - 1;
+  return (cm_uint64_t)(bucket - shift * CM_HISTOGRAM_HALF_COUNT) << shift;
+}
+
+void LatencyHistogram ::Record(cm_uint64_t ns)
+{
+  _add(this->_buckets[BucketOf(ns)], 1);
+  _add(this->_count, 1);
+  _add(this->_sum, ns);
+  cm_uint64_t m = this->_max.load(std::memory_order_relaxed);
+  while (ns > m && !this->_max.compare_exchange_weak(m, ns, std::memory_order_relaxed))
+  {
+  }
+}
+
+cm_uint64_t LatencyHistogram ::GetMean()
+{
+  cm_uint64_t count = _get(this->_count);
+  return count ? _get(this->_sum) / count : 0;
+}
+
+cm_uint64_t LatencyHistogram ::GetValueAt(double percentile)
+{
+  cm_uint64_t count = _get(this->_count);
+  if (!count)
+  {
+    return 0;
+  }
+  // the rank of the value, at least the first one.
+  cm_uint64_t rank = (cm_uint64_t)(percentile / 100.0 * count + 0.5);
+  rank = max(rank, (cm_uint64_t)1);
+  cm_uint64_t seen = 0;
+  for (int i = 0; i != CM_HISTOGRAM_BUCKET_COUNT; i++)
+  {
+    seen += _get(this->_buckets[i]);
+    if (seen >= rank)
+    {
+      // the bucket upper bound, but never above the largest value.
+      cm_uint64_t upper = i + 1 < CM_HISTOGRAM_BUCKET_COUNT ? LowestOf(i + 1) - 1 : LowestOf(i);
+      return min(upper, this->GetMax());
+    }
+  }
+  return this->GetMax();
+}
+
+void LatencyHistogram ::Reset()
+{
+  for (int i = 0; i != CM_HISTOGRAM_BUCKET_COUNT; i++)
+  {
+    this->_buckets[i].store(0, std::memory_order_relaxed);
+  }
+  this->_count.store(0, std::memory_order_relaxed);
+  this->_sum.store(0, std::memory_order_relaxed);
+  this->_max.store(0, std::memory_order_relaxed);
+}
+
+int EngineMetrics ::RegisterWorker()
+{
+  int worker = this->_workerCount.fetch_add(1, std::memory_order_relaxed);
+  return min(worker, CM_METRICS_MAX_WORKERS - 1);
+}
+
+void EngineMetrics ::OnWorker(int worker, cm_uint64_t idle, cm_uint64_t busy, cm_uint64_t steal)
+{
+  _Worker *w = this->_workers + worker;
+  _add(w->Idle, idle);
+  if (busy || steal)
+  {
+    _add(w->Busy, busy);
+    _add(w->Steal, steal);
+    _add(w->Events, 1);
+  }
+}
+
+void EngineMetrics ::GetSnapshot(EngineMetricsSnapshot &snapshot)
+{
+  snapshot.Timestamp = cm_time_ns();
+  snapshot.QueueCapacity = 0;
+  snapshot.QueueDepth = max(this->_depth.load(std::memory_order_relaxed), 0);
+  snapshot.QueueHighWater = this->_highWater.load(std::memory_order_relaxed);
+  snapshot.Sent = _get(this->_sent);
+  snapshot.SendFailures = _get(this->_sendFailures);
+  snapshot.Admitted = _get(this->_admitted);
+  snapshot.Rejected = _get(this->_rejected);
+  snapshot.Inlined = _get(this->_inlined);
+  snapshot.Activations = _get(this->_activations);
+  snapshot.WorkerCount = min(this->_workerCount.load(std::memory_order_relaxed), CM_METRICS_MAX_WORKERS);
+  for (int i = 0; i != snapshot.WorkerCount; i++)
+  {
+    _Worker *w = this->_workers + i;
+    snapshot.Workers[i].Busy = _get(w->Busy);
+    snapshot.Workers[i].Steal = _get(w->Steal);
+    snapshot.Workers[i].Idle = _get(w->Idle);
+    snapshot.Workers[i].Events = _get(w->Events);
+  }
+  LatencySummary &l = snapshot.Latency;
+  l.Count = this->_latency.GetCount();
+  l.Mean = this->_latency.GetMean();
+  l.P50 = this->_latency.GetValueAt(50);
+  l.P90 = this->_latency.GetValueAt(90);
+  l.P99 = this->_latency.GetValueAt(99);
+  l.P999 = this->_latency.GetValueAt(99.9);
+  l.Max = this->_latency.GetMax();
+}
+
+void EngineMetrics ::Reset()
+{
+  for (int i = 0; i != CM_METRICS_MAX_WORKERS; i++)
+  {
+    _Worker *w = this->_workers + i;
+    w->Busy.store(0, std::memory_order_relaxed);
+    w->Steal.store(0, std::memory_order_relaxed);
+    w->Idle.store(0, std::memory_order_relaxed);
+    w->Events.store(0, std::memory_order_relaxed);
+  }
+  this->_highWater.store(this->_depth.load(std::memory_order_relaxed), std::memory_order_relaxed);
+  this->_sent.store(0, std::memory_order_relaxed);
+  this->_sendFailures.store(0, std::memory_order_relaxed);
+  this->_admitted.store(0, std::memory_order_relaxed);
+  this->_rejected.store(0, std::memory_order_relaxed);
+  this->_inlined.store(0, std::memory_order_relaxed);
+  this->_activations.store(0, std::memory_order_relaxed);
+  this->_latency.Reset();
+}
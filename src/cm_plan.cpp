@@ -0,0 +1,218 @@
+#include <new>
+
+#include "cm_plan.hpp"
+
+using namespace CyanMycelium;
+
+// FNV-1a, over the words of the infos.
+#define CM_PLAN_HASH_BASIS 14695981039346656037ULL
+#define CM_PLAN_HASH_PRIME 1099511628211ULL
+
+static inline cm_uint64_t _hash_word(cm_uint64_t hash, cm_uint64_t word)
+{
+  return (hash ^ word) * CM_PLAN_HASH_PRIME;
+}
+
+// the given infos are concrete and fit the declared ones, where a symbolic dimension matches any size.
+static inline bool _fits(TensorInfos *declared, TensorInfos *given)
+{
+  if (given->IsDynamic() || given->Dimension != declared->Dimension)
+  {
+    return false;
+  }
+  for (int d = 0; d != given->Dimension; d++)
+  {
+    if (declared->Shape[d] != TENSOR_DYNAMIC_DIM && declared->Shape[d] != given->Shape[d])
+    {
+      return false;
+    }
+  }
+  return true;
+}
+
+cm_uint64_t ShapePlan ::Hash(TensorInfos **inputs, int count)
+{
+  cm_uint64_t hash = CM_PLAN_HASH_BASIS;
+  for (int i = 0; i != count; i++)
+  {
+    TensorInfos *infos = inputs[i];
+    hash = _hash_word(hash, ((cm_uint64_t)infos->Type << 8) | infos->Dimension);
+    for (int d = 0; d != infos->Dimension; d++)
+    {
+      hash = _hash_word(hash, infos->Shape[d]);
+    }
+  }
+  return hash;
+}
+
+bool ShapePlan ::Matches(TensorInfos **inputs, int count, cm_uint64_t hash)
+{
+  if (hash != this->_hash || count != this->_inputCount)
+  {
+    return false;
+  }
+  for (int i = 0; i != count; i++)
+  {
+    if (inputs[i]->Type != this->_inputs[i].Type || !inputs[i]->AreShapesEqual(this->_inputs + i))
+    {
+      return false;
+    }
+  }
+  return true;
+}
+
+ShapePlan *ShapePlan ::Build(Graph *graph, TensorInfos **inputs, Operator **failed)
+{
+  GraphTopology *t = graph->GetTopology();
+  if (!t)
+  {
+    return nullptr;
+  }
+  // the infos of the links, the pointers given to the operators, then the key. A symbolic dimension is carried by a link,
+  // so the block is never empty.
+  int linkCount = t->GetLinkCount();
+  int inputCount = graph->Inputs.Count();
+  void *block = cm_malloc(linkCount * (sizeof(Tensor) + sizeof(Tensor *)) + inputCount * sizeof(TensorInfos));
+  if (!block)
+  {
+    return nullptr;
+  }
+  ShapePlan *plan = new ShapePlan();
+  plan->_block = block;
+  plan->_infos = (Tensor *)block;
+  Tensor **infos = (Tensor **)(plan->_infos + linkCount);
+  plan->_inputs = (TensorInfos *)(infos + linkCount);
+  plan->_inputCount = inputCount;
+  plan->_hash = ShapePlan::Hash(inputs, inputCount);
+  plan->_size = 0;
+  plan->_previous = nullptr;
+  plan->_next = nullptr;
+
+  // the plan starts from the infos known at load time, the initializers keep their value.
+  for (int i = 0; i != linkCount; i++)
+  {
+    infos[i] = new (plan->_infos + i) Tensor(*t->GetLink(i)->GetPayloadInfos());
+  }
+  for (int i = 0; i != inputCount; i++)
+  {
+    new (plan->_inputs + i) TensorInfos(*inputs[i]);
+    Tensor *declared = infos[graph->Inputs[i].Value->Id];
+    // an input without declared type has nothing to be checked against, the static ones must be given as declared.
+    if (declared->Type == TDT_UNDEFINED)
+    {
+      continue;
+    }
+    if (!_fits(declared, inputs[i]))
+    {
+      delete plan;
+      return nullptr;
+    }
+    declared->Set(inputs[i]->Shape, inputs[i]->Dimension, declared->Type, declared->Data);
+  }
+  if (graph->InferShapes(infos, failed) < 0)
+  {
+    delete plan;
+    return nullptr;
+  }
+  for (int i = 0; i != linkCount; i++)
+  {
+    Tensor *l = infos[i];
+    if (t->GetSource(i) >= 0 && l->Type != TDT_UNDEFINED && !l->IsDynamic())
+    {
+      plan->_size += l->Size;
+    }
+  }
+  return plan;
+}
+
+ShapePlan *ShapePlanCache ::Get(Graph *graph, TensorInfos **inputs, Operator **failed)
+{
+  int count = graph->Inputs.Count();
+  cm_uint64_t hash = ShapePlan::Hash(inputs, count);
+  for (ShapePlan *plan = this->_first; plan; plan = plan->_next)
+  {
+    if (plan->Matches(inputs, count, hash))
+    {
+      this->_hits++;
+      if (plan != this->_first)
+      {
+        this->_unlink(plan);
+        this->_pushFront(plan);
+      }
+      return plan;
+    }
+  }
+  this->_misses++;
+  ShapePlan *plan = ShapePlan::Build(graph, inputs, failed);
+  if (!plan)
+  {
+    return nullptr;
+  }
+  if (this->_count == this->_capacity)
+  {
+    ShapePlan *last = this->_last;
+    this->_unlink(last);
+    delete last;
+  }
+  this->_pushFront(plan);
+  return plan;
+}
+
+void ShapePlanCache ::SetCapacity(int capacity)
+{
+  this->_capacity = max(capacity, 1);
+  while (this->_count > this->_capacity)
+  {
+    ShapePlan *last = this->_last;
+    this->_unlink(last);
+    delete last;
+  }
+}
+
+void ShapePlanCache ::Clear()
+{
+  while (this->_first)
+  {
+    ShapePlan *plan = this->_first;
+    this->_unlink(plan);
+    delete plan;
+  }
+}
+
+void ShapePlanCache ::_unlink(ShapePlan *plan)
+{
+  if (plan->_previous)
+  {
+    plan->_previous->_next = plan->_next;
+  }
+  else
+  {
+    this->_first = plan->_next;
+  }
+  if (plan->_next)
+  {
+    plan->_next->_previous = plan->_previous;
+  }
+  else
+  {
+    this->_last = plan->_previous;
+  }
+  plan->_previous = nullptr;
+  plan->_next = nullptr;
+  this->_count--;
+}
+
+void ShapePlanCache ::_pushFront(ShapePlan *plan)
+{
+  plan->_next = this->_first;
+  if (this->_first)
+  {
+    this->_first->_previous = plan;
+  }
+  else
+  {
+    this->_last = plan;
+  }
+  this->_first = plan;
+  this->_count++;
+}
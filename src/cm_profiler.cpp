@@ -0,0 +1,183 @@
+#include <stdio.h>
+
+#include "cm_graph.hpp"
+#include "cm_profiler.hpp"
+
+using namespace CyanMycelium;
+
+#define CM_PROFILER_UNKNOWN_TYPE "Operator"
+
+// the measures of an operator type.
+struct _ProfileSummary
+{
+  const char *Type;
+  int Count;
+  cm_uint64_t Exec;
+  cm_uint64_t MaxExec;
+  cm_uint64_t Wait;
+  size_t BytesIn;
+  size_t BytesOut;
+  int Allocs;
+};
+
+static inline const char *_type_of(const ProfileRecord *r)
+{
+  return r->Node && r->Node->TypeName ? r->Node->TypeName : CM_PROFILER_UNKNOWN_TYPE;
+}
+
+static inline double _us(cm_uint64_t ns) { return ns / 1000.0; }
+
+Profiler ::Profiler(int capacity) : _capacity(max(capacity, 0)), _next(0), _inferences(0)
+{
+  this->_records = (ProfileRecord *)cm_malloc(this->_capacity * sizeof(ProfileRecord));
+  if (!this->_records)
+  {
+    this->_capacity = 0;
+  }
+}
+
+Profiler ::~Profiler()
+{
+  if (this->_records)
+  {
+    cm_free(this->_records);
+  }
+}
+
+ProfileRecord *Profiler ::Claim(int inference, const Operator *node)
+{
+  int i = this->_next.fetch_add(1, std::memory_order_relaxed);
+  if (i >= this->_capacity)
+  {
+    return nullptr;
+  }
+  ProfileRecord *r = this->_records + i;
+  cm_memset(r, 0, sizeof(ProfileRecord));
+  r->Node = node;
+  r->Inference = inference;
+  return r;
+}
+
+int Profiler ::Count()
+{
+  return min(this->_next.load(std::memory_order_acquire), this->_capacity);
+}
+
+int Profiler ::GetDropped()
+{
+  return max(this->_next.load(std::memory_order_acquire) - this->_capacity, 0);
+}
+
+void Profiler ::Clear()
+{
+  this->_next.store(0, std::memory_order_release);
+  this->_inferences.store(0, std::memory_order_release);
+}
+
+void Profiler ::WriteChromeTrace(ProfilerWriteFunction fn, void *userData)
+{
+  char line[CM_PROFILER_LINE_SIZE];
+  int count = this->Count();
+  // timestamps are relative to the first event.
+  cm_uint64_t origin = count ? this->_records[0].Queued : 0;
+  for (int i = 1; i < count; i++)
+  {
+    origin = min(origin, this->_records[i].Queued);
+  }
+
+  fn("{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n", userData);
+  bool first = true;
+  for (int i = 0; i != count; i++)
+  {
+    ProfileRecord *r = this->_records + i;
+    // the node is still running.
+    if (!r->Ended)
+    {
+      continue;
+    }
+    snprintf(line, sizeof(line),
+             "%s{\"name\":\"%s\",\"cat\":\"node\",\"ph\":\"X\",\"pid\":%d,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f,"
+             "\"args\":{\"node\":%d,\"queue_us\":%.3f,\"bytes_in\":%llu,\"bytes_out\":%llu,\"allocs\":%d}}",
+             first ? "" : ",\n", _type_of(r), r->Inference, (unsigned)r->ThreadId, _us(r->Started - origin), _us(r->Ended - r->Started),
+             r->Node ? (int)r->Node->Id : -1, _us(r->Started - r->Queued), (unsigned long long)r->BytesIn, (unsigned long long)r->BytesOut,
+             r->Allocs);
+    fn(line, userData);
+    first = false;
+  }
+  fn("\n]}\n", userData);
+}
+
+void Profiler ::WriteSummary(ProfilerWriteFunction fn, void *userData)
+{
+  char line[CM_PROFILER_LINE_SIZE];
+  int count = this->Count();
+  // there is at most one type per record.
+  _ProfileSummary *summaries = count ? (_ProfileSummary *)cm_malloc(count * sizeof(_ProfileSummary)) : nullptr;
+  if (count && !summaries)
+  {
+    return;
+  }
+  int n = 0;
+  cm_uint64_t total = 0;
+  for (int i = 0; i != count; i++)
+  {
+    ProfileRecord *r = this->_records + i;
+    if (!r->Ended)
+    {
+      continue;
+    }
+    const char *type = _type_of(r);
+    int j = 0;
+    while (j != n && strcmp(summaries[j].Type, type) != 0)
+    {
+      j++;
+    }
+    _ProfileSummary *s = summaries + j;
+    if (j == n)
+    {
+      cm_memset(s, 0, sizeof(_ProfileSummary));
+      s->Type = type;
+      n++;
+    }
+    cm_uint64_t exec = r->Ended - r->Started;
+    s->Count++;
+    s->Exec += exec;
+    s->MaxExec = max(s->MaxExec, exec);
+    s->Wait += r->Started - r->Queued;
+    s->BytesIn += r->BytesIn;
+    s->BytesOut += r->BytesOut;
+    s->Allocs += r->Allocs;
+    total += exec;
+  }
+
+  // most expensive first, the number of types is small.
+  for (int i = 1; i < n; i++)
+  {
+    _ProfileSummary s = summaries[i];
+    int j = i;
+    for (; j > 0 && summaries[j - 1].Exec < s.Exec; j--)
+    {
+      summaries[j] = summaries[j - 1];
+    }
+    summaries[j] = s;
+  }
+
+  snprintf(line, sizeof(line), "%-24s %8s %12s %10s %10s %12s %7s %14s %14s %7s\n",
+           "type", "count", "total_us", "mean_us", "max_us", "queue_us", "time%", "bytes_in", "bytes_out", "allocs");
+  fn(line, userData);
+  for (int i = 0; i != n; i++)
+  {
+    _ProfileSummary *s = summaries + i;
+    snprintf(line, sizeof(line), "%-24s %8d %12.3f %10.3f %10.3f %12.3f %7.2f %14llu %14llu %7d\n",
+             s->Type, s->Count, _us(s->Exec), _us(s->Exec) / s->Count, _us(s->MaxExec), _us(s->Wait),
+             total ? 100.0 * s->Exec / total : 0.0, (unsigned long long)s->BytesIn, (unsigned long long)s->BytesOut, s->Allocs);
+    fn(line, userData);
+  }
+  snprintf(line, sizeof(line), "%d inferences, %d records, %d dropped\n", this->_inferences.load(std::memory_order_acquire), count, this->GetDropped());
+  fn(line, userData);
+
+  if (summaries)
+  {
+    cm_free(summaries);
+  }
+}
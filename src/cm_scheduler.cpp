@@ -0,0 +1,113 @@
+#include "cm_scheduler.hpp"
+
+using namespace CyanMycelium;
+
+ActivationScheduler ::ActivationScheduler(SchedulingPolicy policy, const int *weights, int initialCapacity) : _lock(), _policy(policy), _count(0), _sequence(0), _virtual(0)
+{
+  this->_capacity = max(initialCapacity, 1);
+  this->_heap = (_Entry *)cm_malloc(this->_capacity * sizeof(_Entry));
+  this->_capacity = this->_heap ? this->_capacity : 0;
+  for (int i = 0; i != CM_SCHEDULING_CLASS_COUNT; i++)
+  {
+    this->_finish[i] = 0;
+    this->_stride[i] = CM_SCHEDULING_STRIDE_UNIT / max(weights ? weights[i] : 1, 1);
+  }
+}
+
+ActivationScheduler ::~ActivationScheduler()
+{
+  if (this->_heap)
+  {
+    cm_free(this->_heap);
+  }
+}
+
+bool ActivationScheduler ::Push(ActivationEvent &e, SchedulingInfos *infos)
+{
+  this->_lock.Take();
+  if (this->_count == this->_capacity)
+  {
+    int capacity = this->_capacity + max(this->_capacity / 2, 2);
+    _Entry *heap = (_Entry *)cm_realloc(this->_heap, capacity * sizeof(_Entry));
+    if (!heap)
+    {
+      this->_lock.Give();
+      return false;
+    }
+    this->_heap = heap;
+    this->_capacity = capacity;
+  }
+
+  _Entry entry;
+  entry.Event = e;
+  entry.Sequence = this->_sequence++;
+  if (this->_policy == CM_SCHEDULING_EDF)
+  {
+    entry.Key = infos->Deadline;
+  }
+  else
+  {
+    // start time fair queuing, a class is served in proportion of its weight while it has pending events,
+    // and an idle class does not accumulate any credit.
+    int c = infos->Class;
+    entry.Key = max(this->_virtual, this->_finish[c]);
+    this->_finish[c] = entry.Key + this->_stride[c];
+  }
+
+  // sift up
+  int i = this->_count++;
+  while (i)
+  {
+    int parent = (i - 1) / 2;
+    if (!_before(entry, this->_heap[parent]))
+    {
+      break;
+    }
+    this->_heap[i] = this->_heap[parent];
+    i = parent;
+  }
+  this->_heap[i] = entry;
+  this->_lock.Give();
+  return true;
+}
+
+bool ActivationScheduler ::Pop(ActivationEvent &e)
+{
+  this->_lock.Take();
+  if (!this->_count)
+  {
+    this->_lock.Give();
+    return false;
+  }
+  e = this->_heap[0].Event;
+  this->_virtual = max(this->_virtual, this->_heap[0].Key);
+
+  // sift down the last entry
+  _Entry last = this->_heap[--this->_count];
+  int i = 0;
+  int n = this->_count;
+  while (true)
+  {
+    int child = 2 * i + 1;
+    if (child >= n)
+    {
+      break;
+    }
+    if (child + 1 < n && _before(this->_heap[child + 1], this->_heap[child]))
+    {
+      child++;
+    }
+    if (!_before(this->_heap[child], last))
+    {
+      break;
+    }
+    this->_heap[i] = this->_heap[child];
+    i = child;
+  }
+  if (n)
+  {
+    this->_heap[i] = last;
+  }
+  this->_lock.Give();
+  return true;
+}
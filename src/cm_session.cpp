@@ -1,8 +1,55 @@
 #include "cm_engine.hpp"
 using namespace CyanMycelium;
 
+// the activations the calling thread has to run inline, collected by the outermost one. A node run inline forwards its
+// outputs through Activate again, so running them in place would nest as deep as the graph.
+static thread_local Collection<ActivationEvent> *_inlined = nullptr;
+
 bool AsyncActivationContext ::Activate(OperatorPtr node)
 {
+  if (this->_profiler)
+  {
+    this->_profileQueued(node);
+  }
   ActivationEvent e = {CM_ACTIVATION_NODE, this, node};
-  return this->_queue->Send(&e);
+  InferenceEngine *engine = this->GetEngine();
+  if (engine->Post(e, 0, &this->_scheduling))
+  {
+    return true;
+  }
+  // the queue is full, even its reserved part, the continuation runs inline rather than being lost.
+  // With a scheduler, this is the most urgent pending activation, which may belong to another session.
+  engine->GetMetrics().OnInlined();
+  if (_inlined)
+  {
+    int count = _inlined->Count();
+    if (_inlined->Add(e).Count() != count)
+    {
+      return true;
+    }
+    // out of memory, the activation is nested rather than lost.
+    engine->Consume(e);
+    return true;
+  }
+  Collection<ActivationEvent> pending;
+  _inlined = &pending;
+  engine->Consume(e);
+  for (int i = 0; i < pending.Count(); i++)
+  {
+    ActivationEvent next = pending[i];
+    engine->Consume(next);
+  }
+  _inlined = nullptr;
+  return true;
+}
+
+bool AsyncActivationContext ::Run()
+{
+  if (!this->GetEngine()->Admit())
+  {
+    this->_setError(CM_ACTIVATION_REJECTED);
+    return false;
+  }
+  this->_scheduling.Deadline = cm_time_ns() + (this->_scheduling.Budget ? this->_scheduling.Budget : CM_SCHEDULING_DEFAULT_BUDGET);
+  return this->ActivationContext::Run();
 }
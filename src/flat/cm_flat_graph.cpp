@@ -0,0 +1,534 @@
+#include "flat/cm_flat_graph.hpp"
+#include "nodes/cm_nodes_registry.hpp"
+
+using namespace CyanMycelium;
+
+static inline uint64_t _align(uint64_t size, uint64_t alignment)
+{
+    return (size + alignment - 1) & ~(alignment - 1);
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Writer
+// ---------------------------------------------------------------------------------------------------------------------
+
+size_t FlatGraphWriter ::Write(Graph *graph, void *buffer, size_t size)
+{
+    this->_error = FLAT_SUCCESS;
+    if (!this->_check(graph))
+    {
+        return 0;
+    }
+    // a first pass sizes the attributes, the strings and the data, then the sections are placed and written.
+    FlatHeader header = {};
+    this->_image = nullptr;
+    this->_emit(graph, &header);
+
+    header.Names = _align(header.Edges + header.EdgeCount * sizeof(int32_t), sizeof(uint64_t));
+    header.Atts = header.Names + (header.InputCount + header.OutputCount) * sizeof(FlatName);
+    uint64_t strings = header.Atts + header.AttCount * sizeof(FlatAtt);
+    uint64_t data = _align(strings + this->_strings, FLAT_ALIGNMENT);
+    header.Size = data + this->_data;
+    if (!buffer)
+    {
+        return (size_t)header.Size;
+    }
+    if (size < header.Size)
+    {
+        this->_error = FLAT_BUFFER_TOO_SMALL;
+        return 0;
+    }
+
+    cm_memset(buffer, 0, (size_t)header.Size);
+    this->_image = (cm_byte_t *)buffer;
+    this->_atts = header.Atts;
+    this->_strings = strings;
+    this->_data = data;
+    this->_emit(graph, &header);
+    cm_memcpy(buffer, &header, sizeof(FlatHeader));
+    return (size_t)header.Size;
+}
+
+bool FlatGraphWriter ::_check(Graph *graph)
+{
+    int links = graph->Links.Count();
+    for (int i = 0; i != links; i++)
+    {
+        Link *l = graph->Links[i];
+        // the links are referenced by their id, which is their index into the graph.
+        if (l->Id != i ||
+            (l->Quantization.Scale && graph->Links[l->Quantization.Scale->Id] != l->Quantization.Scale) ||
+            (l->Quantization.ZeroPoint && graph->Links[l->Quantization.ZeroPoint->Id] != l->Quantization.ZeroPoint))
+        {
+            this->_error = FLAT_INVALID_GRAPH;
+            return false;
+        }
+    }
+    for (int i = 0; i != graph->Nodes.Count(); i++)
+    {
+        Operator *op = graph->Nodes[i];
+        // the node is rebuilt from its type name at load time.
+        if (!op->TypeName || !NodeRegistry ::SizeOf(op->TypeName))
+        {
+            this->_error = FLAT_UNSUPPORTED_NODE;
+            return false;
+        }
+        Collection<Link *> *edges[] = {&op->Opsc, &op->Onsc};
+        for (Collection<Link *> *c : edges)
+        {
+            for (int j = 0; j != c->Count(); j++)
+            {
+                Link *l = (*c)[j];
+                // the blank inputs are null slots.
+                if (!l && c == &op->Opsc)
+                {
+                    continue;
+                }
+                if (!l || l->Id < 0 || l->Id >= links || graph->Links[l->Id] != l)
+                {
+                    this->_error = FLAT_INVALID_GRAPH;
+                    return false;
+                }
+            }
+        }
+    }
+    return true;
+}
+
+void FlatGraphWriter ::_emit(Graph *graph, FlatHeader *header)
+{
+    cm_byte_t *image = this->_image;
+    this->_attCount = 0;
+    if (!image)
+    {
+        this->_strings = 0;
+        this->_data = 0;
+    }
+
+    cm_memcpy(header->Magic, FLAT_MAGIC, sizeof(header->Magic));
+    header->Version = FLAT_VERSION;
+    header->ByteOrder = FLAT_BYTE_ORDER;
+    header->Alignment = FLAT_ALIGNMENT;
+    header->NodeCount = graph->Nodes.Count();
+    header->LinkCount = graph->Links.Count();
+    header->InputCount = graph->Inputs.Count();
+    header->OutputCount = graph->Outputs.Count();
+    header->Nodes = _align(sizeof(FlatHeader), sizeof(uint64_t));
+    header->Links = header->Nodes + header->NodeCount * sizeof(FlatNode);
+    header->Edges = header->Links + header->LinkCount * sizeof(FlatLink);
+
+    // 1 - links, with their initializer.
+    for (uint32_t i = 0; i != header->LinkCount; i++)
+    {
+        Link *l = graph->Links[i];
+        Tensor *t = l->GetPayloadInfos();
+        FlatLink fl = {};
+        cm_memcpy(fl.Shape, t->Shape, sizeof(fl.Shape));
+        fl.Dimension = t->Dimension;
+        fl.Type = t->Type;
+        fl.Data = !l->Oini && t->Data ? this->_putData(t->Data, t->Size) : 0;
+        fl.Scale = l->Quantization.Scale ? l->Quantization.Scale->Id : -1;
+        fl.ZeroPoint = l->Quantization.ZeroPoint ? l->Quantization.ZeroPoint->Id : -1;
+        fl.Axis = l->Quantization.Axis;
+        fl.Flags = (l->InPlace ? FLAT_LINK_IN_PLACE : 0) | (l->InSlice ? FLAT_LINK_IN_SLICE : 0);
+        if (image)
+        {
+            cm_memcpy(image + header->Links + i * sizeof(FlatLink), &fl, sizeof(FlatLink));
+        }
+    }
+
+    // 2 - nodes, with their edges, their attributes and their packed data.
+    _AttEmitter emitter;
+    emitter.Writer = this;
+    uint32_t edges = 0;
+    for (uint32_t i = 0; i != header->NodeCount; i++)
+    {
+        Operator *op = graph->Nodes[i];
+        FlatNode fn = {};
+        fn.Type = this->_putString(op->TypeName);
+        fn.FirstEdge = edges;
+        fn.InputCount = op->Opsc.Count();
+        fn.OutputCount = op->Onsc.Count();
+        for (uint32_t j = 0; j != fn.InputCount + fn.OutputCount; j++, edges++)
+        {
+            Link *l = j < fn.InputCount ? op->Opsc[j] : op->Onsc[j - fn.InputCount];
+            if (image)
+            {
+                ((int32_t *)(image + header->Edges))[edges] = l ? l->Id : -1;
+            }
+        }
+        fn.FirstAtt = this->_attCount;
+        op->GetAtts(&emitter);
+        fn.AttCount = this->_attCount - fn.FirstAtt;
+        fn.PackedSize = op->SavePacked(nullptr);
+        if (fn.PackedSize)
+        {
+            fn.Packed = this->_reserveData((size_t)fn.PackedSize);
+            if (image)
+            {
+                op->SavePacked(image + fn.Packed);
+            }
+        }
+        if (image)
+        {
+            cm_memcpy(image + header->Nodes + i * sizeof(FlatNode), &fn, sizeof(FlatNode));
+        }
+    }
+    header->EdgeCount = edges;
+    header->AttCount = this->_attCount;
+
+    // 3 - names of the inputs, then of the outputs.
+    KeyValueCollection<Link *> *names[] = {&graph->Inputs, &graph->Outputs};
+    uint32_t n = 0;
+    for (KeyValueCollection<Link *> *c : names)
+    {
+        KeyValueCollection<Link *>::Iterator<KeyValue<Link *>> it = c->GetIterator();
+        while (it.MoveNext())
+        {
+            FlatName name = {};
+            name.Name = this->_putString(it.Current()->Key);
+            name.Link = it.Current()->Value->Id;
+            if (image)
+            {
+                cm_memcpy(image + header->Names + n * sizeof(FlatName), &name, sizeof(FlatName));
+            }
+            n++;
+        }
+    }
+}
+
+uint64_t FlatGraphWriter ::_putString(const char *s)
+{
+    uint64_t offset = this->_strings;
+    size_t size = strlen(s) + 1;
+    if (this->_image)
+    {
+        cm_memcpy(this->_image + offset, s, size);
+    }
+    this->_strings += size;
+    return offset;
+}
+
+uint64_t FlatGraphWriter ::_reserveData(size_t size)
+{
+    uint64_t offset = _align(this->_data, FLAT_ALIGNMENT);
+    this->_data = offset + size;
+    return offset;
+}
+
+uint64_t FlatGraphWriter ::_putData(const void *data, size_t size)
+{
+    uint64_t offset = this->_reserveData(size);
+    if (this->_image)
+    {
+        cm_memcpy(this->_image + offset, data, size);
+    }
+    return offset;
+}
+
+void FlatGraphWriter ::_AttEmitter ::Write(const char *n, AttKind kind, Att_value_t value)
+{
+    FlatAtt att = {};
+    att.Name = this->Writer->_putString(n);
+    att.Kind = (uint32_t)kind;
+    switch (kind)
+    {
+    case AttKind ::FLOAT:
+        att.Value.F = value.f;
+        break;
+    case AttKind ::INT:
+        att.Value.I = value.i;
+        break;
+    case AttKind ::STRING:
+        att.Value.Offset = this->Writer->_putString(value.s);
+        break;
+    case AttKind ::INTS:
+        att.Count = value.ints.n;
+        att.Value.Offset = this->Writer->_putData(value.ints.v, value.ints.n * sizeof(cm_int64_t));
+        break;
+    }
+    if (this->Writer->_image)
+    {
+        cm_memcpy(this->Writer->_image + this->Writer->_atts + this->Writer->_attCount * sizeof(FlatAtt), &att, sizeof(FlatAtt));
+    }
+    this->Writer->_attCount++;
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Builder
+// ---------------------------------------------------------------------------------------------------------------------
+
+FlatGraphBuilder &FlatGraphBuilder ::WithImage(const void *image, size_t size)
+{
+    this->_image = (const cm_byte_t *)image;
+    this->_size = size;
+    return *this;
+}
+
+void FlatGraphBuilder ::_setError(int error, const char *infos)
+{
+    this->_error = error;
+    cm_strcpy_s(this->_errorInfos, CM_KEY_MAX_LENGTH, infos ? infos : "");
+}
+
+const char *FlatGraphBuilder ::_getString(uint64_t offset)
+{
+    if (offset >= this->_size)
+    {
+        return nullptr;
+    }
+    const char *s = (const char *)this->_image + offset;
+    // the string must end into the image, and fit into the keys of the collections.
+    size_t max = min(this->_size - (size_t)offset, (size_t)CM_KEY_MAX_LENGTH);
+    return memchr(s, 0, max) ? s : nullptr;
+}
+
+bool FlatGraphBuilder ::_isData(const FlatLink *link)
+{
+    if (link->Dimension > TENSOR_MAX_DIMENSION || link->Type >= TDT_COUNT)
+    {
+        return false;
+    }
+    // the shape comes from the image, so the size is bounded by the image at every product instead of wrapping around.
+    uint64_t size = TensorInfos(nullptr, 0, (tensor_data_type_t)link->Type).Size;
+    for (uint32_t i = 0; i != link->Dimension; i++)
+    {
+        if (link->Shape[i] && size > this->_size / link->Shape[i])
+        {
+            return false;
+        }
+        size *= link->Shape[i];
+    }
+    return this->_isRange(link->Data, size);
+}
+
+bool FlatGraphBuilder ::_checkHeader(const FlatHeader *h)
+{
+    if (!this->_image || this->_size < sizeof(FlatHeader) || memcmp(h->Magic, FLAT_MAGIC, sizeof(h->Magic)) != 0)
+    {
+        this->_setError(FLAT_INVALID_IMAGE, "header");
+        return false;
+    }
+    if (h->Version != FLAT_VERSION || h->ByteOrder != FLAT_BYTE_ORDER || h->Alignment != FLAT_ALIGNMENT)
+    {
+        this->_setError(FLAT_UNSUPPORTED_VERSION);
+        return false;
+    }
+    if (h->Size > this->_size ||
+        !this->_isRange(h->Nodes, (uint64_t)h->NodeCount * sizeof(FlatNode)) ||
+        !this->_isRange(h->Links, (uint64_t)h->LinkCount * sizeof(FlatLink)) ||
+        !this->_isRange(h->Edges, (uint64_t)h->EdgeCount * sizeof(int32_t)) ||
+        !this->_isRange(h->Names, ((uint64_t)h->InputCount + h->OutputCount) * sizeof(FlatName)) ||
+        !this->_isRange(h->Atts, (uint64_t)h->AttCount * sizeof(FlatAtt)) ||
+        (h->Nodes | h->Links | h->Edges | h->Names | h->Atts) & (sizeof(uint64_t) - 1))
+    {
+        this->_setError(FLAT_INVALID_IMAGE, "sections");
+        return false;
+    }
+    return true;
+}
+
+Graph *FlatGraphBuilder ::Build(Graph *target)
+{
+    this->_setError(FLAT_SUCCESS);
+    const FlatHeader *h = (const FlatHeader *)this->_image;
+    if (!this->_checkHeader(h))
+    {
+        return nullptr;
+    }
+    const FlatNode *nodes = (const FlatNode *)(this->_image + h->Nodes);
+    const FlatLink *links = (const FlatLink *)(this->_image + h->Links);
+    const int32_t *edges = (const int32_t *)(this->_image + h->Edges);
+    const FlatName *names = (const FlatName *)(this->_image + h->Names);
+    const FlatAtt *atts = (const FlatAtt *)(this->_image + h->Atts);
+
+    // 1 - every reference is checked before anything is built, so the image may come from an untrusted file.
+    uint64_t linkSize = _align(sizeof(Link), FLAT_ARENA_ALIGNMENT);
+    uint64_t pointers = _align(((uint64_t)h->NodeCount + h->LinkCount) * sizeof(void *), FLAT_ARENA_ALIGNMENT);
+    uint64_t arenaSize = pointers + h->LinkCount * linkSize;
+    for (uint32_t i = 0; i != h->LinkCount; i++)
+    {
+        const FlatLink *fl = links + i;
+        if (fl->Dimension > TENSOR_MAX_DIMENSION || fl->Type >= TDT_COUNT ||
+            fl->Scale < -1 || fl->Scale >= (int32_t)h->LinkCount || fl->ZeroPoint < -1 || fl->ZeroPoint >= (int32_t)h->LinkCount ||
+            (fl->Data && !this->_isData(fl)))
+        {
+            this->_setError(FLAT_INVALID_IMAGE, "link");
+            return nullptr;
+        }
+    }
+    // -1 is a blank input, see the nodes below.
+    for (uint32_t i = 0; i != h->EdgeCount; i++)
+    {
+        if (edges[i] < -1 || edges[i] >= (int32_t)h->LinkCount)
+        {
+            this->_setError(FLAT_INVALID_IMAGE, "edge");
+            return nullptr;
+        }
+    }
+    for (uint32_t i = 0; i != h->InputCount + h->OutputCount; i++)
+    {
+        if (!this->_getString(names[i].Name) || names[i].Link < 0 || names[i].Link >= (int32_t)h->LinkCount)
+        {
+            this->_setError(FLAT_INVALID_IMAGE, "name");
+            return nullptr;
+        }
+    }
+    for (uint32_t i = 0; i != h->AttCount; i++)
+    {
+        const FlatAtt *a = atts + i;
+        if (!this->_getString(a->Name) || a->Kind > (uint32_t)AttKind ::INTS ||
+            (a->Kind == (uint32_t)AttKind ::STRING && !this->_getString(a->Value.Offset)) ||
+            (a->Kind == (uint32_t)AttKind ::INTS && (!this->_isRange(a->Value.Offset, (uint64_t)a->Count * sizeof(cm_int64_t)) || a->Value.Offset & (sizeof(cm_int64_t) - 1))))
+        {
+            this->_setError(FLAT_INVALID_IMAGE, "attribute");
+            return nullptr;
+        }
+    }
+    for (uint32_t i = 0; i != h->NodeCount; i++)
+    {
+        const FlatNode *fn = nodes + i;
+        const char *type = this->_getString(fn->Type);
+        if (!type || (uint64_t)fn->FirstEdge + fn->InputCount + fn->OutputCount > h->EdgeCount ||
+            (uint64_t)fn->FirstAtt + fn->AttCount > h->AttCount || (fn->PackedSize && !this->_isRange(fn->Packed, fn->PackedSize)))
+        {
+            this->_setError(FLAT_INVALID_IMAGE, "node");
+            return nullptr;
+        }
+        for (uint32_t j = fn->InputCount; j != fn->InputCount + fn->OutputCount; j++)
+        {
+            if (edges[fn->FirstEdge + j] < 0)
+            {
+                this->_setError(FLAT_INVALID_IMAGE, "edge");
+                return nullptr;
+            }
+        }
+        size_t size = NodeRegistry ::SizeOf(type);
+        if (!size)
+        {
+            this->_setError(FLAT_UNSUPPORTED_NODE, type);
+            return nullptr;
+        }
+        arenaSize += _align(size, FLAT_ARENA_ALIGNMENT);
+    }
+
+    // 2 - the nodes and the links are placed into a single arena, handed over to the graph.
+    cm_byte_t *arena = (cm_byte_t *)cm_malloc((size_t)arenaSize);
+    if (!arena)
+    {
+        this->_setError(FLAT_SYSTEM_ERROR, "arena");
+        return nullptr;
+    }
+    Operator **ops = (Operator **)arena;
+    Link **ls = (Link **)(ops + h->NodeCount);
+    cm_byte_t *p = arena + pointers;
+    for (uint32_t i = 0; i != h->LinkCount; i++, p += linkSize)
+    {
+        // the initializers are read from the image, they are never written by the activation.
+        const FlatLink *fl = links + i;
+        Link *l = new (p) Link();
+        l->Id = i;
+        l->SetPayloadInfos(fl->Shape, fl->Dimension, (tensor_data_type_t)fl->Type, fl->Data ? (void *)(this->_image + fl->Data) : nullptr);
+        l->InPlace = (fl->Flags & FLAT_LINK_IN_PLACE) != 0;
+        l->InSlice = (fl->Flags & FLAT_LINK_IN_SLICE) != 0;
+        l->Quantization.Axis = fl->Axis;
+        ls[i] = l;
+    }
+    for (uint32_t i = 0; i != h->LinkCount; i++)
+    {
+        ls[i]->Quantization.Scale = links[i].Scale >= 0 ? ls[links[i].Scale] : nullptr;
+        ls[i]->Quantization.ZeroPoint = links[i].ZeroPoint >= 0 ? ls[links[i].ZeroPoint] : nullptr;
+    }
+    for (uint32_t i = 0; i != h->NodeCount; i++)
+    {
+        const FlatNode *fn = nodes + i;
+        const char *type = this->_getString(fn->Type);
+        Operator *op = NodeRegistry ::ForName(type, p);
+        p += _align(NodeRegistry ::SizeOf(type), FLAT_ARENA_ALIGNMENT);
+        op->Id = i;
+        ops[i] = op;
+        for (uint32_t j = 0; j != fn->InputCount + fn->OutputCount; j++)
+        {
+            int32_t edge = edges[fn->FirstEdge + j];
+            Link *l = edge >= 0 ? ls[edge] : nullptr;
+            if (j < fn->InputCount)
+            {
+                op->Opsc.Add(l);
+                if (l)
+                {
+                    l->Ofin = op;
+                }
+                continue;
+            }
+            op->Onsc.Add(l);
+            l->Oini = op;
+        }
+    }
+
+    // a graph allocated here is deleted on failure, with the arena it owns.
+    Graph *owned = target ? nullptr : new Graph(h->NodeCount, h->LinkCount);
+    target = target ? target : owned;
+    for (uint32_t i = 0; i != h->NodeCount; i++)
+    {
+        target->Nodes.Add(ops[i]);
+    }
+    for (uint32_t i = 0; i != h->LinkCount; i++)
+    {
+        target->Links.Add(ls[i]);
+    }
+    for (uint32_t i = 0; i != h->InputCount + h->OutputCount; i++)
+    {
+        KeyValueCollection<Link *> *c = i < h->InputCount ? &target->Inputs : &target->Outputs;
+        c->Set(this->_getString(names[i].Name), ls[names[i].Link]);
+    }
+    // from now on the graph destroys the objects of the arena.
+    target->SetArena(arena, (size_t)arenaSize);
+
+    // 3 - the attributes, then the packed data of the operators, which are prepared again when the data does not fit.
+    for (uint32_t i = 0; i != h->NodeCount; i++)
+    {
+        const FlatNode *fn = nodes + i;
+        Operator *op = ops[i];
+        for (uint32_t j = 0; j != fn->AttCount; j++)
+        {
+            const FlatAtt *a = atts + fn->FirstAtt + j;
+            Att_value_t value;
+            switch ((AttKind)a->Kind)
+            {
+            case AttKind ::FLOAT:
+                value.f = (cm_float_t)a->Value.F;
+                break;
+            case AttKind ::INT:
+                value.i = a->Value.I;
+                break;
+            case AttKind ::STRING:
+                value.s = this->_getString(a->Value.Offset);
+                break;
+            case AttKind ::INTS:
+                value.ints.v = (const cm_int64_t *)(this->_image + a->Value.Offset);
+                value.ints.n = a->Count;
+                break;
+            }
+            if (!op->TrySetAtt(this->_getString(a->Name), value))
+            {
+                this->_setError(FLAT_UNSUPPORTED_ATTRIBUTE, this->_getString(a->Name));
+                delete owned;
+                return nullptr;
+            }
+        }
+        if (!(fn->PackedSize && op->LoadPacked(this->_image + fn->Packed, (size_t)fn->PackedSize)) && !op->Prepack())
+        {
+            this->_setError(FLAT_SYSTEM_ERROR, "prepack");
+            delete owned;
+            return nullptr;
+        }
+    }
+    // the in place flags come from the image, only the topology is compiled again.
+    if (!target->Compile())
+    {
+        this->_setError(FLAT_SYSTEM_ERROR, "topology");
+        delete owned;
+        return nullptr;
+    }
+    return target;
+}
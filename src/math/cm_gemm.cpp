@@ -0,0 +1,370 @@
+#include "math/cm_gemm.hpp"
+#include "math/cm_simd.hpp"
+
+using namespace CyanMycelium;
+
+#define CM_GEMM_NT_MR 4
+#define CM_GEMM_NT_NR 4
+
+// rows of A and panels of B processed together by the packed micro kernel.
+#define CM_GEMM_PACKED_MR 4
+#define CM_GEMM_PACKED_NP 2
+
+// tiles of the half precision product, converted to float: A [MB x KB], B [NB x KB] and C [MB x NB] fit into L2.
+#define CM_GEMM_HALF_MB 32
+#define CM_GEMM_HALF_NB 64
+#define CM_GEMM_HALF_KB 128
+
+// Compute a MR x NR block of dot products. Both operands are contiguous along k,
+// so the accumulation is vectorized along k with MR x NR independent accumulators.
+template <int MR, int NR>
+static void _sgemm_nt_block(int k, const float *a, int lda, const float *b, int ldb, float *c, int ldc, const float *bias, bool accumulate)
+{
+  cm_vfloat_t acc[MR][NR];
+  for (int r = 0; r != MR; r++)
+  {
+    for (int s = 0; s != NR; s++)
+    {
+      acc[r][s] = cm_vset1(0);
+    }
+  }
+
+  int p = 0;
+  for (; p + CM_SIMD_WIDTH <= k; p += CM_SIMD_WIDTH)
+  {
+    cm_vfloat_t vb[NR];
+    for (int s = 0; s != NR; s++)
+    {
+      vb[s] = cm_vload(b + s * ldb + p);
+    }
+    for (int r = 0; r != MR; r++)
+    {
+      cm_vfloat_t va = cm_vload(a + r * lda + p);
+      for (int s = 0; s != NR; s++)
+      {
+        acc[r][s] += va * vb[s];
+      }
+    }
+  }
+
+  for (int r = 0; r != MR; r++)
+  {
+    for (int s = 0; s != NR; s++)
+    {
+      float sum = cm_vsum(acc[r][s]);
+      for (int q = p; q < k; q++)
+      {
+        sum += a[r * lda + q] * b[s * ldb + q];
+      }
+      if (bias)
+      {
+        sum += bias[s];
+      }
+      float *target = c + r * ldc + s;
+      *target = accumulate ? *target + sum : sum;
+    }
+  }
+}
+
+void CyanMycelium::cm_sgemm_nt(int m, int n, int k,
+                               const float *a, int lda,
+                               const float *b, int ldb,
+                               float *c, int ldc,
+                               const float *bias, bool accumulate)
+{
+  int i = 0;
+  for (; i + CM_GEMM_NT_MR <= m; i += CM_GEMM_NT_MR)
+  {
+    int j = 0;
+    for (; j + CM_GEMM_NT_NR <= n; j += CM_GEMM_NT_NR)
+    {
+      _sgemm_nt_block<CM_GEMM_NT_MR, CM_GEMM_NT_NR>(k, a + i * lda, lda, b + j * ldb, ldb, c + i * ldc + j, ldc, bias ? bias + j : nullptr, accumulate);
+    }
+    for (; j < n; j++)
+    {
+      _sgemm_nt_block<CM_GEMM_NT_MR, 1>(k, a + i * lda, lda, b + j * ldb, ldb, c + i * ldc + j, ldc, bias ? bias + j : nullptr, accumulate);
+    }
+  }
+  for (; i < m; i++)
+  {
+    int j = 0;
+    for (; j + CM_GEMM_NT_NR <= n; j += CM_GEMM_NT_NR)
+    {
+      _sgemm_nt_block<1, CM_GEMM_NT_NR>(k, a + i * lda, lda, b + j * ldb, ldb, c + i * ldc + j, ldc, bias ? bias + j : nullptr, accumulate);
+    }
+    for (; j < n; j++)
+    {
+      _sgemm_nt_block<1, 1>(k, a + i * lda, lda, b + j * ldb, ldb, c + i * ldc + j, ldc, bias ? bias + j : nullptr, accumulate);
+    }
+  }
+}
+
+size_t CyanMycelium::cm_sgemm_packed_size(int n, int k)
+{
+  size_t panels = (n + CM_SIMD_WIDTH - 1) / CM_SIMD_WIDTH;
+  return panels * k * CM_SIMD_WIDTH;
+}
+
+void CyanMycelium::cm_sgemm_pack_b(int n, int k, const float *b, int ldb, float *packed)
+{
+  for (int j = 0; j < n; j += CM_SIMD_WIDTH)
+  {
+    int width = min(CM_SIMD_WIDTH, n - j);
+    for (int p = 0; p != k; p++)
+    {
+      int s = 0;
+      for (; s != width; s++)
+      {
+        *packed++ = b[(j + s) * ldb + p];
+      }
+      for (; s != CM_SIMD_WIDTH; s++)
+      {
+        *packed++ = 0;
+      }
+    }
+  }
+}
+
+// Compute a MR x (NP * CM_SIMD_WIDTH) block of C. A single value of A is broadcast against
+// contiguous panel lines of the packed operand, so every iteration is MR x NP independent fused multiply-add.
+// width is the number of valid columns of the last panel.
+template <int MR, int NP>
+static void _sgemm_packed_block(int k, int width, const float *a, int lda, const float *panel, float *c, int ldc, const float *bias, bool accumulate)
+{
+  size_t panelSize = (size_t)k * CM_SIMD_WIDTH;
+  cm_vfloat_t acc[MR][NP];
+  for (int r = 0; r != MR; r++)
+  {
+    for (int q = 0; q != NP; q++)
+    {
+      acc[r][q] = cm_vset1(0);
+    }
+  }
+
+  for (int p = 0; p != k; p++)
+  {
+    cm_vfloat_t vb[NP];
+    for (int q = 0; q != NP; q++)
+    {
+      vb[q] = cm_vload(panel + q * panelSize + p * CM_SIMD_WIDTH);
+    }
+    for (int r = 0; r != MR; r++)
+    {
+      float va = a[r * lda + p];
+      for (int q = 0; q != NP; q++)
+      {
+        acc[r][q] += va * vb[q];
+      }
+    }
+  }
+
+  for (int q = 0; q != NP; q++)
+  {
+    int w = q == NP - 1 ? width : CM_SIMD_WIDTH;
+    if (bias)
+    {
+      cm_vfloat_t vbias = cm_vset1(0);
+      for (int s = 0; s != w; s++)
+      {
+        vbias[s] = bias[q * CM_SIMD_WIDTH + s];
+      }
+      for (int r = 0; r != MR; r++)
+      {
+        acc[r][q] += vbias;
+      }
+    }
+
+    for (int r = 0; r != MR; r++)
+    {
+      float *target = c + r * ldc + q * CM_SIMD_WIDTH;
+      if (w == CM_SIMD_WIDTH)
+      {
+        cm_vstore(target, accumulate ? acc[r][q] + cm_vload(target) : acc[r][q]);
+        continue;
+      }
+      for (int s = 0; s != w; s++)
+      {
+        target[s] = accumulate ? target[s] + acc[r][q][s] : acc[r][q][s];
+      }
+    }
+  }
+}
+
+// Process every rows of A against NP consecutive panels.
+template <int NP>
+static void _sgemm_packed_panels(int m, int k, int width, const float *a, int lda, const float *panel, float *c, int ldc, const float *bias, bool accumulate)
+{
+  int i = 0;
+  for (; i + CM_GEMM_PACKED_MR <= m; i += CM_GEMM_PACKED_MR)
+  {
+    _sgemm_packed_block<CM_GEMM_PACKED_MR, NP>(k, width, a + i * lda, lda, panel, c + i * ldc, ldc, bias, accumulate);
+  }
+  for (; i < m; i++)
+  {
+    _sgemm_packed_block<1, NP>(k, width, a + i * lda, lda, panel, c + i * ldc, ldc, bias, accumulate);
+  }
+}
+
+void CyanMycelium::cm_sgemm_packed(int m, int n, int k,
+                                   const float *a, int lda,
+                                   const float *packed,
+                                   float *c, int ldc,
+                                   const float *bias, bool accumulate)
+{
+  int panels = (n + CM_SIMD_WIDTH - 1) / CM_SIMD_WIDTH;
+  int j = 0;
+  for (; j + CM_GEMM_PACKED_NP <= panels; j += CM_GEMM_PACKED_NP)
+  {
+    int col = j * CM_SIMD_WIDTH;
+    int width = min(CM_SIMD_WIDTH, n - (col + (CM_GEMM_PACKED_NP - 1) * CM_SIMD_WIDTH));
+    _sgemm_packed_panels<CM_GEMM_PACKED_NP>(m, k, width, a, lda, packed + (size_t)col * k, c + col, ldc, bias ? bias + col : nullptr, accumulate);
+  }
+  for (; j < panels; j++)
+  {
+    int col = j * CM_SIMD_WIDTH;
+    int width = min(CM_SIMD_WIDTH, n - col);
+    _sgemm_packed_panels<1>(m, k, width, a, lda, packed + (size_t)col * k, c + col, ldc, bias ? bias + col : nullptr, accumulate);
+  }
+}
+
+// the tile the products of a half product are accumulated into: C itself when it is stored as float, a float tile otherwise.
+static inline float *_half_tile(float *c, int ldc, float *ct, int *ld)
+{
+  *ld = ldc;
+  return c;
+}
+
+template <typename H>
+static inline float *_half_tile(H *c, int ldc, float *ct, int *ld)
+{
+  *ld = CM_GEMM_HALF_NB;
+  return ct;
+}
+
+// round the float tile into C once every k tile is accumulated, C being half.
+static inline void _half_store(const float *ct, float *c, int ldc, int mb, int nb) {}
+
+template <typename H>
+static inline void _half_store(const float *ct, H *c, int ldc, int mb, int nb)
+{
+  for (int r = 0; r != mb; r++)
+  {
+    cm_from_float(ct + r * CM_GEMM_HALF_NB, c + (size_t)r * ldc, nb);
+  }
+}
+
+template <typename H, typename C>
+static bool _gemm_nt_half(int m, int n, int k, const H *a, int lda, const H *b, int ldb, C *c, int ldc, const float *bias, bool accumulate)
+{
+  float *at = (float *)cm_malloc((CM_GEMM_HALF_MB + CM_GEMM_HALF_NB) * CM_GEMM_HALF_KB * sizeof(float) + CM_GEMM_HALF_MB * CM_GEMM_HALF_NB * sizeof(float));
+  if (!at)
+  {
+    return false;
+  }
+  float *bt = at + CM_GEMM_HALF_MB * CM_GEMM_HALF_KB;
+  float *ct = bt + CM_GEMM_HALF_NB * CM_GEMM_HALF_KB;
+
+  for (int i = 0; i < m; i += CM_GEMM_HALF_MB)
+  {
+    int mb = min(CM_GEMM_HALF_MB, m - i);
+    for (int j = 0; j < n; j += CM_GEMM_HALF_NB)
+    {
+      int nb = min(CM_GEMM_HALF_NB, n - j);
+      int ld;
+      float *target = _half_tile(c + (size_t)i * ldc + j, ldc, ct, &ld);
+      for (int p = 0; p < k; p += CM_GEMM_HALF_KB)
+      {
+        int kb = min(CM_GEMM_HALF_KB, k - p);
+        for (int r = 0; r != mb; r++)
+        {
+          cm_to_float(a + (size_t)(i + r) * lda + p, at + r * CM_GEMM_HALF_KB, kb);
+        }
+        for (int r = 0; r != nb; r++)
+        {
+          cm_to_float(b + (size_t)(j + r) * ldb + p, bt + r * CM_GEMM_HALF_KB, kb);
+        }
+        // the bias is added with the first k tile only.
+        cm_sgemm_nt(mb, nb, kb, at, CM_GEMM_HALF_KB, bt, CM_GEMM_HALF_KB, target, ld, p ? nullptr : (bias ? bias + j : nullptr), accumulate || p != 0);
+      }
+      _half_store(ct, c + (size_t)i * ldc + j, ldc, mb, nb);
+    }
+  }
+  cm_free(at);
+  return true;
+}
+
+template <typename H>
+static bool _gemm_packed_half(int m, int n, int k, const H *a, int lda, const float *packed, float *c, int ldc, const float *bias, bool accumulate)
+{
+  // the packed panels span the whole depth, so the rows of A are converted whole.
+  float *at = (float *)cm_malloc((size_t)CM_GEMM_HALF_MB * k * sizeof(float));
+  if (!at)
+  {
+    return false;
+  }
+  for (int i = 0; i < m; i += CM_GEMM_HALF_MB)
+  {
+    int mb = min(CM_GEMM_HALF_MB, m - i);
+    for (int r = 0; r != mb; r++)
+    {
+      cm_to_float(a + (size_t)(i + r) * lda, at + (size_t)r * k, k);
+    }
+    cm_sgemm_packed(mb, n, k, at, k, packed, c + (size_t)i * ldc, ldc, bias, accumulate);
+  }
+  cm_free(at);
+  return true;
+}
+
+bool CyanMycelium::cm_hgemm_nt(int m, int n, int k,
+                               const cm_half_t *a, int lda,
+                               const cm_half_t *b, int ldb,
+                               cm_half_t *c, int ldc,
+                               const float *bias)
+{
+  return _gemm_nt_half(m, n, k, a, lda, b, ldb, c, ldc, bias, false);
+}
+
+bool CyanMycelium::cm_hgemm_nt(int m, int n, int k,
+                               const cm_half_t *a, int lda,
+                               const cm_half_t *b, int ldb,
+                               float *c, int ldc,
+                               const float *bias, bool accumulate)
+{
+  return _gemm_nt_half(m, n, k, a, lda, b, ldb, c, ldc, bias, accumulate);
+}
+
+bool CyanMycelium::cm_hgemm_packed(int m, int n, int k,
+                                   const cm_half_t *a, int lda,
+                                   const float *packed,
+                                   float *c, int ldc,
+                                   const float *bias, bool accumulate)
+{
+  return _gemm_packed_half(m, n, k, a, lda, packed, c, ldc, bias, accumulate);
+}
+
+bool CyanMycelium::cm_bgemm_nt(int m, int n, int k,
+                               const cm_bfloat16_t *a, int lda,
+                               const cm_bfloat16_t *b, int ldb,
+                               cm_bfloat16_t *c, int ldc,
+                               const float *bias)
+{
+  return _gemm_nt_half(m, n, k, a, lda, b, ldb, c, ldc, bias, false);
+}
+
+bool CyanMycelium::cm_bgemm_nt(int m, int n, int k,
+                               const cm_bfloat16_t *a, int lda,
+                               const cm_bfloat16_t *b, int ldb,
+                               float *c, int ldc,
+                               const float *bias, bool accumulate)
+{
+  return _gemm_nt_half(m, n, k, a, lda, b, ldb, c, ldc, bias, accumulate);
+}
+
+bool CyanMycelium::cm_bgemm_packed(int m, int n, int k,
+                                   const cm_bfloat16_t *a, int lda,
+                                   const float *packed,
+                                   float *c, int ldc,
+                                   const float *bias, bool accumulate)
+{
+  return _gemm_packed_half(m, n, k, a, lda, packed, c, ldc, bias, accumulate);
+}
@@ -0,0 +1,115 @@
+#if defined(__F16C__) || defined(__AVX512BF16__)
+#include <immintrin.h>
+#endif
+
+#include "math/cm_half.hpp"
+#include "math/cm_simd.hpp"
+
+namespace CyanMycelium
+{
+  // bfloat16 is the upper half of a float, so the conversions are integer shifts on the lanes.
+  typedef uint32_t _vuint32_t __attribute__((vector_size(CM_SIMD_WIDTH * sizeof(uint32_t))));
+  typedef uint16_t _vuint16_t __attribute__((vector_size(CM_SIMD_WIDTH * sizeof(uint16_t))));
+
+  void cm_to_float(const cm_half_t *src, float *dst, size_t n)
+  {
+    size_t i = 0;
+#if defined(__F16C__)
+    for (; i + 8 <= n; i += 8)
+    {
+      _mm256_storeu_ps(dst + i, _mm256_cvtph_ps(_mm_loadu_si128((const __m128i *)(src + i))));
+    }
+#endif
+    for (; i != n; i++)
+    {
+      dst[i] = cm_half_to_float(src[i].Bits);
+    }
+  }
+
+  void cm_from_float(const float *src, cm_half_t *dst, size_t n)
+  {
+    size_t i = 0;
+#if defined(__F16C__)
+    for (; i + 8 <= n; i += 8)
+    {
+      _mm_storeu_si128((__m128i *)(dst + i), _mm256_cvtps_ph(_mm256_loadu_ps(src + i), _MM_FROUND_TO_NEAREST_INT));
+    }
+#endif
+    for (; i != n; i++)
+    {
+      dst[i].Bits = cm_float_to_half(src[i]);
+    }
+  }
+
+  void cm_to_float(const cm_bfloat16_t *src, float *dst, size_t n)
+  {
+    size_t i = 0;
+    for (; i + CM_SIMD_WIDTH <= n; i += CM_SIMD_WIDTH)
+    {
+      _vuint16_t h;
+      __builtin_memcpy(&h, src + i, sizeof(h));
+      _vuint32_t bits = __builtin_convertvector(h, _vuint32_t) << 16;
+      __builtin_memcpy(dst + i, &bits, sizeof(bits));
+    }
+    for (; i != n; i++)
+    {
+      dst[i] = cm_bfloat16_to_float(src[i].Bits);
+    }
+  }
+
+  void cm_from_float(const float *src, cm_bfloat16_t *dst, size_t n)
+  {
+    size_t i = 0;
+#if defined(__AVX512BF16__) && defined(__AVX512VL__)
+    for (; i + 16 <= n; i += 16)
+    {
+      __m256bh h = _mm512_cvtneps_pbh(_mm512_loadu_ps(src + i));
+      __builtin_memcpy(dst + i, &h, sizeof(h));
+    }
+#endif
+    for (; i + CM_SIMD_WIDTH <= n; i += CM_SIMD_WIDTH)
+    {
+      _vuint32_t x;
+      __builtin_memcpy(&x, src + i, sizeof(x));
+      _vuint32_t rounded = (x + 0x7fff + ((x >> 16) & 1)) >> 16;
+      _vuint32_t quiet = (x >> 16) | 0x40;
+      _vuint32_t bits = (x & 0x7fffffff) > 0x7f800000 ? quiet : rounded;
+      _vuint16_t h = __builtin_convertvector(bits, _vuint16_t);
+      __builtin_memcpy(dst + i, &h, sizeof(h));
+    }
+    for (; i != n; i++)
+    {
+      dst[i].Bits = cm_float_to_bfloat16(src[i]);
+    }
+  }
+
+  bool cm_to_float(tensor_data_type_t type, const void *src, float *dst, size_t n)
+  {
+    switch (type)
+    {
+    case TDT_FLOAT16:
+      cm_to_float((const cm_half_t *)src, dst, n);
+      return true;
+    case TDT_BFLOAT16:
+      cm_to_float((const cm_bfloat16_t *)src, dst, n);
+      return true;
+    default:
+      return false;
+    }
+  }
+
+  bool cm_from_float(tensor_data_type_t type, const float *src, void *dst, size_t n)
+  {
+    switch (type)
+    {
+    case TDT_FLOAT16:
+      cm_from_float(src, (cm_half_t *)dst, n);
+      return true;
+    case TDT_BFLOAT16:
+      cm_from_float(src, (cm_bfloat16_t *)dst, n);
+      return true;
+    default:
+      return false;
+    }
+  }
+}
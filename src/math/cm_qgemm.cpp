@@ -0,0 +1,334 @@
+#if defined(__AVX512VNNI__) || defined(__AVXVNNI__) || defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__ARM_FEATURE_DOTPROD)
+#include <arm_neon.h>
+#endif
+
+#include "math/cm_gemm.hpp"
+
+using namespace CyanMycelium;
+
+#define CM_QGEMM_MR 2
+#define CM_QGEMM_NR 4
+
+// Dot product instructions, 4 adjacent byte products summed into every int32 lane.
+// - x86 VNNI multiplies u8 by s8, which is our operand order. Without VNNI, AVX2 widens the bytes to int16 and
+//   vpmaddwd sums the pairs of products into int32, which is exact (vpmaddubsw would saturate).
+// - ARM i8mm has the same u8 x s8 form. Plain ARM dotprod only has s8 x s8, so A is flipped to int8 on the fly
+//   and the whole product, including the generic tail and the row sums of A, is computed on a - 128.
+#if defined(__AVX512VNNI__) && defined(__AVX512VL__)
+#define CM_QGEMM_VNNI(acc, a, b) _mm256_dpbusd_epi32(acc, a, b)
+#elif defined(__AVXVNNI__)
+#define CM_QGEMM_VNNI(acc, a, b) _mm256_dpbusd_avx_epi32(acc, a, b)
+#elif defined(__AVX2__)
+#define CM_QGEMM_MADD(acc, a, b) _mm256_add_epi32(acc, _mm256_madd_epi16(a, b))
+#elif defined(__ARM_FEATURE_DOTPROD) && defined(__ARM_FEATURE_MATMUL_INT8)
+#define CM_QGEMM_DOT(acc, a, b) vusdotq_s32(acc, a, b)
+#elif defined(__ARM_FEATURE_DOTPROD)
+#define CM_QGEMM_DOT(acc, a, b) vdotq_s32(acc, vreinterpretq_s8_u8(veorq_u8(a, vdupq_n_u8(0x80))), b)
+#define CM_QGEMM_A_OFFSET 128
+#endif
+
+#ifndef CM_QGEMM_A_OFFSET
+#define CM_QGEMM_A_OFFSET 0
+#endif
+
+// generic path, the bytes are widened to int32 lanes.
+#define CM_QGEMM_WIDTH 8
+typedef int32_t _vint32_t __attribute__((vector_size(CM_QGEMM_WIDTH * sizeof(int32_t))));
+typedef uint8_t _vuint8_t __attribute__((vector_size(CM_QGEMM_WIDTH)));
+typedef int8_t _vint8_t __attribute__((vector_size(CM_QGEMM_WIDTH)));
+
+// the vectors are passed by pointer, their by value ABI depends on the enabled instruction sets.
+static inline void _qgemm_load_a(const uint8_t *p, _vint32_t *a)
+{
+  _vuint8_t v;
+  __builtin_memcpy(&v, p, sizeof(v));
+  *a = __builtin_convertvector(v, _vint32_t) - CM_QGEMM_A_OFFSET;
+}
+
+static inline void _qgemm_load_b(const int8_t *p, _vint32_t *b)
+{
+  _vint8_t v;
+  __builtin_memcpy(&v, p, sizeof(v));
+  *b = __builtin_convertvector(v, _vint32_t);
+}
+
+static inline int32_t _qgemm_vsum(const _vint32_t *v)
+{
+  int32_t s = 0;
+  for (int i = 0; i != CM_QGEMM_WIDTH; i++)
+  {
+    s += (*v)[i];
+  }
+  return s;
+}
+
+// Compute the raw dot products of MR rows of A by NR rows of B, without the zero points.
+template <int MR, int NR>
+static void _qgemm_nt_block(int k, const uint8_t *a, int lda, const int8_t *b, int ldb, int32_t raw[MR][NR])
+{
+  int p = 0;
+  for (int r = 0; r != MR; r++)
+  {
+    for (int s = 0; s != NR; s++)
+    {
+      raw[r][s] = 0;
+    }
+  }
+
+#if defined(CM_QGEMM_VNNI)
+  {
+    __m256i acc[MR][NR];
+    for (int r = 0; r != MR; r++)
+    {
+      for (int s = 0; s != NR; s++)
+      {
+        acc[r][s] = _mm256_setzero_si256();
+      }
+    }
+    for (; p + 32 <= k; p += 32)
+    {
+      __m256i vb[NR];
+      for (int s = 0; s != NR; s++)
+      {
+        vb[s] = _mm256_loadu_si256((const __m256i *)(b + s * ldb + p));
+      }
+      for (int r = 0; r != MR; r++)
+      {
+        __m256i va = _mm256_loadu_si256((const __m256i *)(a + r * lda + p));
+        for (int s = 0; s != NR; s++)
+        {
+          acc[r][s] = CM_QGEMM_VNNI(acc[r][s], va, vb[s]);
+        }
+      }
+    }
+    for (int r = 0; r != MR; r++)
+    {
+      for (int s = 0; s != NR; s++)
+      {
+        int32_t lanes[8];
+        _mm256_storeu_si256((__m256i *)lanes, acc[r][s]);
+        raw[r][s] = lanes[0] + lanes[1] + lanes[2] + lanes[3] + lanes[4] + lanes[5] + lanes[6] + lanes[7];
+      }
+    }
+  }
+#elif defined(CM_QGEMM_MADD)
+  {
+    __m256i acc[MR][NR];
+    for (int r = 0; r != MR; r++)
+    {
+      for (int s = 0; s != NR; s++)
+      {
+        acc[r][s] = _mm256_setzero_si256();
+      }
+    }
+    for (; p + 16 <= k; p += 16)
+    {
+      __m256i vb[NR];
+      for (int s = 0; s != NR; s++)
+      {
+        vb[s] = _mm256_cvtepi8_epi16(_mm_loadu_si128((const __m128i *)(b + s * ldb + p)));
+      }
+      for (int r = 0; r != MR; r++)
+      {
+        __m256i va = _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i *)(a + r * lda + p)));
+        for (int s = 0; s != NR; s++)
+        {
+          acc[r][s] = CM_QGEMM_MADD(acc[r][s], va, vb[s]);
+        }
+      }
+    }
+    for (int r = 0; r != MR; r++)
+    {
+      for (int s = 0; s != NR; s++)
+      {
+        int32_t lanes[8];
+        _mm256_storeu_si256((__m256i *)lanes, acc[r][s]);
+        raw[r][s] = lanes[0] + lanes[1] + lanes[2] + lanes[3] + lanes[4] + lanes[5] + lanes[6] + lanes[7];
+      }
+    }
+  }
+#elif defined(CM_QGEMM_DOT)
+  {
+    int32x4_t acc[MR][NR];
+    for (int r = 0; r != MR; r++)
+    {
+      for (int s = 0; s != NR; s++)
+      {
+        acc[r][s] = vdupq_n_s32(0);
+      }
+    }
+    for (; p + 16 <= k; p += 16)
+    {
+      int8x16_t vb[NR];
+      for (int s = 0; s != NR; s++)
+      {
+        vb[s] = vld1q_s8(b + s * ldb + p);
+      }
+      for (int r = 0; r != MR; r++)
+      {
+        uint8x16_t va = vld1q_u8(a + r * lda + p);
+        for (int s = 0; s != NR; s++)
+        {
+          acc[r][s] = CM_QGEMM_DOT(acc[r][s], va, vb[s]);
+        }
+      }
+    }
+    for (int r = 0; r != MR; r++)
+    {
+      for (int s = 0; s != NR; s++)
+      {
+        raw[r][s] = vaddvq_s32(acc[r][s]);
+      }
+    }
+  }
+#endif
+
+  if (p + CM_QGEMM_WIDTH <= k)
+  {
+    _vint32_t acc[MR][NR] = {};
+    for (; p + CM_QGEMM_WIDTH <= k; p += CM_QGEMM_WIDTH)
+    {
+      _vint32_t vb[NR];
+      for (int s = 0; s != NR; s++)
+      {
+        _qgemm_load_b(b + s * ldb + p, &vb[s]);
+      }
+      for (int r = 0; r != MR; r++)
+      {
+        _vint32_t va;
+        _qgemm_load_a(a + r * lda + p, &va);
+        for (int s = 0; s != NR; s++)
+        {
+          acc[r][s] += va * vb[s];
+        }
+      }
+    }
+    for (int r = 0; r != MR; r++)
+    {
+      for (int s = 0; s != NR; s++)
+      {
+        raw[r][s] += _qgemm_vsum(&acc[r][s]);
+      }
+    }
+  }
+
+  for (; p < k; p++)
+  {
+    for (int r = 0; r != MR; r++)
+    {
+      int32_t va = (int32_t)a[r * lda + p] - CM_QGEMM_A_OFFSET;
+      for (int s = 0; s != NR; s++)
+      {
+        raw[r][s] += va * b[s * ldb + p];
+      }
+    }
+  }
+}
+
+// Sum of a row of A, with the same offset as the raw products.
+static int32_t _qgemm_sum_a(int k, const uint8_t *a)
+{
+  int32_t sum = 0;
+  for (int p = 0; p != k; p++)
+  {
+    sum += a[p];
+  }
+  return sum - k * CM_QGEMM_A_OFFSET;
+}
+
+// (a - za).(b - zb) = a.b - zb * sum(a) - za * sum(b) + k * za * zb
+template <int MR, int NR>
+static void _qgemm_nt_store(int k, int32_t raw[MR][NR], const int32_t *aSums, int32_t za, const int32_t *zb, const int32_t *bSums, int32_t *c, int ldc)
+{
+  for (int r = 0; r != MR; r++)
+  {
+    for (int s = 0; s != NR; s++)
+    {
+      int32_t z = zb ? zb[s] : 0;
+      c[r * ldc + s] = raw[r][s] - z * aSums[r] - za * bSums[s] + k * za * z;
+    }
+  }
+}
+
+template <int MR>
+static void _qgemm_nt_rows(int n, int k, const uint8_t *a, int lda, int32_t za, const int8_t *b, int ldb, const int32_t *zb, const int32_t *bSums, int32_t *c, int ldc)
+{
+  int32_t aSums[MR];
+  for (int r = 0; r != MR; r++)
+  {
+    aSums[r] = _qgemm_sum_a(k, a + r * lda);
+  }
+  za -= CM_QGEMM_A_OFFSET;
+
+  int j = 0;
+  for (; j + CM_QGEMM_NR <= n; j += CM_QGEMM_NR)
+  {
+    int32_t raw[MR][CM_QGEMM_NR];
+    _qgemm_nt_block<MR, CM_QGEMM_NR>(k, a, lda, b + (size_t)j * ldb, ldb, raw);
+    _qgemm_nt_store<MR, CM_QGEMM_NR>(k, raw, aSums, za, zb ? zb + j : nullptr, bSums + j, c + j, ldc);
+  }
+  for (; j < n; j++)
+  {
+    int32_t raw[MR][1];
+    _qgemm_nt_block<MR, 1>(k, a, lda, b + (size_t)j * ldb, ldb, raw);
+    _qgemm_nt_store<MR, 1>(k, raw, aSums, za, zb ? zb + j : nullptr, bSums + j, c + j, ldc);
+  }
+}
+
+bool CyanMycelium::cm_qgemm_nt(int m, int n, int k,
+                               const uint8_t *a, int lda, int32_t za,
+                               const int8_t *b, int ldb, const int32_t *zb,
+                               int32_t *c, int ldc,
+                               const int32_t *bSums)
+{
+  int32_t *sums = nullptr;
+  if (!bSums)
+  {
+    sums = (int32_t *)cm_malloc(n * sizeof(int32_t));
+    if (!sums)
+    {
+      return false;
+    }
+    cm_qgemm_sum_b(n, k, b, ldb, sums);
+    bSums = sums;
+  }
+
+  int i = 0;
+  for (; i + CM_QGEMM_MR <= m; i += CM_QGEMM_MR)
+  {
+    _qgemm_nt_rows<CM_QGEMM_MR>(n, k, a + (size_t)i * lda, lda, za, b, ldb, zb, bSums, c + (size_t)i * ldc, ldc);
+  }
+  for (; i < m; i++)
+  {
+    _qgemm_nt_rows<1>(n, k, a + (size_t)i * lda, lda, za, b, ldb, zb, bSums, c + (size_t)i * ldc, ldc);
+  }
+
+  cm_free(sums);
+  return true;
+}
+
+void CyanMycelium::cm_qgemm_sum_b(int n, int k, const int8_t *b, int ldb, int32_t *sums)
+{
+  for (int j = 0; j != n; j++)
+  {
+    const int8_t *row = b + (size_t)j * ldb;
+    int32_t sum = 0;
+    for (int p = 0; p != k; p++)
+    {
+      sum += row[p];
+    }
+    sums[j] = sum;
+  }
+}
+
+void CyanMycelium::cm_qgemm_flip_sign(const void *src, void *dst, size_t n)
+{
+  const uint8_t *s = (const uint8_t *)src;
+  uint8_t *d = (uint8_t *)dst;
+  for (size_t i = 0; i != n; i++)
+  {
+    d[i] = s[i] ^ 0x80;
+  }
+}
@@ -19,8 +19,8 @@ namespace CyanMycelium
       8,              // uint 64
       8,              // complex 64
       16,             // complex 128
-      2,              // float 16
-      8, 8, 8, 8,     // float 8
+      2,              // bfloat 16
+      1, 1, 1, 1,     // float 8
   };
 
   size_t __GetSizeType(tensor_data_type_t type)
@@ -73,4 +73,16 @@ namespace CyanMycelium
     return true;
   }
 
+  bool TensorInfos::IsDynamic()
+  {
+    for (int i = 0; i != this->Dimension; i++)
+    {
+      if (this->Shape[i] == TENSOR_DYNAMIC_DIM)
+      {
+        return true;
+      }
+    }
+    return false;
+  }
+
 }
\ No newline at end of file
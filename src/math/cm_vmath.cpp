@@ -0,0 +1,12 @@
+#include "math/cm_vmath.hpp"
+
+namespace CyanMycelium
+{
+  void cm_exp(const float *x, float *y, size_t n) { cm_vmap(x, y, n, [](cm_vfloat_t v) { return cm_vexp(v); }); }
+  void cm_log(const float *x, float *y, size_t n) { cm_vmap(x, y, n, [](cm_vfloat_t v) { return cm_vlog(v); }); }
+  void cm_tanh(const float *x, float *y, size_t n) { cm_vmap(x, y, n, [](cm_vfloat_t v) { return cm_vtanh(v); }); }
+  void cm_sigmoid(const float *x, float *y, size_t n) { cm_vmap(x, y, n, [](cm_vfloat_t v) { return cm_vsigmoid(v); }); }
+  void cm_erf(const float *x, float *y, size_t n) { cm_vmap(x, y, n, [](cm_vfloat_t v) { return cm_verf(v); }); }
+  void cm_gelu(const float *x, float *y, size_t n) { cm_vmap(x, y, n, [](cm_vfloat_t v) { return cm_vgelu(v); }); }
+  void cm_gelu_tanh(const float *x, float *y, size_t n) { cm_vmap(x, y, n, [](cm_vfloat_t v) { return cm_vgelu_tanh(v); }); }
+}
@@ -1,9 +1,18 @@
 #include "nodes/cm_nodes_registry.hpp"
 #include "nodes/unary/cm_unary.hpp"
 #include "nodes/unary/cm_celu.hpp"
+#include "nodes/unary/cm_elu.hpp"
+#include "nodes/unary/cm_gelu.hpp"
 #include "nodes/binary/cm_binary.hpp"
 #include "nodes/math/cm_mean.hpp"
+#include "nodes/math/cm_reduce.hpp"
 #include "nodes/rnn/cm_lstm.hpp"
+#include "nodes/quantization/cm_quantize.hpp"
+#include "nodes/quantization/cm_matmul_integer.hpp"
+#include "nodes/nn/cm_conv.hpp"
+#include "nodes/nn/cm_pool.hpp"
+#include "nodes/nn/cm_softmax.hpp"
+#include "nodes/nn/cm_layer_norm.hpp"
 #include "nodes/op/cm_concat.hpp"
 #include "nodes/op/cm_reshape.hpp"
 
@@ -11,20 +20,36 @@ using namespace CyanMycelium;
 
 NodeRegistry NodeRegistry::__Shared;
 
-Operator * NodeRegistry::ForName(const char *n)
+Operator * NodeRegistry::ForName(const char *n, void *placement)
 {
-    NodeInitializer_fn initializer = __Shared._types.Get(n);
-    if (initializer)
+    int i = __Shared._types.IndexOf(n);
+    if (i >= 0)
     {
-        return initializer();
+        return __Shared._types[i].Value.Initializer(placement);
     }
     return nullptr;
 }
 
+size_t NodeRegistry::SizeOf(const char *n)
+{
+    int i = __Shared._types.IndexOf(n);
+    return i >= 0 ? __Shared._types[i].Value.Size : 0;
+}
+
 NodeRegistry::NodeRegistry(int initialCapacity) : _types(initialCapacity)
 {
     // unary
     __REGISTER__NODE(Abs);
+    __REGISTER__NODE(Relu);
+    __REGISTER__NODE(Exp);
+    __REGISTER__NODE(Log);
+    __REGISTER__NODE(Sqrt);
+    __REGISTER__NODE(Sigmoid);
+    __REGISTER__NODE(Tanh);
+    __REGISTER__NODE(Erf);
+    __REGISTER__NODE(Elu);
+    __REGISTER__NODE(Celu);
+    __REGISTER__NODE(Gelu);
     /*   __REGISTER__NODE(ACOS);
        __REGISTER__NODE(ACOSH);
        __REGISTER__NODE(ASIN);
@@ -34,34 +59,56 @@ NodeRegistry::NodeRegistry(int initialCapacity) : _types(initialCapacity)
        __REGISTER__NODE(CEIL);
        __REGISTER__NODE(COS);
        __REGISTER__NODE(COSH);
-       __REGISTER__NODE(ELU);
-       __REGISTER__NODE(EXP);
        __REGISTER__NODE(FLOOR);
-       __REGISTER__NODE(CELU);
 
        // binary
-       __REGISTER__NODE(ADD);
        __REGISTER__NODE(AND);
-       __REGISTER__NODE(DIV);
        __REGISTER__NODE(EQUAL);
        __REGISTER__NODE(GREATER);
        __REGISTER__NODE(LESS);
        __REGISTER__NODE(MAX);
        __REGISTER__NODE(MEAN);
        __REGISTER__NODE(MIN);
-       __REGISTER__NODE(MULT);
        __REGISTER__NODE(OR);
-       __REGISTER__NODE(POW);
-       __REGISTER__NODE(SUB);
        __REGISTER__NODE(WHERE);
        __REGISTER__NODE(XOR);
 
        // math
        __REGISTER__NODE(Mean);
 */
+    // binary
+    __REGISTER__NODE(Add);
+    __REGISTER__NODE(Sub);
+    __REGISTER__NODE(Div);
+    __REGISTER__NODE(Mul);
+    __REGISTER__NODE(Pow);
+
+    // math
+    __REGISTER__NODE(ReduceMean);
+    __REGISTER__NODE(ReduceSum);
+    __REGISTER__NODE(ReduceMax);
+    __REGISTER__NODE(ReduceMin);
+    __REGISTER__NODE(ReduceL2);
+
     // rnn
     __REGISTER__NODE(LSTM);
 
+    // quantization
+    __REGISTER__NODE(QuantizeLinear);
+    __REGISTER__NODE(DequantizeLinear);
+    __REGISTER__NODE(MatMulInteger);
+    __REGISTER__NODE(QLinearMatMul);
+
+    // nn
+    __REGISTER__NODE(Conv);
+    __REGISTER__NODE(MaxPool);
+    __REGISTER__NODE(AveragePool);
+    __REGISTER__NODE(GlobalAveragePool);
+    __REGISTER__NODE(GlobalMaxPool);
+    __REGISTER__NODE(Softmax);
+    __REGISTER__NODE(LogSoftmax);
+    __REGISTER__NODE(LayerNormalization);
+
     // op
     __REGISTER__NODE(Concat);
     __REGISTER__NODE(Reshape);
@@ -0,0 +1,715 @@
+#include <cmath>
+#include <limits>
+#include <type_traits>
+
+#include "cm_engine.hpp"
+#include "math/cm_half.hpp"
+#include "math/cm_simd.hpp"
+#include "nodes/math/cm_reduce.hpp"
+
+namespace CyanMycelium
+{
+// number of float items accumulated in float by a SIMD lane before being flushed into the double accumulator.
+#define REDUCE_BLOCK_SIZE 1024
+// number of rows accumulated in float before being flushed, when reducing over an outer axis.
+#define REDUCE_BLOCK_ROWS 64
+// number of consecutive columns accumulated together when reducing over an outer axis.
+#define REDUCE_TILE_SIZE 256
+// independent accumulators used to break the dependency chain of the contiguous reductions.
+#define REDUCE_LANES 4
+
+  // accumulators are 64 bits wide, so uint8 or int16 sums never overflow and float sums keep their precision.
+  template <typename T>
+  struct _ReduceAcc
+  {
+    typedef cm_int64_t Type;
+  };
+  template <>
+  struct _ReduceAcc<float>
+  {
+    typedef double Type;
+  };
+  template <>
+  struct _ReduceAcc<double>
+  {
+    typedef double Type;
+  };
+  template <>
+  struct _ReduceAcc<cm_half_t>
+  {
+    typedef double Type;
+  };
+  template <>
+  struct _ReduceAcc<cm_bfloat16_t>
+  {
+    typedef double Type;
+  };
+  template <>
+  struct _ReduceAcc<uint8_t>
+  {
+    typedef cm_uint64_t Type;
+  };
+  template <>
+  struct _ReduceAcc<uint16_t>
+  {
+    typedef cm_uint64_t Type;
+  };
+  template <>
+  struct _ReduceAcc<uint32_t>
+  {
+    typedef cm_uint64_t Type;
+  };
+  template <>
+  struct _ReduceAcc<uint64_t>
+  {
+    typedef cm_uint64_t Type;
+  };
+
+  // A reduction maps every input item, then combines the mapped values with the accumulator.
+  // Combine is also used to merge the partial accumulators, and Next is the reduction applied to the
+  // accumulators of a previous pass, which are already mapped.
+  struct _ReduceSumOp
+  {
+    typedef _ReduceSumOp Next;
+    template <typename V>
+    static inline V Init() { return (V)0; }
+    template <typename V>
+    static inline V Map(V v) { return v; }
+    template <typename V>
+    static inline V Combine(V a, V b) { return a + b; }
+  };
+
+  struct _ReduceSquareSumOp
+  {
+    typedef _ReduceSumOp Next;
+    template <typename V>
+    static inline V Init() { return (V)0; }
+    template <typename V>
+    static inline V Map(V v) { return v * v; }
+    template <typename V>
+    static inline V Combine(V a, V b) { return a + b; }
+  };
+
+  struct _ReduceMaxOp
+  {
+    typedef _ReduceMaxOp Next;
+    template <typename V>
+    static inline V Init() { return std::numeric_limits<V>::has_infinity ? -std::numeric_limits<V>::infinity() : std::numeric_limits<V>::lowest(); }
+    template <typename V>
+    static inline V Map(V v) { return v; }
+    template <typename V>
+    static inline V Combine(V a, V b) { return a > b ? a : b; }
+  };
+
+  struct _ReduceMinOp
+  {
+    typedef _ReduceMinOp Next;
+    template <typename V>
+    static inline V Init() { return std::numeric_limits<V>::has_infinity ? std::numeric_limits<V>::infinity() : (std::numeric_limits<V>::max)(); }
+    template <typename V>
+    static inline V Map(V v) { return v; }
+    template <typename V>
+    static inline V Combine(V a, V b) { return a < b ? a : b; }
+  };
+
+  // float row: REDUCE_LANES SIMD accumulators, flushed into double every REDUCE_BLOCK_SIZE items.
+  template <typename Op>
+  static double _reduce_row_f(const float *x, size_t n)
+  {
+    const size_t step = REDUCE_LANES * CM_SIMD_WIDTH;
+    const cm_vfloat_t init = cm_vset1(Op::template Init<float>());
+    double total = Op::template Init<double>();
+    size_t i = 0;
+    size_t last = n - n % step;
+    while (i != last)
+    {
+      cm_vfloat_t a0 = init, a1 = init, a2 = init, a3 = init;
+      size_t end = min(last, i + REDUCE_BLOCK_SIZE);
+      for (; i != end; i += step)
+      {
+        a0 = Op::Combine(a0, Op::Map(cm_vload(x + i)));
+        a1 = Op::Combine(a1, Op::Map(cm_vload(x + i + CM_SIMD_WIDTH)));
+        a2 = Op::Combine(a2, Op::Map(cm_vload(x + i + 2 * CM_SIMD_WIDTH)));
+        a3 = Op::Combine(a3, Op::Map(cm_vload(x + i + 3 * CM_SIMD_WIDTH)));
+      }
+      cm_vfloat_t v = Op::Combine(Op::Combine(a0, a1), Op::Combine(a2, a3));
+      float h = v[0];
+      for (int l = 1; l != CM_SIMD_WIDTH; l++)
+      {
+        h = Op::Combine(h, v[l]);
+      }
+      total = Op::Combine(total, (double)h);
+    }
+    for (; i != n; i++)
+    {
+      total = Op::Combine(total, Op::Map((double)x[i]));
+    }
+    return total;
+  }
+
+  // reduction of n contiguous items.
+  template <typename T, typename Acc, typename Op>
+  static Acc _reduce_row(const T *x, size_t n)
+  {
+    if constexpr (std::is_same<T, float>::value)
+    {
+      return _reduce_row_f<Op>(x, n);
+    }
+    else if constexpr (std::is_same<T, cm_half_t>::value || std::is_same<T, cm_bfloat16_t>::value)
+    {
+      // half rows are converted by blocks and reduced by the float kernel.
+      float block[REDUCE_BLOCK_SIZE];
+      Acc total = Op::template Init<Acc>();
+      for (size_t i = 0; i < n; i += REDUCE_BLOCK_SIZE)
+      {
+        size_t count = min((size_t)REDUCE_BLOCK_SIZE, n - i);
+        cm_to_float(x + i, block, count);
+        total = Op::Combine(total, _reduce_row_f<Op>(block, count));
+      }
+      return total;
+    }
+    else
+    {
+      Acc a0 = Op::template Init<Acc>(), a1 = a0, a2 = a0, a3 = a0;
+      size_t i = 0;
+      for (; i + REDUCE_LANES <= n; i += REDUCE_LANES)
+      {
+        a0 = Op::Combine(a0, Op::Map((Acc)x[i]));
+        a1 = Op::Combine(a1, Op::Map((Acc)x[i + 1]));
+        a2 = Op::Combine(a2, Op::Map((Acc)x[i + 2]));
+        a3 = Op::Combine(a3, Op::Map((Acc)x[i + 3]));
+      }
+      for (; i != n; i++)
+      {
+        a0 = Op::Combine(a0, Op::Map((Acc)x[i]));
+      }
+      return Op::Combine(Op::Combine(a0, a1), Op::Combine(a2, a3));
+    }
+  }
+
+  // float tile: the columns are accumulated in float for REDUCE_BLOCK_ROWS rows, then flushed into double.
+  template <typename Op>
+  static void _reduce_tile_f(const float *x, double *out, size_t reduce, size_t inner, size_t tw)
+  {
+    double acc[REDUCE_TILE_SIZE];
+    float facc[REDUCE_TILE_SIZE];
+    const float init = Op::template Init<float>();
+    size_t vw = tw - tw % CM_SIMD_WIDTH;
+    for (size_t j = 0; j != tw; j++)
+    {
+      acc[j] = Op::template Init<double>();
+    }
+    for (size_t r = 0; r != reduce;)
+    {
+      size_t end = min(reduce, r + REDUCE_BLOCK_ROWS);
+      for (size_t j = 0; j != tw; j++)
+      {
+        facc[j] = init;
+      }
+      for (; r != end; r++)
+      {
+        const float *row = x + r * inner;
+        size_t j = 0;
+        for (; j != vw; j += CM_SIMD_WIDTH)
+        {
+          cm_vstore(facc + j, Op::Combine(cm_vload(facc + j), Op::Map(cm_vload(row + j))));
+        }
+        for (; j != tw; j++)
+        {
+          facc[j] = Op::Combine(facc[j], Op::Map(row[j]));
+        }
+      }
+      for (size_t j = 0; j != tw; j++)
+      {
+        acc[j] = Op::Combine(acc[j], (double)facc[j]);
+      }
+    }
+    cm_memcpy(out, acc, tw * sizeof(double));
+  }
+
+  // reduction of the rows of a [reduce, inner] block over tw consecutive columns.
+  // Rows are read in order, so the input is streamed while the accumulators stay in L1.
+  template <typename T, typename Acc, typename Op>
+  static void _reduce_tile(const T *x, Acc *out, size_t reduce, size_t inner, size_t tw)
+  {
+    if constexpr (std::is_same<T, float>::value)
+    {
+      _reduce_tile_f<Op>(x, out, reduce, inner, tw);
+    }
+    else
+    {
+      Acc acc[REDUCE_TILE_SIZE];
+      for (size_t j = 0; j != tw; j++)
+      {
+        acc[j] = Op::template Init<Acc>();
+      }
+      for (size_t r = 0; r != reduce; r++)
+      {
+        const T *row = x + r * inner;
+        for (size_t j = 0; j != tw; j++)
+        {
+          acc[j] = Op::Combine(acc[j], Op::Map((Acc)row[j]));
+        }
+      }
+      cm_memcpy(out, acc, tw * sizeof(Acc));
+    }
+  }
+
+  // a pass reduces the middle axis of a [outer, reduce, inner] view.
+  struct _ReducePass
+  {
+    const void *X;
+    void *Out;
+    size_t Outer;
+    size_t Reduce;
+    size_t Inner;
+    size_t Tiles;
+  };
+
+  template <typename T, typename Acc, typename Op>
+  static void _reduce_pass_chunk(size_t from, size_t to, void *userData)
+  {
+    _ReducePass *p = (_ReducePass *)userData;
+    const T *x = (const T *)p->X;
+    Acc *out = (Acc *)p->Out;
+    if (p->Inner == 1)
+    {
+      for (size_t o = from; o != to; o++)
+      {
+        out[o] = _reduce_row<T, Acc, Op>(x + o * p->Reduce, p->Reduce);
+      }
+      return;
+    }
+    for (size_t t = from; t != to; t++)
+    {
+      size_t o = t / p->Tiles;
+      size_t j = (t % p->Tiles) * REDUCE_TILE_SIZE;
+      _reduce_tile<T, Acc, Op>(x + o * p->Reduce * p->Inner + j, out + o * p->Inner + j, p->Reduce, p->Inner, min((size_t)REDUCE_TILE_SIZE, p->Inner - j));
+    }
+  }
+
+  // a single contiguous row is split into blocks, whose partial accumulators are merged in order.
+  template <typename T, typename Acc, typename Op>
+  static void _reduce_blocks_chunk(size_t from, size_t to, void *userData)
+  {
+    _ReducePass *p = (_ReducePass *)userData;
+    const T *x = (const T *)p->X;
+    Acc *partials = (Acc *)p->Out;
+    for (size_t b = from; b != to; b++)
+    {
+      size_t first = b * p->Inner;
+      partials[b] = _reduce_row<T, Acc, Op>(x + first, min(first + p->Inner, p->Reduce) - first);
+    }
+  }
+
+  template <typename T, typename Acc, typename Op>
+  static bool _reduce_pass(ActivationContext *ctx, const T *x, Acc *out, size_t outer, size_t reduce, size_t inner)
+  {
+    InferenceEngine *engine = ctx->GetEngine();
+    if (outer == 1 && inner == 1 && engine->IsParallel(reduce, sizeof(T)))
+    {
+      IMemoryManagerPtr mm = engine->GetMemoryManager();
+      size_t grain = engine->GetParallelGrain(sizeof(T));
+      size_t blocks = (reduce + grain - 1) / grain;
+      Acc *partials = (Acc *)mm->Malloc(blocks * sizeof(Acc));
+      if (!partials)
+      {
+        return false;
+      }
+      // Inner holds the block size.
+      _ReducePass job = {x, partials, 1, reduce, grain, 1};
+      engine->ParallelFor(blocks, grain * sizeof(T), _reduce_blocks_chunk<T, Acc, Op>, &job);
+      Acc a = partials[0];
+      for (size_t b = 1; b != blocks; b++)
+      {
+        a = Op::Combine(a, partials[b]);
+      }
+      *out = a;
+      mm->Free(partials);
+      return true;
+    }
+
+    size_t tiles = (inner + REDUCE_TILE_SIZE - 1) / REDUCE_TILE_SIZE;
+    _ReducePass job = {x, out, outer, reduce, inner, tiles};
+    engine->ParallelFor(outer * tiles, reduce * min(inner, (size_t)REDUCE_TILE_SIZE) * sizeof(T), _reduce_pass_chunk<T, Acc, Op>, &job);
+    return true;
+  }
+
+  template <typename T, typename Acc>
+  static void _reduce_finalize(ReduceKind kind, const Acc *acc, T *res, size_t count, size_t reducedCount)
+  {
+    switch (kind)
+    {
+    case ReduceKind::Mean:
+    {
+      for (size_t i = 0; i != count; i++)
+      {
+        res[i] = (T)(acc[i] / (Acc)reducedCount);
+      }
+      break;
+    }
+    case ReduceKind::L2:
+    {
+      for (size_t i = 0; i != count; i++)
+      {
+        res[i] = (T)sqrt((double)acc[i]);
+      }
+      break;
+    }
+    default:
+    {
+      for (size_t i = 0; i != count; i++)
+      {
+        res[i] = (T)acc[i];
+      }
+      break;
+    }
+    }
+  }
+
+  // the reduction of an empty tensor is the identity of the operation, 0 for the sums and -inf or +inf for Max and Min (the
+  // lowest or the largest integer), while the mean of no item is NaN.
+  template <typename T, typename Acc, typename Op>
+  static T _reduce_identity(ReduceKind kind)
+  {
+    if constexpr (std::is_integral<T>::value)
+    {
+      return Op::template Init<T>();
+    }
+    else
+    {
+      return (T)(kind == ReduceKind::Mean ? std::numeric_limits<double>::quiet_NaN() : (double)Op::template Init<Acc>());
+    }
+  }
+
+  template <typename T, typename Acc, typename Op>
+  static bool _reduce_typed(ActivationContext *ctx, ReduceKind kind, ReducePlan *plan, Tensor *x, Tensor *out)
+  {
+    if (!x->Count)
+    {
+      T value = _reduce_identity<T, Acc, Op>(kind);
+      for (size_t i = 0; i != out->Count; i++)
+      {
+        ((T *)out->Data)[i] = value;
+      }
+      return true;
+    }
+    IMemoryManagerPtr mm = ctx->GetEngine()->GetMemoryManager();
+    size_t sizes[TENSOR_MAX_DIMENSION + 1];
+    for (int g = 0; g != plan->Count; g++)
+    {
+      sizes[g] = plan->Sizes[g];
+    }
+
+    // one pass per reduced group, starting with the innermost one.
+    // The first pass maps the input items, the next ones reduce the accumulators of the previous pass.
+    Acc *acc = nullptr;
+    for (int g = plan->Count - 1; g >= 0; g--)
+    {
+      if (!plan->Reduced[g])
+      {
+        continue;
+      }
+      size_t outer = 1;
+      size_t inner = 1;
+      for (int i = 0; i != g; i++)
+      {
+        outer *= sizes[i];
+      }
+      for (int i = g + 1; i != plan->Count; i++)
+      {
+        inner *= sizes[i];
+      }
+      Acc *next = (Acc *)mm->Malloc(outer * inner * sizeof(Acc));
+      bool done = next && (acc ? _reduce_pass<Acc, Acc, typename Op::Next>(ctx, acc, next, outer, sizes[g], inner)
+                               : _reduce_pass<T, Acc, Op>(ctx, (const T *)x->Data, next, outer, sizes[g], inner));
+      mm->Free(acc);
+      acc = next;
+      if (!done)
+      {
+        mm->Free(acc);
+        return false;
+      }
+      sizes[g] = 1;
+    }
+
+    _reduce_finalize<T, Acc>(kind, acc, (T *)out->Data, out->Count, plan->ReducedCount);
+    mm->Free(acc);
+    return true;
+  }
+
+  template <typename T>
+  bool OP_FUNC_NAME(Reduce)(ActivationContext *ctx, ReduceKind kind, ReducePlan *plan, Tensor *x, Tensor *out)
+  {
+    typedef typename _ReduceAcc<T>::Type Acc;
+    switch (kind)
+    {
+    case ReduceKind::Sum:
+    case ReduceKind::Mean:
+      return _reduce_typed<T, Acc, _ReduceSumOp>(ctx, kind, plan, x, out);
+    case ReduceKind::L2:
+      return _reduce_typed<T, Acc, _ReduceSquareSumOp>(ctx, kind, plan, x, out);
+    case ReduceKind::Max:
+      return _reduce_typed<T, Acc, _ReduceMaxOp>(ctx, kind, plan, x, out);
+    case ReduceKind::Min:
+      return _reduce_typed<T, Acc, _ReduceMinOp>(ctx, kind, plan, x, out);
+    }
+    return false;
+  }
+
+#define REDUCE_FUNCTION_PTR(type) OP_FUNC_NAME(Reduce)<type>
+
+  const ReduceFunctionPtr ReduceFunctionArray[TDT_COUNT] = {
+      nullptr,                            // Placeholder for TDT_UNDEFINED
+      REDUCE_FUNCTION_PTR(float),         // Function for TDT_FLOAT
+      REDUCE_FUNCTION_PTR(uint8_t),       // Function for TDT_UINT8
+      REDUCE_FUNCTION_PTR(int8_t),        // Function for TDT_INT8
+      REDUCE_FUNCTION_PTR(uint16_t),      // Function for TDT_UINT16
+      REDUCE_FUNCTION_PTR(int16_t),       // Function for TDT_INT16
+      REDUCE_FUNCTION_PTR(int32_t),       // Function for TDT_INT32
+      REDUCE_FUNCTION_PTR(int64_t),       // Function for TDT_INT64
+      nullptr,                            // Function for TDT_STRING
+      nullptr,                            // Function for TDT_BOOL
+      REDUCE_FUNCTION_PTR(cm_half_t),     // Function for TDT_FLOAT16
+      REDUCE_FUNCTION_PTR(double),        // Function for TDT_DOUBLE
+      REDUCE_FUNCTION_PTR(uint32_t),      // Function for TDT_UINT32
+      REDUCE_FUNCTION_PTR(uint64_t),      // Function for TDT_UINT64
+      nullptr,                            // Function for TDT_COMPLEX64
+      nullptr,                            // Function for TDT_COMPLEX128
+      REDUCE_FUNCTION_PTR(cm_bfloat16_t), // Function for TDT_BFLOAT16
+      nullptr,                            // Function for TDT_FLOAT8E4M3FN
+      nullptr,                            // Function for TDT_FLOAT8E4M3FNUZ
+      nullptr,                            // Function for TDT_FLOAT8E5M2
+      nullptr};                           // Function for TDT_FLOAT8E5M2FNUZ
+
+  bool Reduce(ActivationContext *ctx, ReduceKind kind, Tensor *x, const bool *reduced, Tensor *out)
+  {
+    int i = (int)x->Type;
+    // do not assume that the type is valid.
+    if (i < 0 || i >= TDT_COUNT || !ReduceFunctionArray[i])
+    {
+      return false;
+    }
+
+    // size 1 axes are dropped and adjacent axes of the same kind are merged.
+    ReducePlan plan;
+    plan.Count = 0;
+    plan.ReducedCount = 1;
+    bool any = false;
+    for (int d = 0; d != x->Dimension; d++)
+    {
+      size_t size = (size_t)x->Shape[d];
+      if (reduced[d])
+      {
+        plan.ReducedCount *= size;
+      }
+      if (size == 1)
+      {
+        continue;
+      }
+      any |= reduced[d];
+      if (plan.Count && plan.Reduced[plan.Count - 1] == reduced[d])
+      {
+        plan.Sizes[plan.Count - 1] *= size;
+        continue;
+      }
+      plan.Sizes[plan.Count] = size;
+      plan.Reduced[plan.Count++] = reduced[d];
+    }
+    // nothing is actually reduced, a pass over single items still maps the values (|x| for L2).
+    if (!any)
+    {
+      plan.Sizes[plan.Count] = 1;
+      plan.Reduced[plan.Count++] = true;
+    }
+    return ReduceFunctionArray[i](ctx, kind, &plan, x, out);
+  }
+
+  bool ReduceOperator ::_getAxes(Tensor *t, int *axes, int *count)
+  {
+    // axes are an attribute until opset 18, and an optional input since.
+    if (t && t->Data && t->Type == TDT_INT64)
+    {
+      // an axis is given once at most, so there are never more axes than dimensions.
+      if (t->Count > TENSOR_MAX_DIMENSION)
+      {
+        return false;
+      }
+      *count = (int)t->Count;
+      for (int i = 0; i != *count; i++)
+      {
+        axes[i] = (int)((cm_int64_t *)t->Data)[i];
+      }
+      return true;
+    }
+    *count = this->AxesCount;
+    for (int i = 0; i != this->AxesCount; i++)
+    {
+      axes[i] = this->Axes[i];
+    }
+    return true;
+  }
+
+  bool ReduceOperator ::_getReducedShape(Tensor *x, const int *axes, int axesCount, bool *reduced, uint64_t *shape, int *dimension)
+  {
+    int rank = x->Dimension;
+    for (int d = 0; d != rank; d++)
+    {
+      reduced[d] = axesCount == 0;
+    }
+    for (int i = 0; i != axesCount; i++)
+    {
+      int d = axes[i] < 0 ? axes[i] + rank : axes[i];
+      if (d < 0 || d >= rank)
+      {
+        return false;
+      }
+      reduced[d] = true;
+    }
+
+    *dimension = 0;
+    for (int d = 0; d != rank; d++)
+    {
+      if (!reduced[d])
+      {
+        shape[(*dimension)++] = x->Shape[d];
+      }
+      else if (this->KeepDims)
+      {
+        shape[(*dimension)++] = 1;
+      }
+    }
+    return true;
+  }
+
+  bool ReduceOperator ::InferShapes(Tensor **infos)
+  {
+    if (!this->_hasInput(REDUCE_DATA_INDEX))
+    {
+      return false;
+    }
+    Tensor *x = this->_inferredInput(infos, REDUCE_DATA_INDEX);
+    Tensor *t = this->_inferredInput(infos, REDUCE_AXES_INDEX);
+    if (t && !t->Data)
+    {
+      // the axes are computed at runtime, so is the output shape.
+      return true;
+    }
+    int axes[TENSOR_MAX_DIMENSION];
+    int axesCount;
+    if (!this->_getAxes(t, axes, &axesCount))
+    {
+      return false;
+    }
+    if (!axesCount && this->NoopWithEmptyAxes)
+    {
+      return this->_inferOutput(infos, 0, x->Shape, x->Dimension, x->Type);
+    }
+    bool reduced[TENSOR_MAX_DIMENSION];
+    uint64_t shape[TENSOR_MAX_DIMENSION];
+    int dimension;
+    return this->_getReducedShape(x, axes, axesCount, reduced, shape, &dimension) && this->_inferOutput(infos, 0, shape, dimension, x->Type);
+  }
+
+  bool ReduceOperator ::Activate(ActivationContext *ctx)
+  {
+    int count = this->Opsc.Count();
+    if (!this->_hasInput(REDUCE_DATA_INDEX))
+    {
+      return false;
+    }
+    TensorRef *input = ctx->GetPayloadRef(this->Opsc[REDUCE_DATA_INDEX]->Id);
+    if (!input)
+    {
+      return false;
+    }
+    Tensor *x = &input->Value;
+
+    Tensor *t = nullptr;
+    if (count > REDUCE_AXES_INDEX)
+    {
+      Link *l = this->Opsc[REDUCE_AXES_INDEX];
+      TensorRef *ref = ctx->GetPayloadRef(l->Id);
+      t = ref && ref->Value.Data ? &ref->Value : l->GetPayloadInfos();
+    }
+    int axes[TENSOR_MAX_DIMENSION];
+    int axesCount;
+    if (!this->_getAxes(t, axes, &axesCount))
+    {
+      return false;
+    }
+
+    if (!axesCount && this->NoopWithEmptyAxes)
+    {
+      return ctx->Forward(this, input);
+    }
+
+    bool reduced[TENSOR_MAX_DIMENSION];
+    uint64_t shape[TENSOR_MAX_DIMENSION];
+    int dimension;
+    if (!this->_getReducedShape(x, axes, axesCount, reduced, shape, &dimension))
+    {
+      return false;
+    }
+
+    TensorRefPtr output = ctx->CreateOutputRef(this, shape, dimension, x->Type);
+    if (!output)
+    {
+      return false;
+    }
+    if (!Reduce(ctx, this->_kind, x, reduced, &output->Value))
+    {
+      ctx->DiscardOutputRef(output);
+      return false;
+    }
+    return ctx->Forward(this, &output, 1);
+  }
+
+  bool ReduceOperator ::TrySetAtt(const char *n, Att_value_t v)
+  {
+    if (strcmp(n, "axes") == 0)
+    {
+      if (v.ints.n > TENSOR_MAX_DIMENSION)
+      {
+        return false;
+      }
+      this->AxesCount = v.ints.n;
+      for (int i = 0; i != this->AxesCount; i++)
+      {
+        this->Axes[i] = (int)v.ints.v[i];
+      }
+      return true;
+    }
+    if (strcmp(n, "keepdims") == 0)
+    {
+      this->KeepDims = (int)v.i;
+      return true;
+    }
+    if (strcmp(n, "noop_with_empty_axes") == 0)
+    {
+      this->NoopWithEmptyAxes = (int)v.i;
+      return true;
+    }
+    return false;
+  }
+
+  void ReduceOperator ::GetAtts(AttWriter *writer)
+  {
+    Att_value_t v;
+    cm_int64_t axes[TENSOR_MAX_DIMENSION];
+    if (this->AxesCount)
+    {
+      for (int i = 0; i != this->AxesCount; i++)
+      {
+        axes[i] = this->Axes[i];
+      }
+      v.ints.v = axes;
+      v.ints.n = this->AxesCount;
+      writer->Write("axes", AttKind::INTS, v);
+    }
+    v.i = this->KeepDims;
+    writer->Write("keepdims", AttKind::INT, v);
+    v.i = this->NoopWithEmptyAxes;
+    writer->Write("noop_with_empty_axes", AttKind::INT, v);
+  }
+}
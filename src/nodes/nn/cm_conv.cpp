@@ -0,0 +1,1177 @@
+#include <atomic>
+
+#include "cm_engine.hpp"
+#include "math/cm_gemm.hpp"
+#include "math/cm_half.hpp"
+#include "math/cm_simd.hpp"
+#include "nodes/nn/cm_conv.hpp"
+
+using namespace CyanMycelium;
+
+// the 16 positions of a 4x4 Winograd tile.
+#define CONV_WINOGRAD_POSITIONS 16
+
+// the header of the data saved by SavePacked, 16 bytes so the prepared W keeps the alignment of the image.
+struct _ConvPackedHeader
+{
+  int32_t Algorithm;
+  int32_t Reserved[3];
+};
+
+struct _ConvJob
+{
+  ConvGeometry G;
+  const float *X; // X, W and Y are stored as half when W is, see _conv_im2col_chunk
+  const float *W;
+  const float *B; // converted to float when the tensors are half
+  float *Y;
+  const float *Packed; // the W prepared for the algorithm, null to use W as is
+  int TileSize;        // the number of rows (im2col) or tiles (Winograd) unfolded at once
+  int Tiles;           // the number of unfolded blocks per image and group, or of bands of rows per image (grouped)
+  ConvActivation Activation;
+  IMemoryManagerPtr Memory;
+  std::atomic<bool> Failed;
+};
+
+static inline float _activate(float v, ConvActivation activation) { return activation == ConvActivation::RELU ? max(v, 0.0f) : v; }
+
+static inline cm_vfloat_t _vactivate(cm_vfloat_t v, ConvActivation activation) { return activation == ConvActivation::RELU ? cm_vmax(v, cm_vset1(0.0f)) : v; }
+
+// Unfold rows of output pixels into a [rows x Cg.kH.kW] matrix, the columns following the layout of W.
+// x is the first channel of the group, outside the image the values are zero. The half tensors are unfolded as is.
+template <typename T>
+static void _im2row(const ConvGeometry &g, const T *x, int p0, int rows, T *a, int k)
+{
+  int depth = g.Channels / g.Group;
+  for (int r = 0; r != rows; r++)
+  {
+    int oh = (p0 + r) / g.OutWidth;
+    int ow = (p0 + r) % g.OutWidth;
+    T *row = a + (size_t)r * k;
+    for (int c = 0; c != depth; c++)
+    {
+      for (int kh = 0; kh != g.KernelHeight; kh++)
+      {
+        T *dst = row + (c * g.KernelHeight + kh) * g.KernelWidth;
+        int ih = oh * g.StrideH + kh * g.DilationH - g.PadTop;
+        if (ih < 0 || ih >= g.Height)
+        {
+          cm_memset(dst, 0, g.KernelWidth * sizeof(T));
+          continue;
+        }
+        const T *src = x + ((size_t)c * g.Height + ih) * g.Width;
+        int iw = ow * g.StrideW - g.PadLeft;
+        for (int kw = 0; kw != g.KernelWidth; kw++, iw += g.DilationW)
+        {
+          dst[kw] = iw >= 0 && iw < g.Width ? src[iw] : T(0.0f);
+        }
+      }
+    }
+  }
+}
+
+// the product of the unfolded patches by W, or by the W packed at load time when not null.
+static inline bool _conv_gemm(int m, int n, int k, const float *a, const float *w, const float *packed, float *c, const float *bias)
+{
+  if (packed)
+  {
+    cm_sgemm_packed(m, n, k, a, k, packed, c, n, bias, false);
+  }
+  else
+  {
+    cm_sgemm_nt(m, n, k, a, k, w, k, c, n, bias, false);
+  }
+  return true;
+}
+
+static inline bool _conv_gemm(int m, int n, int k, const cm_half_t *a, const cm_half_t *w, const float *packed, float *c, const float *bias)
+{
+  return packed ? cm_hgemm_packed(m, n, k, a, k, packed, c, n, bias, false) : cm_hgemm_nt(m, n, k, a, k, w, k, c, n, bias, false);
+}
+
+static inline bool _conv_gemm(int m, int n, int k, const cm_bfloat16_t *a, const cm_bfloat16_t *w, const float *packed, float *c, const float *bias)
+{
+  return packed ? cm_bgemm_packed(m, n, k, a, k, packed, c, n, bias, false) : cm_bgemm_nt(m, n, k, a, k, w, k, c, n, bias, false);
+}
+
+// a unit is a tile of output pixels of one image and one group: unfold, multiply by W_g then store transposed into NCHW.
+// T is the storage of X, W and Y, the products being computed in float.
+template <typename T>
+static void _conv_im2col_chunk(size_t from, size_t to, void *userData)
+{
+  _ConvJob *job = (_ConvJob *)userData;
+  const ConvGeometry &g = job->G;
+  int depth = g.Channels / g.Group;
+  int features = g.Features / g.Group;
+  int k = depth * g.KernelHeight * g.KernelWidth;
+  int pixels = g.OutHeight * g.OutWidth;
+  size_t packedSize = cm_sgemm_packed_size(features, k);
+
+  // the float products first, so they stay aligned whatever the size of the unfolded patches.
+  float *c = (float *)job->Memory->Malloc((size_t)job->TileSize * (k * sizeof(T) + features * sizeof(float)));
+  if (!c)
+  {
+    job->Failed = true;
+    return;
+  }
+  T *a = (T *)(c + (size_t)job->TileSize * features);
+  const T *x = (const T *)job->X;
+  const T *w = (const T *)job->W;
+  T *y = (T *)job->Y;
+  for (size_t u = from; u != to; u++)
+  {
+    int tile = (int)(u % job->Tiles);
+    int group = (int)(u / job->Tiles % g.Group);
+    int n = (int)(u / job->Tiles / g.Group);
+    int p0 = tile * job->TileSize;
+    int rows = min(job->TileSize, pixels - p0);
+
+    _im2row(g, x + ((size_t)n * g.Channels + (size_t)group * depth) * g.Height * g.Width, p0, rows, a, k);
+    const float *bias = job->B ? job->B + group * features : nullptr;
+    if (!_conv_gemm(rows, features, k, a, w + (size_t)group * features * k, job->Packed ? job->Packed + group * packedSize : nullptr, c, bias))
+    {
+      job->Failed = true;
+      break;
+    }
+    T *yg = y + ((size_t)n * g.Features + (size_t)group * features) * pixels + p0;
+    for (int m = 0; m != features; m++)
+    {
+      T *ym = yg + (size_t)m * pixels;
+      for (int r = 0; r != rows; r++)
+      {
+        ym[r] = T(_activate(c[(size_t)r * features + m], job->Activation));
+      }
+    }
+  }
+  job->Memory->Free(c);
+}
+
+// NV vectors of outputs from ow for NB features, accumulated in registers over the whole window.
+// x is the origin of the window of the output row, the window being inside the row.
+template <int NB, int NV>
+static inline void _conv_direct_vectors(const ConvGeometry &g, const float *x, const float *const *w, const float *bias, ConvActivation activation,
+                                        float *const *y, int ow, int kh0, int kh1, int depth)
+{
+  cm_vfloat_t acc[NB][NV];
+  for (int b = 0; b != NB; b++)
+  {
+    for (int j = 0; j != NV; j++)
+    {
+      acc[b][j] = cm_vset1(bias[b]);
+    }
+  }
+  for (int c = 0; c != depth; c++)
+  {
+    for (int kh = kh0; kh != kh1; kh++)
+    {
+      const float *xr = x + ((size_t)c * g.Height + kh * g.DilationH) * g.Width + ow * g.StrideW;
+      int wi = (c * g.KernelHeight + kh) * g.KernelWidth;
+      for (int kw = 0; kw != g.KernelWidth; kw++, wi++)
+      {
+        const float *xs = xr + kw * g.DilationW;
+        cm_vfloat_t xv[NV];
+        for (int j = 0; j != NV; j++)
+        {
+          if (g.StrideW == 1)
+          {
+            xv[j] = cm_vload(xs + j * CM_SIMD_WIDTH);
+          }
+          else
+          {
+            for (int i = 0; i != CM_SIMD_WIDTH; i++)
+            {
+              xv[j][i] = xs[(j * CM_SIMD_WIDTH + i) * g.StrideW];
+            }
+          }
+        }
+        for (int b = 0; b != NB; b++)
+        {
+          cm_vfloat_t wv = cm_vset1(w[b][wi]);
+          for (int j = 0; j != NV; j++)
+          {
+            acc[b][j] += wv * xv[j];
+          }
+        }
+      }
+    }
+  }
+  for (int b = 0; b != NB; b++)
+  {
+    for (int j = 0; j != NV; j++)
+    {
+      cm_vstore(y[b] + ow + j * CM_SIMD_WIDTH, _vactivate(acc[b][j], activation));
+    }
+  }
+}
+
+template <int NB>
+static int _conv_direct_row(const ConvGeometry &g, const float *x, const float *const *w, const float *bias, ConvActivation activation,
+                            float *const *y, int ow, int end, int kh0, int kh1, int depth)
+{
+  for (; ow + 2 * CM_SIMD_WIDTH <= end; ow += 2 * CM_SIMD_WIDTH)
+  {
+    _conv_direct_vectors<NB, 2>(g, x, w, bias, activation, y, ow, kh0, kh1, depth);
+  }
+  for (; ow + CM_SIMD_WIDTH <= end; ow += CM_SIMD_WIDTH)
+  {
+    _conv_direct_vectors<NB, 1>(g, x, w, bias, activation, y, ow, kh0, kh1, depth);
+  }
+  return ow;
+}
+
+// a unit is an output row of CONV_DIRECT_BLOCK features of one image. The outputs are accumulated by vectors kept in registers
+// over the whole window, every input vector being multiplied by the weights of all the features of the block. The vectors
+// whose window crosses the padding, and the tail of the row, are computed one output at a time.
+static void _conv_direct_chunk(size_t from, size_t to, void *userData)
+{
+  _ConvJob *job = (_ConvJob *)userData;
+  const ConvGeometry &g = job->G;
+  int depth = g.Channels / g.Group;
+  int features = g.Features / g.Group;
+  int blocks = (features + CONV_DIRECT_BLOCK - 1) / CONV_DIRECT_BLOCK;
+  int kernelSize = g.KernelHeight * g.KernelWidth;
+  int extent = (g.KernelWidth - 1) * g.DilationW;
+  // the outputs [inner, innerEnd) read their whole window inside the row.
+  int inner = min(g.OutWidth, (g.PadLeft + g.StrideW - 1) / g.StrideW);
+  int innerEnd = g.Width - extent + g.PadLeft > 0 ? min(g.OutWidth, (g.Width - extent + g.PadLeft - 1) / g.StrideW + 1) : 0;
+  innerEnd = max(inner, innerEnd);
+
+  for (size_t u = from; u != to; u++)
+  {
+    int oh = (int)(u % g.OutHeight);
+    size_t v = u / g.OutHeight;
+    int m0 = (int)(v % blocks) * CONV_DIRECT_BLOCK;
+    v /= blocks;
+    int group = (int)(v % g.Group);
+    int n = (int)(v / g.Group);
+    int count = min(CONV_DIRECT_BLOCK, features - m0);
+    int m = group * features + m0;
+
+    // the rows of the window inside the image.
+    int kh0 = 0;
+    int kh1 = g.KernelHeight;
+    while (kh0 != kh1 && oh * g.StrideH + kh0 * g.DilationH - g.PadTop < 0)
+    {
+      kh0++;
+    }
+    while (kh1 != kh0 && oh * g.StrideH + (kh1 - 1) * g.DilationH - g.PadTop >= g.Height)
+    {
+      kh1--;
+    }
+
+    float *y[CONV_DIRECT_BLOCK];
+    const float *w[CONV_DIRECT_BLOCK];
+    float bias[CONV_DIRECT_BLOCK];
+    for (int b = 0; b != count; b++)
+    {
+      y[b] = job->Y + (((size_t)n * g.Features + m + b) * g.OutHeight + oh) * g.OutWidth;
+      w[b] = job->W + (size_t)(m + b) * depth * kernelSize;
+      bias[b] = job->B ? job->B[m + b] : 0.0f;
+    }
+    const float *x = job->X + ((size_t)n * g.Channels + (size_t)group * depth) * g.Height * g.Width +
+                     (size_t)(oh * g.StrideH - g.PadTop) * g.Width - g.PadLeft;
+
+    // the vectors of the row, then returns the first output left.
+    int ow = inner;
+    switch (count)
+    {
+    case 1:
+      ow = _conv_direct_row<1>(g, x, w, bias, job->Activation, y, ow, innerEnd, kh0, kh1, depth);
+      break;
+    case 2:
+      ow = _conv_direct_row<2>(g, x, w, bias, job->Activation, y, ow, innerEnd, kh0, kh1, depth);
+      break;
+    case 3:
+      ow = _conv_direct_row<3>(g, x, w, bias, job->Activation, y, ow, innerEnd, kh0, kh1, depth);
+      break;
+    default:
+      ow = _conv_direct_row<CONV_DIRECT_BLOCK>(g, x, w, bias, job->Activation, y, ow, innerEnd, kh0, kh1, depth);
+      break;
+    }
+
+    // the borders and the tail, with the columns of the window checked one by one.
+    for (int o = 0; o != g.OutWidth; o++)
+    {
+      if (o == inner)
+      {
+        o = ow;
+        if (o == g.OutWidth)
+        {
+          break;
+        }
+      }
+      float acc[CONV_DIRECT_BLOCK];
+      for (int b = 0; b != count; b++)
+      {
+        acc[b] = bias[b];
+      }
+      for (int c = 0; c != depth; c++)
+      {
+        for (int kh = kh0; kh != kh1; kh++)
+        {
+          const float *xr = x + ((size_t)c * g.Height + kh * g.DilationH) * g.Width + g.PadLeft;
+          int wi = (c * g.KernelHeight + kh) * g.KernelWidth;
+          int iw = o * g.StrideW - g.PadLeft;
+          for (int kw = 0; kw != g.KernelWidth; kw++, wi++, iw += g.DilationW)
+          {
+            if (iw < 0 || iw >= g.Width)
+            {
+              continue;
+            }
+            for (int b = 0; b != count; b++)
+            {
+              acc[b] += w[b][wi] * xr[iw];
+            }
+          }
+        }
+      }
+      for (int b = 0; b != count; b++)
+      {
+        y[b][o] = _activate(acc[b], job->Activation);
+      }
+    }
+  }
+}
+
+// NP pixels of a row from ow for the CM_SIMD_WIDTH output channels of a block, one channel per lane. x is the band of the
+// block gathered by _conv_grouped_chunk, from the first input row of the output row, and w the weights of the block.
+template <int NP>
+static inline void _conv_grouped_pixels(const ConvGeometry &g, const float *x, size_t planeSize, int cols, const float *w, cm_vfloat_t bias,
+                                        ConvActivation activation, float *y, size_t yPlane, int ow, int lanes, int depth)
+{
+  size_t rowSize = (size_t)cols * CM_SIMD_WIDTH;
+  cm_vfloat_t acc[NP];
+  for (int p = 0; p != NP; p++)
+  {
+    acc[p] = bias;
+  }
+  for (int c = 0; c != depth; c++)
+  {
+    for (int kh = 0; kh != g.KernelHeight; kh++)
+    {
+      const float *xr = x + c * planeSize + kh * g.DilationH * rowSize + (size_t)ow * g.StrideW * CM_SIMD_WIDTH;
+      for (int kw = 0; kw != g.KernelWidth; kw++, w += CM_SIMD_WIDTH)
+      {
+        cm_vfloat_t wv = cm_vload(w);
+        const float *xs = xr + (size_t)kw * g.DilationW * CM_SIMD_WIDTH;
+        for (int p = 0; p != NP; p++)
+        {
+          acc[p] += cm_vload(xs + (size_t)p * g.StrideW * CM_SIMD_WIDTH) * wv;
+        }
+      }
+    }
+  }
+  for (int p = 0; p != NP; p++)
+  {
+    acc[p] = _vactivate(acc[p], activation);
+    for (int j = 0; j != lanes; j++)
+    {
+      y[j * yPlane + ow + p] = acc[p][j];
+    }
+  }
+}
+
+// a unit is a band of output rows of one image for a block of CM_SIMD_WIDTH output channels. The input rows read by the band
+// are gathered for every lane from the channels of the group of its output channel, with the padding, so the channels of a
+// pixel are contiguous and the window is read without any test. A depthwise convolution gathers one channel per lane.
+static void _conv_grouped_chunk(size_t from, size_t to, void *userData)
+{
+  _ConvJob *job = (_ConvJob *)userData;
+  const ConvGeometry &g = job->G;
+  int depth = g.Channels / g.Group;
+  int features = g.Features / g.Group;
+  int blocks = (g.Features + CM_SIMD_WIDTH - 1) / CM_SIMD_WIDTH;
+  int kernelSize = g.KernelHeight * g.KernelWidth;
+  // the columns read by an output row, and the rows read by a band, padding included.
+  int cols = (g.OutWidth - 1) * g.StrideW + (g.KernelWidth - 1) * g.DilationW + 1;
+  int rows = (job->TileSize - 1) * g.StrideH + (g.KernelHeight - 1) * g.DilationH + 1;
+  size_t planeSize = (size_t)rows * cols * CM_SIMD_WIDTH;
+  size_t yPlane = (size_t)g.OutHeight * g.OutWidth;
+
+  float *band = (float *)job->Memory->Malloc(depth * planeSize * sizeof(float));
+  if (!band)
+  {
+    job->Failed = true;
+    return;
+  }
+  for (size_t u = from; u != to; u++)
+  {
+    int oh0 = (int)(u % job->Tiles) * job->TileSize;
+    int block = (int)(u / job->Tiles % blocks);
+    int n = (int)(u / job->Tiles / blocks);
+    int ohCount = min(job->TileSize, g.OutHeight - oh0);
+    int rowCount = (ohCount - 1) * g.StrideH + (g.KernelHeight - 1) * g.DilationH + 1;
+    int ih0 = oh0 * g.StrideH - g.PadTop;
+    int m0 = block * CM_SIMD_WIDTH;
+    int lanes = min(CM_SIMD_WIDTH, g.Features - m0);
+
+    cm_vfloat_t bias = cm_vset1(0.0f);
+    for (int j = 0; j != CM_SIMD_WIDTH; j++)
+    {
+      const float *x = j < lanes ? job->X + ((size_t)n * g.Channels + (size_t)((m0 + j) / features) * depth) * g.Height * g.Width : nullptr;
+      bias[j] = x && job->B ? job->B[m0 + j] : 0.0f;
+      for (int c = 0; c != depth; c++)
+      {
+        for (int r = 0; r != rowCount; r++)
+        {
+          float *dst = band + c * planeSize + (size_t)r * cols * CM_SIMD_WIDTH + j;
+          int ih = ih0 + r;
+          if (!x || ih < 0 || ih >= g.Height)
+          {
+            for (int i = 0; i != cols; i++)
+            {
+              dst[i * CM_SIMD_WIDTH] = 0.0f;
+            }
+            continue;
+          }
+          const float *src = x + ((size_t)c * g.Height + ih) * g.Width - g.PadLeft;
+          int first = min(cols, g.PadLeft);
+          int last = max(first, min(cols, g.Width + g.PadLeft));
+          for (int i = 0; i != first; i++)
+          {
+            dst[i * CM_SIMD_WIDTH] = 0.0f;
+          }
+          for (int i = first; i != last; i++)
+          {
+            dst[i * CM_SIMD_WIDTH] = src[i];
+          }
+          for (int i = last; i != cols; i++)
+          {
+            dst[i * CM_SIMD_WIDTH] = 0.0f;
+          }
+        }
+      }
+    }
+
+    const float *w = job->Packed + (size_t)block * depth * kernelSize * CM_SIMD_WIDTH;
+    for (int oh = 0; oh != ohCount; oh++)
+    {
+      const float *x = band + (size_t)oh * g.StrideH * cols * CM_SIMD_WIDTH;
+      float *y = job->Y + ((size_t)n * g.Features + m0) * yPlane + (size_t)(oh0 + oh) * g.OutWidth;
+      int ow = 0;
+      for (; ow + CONV_GROUPED_PIXELS <= g.OutWidth; ow += CONV_GROUPED_PIXELS)
+      {
+        _conv_grouped_pixels<CONV_GROUPED_PIXELS>(g, x, planeSize, cols, w, bias, job->Activation, y, yPlane, ow, lanes, depth);
+      }
+      for (; ow != g.OutWidth; ow++)
+      {
+        _conv_grouped_pixels<1>(g, x, planeSize, cols, w, bias, job->Activation, y, yPlane, ow, lanes, depth);
+      }
+    }
+  }
+  job->Memory->Free(band);
+}
+
+// U = G.g.Gt, the 3x3 kernel g into the 4x4 Winograd domain.
+static void _winograd_kernel(const float *g, float *u)
+{
+  float t[4][3];
+  for (int j = 0; j != 3; j++)
+  {
+    t[0][j] = g[j];
+    t[1][j] = 0.5f * (g[j] + g[3 + j] + g[6 + j]);
+    t[2][j] = 0.5f * (g[j] - g[3 + j] + g[6 + j]);
+    t[3][j] = g[6 + j];
+  }
+  for (int i = 0; i != 4; i++)
+  {
+    u[i * 4 + 0] = t[i][0];
+    u[i * 4 + 1] = 0.5f * (t[i][0] + t[i][1] + t[i][2]);
+    u[i * 4 + 2] = 0.5f * (t[i][0] - t[i][1] + t[i][2]);
+    u[i * 4 + 3] = t[i][2];
+  }
+}
+
+// V = Bt.d.B, the 4x4 input tile d into the Winograd domain.
+static inline void _winograd_input(const float *d, float *v)
+{
+  float t[16];
+  for (int j = 0; j != 4; j++)
+  {
+    t[j] = d[j] - d[8 + j];
+    t[4 + j] = d[4 + j] + d[8 + j];
+    t[8 + j] = d[8 + j] - d[4 + j];
+    t[12 + j] = d[4 + j] - d[12 + j];
+  }
+  for (int i = 0; i != 4; i++)
+  {
+    const float *r = t + i * 4;
+    v[i * 4 + 0] = r[0] - r[2];
+    v[i * 4 + 1] = r[1] + r[2];
+    v[i * 4 + 2] = r[2] - r[1];
+    v[i * 4 + 3] = r[1] - r[3];
+  }
+}
+
+// Y = At.m.A, the 4x4 product m back into a 2x2 output tile.
+static inline void _winograd_output(const float *m, float *y)
+{
+  float t[8];
+  for (int j = 0; j != 4; j++)
+  {
+    t[j] = m[j] + m[4 + j] + m[8 + j];
+    t[4 + j] = m[4 + j] - m[8 + j] - m[12 + j];
+  }
+  for (int i = 0; i != 2; i++)
+  {
+    const float *r = t + i * 4;
+    y[i * 2 + 0] = r[0] + r[1] + r[2];
+    y[i * 2 + 1] = r[1] - r[2] - r[3];
+  }
+}
+
+// a unit is a block of 2x2 output tiles of one image and one group. The input tiles are transformed into 16 matrices
+// [tiles x Cg], each multiplied by its transformed W [Mg x Cg], then the products are transformed back into the outputs.
+static void _conv_winograd_chunk(size_t from, size_t to, void *userData)
+{
+  _ConvJob *job = (_ConvJob *)userData;
+  const ConvGeometry &g = job->G;
+  int depth = g.Channels / g.Group;
+  int features = g.Features / g.Group;
+  int tilesW = (g.OutWidth + 1) / 2;
+  int tiles = tilesW * ((g.OutHeight + 1) / 2);
+  size_t packedSize = cm_sgemm_packed_size(features, depth);
+  size_t vSize = (size_t)job->TileSize * depth;
+  size_t mSize = (size_t)job->TileSize * features;
+
+  float *v = (float *)job->Memory->Malloc(CONV_WINOGRAD_POSITIONS * (vSize + mSize) * sizeof(float));
+  if (!v)
+  {
+    job->Failed = true;
+    return;
+  }
+  float *p = v + CONV_WINOGRAD_POSITIONS * vSize;
+  for (size_t u = from; u != to; u++)
+  {
+    int block = (int)(u % job->Tiles);
+    int group = (int)(u / job->Tiles % g.Group);
+    int n = (int)(u / job->Tiles / g.Group);
+    int t0 = block * job->TileSize;
+    int count = min(job->TileSize, tiles - t0);
+    const float *x = job->X + ((size_t)n * g.Channels + (size_t)group * depth) * g.Height * g.Width;
+
+    for (int t = 0; t != count; t++)
+    {
+      int ih0 = (t0 + t) / tilesW * 2 - g.PadTop;
+      int iw0 = (t0 + t) % tilesW * 2 - g.PadLeft;
+      bool inside = ih0 >= 0 && iw0 >= 0 && ih0 + 4 <= g.Height && iw0 + 4 <= g.Width;
+      for (int c = 0; c != depth; c++)
+      {
+        const float *xc = x + (size_t)c * g.Height * g.Width;
+        float d[16], vt[16];
+        for (int i = 0; i != 4; i++)
+        {
+          int ih = ih0 + i;
+          for (int j = 0; j != 4; j++)
+          {
+            int iw = iw0 + j;
+            d[i * 4 + j] = inside || (ih >= 0 && ih < g.Height && iw >= 0 && iw < g.Width) ? xc[(size_t)ih * g.Width + iw] : 0.0f;
+          }
+        }
+        _winograd_input(d, vt);
+        float *vc = v + (size_t)t * depth + c;
+        for (int i = 0; i != CONV_WINOGRAD_POSITIONS; i++)
+        {
+          vc[i * vSize] = vt[i];
+        }
+      }
+    }
+
+    const float *packed = job->Packed + (size_t)group * CONV_WINOGRAD_POSITIONS * packedSize;
+    for (int i = 0; i != CONV_WINOGRAD_POSITIONS; i++)
+    {
+      cm_sgemm_packed(count, features, depth, v + i * vSize, depth, packed + i * packedSize, p + i * mSize, features, nullptr, false);
+    }
+
+    float *y = job->Y + ((size_t)n * g.Features + (size_t)group * features) * g.OutHeight * g.OutWidth;
+    for (int t = 0; t != count; t++)
+    {
+      int oh = (t0 + t) / tilesW * 2;
+      int ow = (t0 + t) % tilesW * 2;
+      int rows = min(2, g.OutHeight - oh);
+      int cols = min(2, g.OutWidth - ow);
+      for (int m = 0; m != features; m++)
+      {
+        const float *pm = p + (size_t)t * features + m;
+        float mt[16], yt[4];
+        for (int i = 0; i != CONV_WINOGRAD_POSITIONS; i++)
+        {
+          mt[i] = pm[i * mSize];
+        }
+        _winograd_output(mt, yt);
+        float bias = job->B ? job->B[group * features + m] : 0.0f;
+        float *ym = y + ((size_t)m * g.OutHeight + oh) * g.OutWidth + ow;
+        for (int i = 0; i != rows; i++)
+        {
+          for (int j = 0; j != cols; j++)
+          {
+            ym[(size_t)i * g.OutWidth + j] = _activate(yt[i * 2 + j] + bias, job->Activation);
+          }
+        }
+      }
+    }
+  }
+  job->Memory->Free(v);
+}
+
+Conv ::~Conv()
+{
+  if (!this->_packedExternal)
+  {
+    cm_free(this->_packed);
+  }
+}
+
+bool Conv ::GetGeometry(TensorInfos *x, TensorInfos *w, ConvGeometry *g)
+{
+  if ((w->Type != TDT_FLOAT && !cm_is_half(w->Type)) || w->Dimension < 3 || w->Dimension > 2 + CONV_MAX_SPATIAL_RANK || this->Group < 1 ||
+      (x && (x->Type != w->Type || x->Dimension != w->Dimension)))
+  {
+    return false;
+  }
+  int rank = w->Dimension - 2;
+  if ((this->KernelRank && this->KernelRank != rank) || (this->StrideCount && this->StrideCount != rank) ||
+      (this->DilationCount && this->DilationCount != rank) || (this->PadCount && this->PadCount != 2 * rank))
+  {
+    return false;
+  }
+  int features = (int)w->Shape[0];
+  int depth = (int)w->Shape[1];
+  if (features < 1 || depth < 1 || features % this->Group)
+  {
+    return false;
+  }
+  if (x && x->Shape[1] != (uint64_t)depth * this->Group)
+  {
+    return false;
+  }
+
+  // a 1D convolution is a 2D one of height 1, so the spatial axes are aligned on the width.
+  int kernel[CONV_MAX_SPATIAL_RANK] = {1, 1};
+  int stride[CONV_MAX_SPATIAL_RANK] = {1, 1};
+  int dilation[CONV_MAX_SPATIAL_RANK] = {1, 1};
+  int begin[CONV_MAX_SPATIAL_RANK] = {0, 0};
+  int end[CONV_MAX_SPATIAL_RANK] = {0, 0};
+  int in[CONV_MAX_SPATIAL_RANK] = {1, 1};
+  int out[CONV_MAX_SPATIAL_RANK] = {1, 1};
+  for (int a = 0; a != rank; a++)
+  {
+    int i = CONV_MAX_SPATIAL_RANK - rank + a;
+    kernel[i] = (int)w->Shape[2 + a];
+    stride[i] = this->StrideCount ? this->Strides[a] : 1;
+    dilation[i] = this->DilationCount ? this->Dilations[a] : 1;
+    if (kernel[i] < 1 || stride[i] < 1 || dilation[i] < 1 || (this->KernelRank && this->KernelShape[a] != kernel[i]))
+    {
+      return false;
+    }
+    begin[i] = this->PadCount ? this->Pads[a] : 0;
+    end[i] = this->PadCount ? this->Pads[rank + a] : 0;
+    if (begin[i] < 0 || end[i] < 0)
+    {
+      return false;
+    }
+    // only W is known.
+    if (!x)
+    {
+      in[i] = out[i] = 0;
+      continue;
+    }
+    in[i] = (int)x->Shape[2 + a];
+    int extent = (kernel[i] - 1) * dilation[i] + 1;
+    switch (this->AutoPad)
+    {
+    case ConvAutoPad::SAME_UPPER:
+    case ConvAutoPad::SAME_LOWER:
+    {
+      // the output keeps ceil(in / stride) values, the extra padding goes to the end for SAME_UPPER.
+      out[i] = (in[i] + stride[i] - 1) / stride[i];
+      int total = max(0, (out[i] - 1) * stride[i] + extent - in[i]);
+      begin[i] = this->AutoPad == ConvAutoPad::SAME_UPPER ? total / 2 : total - total / 2;
+      end[i] = total - begin[i];
+      break;
+    }
+    case ConvAutoPad::VALID:
+      begin[i] = end[i] = 0;
+      out[i] = in[i] >= extent ? (in[i] - extent) / stride[i] + 1 : 0;
+      break;
+    default:
+      out[i] = in[i] + begin[i] + end[i] >= extent ? (in[i] + begin[i] + end[i] - extent) / stride[i] + 1 : 0;
+      break;
+    }
+    if (out[i] < 1)
+    {
+      return false;
+    }
+  }
+
+  g->Rank = rank;
+  g->Batch = x ? (int)x->Shape[0] : 0;
+  g->Channels = depth * this->Group;
+  g->Height = in[0];
+  g->Width = in[1];
+  g->Features = features;
+  g->KernelHeight = kernel[0];
+  g->KernelWidth = kernel[1];
+  g->Group = this->Group;
+  g->StrideH = stride[0];
+  g->StrideW = stride[1];
+  g->DilationH = dilation[0];
+  g->DilationW = dilation[1];
+  g->PadTop = begin[0];
+  g->PadLeft = begin[1];
+  g->PadBottom = end[0];
+  g->PadRight = end[1];
+  g->OutHeight = out[0];
+  g->OutWidth = out[1];
+  return true;
+}
+
+ConvAlgorithm Conv ::Choose(ConvGeometry *g, ConvAlgorithm requested)
+{
+  int depth = g->Channels / g->Group;
+  int features = g->Features / g->Group;
+  bool winograd = g->KernelHeight == 3 && g->KernelWidth == 3 && g->StrideH == 1 && g->StrideW == 1 && g->DilationH == 1 && g->DilationW == 1;
+  if (requested == ConvAlgorithm::IM2COL || requested == ConvAlgorithm::DIRECT || (requested == ConvAlgorithm::WINOGRAD && winograd) ||
+      (requested == ConvAlgorithm::GROUPED && g->Group > 1))
+  {
+    return requested;
+  }
+  // depthwise and narrow groups over 2D windows: a GEMM per group would be too small to pay for its unfolding, while
+  // the vectors of the direct kernel would hold a single output channel.
+  if (g->Group > 1 && features <= CONV_GROUPED_MAX_FEATURES && g->KernelHeight > 1)
+  {
+    return ConvAlgorithm::GROUPED;
+  }
+  // few multiply-adds per output: the unfolding would cost as much as the product. A strided row is gathered by the
+  // direct kernel, which is then slower than the unfolding.
+  if (g->StrideW == 1 && depth * g->KernelHeight * g->KernelWidth <= CONV_DIRECT_MAX_DEPTH)
+  {
+    return ConvAlgorithm::DIRECT;
+  }
+  if (winograd && depth >= CONV_WINOGRAD_MIN_CHANNELS && features >= CONV_WINOGRAD_MIN_CHANNELS)
+  {
+    return ConvAlgorithm::WINOGRAD;
+  }
+  return ConvAlgorithm::IM2COL;
+}
+
+size_t Conv ::_getPackedSize(ConvGeometry *g, ConvAlgorithm algorithm)
+{
+  int depth = g->Channels / g->Group;
+  int features = g->Features / g->Group;
+  switch (algorithm)
+  {
+  case ConvAlgorithm::IM2COL:
+    return g->Group * cm_sgemm_packed_size(features, depth * g->KernelHeight * g->KernelWidth);
+  case ConvAlgorithm::WINOGRAD:
+    return (size_t)g->Group * CONV_WINOGRAD_POSITIONS * cm_sgemm_packed_size(features, depth);
+  case ConvAlgorithm::GROUPED:
+    return (size_t)(g->Features + CM_SIMD_WIDTH - 1) / CM_SIMD_WIDTH * depth * g->KernelHeight * g->KernelWidth * CM_SIMD_WIDTH;
+  default:
+    return 0;
+  }
+}
+
+bool Conv ::Prepack()
+{
+  if (!this->_hasInput(CONV_W_INDEX))
+  {
+    return true;
+  }
+  Tensor *w = this->Opsc[CONV_W_INDEX]->GetPayloadInfos();
+  ConvGeometry g;
+  // the shape of W is unknown until the runtime, Activate chooses the algorithm on every call.
+  if (w->IsDynamic() || !this->GetGeometry(nullptr, w, &g))
+  {
+    return true;
+  }
+  // the half tensors are only unfolded by im2col.
+  this->Algorithm = cm_is_half(w->Type) ? ConvAlgorithm::IM2COL : Conv::Choose(&g, this->Algorithm);
+  size_t size = _getPackedSize(&g, this->Algorithm);
+  // W is a runtime input, or the algorithm reads it as is.
+  if (!w->Data || !size)
+  {
+    return true;
+  }
+  this->_packed = (float *)cm_malloc(size * sizeof(float));
+  if (!this->_packed)
+  {
+    return false;
+  }
+
+  int depth = g.Channels / g.Group;
+  int features = g.Features / g.Group;
+  const float *wData = (const float *)w->Data;
+  if (this->Algorithm == ConvAlgorithm::IM2COL)
+  {
+    int k = depth * g.KernelHeight * g.KernelWidth;
+    size_t packedSize = cm_sgemm_packed_size(features, k);
+    // a half W is packed as floats, converted one group at a time.
+    float *converted = cm_is_half(w->Type) ? (float *)cm_malloc((size_t)features * k * sizeof(float)) : nullptr;
+    if (cm_is_half(w->Type) && !converted)
+    {
+      return false;
+    }
+    for (int group = 0; group != g.Group; group++)
+    {
+      const float *wg = wData + (size_t)group * features * k;
+      if (converted)
+      {
+        cm_to_float(w->Type, (const cm_byte_t *)w->Data + (size_t)group * features * k * sizeof(cm_half_t), converted, (size_t)features * k);
+        wg = converted;
+      }
+      cm_sgemm_pack_b(features, k, wg, k, this->_packed + group * packedSize);
+    }
+    cm_free(converted);
+    return true;
+  }
+
+  if (this->Algorithm == ConvAlgorithm::GROUPED)
+  {
+    // [blocks][Cg][kH][kW][CM_SIMD_WIDTH], the weights of the output channels of a block interleaved, zero for the missing ones.
+    int kernelSize = depth * g.KernelHeight * g.KernelWidth;
+    float *p = this->_packed;
+    for (int m0 = 0; m0 < g.Features; m0 += CM_SIMD_WIDTH)
+    {
+      for (int k = 0; k != kernelSize; k++)
+      {
+        for (int j = 0; j != CM_SIMD_WIDTH; j++)
+        {
+          *p++ = m0 + j < g.Features ? wData[(size_t)(m0 + j) * kernelSize + k] : 0.0f;
+        }
+      }
+    }
+    return true;
+  }
+
+  // Winograd: every [Mg x Cg] matrix of a position is gathered from the transformed kernels, then packed.
+  size_t matrixSize = (size_t)features * depth;
+  size_t packedSize = cm_sgemm_packed_size(features, depth);
+  float *u = (float *)cm_malloc(CONV_WINOGRAD_POSITIONS * matrixSize * sizeof(float));
+  if (!u)
+  {
+    return false;
+  }
+  for (int group = 0; group != g.Group; group++)
+  {
+    for (size_t i = 0; i != matrixSize; i++)
+    {
+      float ut[CONV_WINOGRAD_POSITIONS];
+      _winograd_kernel(wData + ((size_t)group * matrixSize + i) * 9, ut);
+      for (int p = 0; p != CONV_WINOGRAD_POSITIONS; p++)
+      {
+        u[p * matrixSize + i] = ut[p];
+      }
+    }
+    for (int p = 0; p != CONV_WINOGRAD_POSITIONS; p++)
+    {
+      cm_sgemm_pack_b(features, depth, u + p * matrixSize, depth, this->_packed + ((size_t)group * CONV_WINOGRAD_POSITIONS + p) * packedSize);
+    }
+  }
+  cm_free(u);
+  return true;
+}
+
+size_t Conv ::SavePacked(void *buffer)
+{
+  if (this->Algorithm == ConvAlgorithm::AUTO || !this->_hasInput(CONV_W_INDEX))
+  {
+    return 0;
+  }
+  ConvGeometry g;
+  if (!this->GetGeometry(nullptr, this->Opsc[CONV_W_INDEX]->GetPayloadInfos(), &g))
+  {
+    return 0;
+  }
+  // the algorithm is saved even without prepared W, so a forced choice survives the image.
+  size_t size = this->_packed ? _getPackedSize(&g, this->Algorithm) * sizeof(float) : 0;
+  if (buffer)
+  {
+    _ConvPackedHeader *header = (_ConvPackedHeader *)buffer;
+    cm_memset(header, 0, sizeof(_ConvPackedHeader));
+    header->Algorithm = (int32_t)this->Algorithm;
+    if (size)
+    {
+      cm_memcpy(header + 1, this->_packed, size);
+    }
+  }
+  return sizeof(_ConvPackedHeader) + size;
+}
+
+bool Conv ::LoadPacked(const void *data, size_t size)
+{
+  if (!this->_hasInput(CONV_W_INDEX) || this->_packed || size < sizeof(_ConvPackedHeader))
+  {
+    return false;
+  }
+  ConvGeometry g;
+  Tensor *w = this->Opsc[CONV_W_INDEX]->GetPayloadInfos();
+  if (w->IsDynamic() || !this->GetGeometry(nullptr, w, &g))
+  {
+    return false;
+  }
+  const _ConvPackedHeader *header = (const _ConvPackedHeader *)data;
+  ConvAlgorithm algorithm = (ConvAlgorithm)header->Algorithm;
+  if (Conv::Choose(&g, algorithm) != algorithm || (cm_is_half(w->Type) && algorithm != ConvAlgorithm::IM2COL))
+  {
+    return false;
+  }
+  size -= sizeof(_ConvPackedHeader);
+  if (size && size != _getPackedSize(&g, algorithm) * sizeof(float))
+  {
+    return false;
+  }
+  this->Algorithm = algorithm;
+  this->_packed = size ? (float *)(header + 1) : nullptr;
+  this->_packedExternal = true;
+  return true;
+}
+
+bool Conv ::InferShapes(Tensor **infos)
+{
+  if (!this->_hasInput(CONV_W_INDEX))
+  {
+    return false;
+  }
+  Tensor *x = this->_inferredInput(infos, CONV_X_INDEX);
+  Tensor *w = this->_inferredInput(infos, CONV_W_INDEX);
+  Tensor *b = this->_inferredInput(infos, CONV_B_INDEX);
+  ConvGeometry g;
+  if (!x || !this->GetGeometry(x, w, &g) || (b && (b->Type != w->Type || b->Count != (size_t)g.Features)))
+  {
+    return false;
+  }
+  // Y is [N, M, (oH,) oW].
+  uint64_t shape[2 + CONV_MAX_SPATIAL_RANK] = {x->Shape[0], (uint64_t)g.Features, (uint64_t)g.OutHeight, (uint64_t)g.OutWidth};
+  if (g.Rank == 1)
+  {
+    shape[2] = (uint64_t)g.OutWidth;
+  }
+  return this->_inferOutput(infos, 0, shape, 2 + g.Rank, x->Type);
+}
+
+bool Conv ::Activate(ActivationContext *ctx)
+{
+  if (!this->_hasInput(CONV_W_INDEX))
+  {
+    return false;
+  }
+  Tensor *x = this->_getValue(ctx, CONV_X_INDEX);
+  Tensor *w = this->_getValue(ctx, CONV_W_INDEX);
+  Tensor *b = this->Opsc.Count() > CONV_B_INDEX ? this->_getValue(ctx, CONV_B_INDEX) : nullptr;
+  if (!x || !w)
+  {
+    return false;
+  }
+  _ConvJob job;
+  ConvGeometry &g = job.G;
+  if (!this->GetGeometry(x, w, &g) || !g.Batch || !g.OutHeight || !g.OutWidth ||
+      (b && (b->Type != w->Type || b->Count != (size_t)g.Features)))
+  {
+    return false;
+  }
+  tensor_data_type_t type = w->Type;
+  ConvAlgorithm algorithm = cm_is_half(type) ? ConvAlgorithm::IM2COL : Conv::Choose(&g, this->Algorithm);
+  // Winograd and the grouped kernel need the prepared W, which is only prepared for the initializers.
+  if (algorithm == ConvAlgorithm::WINOGRAD && !this->_packed)
+  {
+    algorithm = ConvAlgorithm::IM2COL;
+  }
+  if (algorithm == ConvAlgorithm::GROUPED && !this->_packed)
+  {
+    algorithm = ConvAlgorithm::DIRECT;
+  }
+
+  uint64_t shape[2 + CONV_MAX_SPATIAL_RANK] = {(uint64_t)g.Batch, (uint64_t)g.Features, (uint64_t)g.OutHeight, (uint64_t)g.OutWidth};
+  if (g.Rank == 1)
+  {
+    shape[2] = (uint64_t)g.OutWidth;
+  }
+  TensorRefPtr output = ctx->CreateOutputRef(this, shape, 2 + g.Rank, type);
+  if (!output)
+  {
+    return false;
+  }
+
+  InferenceEngine *engine = ctx->GetEngine();
+  job.X = (const float *)x->Data;
+  job.W = (const float *)w->Data;
+  job.B = b ? (const float *)b->Data : nullptr;
+  job.Y = (float *)output->Value.Data;
+  job.Packed = this->_packed;
+  job.Activation = this->Activation;
+  job.Memory = engine->GetMemoryManager();
+  job.Failed = false;
+  // the bias is added to the float products.
+  float *bias = nullptr;
+  if (b && cm_is_half(type))
+  {
+    bias = (float *)job.Memory->Malloc(g.Features * sizeof(float));
+    if (!bias)
+    {
+      ctx->DiscardOutputRef(output);
+      return false;
+    }
+    cm_to_float(type, b->Data, bias, g.Features);
+    job.B = bias;
+  }
+
+  int depth = g.Channels / g.Group;
+  int features = g.Features / g.Group;
+  size_t units = (size_t)g.Batch * g.Group;
+  switch (algorithm)
+  {
+  case ConvAlgorithm::DIRECT:
+  {
+    int blocks = (features + CONV_DIRECT_BLOCK - 1) / CONV_DIRECT_BLOCK;
+    size_t rowSize = (size_t)depth * g.KernelHeight * g.KernelWidth * g.OutWidth * CONV_DIRECT_BLOCK * sizeof(float);
+    engine->ParallelFor(units * blocks * g.OutHeight, rowSize, _conv_direct_chunk, &job);
+    break;
+  }
+  case ConvAlgorithm::GROUPED:
+  {
+    // bands of output rows, the input rows they read fitting the tile.
+    int blocks = (g.Features + CM_SIMD_WIDTH - 1) / CM_SIMD_WIDTH;
+    size_t rowSize = (size_t)depth * ((g.OutWidth - 1) * g.StrideW + (g.KernelWidth - 1) * g.DilationW + 1) * CM_SIMD_WIDTH * sizeof(float);
+    int rows = (int)(CONV_TILE_SIZE / rowSize) - (g.KernelHeight - 1) * g.DilationH - 1;
+    job.TileSize = max(1, min(g.OutHeight, rows / g.StrideH + 1));
+    job.Tiles = (g.OutHeight + job.TileSize - 1) / job.TileSize;
+    engine->ParallelFor((size_t)g.Batch * blocks * job.Tiles, (size_t)job.TileSize * g.OutWidth * depth * g.KernelHeight * g.KernelWidth * CM_SIMD_WIDTH * sizeof(float),
+                        _conv_grouped_chunk, &job);
+    break;
+  }
+  case ConvAlgorithm::WINOGRAD:
+  {
+    int tiles = ((g.OutHeight + 1) / 2) * ((g.OutWidth + 1) / 2);
+    job.TileSize = max(1, min(tiles, (int)(CONV_TILE_SIZE / (CONV_WINOGRAD_POSITIONS * depth * sizeof(float)))));
+    job.Tiles = (tiles + job.TileSize - 1) / job.TileSize;
+    engine->ParallelFor(units * job.Tiles, (size_t)job.TileSize * CONV_WINOGRAD_POSITIONS * depth * sizeof(float), _conv_winograd_chunk, &job);
+    break;
+  }
+  default:
+  {
+    int pixels = g.OutHeight * g.OutWidth;
+    int k = depth * g.KernelHeight * g.KernelWidth;
+    job.TileSize = max(1, min(pixels, (int)(CONV_TILE_SIZE / (k * sizeof(float)))));
+    job.Tiles = (pixels + job.TileSize - 1) / job.TileSize;
+    ParallelForFunction chunk = type == TDT_FLOAT16 ? _conv_im2col_chunk<cm_half_t> : type == TDT_BFLOAT16 ? _conv_im2col_chunk<cm_bfloat16_t>
+                                                                                                              : _conv_im2col_chunk<float>;
+    engine->ParallelFor(units * job.Tiles, (size_t)job.TileSize * k * sizeof(float), chunk, &job);
+    break;
+  }
+  }
+  if (bias)
+  {
+    job.Memory->Free(bias);
+  }
+
+  if (job.Failed)
+  {
+    ctx->DiscardOutputRef(output);
+    return false;
+  }
+  return ctx->Forward(this, &output, 1);
+}
+
+bool Conv ::TrySetAtt(const char *n, Att_value_t v)
+{
+  int *values = nullptr;
+  int *count = nullptr;
+  int capacity = CONV_MAX_SPATIAL_RANK;
+  if (strcmp(n, "group") == 0)
+  {
+    this->Group = (int)v.i;
+    return true;
+  }
+  if (strcmp(n, "auto_pad") == 0)
+  {
+    this->AutoPad = strcmp(v.s, "SAME_UPPER") == 0 ? ConvAutoPad::SAME_UPPER : strcmp(v.s, "SAME_LOWER") == 0 ? ConvAutoPad::SAME_LOWER
+                                                                         : strcmp(v.s, "VALID") == 0        ? ConvAutoPad::VALID
+                                                                                                             : ConvAutoPad::NOTSET;
+    return true;
+  }
+  if (strcmp(n, "activation") == 0)
+  {
+    this->Activation = strcmp(v.s, "Relu") == 0 ? ConvActivation::RELU : ConvActivation::NONE;
+    return true;
+  }
+  if (strcmp(n, "kernel_shape") == 0)
+  {
+    values = this->KernelShape;
+    count = &this->KernelRank;
+  }
+  else if (strcmp(n, "strides") == 0)
+  {
+    values = this->Strides;
+    count = &this->StrideCount;
+  }
+  else if (strcmp(n, "dilations") == 0)
+  {
+    values = this->Dilations;
+    count = &this->DilationCount;
+  }
+  else if (strcmp(n, "pads") == 0)
+  {
+    values = this->Pads;
+    count = &this->PadCount;
+    capacity = 2 * CONV_MAX_SPATIAL_RANK;
+  }
+  if (values)
+  {
+    // more axes than supported are kept as a count, so GetGeometry rejects them.
+    *count = v.ints.n;
+    for (int i = 0; i < min(v.ints.n, capacity); i++)
+    {
+      values[i] = (int)v.ints.v[i];
+    }
+  }
+  return true;
+}
+
+void Conv ::GetAtts(AttWriter *writer)
+{
+  Att_value_t v;
+  cm_int64_t values[2 * CONV_MAX_SPATIAL_RANK];
+  const char *names[4] = {"kernel_shape", "strides", "dilations", "pads"};
+  const int *arrays[4] = {this->KernelShape, this->Strides, this->Dilations, this->Pads};
+  int counts[4] = {this->KernelRank, this->StrideCount, this->DilationCount, this->PadCount};
+  int capacities[4] = {CONV_MAX_SPATIAL_RANK, CONV_MAX_SPATIAL_RANK, CONV_MAX_SPATIAL_RANK, 2 * CONV_MAX_SPATIAL_RANK};
+
+  v.i = this->Group;
+  writer->Write("group", AttKind::INT, v);
+  for (int a = 0; a != 4; a++)
+  {
+    if (!counts[a] || counts[a] > capacities[a])
+    {
+      continue;
+    }
+    for (int i = 0; i != counts[a]; i++)
+    {
+      values[i] = arrays[a][i];
+    }
+    v.ints.v = values;
+    v.ints.n = counts[a];
+    writer->Write(names[a], AttKind::INTS, v);
+  }
+  if (this->AutoPad != ConvAutoPad::NOTSET)
+  {
+    v.s = this->AutoPad == ConvAutoPad::SAME_UPPER ? "SAME_UPPER" : this->AutoPad == ConvAutoPad::SAME_LOWER ? "SAME_LOWER"
+                                                                                                            : "VALID";
+    writer->Write("auto_pad", AttKind::STRING, v);
+  }
+  if (this->Activation == ConvActivation::RELU)
+  {
+    v.s = "Relu";
+    writer->Write("activation", AttKind::STRING, v);
+  }
+}
+
+bool Conv ::Fuse(Operator *next)
+{
+  if (this->Activation != ConvActivation::NONE || !next->TypeName || strcmp(next->TypeName, "Relu") != 0)
+  {
+    return false;
+  }
+  this->Activation = ConvActivation::RELU;
+  return true;
+}
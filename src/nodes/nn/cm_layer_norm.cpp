@@ -0,0 +1,237 @@
+#include <cmath>
+
+#include "cm_engine.hpp"
+#include "math/cm_simd.hpp"
+#include "nodes/nn/cm_layer_norm.hpp"
+
+using namespace CyanMycelium;
+
+// number of float items accumulated by a SIMD lane before being flushed into the double sums of a row.
+#define LAYER_NORM_BLOCK_SIZE 1024
+
+struct _LayerNormJob
+{
+  const float *X;
+  float *Y;
+  const float *Scale;
+  const float *B;
+  float *Mean;      // null when the mean is not linked
+  float *InvStdDev; // null when the inverse standard deviation is not linked
+  size_t N;
+  float Epsilon;
+};
+
+// the first pass: the sums of d and d * d, d being x shifted by its first item. The shift brings the items close to the
+// mean, so the variance is not lost into the cancellation of two large sums.
+static void _layer_norm_sums(const float *x, size_t n, float shift, double *s1, double *s2)
+{
+  const cm_vfloat_t vs = cm_vset1(shift);
+  size_t last = n - n % CM_SIMD_WIDTH;
+  size_t i = 0;
+  *s1 = 0;
+  *s2 = 0;
+  while (i != last)
+  {
+    cm_vfloat_t a1 = {};
+    cm_vfloat_t a2 = {};
+    size_t end = min(last, i + LAYER_NORM_BLOCK_SIZE);
+    for (; i != end; i += CM_SIMD_WIDTH)
+    {
+      cm_vfloat_t d = cm_vload(x + i) - vs;
+      a1 += d;
+      a2 += d * d;
+    }
+    *s1 += cm_vsum(a1);
+    *s2 += cm_vsum(a2);
+  }
+  for (; i != n; i++)
+  {
+    double d = (double)x[i] - shift;
+    *s1 += d;
+    *s2 += d * d;
+  }
+}
+
+// the second pass: y = (x - mean) * inv * scale + b.
+template <bool SCALE, bool BIAS>
+static void _layer_norm_write(const float *x, float *y, size_t n, float mean, float inv, const float *scale, const float *b)
+{
+  const cm_vfloat_t vm = cm_vset1(mean);
+  const cm_vfloat_t vi = cm_vset1(inv);
+  size_t i = 0;
+  for (; i + CM_SIMD_WIDTH <= n; i += CM_SIMD_WIDTH)
+  {
+    cm_vfloat_t v = (cm_vload(x + i) - vm) * vi;
+    if (SCALE)
+    {
+      v *= cm_vload(scale + i);
+    }
+    if (BIAS)
+    {
+      v += cm_vload(b + i);
+    }
+    cm_vstore(y + i, v);
+  }
+  for (; i != n; i++)
+  {
+    float v = (x[i] - mean) * inv;
+    y[i] = (SCALE ? v * scale[i] : v) + (BIAS ? b[i] : 0.0f);
+  }
+}
+
+template <bool SCALE, bool BIAS>
+static void _layer_norm_chunk(size_t from, size_t to, void *userData)
+{
+  _LayerNormJob *job = (_LayerNormJob *)userData;
+  size_t n = job->N;
+  for (size_t r = from; r != to; r++)
+  {
+    const float *x = job->X + r * n;
+    double s1, s2;
+    _layer_norm_sums(x, n, x[0], &s1, &s2);
+    double m = s1 / n;
+    double var = s2 / n - m * m;
+    float mean = (float)(x[0] + m);
+    float inv = (float)(1.0 / sqrt((var > 0 ? var : 0.0) + job->Epsilon));
+    _layer_norm_write<SCALE, BIAS>(x, job->Y + r * n, n, mean, inv, job->Scale, job->B);
+    if (job->Mean)
+    {
+      job->Mean[r] = mean;
+    }
+    if (job->InvStdDev)
+    {
+      job->InvStdDev[r] = inv;
+    }
+  }
+}
+
+bool LayerNormalization ::_getRows(Tensor *x, size_t *rows, size_t *size, uint64_t *statShape)
+{
+  int axis = this->Axis < 0 ? this->Axis + x->Dimension : this->Axis;
+  if (axis < 0 || axis >= x->Dimension)
+  {
+    return false;
+  }
+  *rows = 1;
+  *size = 1;
+  for (int d = 0; d != x->Dimension; d++)
+  {
+    *(d < axis ? rows : size) *= (size_t)x->Shape[d];
+    statShape[d] = d < axis ? x->Shape[d] : 1;
+  }
+  return true;
+}
+
+bool LayerNormalization ::InferShapes(Tensor **infos)
+{
+  if (this->Opsc.Count() <= LAYER_NORM_X_INDEX)
+  {
+    return false;
+  }
+  Tensor *x = this->_inferredInput(infos, LAYER_NORM_X_INDEX);
+  size_t rows, size;
+  uint64_t statShape[TENSOR_MAX_DIMENSION];
+  if (!this->_getRows(x, &rows, &size, statShape))
+  {
+    return false;
+  }
+  // the scale and the bias hold one item per normalized item.
+  for (int i = LAYER_NORM_SCALE_INDEX; i <= LAYER_NORM_B_INDEX; i++)
+  {
+    Tensor *t = this->_inferredInput(infos, i);
+    if (t && !x->IsDynamic() && !t->IsDynamic() && t->Count != size)
+    {
+      return false;
+    }
+  }
+  return this->_inferOutput(infos, LAYER_NORM_Y_INDEX, x->Shape, x->Dimension, x->Type) &&
+         this->_inferOutput(infos, LAYER_NORM_MEAN_INDEX, statShape, x->Dimension, TDT_FLOAT) &&
+         this->_inferOutput(infos, LAYER_NORM_INV_STD_DEV_INDEX, statShape, x->Dimension, TDT_FLOAT);
+}
+
+bool LayerNormalization ::Activate(ActivationContext *ctx)
+{
+  if (this->Opsc.Count() <= LAYER_NORM_X_INDEX)
+  {
+    return false;
+  }
+  Tensor *x = this->_getValue(ctx, LAYER_NORM_X_INDEX);
+  Tensor *scale = this->_getValue(ctx, LAYER_NORM_SCALE_INDEX);
+  Tensor *b = this->_getValue(ctx, LAYER_NORM_B_INDEX);
+  _LayerNormJob job;
+  size_t rows;
+  uint64_t statShape[TENSOR_MAX_DIMENSION];
+  if (!x || x->Type != TDT_FLOAT || !this->_getRows(x, &rows, &job.N, statShape))
+  {
+    return false;
+  }
+  if ((scale && (scale->Type != TDT_FLOAT || scale->Count != job.N)) || (b && (b->Type != TDT_FLOAT || b->Count != job.N)))
+  {
+    return false;
+  }
+
+  // the statistics are only computed when they are linked.
+  int outputCount = min(this->Onsc.Count(), LAYER_NORM_INV_STD_DEV_INDEX + 1);
+  TensorRefPtr outputs[LAYER_NORM_INV_STD_DEV_INDEX + 1] = {nullptr, nullptr, nullptr};
+  for (int i = 0; i != outputCount; i++)
+  {
+    outputs[i] = ctx->CreateOutputRef(this, i == LAYER_NORM_Y_INDEX ? x->Shape : statShape, x->Dimension, TDT_FLOAT, outputCount > 1 ? i : -1);
+    if (!outputs[i])
+    {
+      goto _error;
+    }
+  }
+
+  job.X = (const float *)x->Data;
+  job.Y = (float *)outputs[LAYER_NORM_Y_INDEX]->Value.Data;
+  job.Scale = scale ? (const float *)scale->Data : nullptr;
+  job.B = b ? (const float *)b->Data : nullptr;
+  job.Mean = outputs[LAYER_NORM_MEAN_INDEX] ? (float *)outputs[LAYER_NORM_MEAN_INDEX]->Value.Data : nullptr;
+  job.InvStdDev = outputs[LAYER_NORM_INV_STD_DEV_INDEX] ? (float *)outputs[LAYER_NORM_INV_STD_DEV_INDEX]->Value.Data : nullptr;
+  job.Epsilon = this->Epsilon;
+  if (rows && job.N)
+  {
+    ParallelForFunction fn = scale ? (b ? _layer_norm_chunk<true, true> : _layer_norm_chunk<true, false>)
+                                   : (b ? _layer_norm_chunk<false, true> : _layer_norm_chunk<false, false>);
+    ctx->GetEngine()->ParallelFor(rows, job.N * sizeof(float), fn, &job);
+  }
+  return ctx->Forward(this, outputs, outputCount);
+
+_error:
+  for (int i = 0; i != outputCount; i++)
+  {
+    ctx->DiscardOutputRef(outputs[i]);
+  }
+  return false;
+}
+
+bool LayerNormalization ::TrySetAtt(const char *n, Att_value_t v)
+{
+  if (strcmp(n, "axis") == 0)
+  {
+    this->Axis = (int)v.i;
+    return true;
+  }
+  if (strcmp(n, "epsilon") == 0)
+  {
+    this->Epsilon = v.f;
+    return true;
+  }
+  if (strcmp(n, "stash_type") == 0)
+  {
+    this->StashType = (int)v.i;
+    return true;
+  }
+  return true;
+}
+
+void LayerNormalization ::GetAtts(AttWriter *writer)
+{
+  Att_value_t v;
+  v.i = this->Axis;
+  writer->Write("axis", AttKind::INT, v);
+  v.f = this->Epsilon;
+  writer->Write("epsilon", AttKind::FLOAT, v);
+  v.i = this->StashType;
+  writer->Write("stash_type", AttKind::INT, v);
+}
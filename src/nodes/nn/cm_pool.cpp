@@ -0,0 +1,565 @@
+#include <atomic>
+#include <limits>
+
+#include "cm_engine.hpp"
+#include "math/cm_simd.hpp"
+#include "nodes/nn/cm_pool.hpp"
+
+using namespace CyanMycelium;
+
+struct _PoolJob
+{
+  ConvGeometry G;
+  PoolKind Kind;
+  int CountIncludePad;
+  int StorageOrder;
+  const float *X;
+  float *Y;
+  cm_int64_t *Indices; // null when the indices are not requested
+  int TileSize;        // the number of output rows of a band
+  int Tiles;           // the number of bands per plane
+  IMemoryManagerPtr Memory;
+  std::atomic<bool> Failed;
+};
+
+// the number of taps of a window starting at start which fall into [lo, hi).
+static inline int _pool_count(int start, int kernel, int dilation, int lo, int hi)
+{
+  int count = 0;
+  for (int t = 0; t != kernel; t++)
+  {
+    int i = start + t * dilation;
+    count += i >= lo && i < hi;
+  }
+  return count;
+}
+
+// NP consecutive output pixels of an output row over the CM_SIMD_WIDTH planes of a block, x being the band gathered by
+// _pool_chunk from the first input row of the output row. For the average, counts holds the divisor of every pixel of the row.
+template <bool MAX, int NP>
+static inline void _pool_pixels(const ConvGeometry &g, const float *x, int cols, const float *counts, float *y, size_t yPlane, int ow, int lanes)
+{
+  size_t rowSize = (size_t)cols * CM_SIMD_WIDTH;
+  cm_vfloat_t acc[NP];
+  for (int p = 0; p != NP; p++)
+  {
+    acc[p] = cm_vset1(MAX ? -std::numeric_limits<float>::infinity() : 0.0f);
+  }
+  for (int kh = 0; kh != g.KernelHeight; kh++)
+  {
+    const float *xr = x + kh * g.DilationH * rowSize + (size_t)ow * g.StrideW * CM_SIMD_WIDTH;
+    for (int kw = 0; kw != g.KernelWidth; kw++)
+    {
+      const float *xs = xr + (size_t)kw * g.DilationW * CM_SIMD_WIDTH;
+      for (int p = 0; p != NP; p++)
+      {
+        cm_vfloat_t v = cm_vload(xs + (size_t)p * g.StrideW * CM_SIMD_WIDTH);
+        acc[p] = MAX ? cm_vmax(acc[p], v) : acc[p] + v;
+      }
+    }
+  }
+  for (int p = 0; p != NP; p++)
+  {
+    if (!MAX)
+    {
+      acc[p] *= cm_vset1(counts[ow + p] ? 1.0f / counts[ow + p] : 0.0f);
+    }
+    for (int j = 0; j != lanes; j++)
+    {
+      y[j * yPlane + ow + p] = acc[p][j];
+    }
+  }
+}
+
+// a unit is a band of output rows for a block of CM_SIMD_WIDTH planes. The input rows read by the band are gathered with
+// their padding into [row][col][lane], the padding being -inf for the max and 0 for the average.
+static void _pool_chunk(size_t from, size_t to, void *userData)
+{
+  _PoolJob *job = (_PoolJob *)userData;
+  const ConvGeometry &g = job->G;
+  bool isMax = job->Kind == PoolKind::MAX;
+  float pad = isMax ? -std::numeric_limits<float>::infinity() : 0.0f;
+  int planes = g.Batch * g.Channels;
+  int cols = (g.OutWidth - 1) * g.StrideW + (g.KernelWidth - 1) * g.DilationW + 1;
+  int rows = (job->TileSize - 1) * g.StrideH + (g.KernelHeight - 1) * g.DilationH + 1;
+  size_t xPlane = (size_t)g.Height * g.Width;
+  size_t yPlane = (size_t)g.OutHeight * g.OutWidth;
+
+  // the band, then the number of taps counted by every column, then the divisors of an output row.
+  float *band = (float *)job->Memory->Malloc(((size_t)rows * cols * CM_SIMD_WIDTH + 2 * g.OutWidth) * sizeof(float));
+  if (!band)
+  {
+    job->Failed = true;
+    return;
+  }
+  float *colCounts = band + (size_t)rows * cols * CM_SIMD_WIDTH;
+  float *counts = colCounts + g.OutWidth;
+  int lo = job->CountIncludePad ? -g.PadLeft : 0;
+  int hi = job->CountIncludePad ? g.Width + g.PadRight : g.Width;
+  for (int ow = 0; ow != g.OutWidth; ow++)
+  {
+    colCounts[ow] = (float)_pool_count(ow * g.StrideW - g.PadLeft, g.KernelWidth, g.DilationW, lo, hi);
+  }
+  lo = job->CountIncludePad ? -g.PadTop : 0;
+  hi = job->CountIncludePad ? g.Height + g.PadBottom : g.Height;
+
+  for (size_t u = from; u != to; u++)
+  {
+    int oh0 = (int)(u % job->Tiles) * job->TileSize;
+    int p0 = (int)(u / job->Tiles) * CM_SIMD_WIDTH;
+    int ohCount = min(job->TileSize, g.OutHeight - oh0);
+    int rowCount = (ohCount - 1) * g.StrideH + (g.KernelHeight - 1) * g.DilationH + 1;
+    int ih0 = oh0 * g.StrideH - g.PadTop;
+    int lanes = min(CM_SIMD_WIDTH, planes - p0);
+
+    for (int j = 0; j != CM_SIMD_WIDTH; j++)
+    {
+      const float *x = j < lanes ? job->X + (size_t)(p0 + j) * xPlane : nullptr;
+      for (int r = 0; r != rowCount; r++)
+      {
+        float *dst = band + (size_t)r * cols * CM_SIMD_WIDTH + j;
+        int ih = ih0 + r;
+        if (!x || ih < 0 || ih >= g.Height)
+        {
+          for (int i = 0; i != cols; i++)
+          {
+            dst[i * CM_SIMD_WIDTH] = pad;
+          }
+          continue;
+        }
+        const float *src = x + (size_t)ih * g.Width - g.PadLeft;
+        int first = min(cols, g.PadLeft);
+        int last = max(first, min(cols, g.Width + g.PadLeft));
+        for (int i = 0; i != first; i++)
+        {
+          dst[i * CM_SIMD_WIDTH] = pad;
+        }
+        for (int i = first; i != last; i++)
+        {
+          dst[i * CM_SIMD_WIDTH] = src[i];
+        }
+        for (int i = last; i != cols; i++)
+        {
+          dst[i * CM_SIMD_WIDTH] = pad;
+        }
+      }
+    }
+
+    for (int oh = 0; oh != ohCount; oh++)
+    {
+      const float *x = band + (size_t)oh * g.StrideH * cols * CM_SIMD_WIDTH;
+      float *y = job->Y + (size_t)p0 * yPlane + (size_t)(oh0 + oh) * g.OutWidth;
+      int ow = 0;
+      if (isMax)
+      {
+        for (; ow + POOL_PIXELS <= g.OutWidth; ow += POOL_PIXELS)
+        {
+          _pool_pixels<true, POOL_PIXELS>(g, x, cols, counts, y, yPlane, ow, lanes);
+        }
+        for (; ow != g.OutWidth; ow++)
+        {
+          _pool_pixels<true, 1>(g, x, cols, counts, y, yPlane, ow, lanes);
+        }
+        continue;
+      }
+      float rowCount = (float)_pool_count((oh0 + oh) * g.StrideH - g.PadTop, g.KernelHeight, g.DilationH, lo, hi);
+      for (int i = 0; i != g.OutWidth; i++)
+      {
+        counts[i] = rowCount * colCounts[i];
+      }
+      for (; ow + POOL_PIXELS <= g.OutWidth; ow += POOL_PIXELS)
+      {
+        _pool_pixels<false, POOL_PIXELS>(g, x, cols, counts, y, yPlane, ow, lanes);
+      }
+      for (; ow != g.OutWidth; ow++)
+      {
+        _pool_pixels<false, 1>(g, x, cols, counts, y, yPlane, ow, lanes);
+      }
+    }
+  }
+  job->Memory->Free(band);
+}
+
+// MaxPool with its indices, a unit being a plane. The index is the first of the maximum, flattened over the whole input.
+static void _maxpool_indices_chunk(size_t from, size_t to, void *userData)
+{
+  _PoolJob *job = (_PoolJob *)userData;
+  const ConvGeometry &g = job->G;
+  size_t xPlane = (size_t)g.Height * g.Width;
+  size_t yPlane = (size_t)g.OutHeight * g.OutWidth;
+  for (size_t p = from; p != to; p++)
+  {
+    const float *x = job->X + p * xPlane;
+    float *y = job->Y + p * yPlane;
+    cm_int64_t *indices = job->Indices + p * yPlane;
+    for (int oh = 0; oh != g.OutHeight; oh++)
+    {
+      for (int ow = 0; ow != g.OutWidth; ow++)
+      {
+        float best = -std::numeric_limits<float>::infinity();
+        cm_int64_t index = -1;
+        for (int kh = 0; kh != g.KernelHeight; kh++)
+        {
+          int ih = oh * g.StrideH + kh * g.DilationH - g.PadTop;
+          if (ih < 0 || ih >= g.Height)
+          {
+            continue;
+          }
+          for (int kw = 0; kw != g.KernelWidth; kw++)
+          {
+            int iw = ow * g.StrideW + kw * g.DilationW - g.PadLeft;
+            if (iw < 0 || iw >= g.Width || !(x[(size_t)ih * g.Width + iw] > best || index < 0))
+            {
+              continue;
+            }
+            best = x[(size_t)ih * g.Width + iw];
+            index = job->StorageOrder ? (cm_int64_t)iw * g.Height + ih : (cm_int64_t)ih * g.Width + iw;
+          }
+        }
+        y[(size_t)oh * g.OutWidth + ow] = best;
+        indices[(size_t)oh * g.OutWidth + ow] = index < 0 ? -1 : (cm_int64_t)(p * xPlane) + index;
+      }
+    }
+  }
+}
+
+bool PoolOperator ::GetGeometry(TensorInfos *x, ConvGeometry *g)
+{
+  if (x->Type != TDT_FLOAT || x->Dimension < 3 || x->Dimension > 2 + CONV_MAX_SPATIAL_RANK)
+  {
+    return false;
+  }
+  int rank = x->Dimension - 2;
+  if (this->KernelRank != rank || (this->StrideCount && this->StrideCount != rank) || (this->DilationCount && this->DilationCount != rank) ||
+      (this->PadCount && this->PadCount != 2 * rank))
+  {
+    return false;
+  }
+
+  // a 1D pool is a 2D one of height 1, so the spatial axes are aligned on the width.
+  int kernel[CONV_MAX_SPATIAL_RANK] = {1, 1};
+  int stride[CONV_MAX_SPATIAL_RANK] = {1, 1};
+  int dilation[CONV_MAX_SPATIAL_RANK] = {1, 1};
+  int begin[CONV_MAX_SPATIAL_RANK] = {0, 0};
+  int end[CONV_MAX_SPATIAL_RANK] = {0, 0};
+  int in[CONV_MAX_SPATIAL_RANK] = {1, 1};
+  int out[CONV_MAX_SPATIAL_RANK] = {1, 1};
+  for (int a = 0; a != rank; a++)
+  {
+    int i = CONV_MAX_SPATIAL_RANK - rank + a;
+    kernel[i] = this->KernelShape[a];
+    stride[i] = this->StrideCount ? this->Strides[a] : 1;
+    dilation[i] = this->DilationCount ? this->Dilations[a] : 1;
+    begin[i] = this->PadCount ? this->Pads[a] : 0;
+    end[i] = this->PadCount ? this->Pads[rank + a] : 0;
+    in[i] = (int)x->Shape[2 + a];
+    if (kernel[i] < 1 || stride[i] < 1 || dilation[i] < 1 || begin[i] < 0 || end[i] < 0 || in[i] < 1)
+    {
+      return false;
+    }
+    int extent = (kernel[i] - 1) * dilation[i] + 1;
+    switch (this->AutoPad)
+    {
+    case ConvAutoPad::SAME_UPPER:
+    case ConvAutoPad::SAME_LOWER:
+    {
+      // the output keeps ceil(in / stride) values, the extra padding goes to the end for SAME_UPPER.
+      out[i] = (in[i] + stride[i] - 1) / stride[i];
+      int total = max(0, (out[i] - 1) * stride[i] + extent - in[i]);
+      begin[i] = this->AutoPad == ConvAutoPad::SAME_UPPER ? total / 2 : total - total / 2;
+      end[i] = total - begin[i];
+      continue;
+    }
+    case ConvAutoPad::VALID:
+      begin[i] = end[i] = 0;
+      break;
+    default:
+      break;
+    }
+    int span = in[i] + begin[i] + end[i] - extent;
+    if (span < 0)
+    {
+      return false;
+    }
+    out[i] = (this->CeilMode ? (span + stride[i] - 1) / stride[i] : span / stride[i]) + 1;
+    // rounded up, the last window must still start into the input or its beginning padding.
+    if (this->CeilMode && (out[i] - 1) * stride[i] >= in[i] + begin[i])
+    {
+      out[i]--;
+    }
+  }
+
+  g->Rank = rank;
+  g->Batch = (int)x->Shape[0];
+  g->Channels = g->Features = g->Group = (int)x->Shape[1];
+  g->Height = in[0];
+  g->Width = in[1];
+  g->KernelHeight = kernel[0];
+  g->KernelWidth = kernel[1];
+  g->StrideH = stride[0];
+  g->StrideW = stride[1];
+  g->DilationH = dilation[0];
+  g->DilationW = dilation[1];
+  g->PadTop = begin[0];
+  g->PadLeft = begin[1];
+  g->PadBottom = end[0];
+  g->PadRight = end[1];
+  g->OutHeight = out[0];
+  g->OutWidth = out[1];
+  return true;
+}
+
+bool PoolOperator ::InferShapes(Tensor **infos)
+{
+  if (this->Opsc.Count() <= POOL_X_INDEX)
+  {
+    return false;
+  }
+  Tensor *x = this->_inferredInput(infos, POOL_X_INDEX);
+  ConvGeometry g;
+  if (!this->GetGeometry(x, &g))
+  {
+    return false;
+  }
+  // Y and the indices are [N, C, (oH,) oW].
+  uint64_t shape[2 + CONV_MAX_SPATIAL_RANK] = {x->Shape[0], x->Shape[1], (uint64_t)g.OutHeight, (uint64_t)g.OutWidth};
+  if (g.Rank == 1)
+  {
+    shape[2] = (uint64_t)g.OutWidth;
+  }
+  return this->_inferOutput(infos, POOL_Y_INDEX, shape, 2 + g.Rank, TDT_FLOAT) &&
+         (this->_kind != PoolKind::MAX || this->_inferOutput(infos, POOL_INDICES_INDEX, shape, 2 + g.Rank, TDT_INT64));
+}
+
+bool PoolOperator ::Activate(ActivationContext *ctx)
+{
+  if (this->Opsc.Count() <= POOL_X_INDEX)
+  {
+    return false;
+  }
+  Tensor *x = this->_getValue(ctx, POOL_X_INDEX);
+  if (!x)
+  {
+    return false;
+  }
+  _PoolJob job;
+  ConvGeometry &g = job.G;
+  if (!this->GetGeometry(x, &g) || !g.Batch || !g.Channels)
+  {
+    return false;
+  }
+
+  uint64_t shape[2 + CONV_MAX_SPATIAL_RANK] = {(uint64_t)g.Batch, (uint64_t)g.Channels, (uint64_t)g.OutHeight, (uint64_t)g.OutWidth};
+  if (g.Rank == 1)
+  {
+    shape[2] = (uint64_t)g.OutWidth;
+  }
+  // the indices are only computed when they are linked.
+  bool indices = this->_kind == PoolKind::MAX && this->Onsc.Count() > POOL_INDICES_INDEX;
+  int outputCount = indices ? 2 : 1;
+  TensorRefPtr outputs[2] = {nullptr, nullptr};
+  for (int i = 0; i != outputCount; i++)
+  {
+    outputs[i] = ctx->CreateOutputRef(this, shape, 2 + g.Rank, i == POOL_Y_INDEX ? TDT_FLOAT : TDT_INT64, indices ? i : -1);
+    if (!outputs[i])
+    {
+      goto _error;
+    }
+  }
+
+  {
+    InferenceEngine *engine = ctx->GetEngine();
+    job.Kind = this->_kind;
+    job.CountIncludePad = this->CountIncludePad;
+    job.StorageOrder = this->StorageOrder;
+    job.X = (const float *)x->Data;
+    job.Y = (float *)outputs[POOL_Y_INDEX]->Value.Data;
+    job.Indices = indices ? (cm_int64_t *)outputs[POOL_INDICES_INDEX]->Value.Data : nullptr;
+    job.Memory = engine->GetMemoryManager();
+    job.Failed = false;
+
+    size_t planes = (size_t)g.Batch * g.Channels;
+    if (indices)
+    {
+      engine->ParallelFor(planes, (size_t)g.Height * g.Width * sizeof(float), _maxpool_indices_chunk, &job);
+    }
+    else
+    {
+      // bands of output rows, the input rows they read fitting the tile.
+      size_t blocks = (planes + CM_SIMD_WIDTH - 1) / CM_SIMD_WIDTH;
+      size_t rowSize = (size_t)((g.OutWidth - 1) * g.StrideW + (g.KernelWidth - 1) * g.DilationW + 1) * CM_SIMD_WIDTH * sizeof(float);
+      int rows = (int)(POOL_TILE_SIZE / rowSize) - (g.KernelHeight - 1) * g.DilationH - 1;
+      job.TileSize = max(1, min(g.OutHeight, rows / g.StrideH + 1));
+      job.Tiles = (g.OutHeight + job.TileSize - 1) / job.TileSize;
+      engine->ParallelFor(blocks * job.Tiles, (size_t)job.TileSize * g.OutWidth * g.KernelHeight * g.KernelWidth * CM_SIMD_WIDTH * sizeof(float),
+                          _pool_chunk, &job);
+    }
+    if (!job.Failed)
+    {
+      return ctx->Forward(this, outputs, outputCount);
+    }
+  }
+
+_error:
+  for (int i = 0; i != outputCount; i++)
+  {
+    ctx->DiscardOutputRef(outputs[i]);
+  }
+  return false;
+}
+
+bool PoolOperator ::TrySetAtt(const char *n, Att_value_t v)
+{
+  int *values = nullptr;
+  int *count = nullptr;
+  int capacity = CONV_MAX_SPATIAL_RANK;
+  if (strcmp(n, "auto_pad") == 0)
+  {
+    this->AutoPad = strcmp(v.s, "SAME_UPPER") == 0 ? ConvAutoPad::SAME_UPPER : strcmp(v.s, "SAME_LOWER") == 0 ? ConvAutoPad::SAME_LOWER
+                                                                         : strcmp(v.s, "VALID") == 0        ? ConvAutoPad::VALID
+                                                                                                             : ConvAutoPad::NOTSET;
+    return true;
+  }
+  if (strcmp(n, "ceil_mode") == 0)
+  {
+    this->CeilMode = (int)v.i;
+    return true;
+  }
+  if (strcmp(n, "count_include_pad") == 0)
+  {
+    this->CountIncludePad = (int)v.i;
+    return true;
+  }
+  if (strcmp(n, "storage_order") == 0)
+  {
+    this->StorageOrder = (int)v.i;
+    return true;
+  }
+  if (strcmp(n, "kernel_shape") == 0)
+  {
+    values = this->KernelShape;
+    count = &this->KernelRank;
+  }
+  else if (strcmp(n, "strides") == 0)
+  {
+    values = this->Strides;
+    count = &this->StrideCount;
+  }
+  else if (strcmp(n, "dilations") == 0)
+  {
+    values = this->Dilations;
+    count = &this->DilationCount;
+  }
+  else if (strcmp(n, "pads") == 0)
+  {
+    values = this->Pads;
+    count = &this->PadCount;
+    capacity = 2 * CONV_MAX_SPATIAL_RANK;
+  }
+  if (values)
+  {
+    // more axes than supported are kept as a count, so GetGeometry rejects them.
+    *count = v.ints.n;
+    for (int i = 0; i < min(v.ints.n, capacity); i++)
+    {
+      values[i] = (int)v.ints.v[i];
+    }
+  }
+  return true;
+}
+
+void PoolOperator ::GetAtts(AttWriter *writer)
+{
+  Att_value_t v;
+  cm_int64_t values[2 * CONV_MAX_SPATIAL_RANK];
+  const char *names[4] = {"kernel_shape", "strides", "dilations", "pads"};
+  const int *arrays[4] = {this->KernelShape, this->Strides, this->Dilations, this->Pads};
+  int counts[4] = {this->KernelRank, this->StrideCount, this->DilationCount, this->PadCount};
+  int capacities[4] = {CONV_MAX_SPATIAL_RANK, CONV_MAX_SPATIAL_RANK, CONV_MAX_SPATIAL_RANK, 2 * CONV_MAX_SPATIAL_RANK};
+
+  for (int a = 0; a != 4; a++)
+  {
+    if (!counts[a] || counts[a] > capacities[a])
+    {
+      continue;
+    }
+    for (int i = 0; i != counts[a]; i++)
+    {
+      values[i] = arrays[a][i];
+    }
+    v.ints.v = values;
+    v.ints.n = counts[a];
+    writer->Write(names[a], AttKind::INTS, v);
+  }
+  if (this->AutoPad != ConvAutoPad::NOTSET)
+  {
+    v.s = this->AutoPad == ConvAutoPad::SAME_UPPER ? "SAME_UPPER" : this->AutoPad == ConvAutoPad::SAME_LOWER ? "SAME_LOWER"
+                                                                                                            : "VALID";
+    writer->Write("auto_pad", AttKind::STRING, v);
+  }
+  v.i = this->CeilMode;
+  writer->Write("ceil_mode", AttKind::INT, v);
+  if (this->_kind == PoolKind::AVERAGE)
+  {
+    v.i = this->CountIncludePad;
+    writer->Write("count_include_pad", AttKind::INT, v);
+  }
+  else
+  {
+    v.i = this->StorageOrder;
+    writer->Write("storage_order", AttKind::INT, v);
+  }
+}
+
+bool GlobalPoolOperator ::_getReducedShape(Tensor *x, bool *reduced, uint64_t *shape)
+{
+  if (x->Dimension < 3)
+  {
+    return false;
+  }
+  for (int d = 0; d != x->Dimension; d++)
+  {
+    reduced[d] = d >= 2;
+    shape[d] = reduced[d] ? 1 : x->Shape[d];
+  }
+  return true;
+}
+
+bool GlobalPoolOperator ::InferShapes(Tensor **infos)
+{
+  if (this->Opsc.Count() <= POOL_X_INDEX)
+  {
+    return false;
+  }
+  Tensor *x = this->_inferredInput(infos, POOL_X_INDEX);
+  bool reduced[TENSOR_MAX_DIMENSION];
+  uint64_t shape[TENSOR_MAX_DIMENSION];
+  return this->_getReducedShape(x, reduced, shape) && this->_inferOutput(infos, POOL_Y_INDEX, shape, x->Dimension, x->Type);
+}
+
+bool GlobalPoolOperator ::Activate(ActivationContext *ctx)
+{
+  if (this->Opsc.Count() <= POOL_X_INDEX)
+  {
+    return false;
+  }
+  Tensor *x = this->_getValue(ctx, POOL_X_INDEX);
+  bool reduced[TENSOR_MAX_DIMENSION];
+  uint64_t shape[TENSOR_MAX_DIMENSION];
+  if (!x || !this->_getReducedShape(x, reduced, shape))
+  {
+    return false;
+  }
+  TensorRefPtr output = ctx->CreateOutputRef(this, shape, x->Dimension, x->Type);
+  if (!output)
+  {
+    return false;
+  }
+  // [N, C, H, W] is planned as the rows [N x C, H x W], reduced by the contiguous kernel.
+  if (!Reduce(ctx, this->_kind, x, reduced, &output->Value))
+  {
+    ctx->DiscardOutputRef(output);
+    return false;
+  }
+  return ctx->Forward(this, &output, 1);
+}
@@ -0,0 +1,325 @@
+#include <cmath>
+
+#include "cm_engine.hpp"
+#include "math/cm_vmath.hpp"
+#include "nodes/nn/cm_softmax.hpp"
+
+using namespace CyanMycelium;
+
+// number of exponentials summed in float before being flushed into the double sum of a row.
+#define SOFTMAX_BLOCK_SIZE 1024
+
+// the [outer, n, inner] view of the input, with the rows of n items spaced by inner.
+struct _SoftmaxJob
+{
+  const float *X;
+  float *Y;
+  size_t N;
+  size_t Inner;
+  size_t Tiles; // the number of column tiles of an outer slice, when inner > 1
+  bool Log;
+};
+
+// the first pass: the maximum of n contiguous items, over two independent accumulators.
+static float _softmax_max(const float *x, size_t n)
+{
+  const size_t step = 2 * CM_SIMD_WIDTH;
+  cm_vfloat_t a0 = cm_vset1(-INFINITY);
+  cm_vfloat_t a1 = a0;
+  size_t i = 0;
+  for (; i + step <= n; i += step)
+  {
+    a0 = cm_vmax(a0, cm_vload(x + i));
+    a1 = cm_vmax(a1, cm_vload(x + i + CM_SIMD_WIDTH));
+  }
+  a0 = cm_vmax(a0, a1);
+  float m = a0[0];
+  for (int l = 1; l != CM_SIMD_WIDTH; l++)
+  {
+    m = a0[l] > m ? a0[l] : m;
+  }
+  for (; i != n; i++)
+  {
+    m = x[i] > m ? x[i] : m;
+  }
+  return m;
+}
+
+// the second pass: the sum of exp(x - m) over n contiguous items, also stored into y when y is given.
+// The exponentials are lower than 1, so the float partial sums of a block keep their precision.
+static double _softmax_exp(const float *x, float *y, size_t n, float m)
+{
+  const cm_vfloat_t vm = cm_vset1(m);
+  double total = 0;
+  size_t i = 0;
+  while (i + CM_SIMD_WIDTH <= n)
+  {
+    size_t end = min(n - n % CM_SIMD_WIDTH, i + SOFTMAX_BLOCK_SIZE);
+    cm_vfloat_t sum = cm_vset1(0.0f);
+    for (; i != end; i += CM_SIMD_WIDTH)
+    {
+      cm_vfloat_t e = cm_vexp(cm_vload(x + i) - vm);
+      if (y)
+      {
+        cm_vstore(y + i, e);
+      }
+      sum += e;
+    }
+    for (int l = 0; l != CM_SIMD_WIDTH; l++)
+    {
+      total += sum[l];
+    }
+  }
+  if (i != n)
+  {
+    // the lanes beyond n hold exp(-m), only the n - i first ones are summed.
+    cm_vfloat_t e = cm_vexp(cm_vload_partial(x + i, n - i) - vm);
+    if (y)
+    {
+      cm_vstore_partial(y + i, e, n - i);
+    }
+    for (size_t l = 0; l != n - i; l++)
+    {
+      total += e[l];
+    }
+  }
+  return total;
+}
+
+// y = x * a + b over n contiguous items, which scales the exponentials (a = 1 / sum, b = 0) or shifts the logits
+// (a = 1, b = -max - log(sum)).
+static void _softmax_affine(const float *x, float *y, size_t n, float a, float b)
+{
+  const cm_vfloat_t va = cm_vset1(a);
+  const cm_vfloat_t vb = cm_vset1(b);
+  size_t i = 0;
+  for (; i + CM_SIMD_WIDTH <= n; i += CM_SIMD_WIDTH)
+  {
+    cm_vstore(y + i, cm_vload(x + i) * va + vb);
+  }
+  for (; i != n; i++)
+  {
+    y[i] = x[i] * a + b;
+  }
+}
+
+static void _softmax_row(const float *x, float *y, size_t n, bool log)
+{
+  float m = _softmax_max(x, n);
+  if (log)
+  {
+    double sum = _softmax_exp(x, nullptr, n, m);
+    _softmax_affine(x, y, n, 1.0f, (float)(-m - std::log(sum)));
+    return;
+  }
+  double sum = _softmax_exp(x, y, n, m);
+  _softmax_affine(y, y, n, (float)(1.0 / sum), 0.0f);
+}
+
+// the same passes over tw consecutive columns of the n rows spaced by inner, so every row is read as a contiguous
+// segment and the maximums and sums of the columns stay in L1.
+static void _softmax_tile(const float *x, float *y, size_t n, size_t inner, size_t tw, bool log)
+{
+  float m[SOFTMAX_TILE_SIZE];
+  float s[SOFTMAX_TILE_SIZE];
+  size_t vw = tw - tw % CM_SIMD_WIDTH;
+  for (size_t j = 0; j != tw; j++)
+  {
+    m[j] = -INFINITY;
+    s[j] = 0;
+  }
+  for (size_t r = 0; r != n; r++)
+  {
+    const float *row = x + r * inner;
+    size_t j = 0;
+    for (; j != vw; j += CM_SIMD_WIDTH)
+    {
+      cm_vstore(m + j, cm_vmax(cm_vload(m + j), cm_vload(row + j)));
+    }
+    for (; j != tw; j++)
+    {
+      m[j] = row[j] > m[j] ? row[j] : m[j];
+    }
+  }
+  for (size_t r = 0; r != n; r++)
+  {
+    const float *row = x + r * inner;
+    float *out = y + r * inner;
+    size_t j = 0;
+    for (; j != vw; j += CM_SIMD_WIDTH)
+    {
+      cm_vfloat_t e = cm_vexp(cm_vload(row + j) - cm_vload(m + j));
+      if (!log)
+      {
+        cm_vstore(out + j, e);
+      }
+      cm_vstore(s + j, cm_vload(s + j) + e);
+    }
+    if (j != tw)
+    {
+      // only the tw - j first lanes are stored, the others are computed from the zeros of the partial loads.
+      cm_vfloat_t e = cm_vexp(cm_vload_partial(row + j, tw - j) - cm_vload_partial(m + j, tw - j));
+      if (!log)
+      {
+        cm_vstore_partial(out + j, e, tw - j);
+      }
+      cm_vstore_partial(s + j, cm_vload_partial(s + j, tw - j) + e, tw - j);
+    }
+  }
+  // s holds the factor, and m the shift, of every column.
+  for (size_t j = 0; j != tw; j++)
+  {
+    if (log)
+    {
+      m[j] = -m[j] - logf(s[j]);
+      s[j] = 1.0f;
+    }
+    else
+    {
+      m[j] = 0;
+      s[j] = 1.0f / s[j];
+    }
+  }
+  for (size_t r = 0; r != n; r++)
+  {
+    const float *row = log ? x + r * inner : y + r * inner;
+    float *out = y + r * inner;
+    size_t j = 0;
+    for (; j != vw; j += CM_SIMD_WIDTH)
+    {
+      cm_vstore(out + j, cm_vload(row + j) * cm_vload(s + j) + cm_vload(m + j));
+    }
+    for (; j != tw; j++)
+    {
+      out[j] = row[j] * s[j] + m[j];
+    }
+  }
+}
+
+static void _softmax_chunk(size_t from, size_t to, void *userData)
+{
+  _SoftmaxJob *job = (_SoftmaxJob *)userData;
+  if (job->Inner == 1)
+  {
+    for (size_t o = from; o != to; o++)
+    {
+      _softmax_row(job->X + o * job->N, job->Y + o * job->N, job->N, job->Log);
+    }
+    return;
+  }
+  for (size_t t = from; t != to; t++)
+  {
+    size_t o = t / job->Tiles;
+    size_t j = (t % job->Tiles) * SOFTMAX_TILE_SIZE;
+    size_t offset = o * job->N * job->Inner + j;
+    _softmax_tile(job->X + offset, job->Y + offset, job->N, job->Inner, min((size_t)SOFTMAX_TILE_SIZE, job->Inner - j), job->Log);
+  }
+}
+
+bool SoftmaxOperator ::InferShapes(Tensor **infos)
+{
+  if (this->Opsc.Count() <= SOFTMAX_X_INDEX)
+  {
+    return false;
+  }
+  Tensor *x = this->_inferredInput(infos, SOFTMAX_X_INDEX);
+  int axis = this->Axis < 0 ? this->Axis + x->Dimension : this->Axis;
+  return axis >= 0 && axis < x->Dimension && this->_inferOutput(infos, SOFTMAX_Y_INDEX, x->Shape, x->Dimension, x->Type);
+}
+
+bool SoftmaxOperator ::Activate(ActivationContext *ctx)
+{
+  if (this->Opsc.Count() <= SOFTMAX_X_INDEX)
+  {
+    return false;
+  }
+  Tensor *x = this->_getValue(ctx, SOFTMAX_X_INDEX);
+  if (!x || x->Type != TDT_FLOAT)
+  {
+    return false;
+  }
+  int axis = this->Axis < 0 ? this->Axis + x->Dimension : this->Axis;
+  if (axis < 0 || axis >= x->Dimension)
+  {
+    return false;
+  }
+  TensorRefPtr output = ctx->CreateOutputRef(this, x->Shape, x->Dimension, x->Type);
+  if (!output)
+  {
+    return false;
+  }
+
+  _SoftmaxJob job;
+  size_t outer = 1;
+  job.Inner = 1;
+  for (int d = 0; d != axis; d++)
+  {
+    outer *= (size_t)x->Shape[d];
+  }
+  for (int d = axis + 1; d != x->Dimension; d++)
+  {
+    job.Inner *= (size_t)x->Shape[d];
+  }
+  job.X = (const float *)x->Data;
+  job.Y = (float *)output->Value.Data;
+  job.N = (size_t)x->Shape[axis];
+  // the axes after Axis are normalized with it, the rows are then contiguous.
+  if (this->Coerced)
+  {
+    job.N *= job.Inner;
+    job.Inner = 1;
+  }
+  job.Tiles = (job.Inner + SOFTMAX_TILE_SIZE - 1) / SOFTMAX_TILE_SIZE;
+  job.Log = this->_log;
+  if (x->Count)
+  {
+    InferenceEngine *engine = ctx->GetEngine();
+    if (job.Inner == 1)
+    {
+      engine->ParallelFor(outer, job.N * sizeof(float), _softmax_chunk, &job);
+    }
+    else
+    {
+      engine->ParallelFor(outer * job.Tiles, job.N * min(job.Inner, (size_t)SOFTMAX_TILE_SIZE) * sizeof(float), _softmax_chunk, &job);
+    }
+  }
+  return ctx->Forward(this, &output, 1);
+}
+
+bool SoftmaxOperator ::SetOpset(int version)
+{
+  this->Coerced = version < SOFTMAX_OPSET_SINGLE_AXIS;
+  if (this->Coerced && !this->_hasAxis)
+  {
+    this->Axis = 1;
+  }
+  return true;
+}
+
+bool SoftmaxOperator ::TrySetAtt(const char *n, Att_value_t v)
+{
+  if (strcmp(n, "axis") == 0)
+  {
+    this->Axis = (int)v.i;
+    this->_hasAxis = true;
+    return true;
+  }
+  if (strcmp(n, "coerced") == 0)
+  {
+    this->Coerced = v.i != 0;
+    return true;
+  }
+  return false;
+}
+
+void SoftmaxOperator ::GetAtts(AttWriter *writer)
+{
+  Att_value_t v;
+  v.i = this->Axis;
+  writer->Write("axis", AttKind::INT, v);
+  if (this->Coerced)
+  {
+    v.i = 1;
+    writer->Write("coerced", AttKind::INT, v);
+  }
+}
@@ -0,0 +1,198 @@
+#include "cm_engine.hpp"
+#include "cm_plan.hpp"
+#include "nodes/op/cm_concat.hpp"
+
+using namespace CyanMycelium;
+
+// the copy of the inputs which were not written into their slice, as outer x count contiguous blocks.
+struct _ConcatJob
+{
+    Tensor **Inputs; // null for the inputs already in place
+    size_t *Offsets; // the offset of every input within an outer index of the result, in bytes
+    int Count;
+    size_t Outer;
+    cm_byte_t *Y;
+    size_t Row; // the size of an outer index of the result, in bytes
+};
+
+static void _concat_chunk(size_t from, size_t to, void *userData)
+{
+    _ConcatJob *job = (_ConcatJob *)userData;
+    for (size_t k = from; k != to; k++)
+    {
+        size_t o = k / job->Count;
+        int i = (int)(k % job->Count);
+        Tensor *x = job->Inputs[i];
+        if (x)
+        {
+            size_t block = x->Size / job->Outer;
+            cm_memcpy(job->Y + o * job->Row + job->Offsets[i], (cm_byte_t *)x->Data + o * block, block);
+        }
+    }
+}
+
+// the infos of the concatenation of count inputs, given by input(i), and the positive axis. A symbolic size along the axis
+// keeps the sum symbolic.
+template <typename F>
+static bool _concat_shape(int count, int axis, F input, TensorInfos *y, int *a)
+{
+    TensorInfos *first = count ? input(0) : nullptr;
+    if (!first || first->Type == TDT_UNDEFINED)
+    {
+        return false;
+    }
+    int dimension = first->Dimension;
+    *a = axis < 0 ? axis + dimension : axis;
+    if (*a < 0 || *a >= dimension)
+    {
+        return false;
+    }
+    uint64_t shape[TENSOR_MAX_DIMENSION];
+    cm_memcpy(shape, first->Shape, dimension * sizeof(uint64_t));
+    for (int i = 1; i != count; i++)
+    {
+        TensorInfos *x = input(i);
+        if (!x || x->Type != first->Type || x->Dimension != dimension)
+        {
+            return false;
+        }
+        for (int d = 0; d != dimension; d++)
+        {
+            uint64_t s = x->Shape[d];
+            if (d == *a)
+            {
+                shape[d] = shape[d] == TENSOR_DYNAMIC_DIM || s == TENSOR_DYNAMIC_DIM ? TENSOR_DYNAMIC_DIM : shape[d] + s;
+            }
+            else if (shape[d] == TENSOR_DYNAMIC_DIM)
+            {
+                shape[d] = s;
+            }
+            else if (s != TENSOR_DYNAMIC_DIM && s != shape[d])
+            {
+                return false;
+            }
+        }
+    }
+    y->Set(shape, dimension, first->Type);
+    return true;
+}
+
+// the number of blocks of every input, which is the product of the sizes before the axis.
+static size_t _concat_outer(TensorInfos *y, int axis)
+{
+    size_t outer = 1;
+    for (int d = 0; d != axis; d++)
+    {
+        outer *= (size_t)y->Shape[d];
+    }
+    return outer;
+}
+
+bool Concat ::InferShapes(Tensor **infos)
+{
+    TensorInfos y(nullptr, 1);
+    int axis;
+    auto input = [&](int i) -> TensorInfos *
+    { return this->_inferredInput(infos, i); };
+    return _concat_shape(this->Opsc.Count(), this->Axis, input, &y, &axis) && this->_inferOutput(infos, CONCAT_Y_INDEX, y.Shape, y.Dimension, y.Type);
+}
+
+bool Concat ::GetInputSlice(int index, ShapePlan *plan, TensorInfos *output, size_t *offset)
+{
+    auto input = [&](int i) -> TensorInfos *
+    {
+        Link *l = this->Opsc[i];
+        return !l ? nullptr : plan ? plan->GetInfos(l->Id) : l->GetPayloadInfos();
+    };
+    int axis;
+    // the slices are contiguous when there is a single block per input.
+    if (!_concat_shape(this->Opsc.Count(), this->Axis, input, output, &axis) || output->IsDynamic() || _concat_outer(output, axis) != 1)
+    {
+        return false;
+    }
+    *offset = 0;
+    for (int i = 0; i != index; i++)
+    {
+        *offset += input(i)->Size;
+    }
+    return true;
+}
+
+bool Concat ::Activate(ActivationContext *ctx)
+{
+    int count = this->Opsc.Count();
+    TensorInfos y(nullptr, 1);
+    int axis;
+    auto input = [&](int i) -> TensorInfos *
+    { return this->_getValue(ctx, i); };
+    if (!_concat_shape(count, this->Axis, input, &y, &axis) || y.IsDynamic())
+    {
+        return false;
+    }
+
+    // the sources of the inputs may have written their results into the slices of the result already, see Link::InSlice.
+    TensorRefPtr output = ctx->TakeSliceRef(this);
+    if (!output || output->Value.Size != y.Size)
+    {
+        ctx->DiscardOutputRef(output);
+        output = ctx->CreateOutputRef(this, y.Shape, y.Dimension, y.Type);
+        if (!output)
+        {
+            return false;
+        }
+    }
+
+    _ConcatJob job;
+    job.Inputs = (Tensor **)cm_malloc(count * (sizeof(Tensor *) + sizeof(size_t)));
+    if (!job.Inputs)
+    {
+        ctx->DiscardOutputRef(output);
+        return false;
+    }
+    job.Offsets = (size_t *)(job.Inputs + count);
+    job.Count = count;
+    job.Outer = _concat_outer(&y, axis);
+    job.Y = (cm_byte_t *)output->Value.Data;
+    job.Row = y.Size / job.Outer;
+    bool copy = false;
+    size_t offset = 0;
+    for (int i = 0; i != count; i++)
+    {
+        Tensor *x = this->_getValue(ctx, i);
+        job.Offsets[i] = offset;
+        job.Inputs[i] = job.Outer == 1 && x->Data == job.Y + offset ? nullptr : x;
+        copy = copy || job.Inputs[i];
+        offset += x->Size / job.Outer;
+    }
+    if (copy)
+    {
+        InferenceEngine *engine = ctx->GetEngine();
+        size_t n = job.Outer * count;
+        if (engine)
+        {
+            engine->ParallelFor(n, job.Row / count, _concat_chunk, &job);
+        }
+        else
+        {
+            _concat_chunk(0, n, &job);
+        }
+    }
+    cm_free(job.Inputs);
+    return ctx->Forward(this, output);
+}
+
+bool Concat ::TrySetAtt(const char *n, Att_value_t v)
+{
+    if (strcmp(n, "axis") == 0)
+    {
+        this->Axis = (int)v.i;
+    }
+    return true;
+}
+
+void Concat ::GetAtts(AttWriter *writer)
+{
+    Att_value_t v;
+    v.i = this->Axis;
+    writer->Write("axis", AttKind::INT, v);
+}
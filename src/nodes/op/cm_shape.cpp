@@ -4,20 +4,44 @@ using namespace CyanMycelium;
 
 #define __ENSURE_OFFSET_POSITIV(a, d) a < 0 ? d + a : a
 
-bool Shape ::Activate(ActivationContext *ctx)
+int Shape ::_getRange(int dimension, int *start)
 {
-    TensorPtr infos = this->Opsc[0]->GetPayloadInfos();
-    uint64_t *shape = infos->Shape;
-    uint8_t dimension = infos->Dimension;
-
     int a = _mask.bits._hasStart ? this->_start : 0;
     int b = _mask.bits._hasEnd ? this->_end : dimension - 1;
 
     a = __ENSURE_OFFSET_POSITIV(a, dimension);
     b = __ENSURE_OFFSET_POSITIV(b, dimension);
+    *start = a;
+    return b - a + 1;
+}
+
+bool Shape ::InferShapes(Tensor **infos)
+{
+    if (!this->Opsc.Count())
+    {
+        return false;
+    }
+    int a;
+    uint64_t oneDimShape[1];
+    oneDimShape[0] = (uint64_t)this->_getRange(this->_inferredInput(infos, 0)->Dimension, &a);
+    for (int i = 0; i != this->Onsc.Count(); i++)
+    {
+        if (!this->_inferOutput(infos, i, oneDimShape, 1, TDT_UINT32))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool Shape ::Activate(ActivationContext *ctx)
+{
+    TensorPtr infos = this->Opsc[0]->GetPayloadInfos();
+    uint64_t *shape = infos->Shape;
 
+    int a;
     uint64_t oneDimShape[1];
-    oneDimShape[0] = (uint64_t)(b - a + 1);
+    oneDimShape[0] = (uint64_t)this->_getRange(infos->Dimension, &a);
 
     int count = this->Onsc.Count();
     for (int i = 0; i != count; i++)
@@ -0,0 +1,340 @@
+#include <cmath>
+#include <limits>
+
+#include "cm_engine.hpp"
+#include "math/cm_gemm.hpp"
+#include "nodes/quantization/cm_matmul_integer.hpp"
+
+using namespace CyanMycelium;
+
+static inline bool _is_8bits(Tensor *t) { return t && (t->Type == TDT_UINT8 || t->Type == TDT_INT8); }
+
+static inline int32_t _get_8bits(Tensor *t, size_t i) { return t->Type == TDT_UINT8 ? ((const uint8_t *)t->Data)[i] : ((const int8_t *)t->Data)[i]; }
+
+// B is [K x N] and its zero point is a scalar or holds one value per column.
+static bool _can_pack(Tensor *b, Tensor *zb)
+{
+  return _is_8bits(b) && b->Dimension == 2 && (!zb || (zb->Type == b->Type && (zb->Count == 1 || zb->Count == b->Shape[1])));
+}
+
+// the matrix, its row sums and zero points, then its data, in a single block.
+static size_t _packed_size(Tensor *b)
+{
+  size_t n = b->Shape[1];
+  size_t k = b->Shape[0];
+  return sizeof(QuantizedMatrix) + 2 * n * sizeof(int32_t) + n * k;
+}
+
+// transpose B to [N x K] int8, uint8 values and zero points are shifted by -128.
+static QuantizedMatrix *_pack(Tensor *b, Tensor *zb, void *buffer)
+{
+  QuantizedMatrix *packed = (QuantizedMatrix *)buffer;
+  int k = (int)b->Shape[0];
+  int n = (int)b->Shape[1];
+  packed->N = n;
+  packed->K = k;
+  packed->Sums = (int32_t *)(packed + 1);
+  packed->ZeroPoints = packed->Sums + n;
+  packed->Data = (int8_t *)(packed->ZeroPoints + n);
+
+  uint8_t flip = b->Type == TDT_UINT8 ? 0x80 : 0;
+  const uint8_t *src = (const uint8_t *)b->Data;
+  uint8_t *dst = (uint8_t *)packed->Data;
+  for (int j = 0; j != n; j++)
+  {
+    for (int p = 0; p != k; p++)
+    {
+      dst[(size_t)j * k + p] = src[(size_t)p * n + j] ^ flip;
+    }
+    packed->ZeroPoints[j] = (zb ? _get_8bits(zb, zb->Count == 1 ? 0 : j) : 0) - (flip ? 128 : 0);
+  }
+  cm_qgemm_sum_b(n, k, packed->Data, k, packed->Sums);
+  return packed;
+}
+
+struct _QMatMulJob
+{
+  const uint8_t *A;
+  int32_t Za;
+  QuantizedMatrix *B;
+  int32_t *C;
+};
+
+static void _qmatmul_chunk(size_t from, size_t to, void *userData)
+{
+  _QMatMulJob *job = (_QMatMulJob *)userData;
+  int k = job->B->K;
+  int n = job->B->N;
+  // the row sums of B are given, so the kernel does not allocate.
+  cm_qgemm_nt((int)(to - from), n, k, job->A + from * k, k, job->Za, job->B->Data, k, job->B->ZeroPoints, job->C + from * n, n, job->B->Sums);
+}
+
+QuantizedMatMul ::~QuantizedMatMul()
+{
+  cm_free(this->_packedB);
+}
+
+bool QuantizedMatMul ::Prepack()
+{
+  if (!this->_hasInput(this->_bIndex))
+  {
+    return true;
+  }
+  Tensor *b = this->Opsc[this->_bIndex]->GetPayloadInfos();
+  Tensor *zb = this->_hasInput(this->_bZeroPointIndex) ? this->Opsc[this->_bZeroPointIndex]->GetPayloadInfos() : nullptr;
+  // B or its zero point are runtime inputs, nothing to prepare.
+  if (!b->Data || (zb && !zb->Data) || !_can_pack(b, zb))
+  {
+    return true;
+  }
+  void *buffer = cm_malloc(_packed_size(b));
+  if (!buffer)
+  {
+    return false;
+  }
+  this->_packedB = _pack(b, zb, buffer);
+  return true;
+}
+
+size_t QuantizedMatMul ::SavePacked(void *buffer)
+{
+  QuantizedMatrix *packed = this->_packedB;
+  if (!packed)
+  {
+    return 0;
+  }
+  // the arrays follow each other, see _pack.
+  size_t size = _packed_size(this->Opsc[this->_bIndex]->GetPayloadInfos()) - sizeof(QuantizedMatrix);
+  if (buffer)
+  {
+    cm_memcpy(buffer, packed->Sums, size);
+  }
+  return size;
+}
+
+bool QuantizedMatMul ::LoadPacked(const void *data, size_t size)
+{
+  if (!this->_hasInput(this->_bIndex) || this->_packedB)
+  {
+    return false;
+  }
+  Tensor *b = this->Opsc[this->_bIndex]->GetPayloadInfos();
+  if (!_is_8bits(b) || b->Dimension != 2 || size != _packed_size(b) - sizeof(QuantizedMatrix))
+  {
+    return false;
+  }
+  // only the matrix is allocated, its arrays are read from the data.
+  QuantizedMatrix *packed = (QuantizedMatrix *)cm_malloc(sizeof(QuantizedMatrix));
+  if (!packed)
+  {
+    return false;
+  }
+  packed->N = (int)b->Shape[1];
+  packed->K = (int)b->Shape[0];
+  packed->Sums = (int32_t *)data;
+  packed->ZeroPoints = packed->Sums + packed->N;
+  packed->Data = (int8_t *)(packed->ZeroPoints + packed->N);
+  this->_packedB = packed;
+  return true;
+}
+
+bool QuantizedMatMul ::_multiply(ActivationContext *ctx, Tensor *a, Tensor *b, int32_t *c)
+{
+  IMemoryManagerPtr mm = ctx->GetEngine()->GetMemoryManager();
+  Tensor *za = this->_getValue(ctx, this->_aZeroPointIndex);
+  if (!_is_8bits(a) || !a->Dimension || (za && (za->Type != a->Type || za->Count != 1)))
+  {
+    return false;
+  }
+
+  void *packedBuffer = nullptr;
+  void *flipped = nullptr;
+  QuantizedMatrix *packed = this->_packedB;
+  if (!packed)
+  {
+    Tensor *zb = this->_getValue(ctx, this->_bZeroPointIndex);
+    if (!_can_pack(b, zb) || !(packedBuffer = mm->Malloc(_packed_size(b))))
+    {
+      return false;
+    }
+    packed = _pack(b, zb, packedBuffer);
+  }
+
+  _QMatMulJob job;
+  int k = packed->K;
+  size_t rows = k ? a->Count / k : 0;
+  bool res = a->Shape[a->Dimension - 1] == (uint64_t)k;
+  if (res)
+  {
+    job.A = (const uint8_t *)a->Data;
+    job.Za = za ? _get_8bits(za, 0) : 0;
+    job.B = packed;
+    job.C = c;
+    // int8 activations are shifted to uint8.
+    if (a->Type == TDT_INT8)
+    {
+      res = (flipped = mm->Malloc(a->Count)) != nullptr;
+      if (res)
+      {
+        cm_qgemm_flip_sign(a->Data, flipped, a->Count);
+        job.A = (const uint8_t *)flipped;
+        job.Za += 128;
+      }
+    }
+  }
+  if (res)
+  {
+    // a row costs N x K multiply-adds, which sizes the chunks.
+    ctx->GetEngine()->ParallelFor(rows, (size_t)packed->N * k, _qmatmul_chunk, &job);
+  }
+
+  if (flipped)
+  {
+    mm->Free(flipped);
+  }
+  if (packedBuffer)
+  {
+    mm->Free(packedBuffer);
+  }
+  return res;
+}
+
+bool QuantizedMatMul ::_inferProduct(Tensor **infos, int aIndex, tensor_data_type_t type)
+{
+  if (this->Opsc.Count() <= max(aIndex, this->_bIndex))
+  {
+    return false;
+  }
+  Tensor *a = this->_inferredInput(infos, aIndex);
+  Tensor *b = this->_inferredInput(infos, this->_bIndex);
+  if (!_is_8bits(a) || !_is_8bits(b) || !a->Dimension || b->Dimension != 2 || a->Shape[a->Dimension - 1] != b->Shape[0])
+  {
+    return false;
+  }
+  uint64_t shape[TENSOR_MAX_DIMENSION];
+  for (int d = 0; d != a->Dimension; d++)
+  {
+    shape[d] = a->Shape[d];
+  }
+  shape[a->Dimension - 1] = b->Shape[1];
+  return this->_inferOutput(infos, 0, shape, a->Dimension, type);
+}
+
+bool MatMulInteger ::Activate(ActivationContext *ctx)
+{
+  Tensor *a = this->_getValue(ctx, MATMUL_INTEGER_A_INDEX);
+  Tensor *b = this->_getValue(ctx, MATMUL_INTEGER_B_INDEX);
+  if (!a || !b || !a->Dimension || b->Dimension != 2)
+  {
+    return false;
+  }
+
+  uint64_t shape[TENSOR_MAX_DIMENSION];
+  for (int d = 0; d != a->Dimension; d++)
+  {
+    shape[d] = a->Shape[d];
+  }
+  shape[a->Dimension - 1] = b->Shape[1];
+  TensorRefPtr output = ctx->CreateOutputRef(this, shape, a->Dimension, TDT_INT32);
+  if (!output)
+  {
+    return false;
+  }
+  if (!this->_multiply(ctx, a, b, (int32_t *)output->Value.Data))
+  {
+    ctx->DiscardOutputRef(output);
+    return false;
+  }
+  return ctx->Forward(this, &output, 1);
+}
+
+// y = saturate(round(c * multiplier[j]) + zero), with one multiplier per column.
+template <typename Q>
+static void _requantize(const int32_t *c, Q *y, size_t rows, size_t n, const float *multipliers, float zero)
+{
+  const float lo = (float)(std::numeric_limits<Q>::min)();
+  const float hi = (float)(std::numeric_limits<Q>::max)();
+  for (size_t i = 0; i != rows; i++)
+  {
+    for (size_t j = 0; j != n; j++)
+    {
+      float v = nearbyintf((float)c[i * n + j] * multipliers[j]) + zero;
+      v = v >= lo ? v : lo;
+      v = v <= hi ? v : hi;
+      y[i * n + j] = (Q)v;
+    }
+  }
+}
+
+bool QLinearMatMul ::InferShapes(Tensor **infos)
+{
+  // the type of the result is the type of its zero point, which is required.
+  if (this->Opsc.Count() <= QLINEAR_MATMUL_Y_ZERO_POINT_INDEX)
+  {
+    return false;
+  }
+  Tensor *yZeroPoint = this->_inferredInput(infos, QLINEAR_MATMUL_Y_ZERO_POINT_INDEX);
+  return _is_8bits(yZeroPoint) && this->_inferProduct(infos, QLINEAR_MATMUL_A_INDEX, yZeroPoint->Type);
+}
+
+bool QLinearMatMul ::Activate(ActivationContext *ctx)
+{
+  Tensor *a = this->_getValue(ctx, QLINEAR_MATMUL_A_INDEX);
+  Tensor *aScale = this->_getValue(ctx, QLINEAR_MATMUL_A_SCALE_INDEX);
+  Tensor *b = this->_getValue(ctx, QLINEAR_MATMUL_B_INDEX);
+  Tensor *bScale = this->_getValue(ctx, QLINEAR_MATMUL_B_SCALE_INDEX);
+  Tensor *yScale = this->_getValue(ctx, QLINEAR_MATMUL_Y_SCALE_INDEX);
+  Tensor *yZeroPoint = this->_getValue(ctx, QLINEAR_MATMUL_Y_ZERO_POINT_INDEX);
+  if (!a || !b || !aScale || !bScale || !yScale || !_is_8bits(yZeroPoint) || !a->Dimension || b->Dimension != 2 ||
+      aScale->Type != TDT_FLOAT || bScale->Type != TDT_FLOAT || yScale->Type != TDT_FLOAT ||
+      (bScale->Count != 1 && bScale->Count != b->Shape[1]))
+  {
+    return false;
+  }
+
+  size_t n = b->Shape[1];
+  size_t rows = a->Count / max(a->Shape[a->Dimension - 1], (uint64_t)1);
+  uint64_t shape[TENSOR_MAX_DIMENSION];
+  for (int d = 0; d != a->Dimension; d++)
+  {
+    shape[d] = a->Shape[d];
+  }
+  shape[a->Dimension - 1] = n;
+
+  IMemoryManagerPtr mm = ctx->GetEngine()->GetMemoryManager();
+  TensorRefPtr output = ctx->CreateOutputRef(this, shape, a->Dimension, yZeroPoint->Type);
+  if (!output)
+  {
+    return false;
+  }
+  // the int32 product, followed by the multipliers of the columns.
+  int32_t *c = (int32_t *)mm->Malloc(rows * n * sizeof(int32_t) + n * sizeof(float));
+  if (!c || !this->_multiply(ctx, a, b, c))
+  {
+    if (c)
+    {
+      mm->Free(c);
+    }
+    ctx->DiscardOutputRef(output);
+    return false;
+  }
+
+  float *multipliers = (float *)(c + rows * n);
+  float as = *(const float *)aScale->Data;
+  float ys = *(const float *)yScale->Data;
+  for (size_t j = 0; j != n; j++)
+  {
+    multipliers[j] = as * ((const float *)bScale->Data)[bScale->Count == 1 ? 0 : j] / ys;
+  }
+  float zero = (float)_get_8bits(yZeroPoint, 0);
+  if (yZeroPoint->Type == TDT_UINT8)
+  {
+    _requantize(c, (uint8_t *)output->Value.Data, rows, n, multipliers, zero);
+  }
+  else
+  {
+    _requantize(c, (int8_t *)output->Value.Data, rows, n, multipliers, zero);
+  }
+  mm->Free(c);
+  return ctx->Forward(this, &output, 1);
+}
@@ -0,0 +1,242 @@
+#include <cmath>
+#include <limits>
+
+#include "cm_engine.hpp"
+#include "nodes/quantization/cm_quantize.hpp"
+
+using namespace CyanMycelium;
+
+bool QuantizationParameters ::Bind(Tensor *x, int axis, Tensor *scale, Tensor *zeroPoint)
+{
+  if (!scale || !scale->Data || scale->Type != TDT_FLOAT || (zeroPoint && (!zeroPoint->Data || zeroPoint->Count != scale->Count)))
+  {
+    return false;
+  }
+  this->Scale = (const float *)scale->Data;
+  this->ZeroPoint = zeroPoint ? zeroPoint->Data : nullptr;
+  this->ZeroPointType = zeroPoint ? zeroPoint->Type : TDT_UINT8;
+  this->Channels = 1;
+  this->Inner = x->Count ? x->Count : 1;
+  if (scale->Count > 1)
+  {
+    axis = axis < 0 ? axis + x->Dimension : axis;
+    if (axis < 0 || axis >= x->Dimension || x->Shape[axis] != scale->Count)
+    {
+      return false;
+    }
+    this->Channels = scale->Count;
+    this->Inner = 1;
+    for (int d = axis + 1; d < x->Dimension; d++)
+    {
+      this->Inner *= x->Shape[d];
+    }
+  }
+  return true;
+}
+
+int32_t QuantizationParameters ::GetZeroPoint(size_t channel)
+{
+  if (!this->ZeroPoint)
+  {
+    return 0;
+  }
+  switch (this->ZeroPointType)
+  {
+  case TDT_UINT8:
+    return ((const uint8_t *)this->ZeroPoint)[channel];
+  case TDT_INT8:
+    return ((const int8_t *)this->ZeroPoint)[channel];
+  case TDT_UINT16:
+    return ((const uint16_t *)this->ZeroPoint)[channel];
+  case TDT_INT16:
+    return ((const int16_t *)this->ZeroPoint)[channel];
+  case TDT_INT32:
+    return ((const int32_t *)this->ZeroPoint)[channel];
+  default:
+    return 0;
+  }
+}
+
+// every channel is a run of Inner consecutive items sharing the same scale and zero point.
+template <typename Q>
+static void _quantize(const float *x, Q *y, size_t count, QuantizationParameters *p)
+{
+  const float lo = (float)(std::numeric_limits<Q>::min)();
+  const float hi = (float)(std::numeric_limits<Q>::max)();
+  for (size_t i = 0; i < count;)
+  {
+    size_t run = i / p->Inner;
+    size_t end = min(count, (run + 1) * p->Inner);
+    size_t channel = run % p->Channels;
+    float scale = p->Scale[channel];
+    float zero = (float)p->GetZeroPoint(channel);
+    for (; i != end; i++)
+    {
+      // nearbyint rounds half to even with the default rounding mode, nan saturates to the lower bound.
+      float v = nearbyintf(x[i] / scale) + zero;
+      v = v >= lo ? v : lo;
+      v = v <= hi ? v : hi;
+      y[i] = (Q)v;
+    }
+  }
+}
+
+template <typename Q>
+static void _dequantize(const Q *x, float *y, size_t count, QuantizationParameters *p)
+{
+  for (size_t i = 0; i < count;)
+  {
+    size_t run = i / p->Inner;
+    size_t end = min(count, (run + 1) * p->Inner);
+    size_t channel = run % p->Channels;
+    float scale = p->Scale[channel];
+    cm_int64_t zero = p->GetZeroPoint(channel);
+    for (; i != end; i++)
+    {
+      y[i] = (float)((cm_int64_t)x[i] - zero) * scale;
+    }
+  }
+}
+
+bool QuantizationOperator ::TrySetAtt(const char *n, Att_value_t v)
+{
+  if (strcmp(n, "axis") == 0)
+  {
+    this->Axis = (int)v.i;
+    return true;
+  }
+  return false;
+}
+
+void QuantizationOperator ::GetAtts(AttWriter *writer)
+{
+  Att_value_t v;
+  v.i = this->Axis;
+  writer->Write("axis", AttKind::INT, v);
+}
+
+bool QuantizationOperator ::Prepack()
+{
+  Link *l = this->_getQuantizedLink();
+  // annotations of the graph take precedence.
+  if (!l || l->IsQuantized() || !this->_hasInput(QLINEAR_SCALE_INDEX))
+  {
+    return true;
+  }
+  l->Quantization.Scale = this->Opsc[QLINEAR_SCALE_INDEX];
+  l->Quantization.ZeroPoint = this->_hasInput(QLINEAR_ZERO_POINT_INDEX) ? this->Opsc[QLINEAR_ZERO_POINT_INDEX] : nullptr;
+  l->Quantization.Axis = this->Axis;
+  return true;
+}
+
+bool QuantizeLinear ::Activate(ActivationContext *ctx)
+{
+  Tensor *x = this->_getValue(ctx, QLINEAR_X_INDEX);
+  QuantizationParameters p;
+  if (!x || x->Type != TDT_FLOAT || !p.Bind(x, this->Axis, this->_getValue(ctx, QLINEAR_SCALE_INDEX), this->_getValue(ctx, QLINEAR_ZERO_POINT_INDEX)))
+  {
+    return false;
+  }
+
+  TensorRefPtr output = ctx->CreateOutputRef(this, x->Shape, x->Dimension, p.ZeroPointType);
+  if (!output)
+  {
+    return false;
+  }
+  const float *xData = (const float *)x->Data;
+  void *yData = output->Value.Data;
+  switch (p.ZeroPointType)
+  {
+  case TDT_UINT8:
+    _quantize(xData, (uint8_t *)yData, x->Count, &p);
+    break;
+  case TDT_INT8:
+    _quantize(xData, (int8_t *)yData, x->Count, &p);
+    break;
+  case TDT_UINT16:
+    _quantize(xData, (uint16_t *)yData, x->Count, &p);
+    break;
+  case TDT_INT16:
+    _quantize(xData, (int16_t *)yData, x->Count, &p);
+    break;
+  default:
+    ctx->DiscardOutputRef(output);
+    return false;
+  }
+  return ctx->Forward(this, &output, 1);
+}
+
+bool QuantizationOperator ::_checkParameters(Tensor **infos, Tensor *x)
+{
+  Tensor *scale = this->_inferredInput(infos, QLINEAR_SCALE_INDEX);
+  Tensor *zeroPoint = this->_inferredInput(infos, QLINEAR_ZERO_POINT_INDEX);
+  if (!scale || scale->Type != TDT_FLOAT || (zeroPoint && zeroPoint->Count != scale->Count))
+  {
+    return false;
+  }
+  int axis = this->Axis < 0 ? this->Axis + x->Dimension : this->Axis;
+  return scale->Count == 1 || (axis >= 0 && axis < x->Dimension && x->Shape[axis] == scale->Count);
+}
+
+bool QuantizeLinear ::InferShapes(Tensor **infos)
+{
+  Tensor *x = this->_inferredInput(infos, QLINEAR_X_INDEX);
+  if (!x || x->Type != TDT_FLOAT || !this->_checkParameters(infos, x))
+  {
+    return false;
+  }
+  // the quantized type is the type of the zero point, uint8 without it.
+  Tensor *zeroPoint = this->_inferredInput(infos, QLINEAR_ZERO_POINT_INDEX);
+  return this->_inferOutput(infos, 0, x->Shape, x->Dimension, zeroPoint ? zeroPoint->Type : TDT_UINT8);
+}
+
+bool DequantizeLinear ::InferShapes(Tensor **infos)
+{
+  Tensor *x = this->_inferredInput(infos, QLINEAR_X_INDEX);
+  if (!x || !this->_checkParameters(infos, x))
+  {
+    return false;
+  }
+  return this->_inferOutput(infos, 0, x->Shape, x->Dimension, TDT_FLOAT);
+}
+
+bool DequantizeLinear ::Activate(ActivationContext *ctx)
+{
+  Tensor *x = this->_getValue(ctx, QLINEAR_X_INDEX);
+  QuantizationParameters p;
+  if (!x || !p.Bind(x, this->Axis, this->_getValue(ctx, QLINEAR_SCALE_INDEX), this->_getValue(ctx, QLINEAR_ZERO_POINT_INDEX)))
+  {
+    return false;
+  }
+  // the zero point is optional, the quantized type is then the type of x.
+  p.ZeroPointType = x->Type;
+
+  TensorRefPtr output = ctx->CreateOutputRef(this, x->Shape, x->Dimension, TDT_FLOAT);
+  if (!output)
+  {
+    return false;
+  }
+  float *yData = (float *)output->Value.Data;
+  switch (x->Type)
+  {
+  case TDT_UINT8:
+    _dequantize((const uint8_t *)x->Data, yData, x->Count, &p);
+    break;
+  case TDT_INT8:
+    _dequantize((const int8_t *)x->Data, yData, x->Count, &p);
+    break;
+  case TDT_UINT16:
+    _dequantize((const uint16_t *)x->Data, yData, x->Count, &p);
+    break;
+  case TDT_INT16:
+    _dequantize((const int16_t *)x->Data, yData, x->Count, &p);
+    break;
+  case TDT_INT32:
+    _dequantize((const int32_t *)x->Data, yData, x->Count, &p);
+    break;
+  default:
+    ctx->DiscardOutputRef(output);
+    return false;
+  }
+  return ctx->Forward(this, &output, 1);
+}
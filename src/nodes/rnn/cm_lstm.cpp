@@ -0,0 +1,529 @@
+#include <cmath>
+
+#include "cm_engine.hpp"
+#include "math/cm_gemm.hpp"
+#include "math/cm_half.hpp"
+#include "math/cm_vmath.hpp"
+#include "nodes/rnn/cm_lstm.hpp"
+
+using namespace CyanMycelium;
+
+static inline cm_vfloat_t _vclip(cm_vfloat_t x, float c)
+{
+  if (c <= 0)
+  {
+    return x;
+  }
+  x = x < -c ? cm_vset1(-c) : x;
+  return x > c ? cm_vset1(c) : x;
+}
+
+static inline cm_vfloat_t _vload_n(const float *p, size_t n) { return n == CM_SIMD_WIDTH ? cm_vload(p) : cm_vload_partial(p, n); }
+
+static inline void _vstore_n(float *p, cm_vfloat_t v, size_t n)
+{
+  if (n == CM_SIMD_WIDTH)
+  {
+    cm_vstore(p, v);
+    return;
+  }
+  cm_vstore_partial(p, v, n);
+}
+
+// the gates activations and the cell update of n <= CM_SIMD_WIDTH consecutive hidden units.
+static inline void _lstm_lanes(const float *gi, const float *go, const float *gf, const float *gc, float *cb, float *hb, size_t n, float clip, bool inputForget)
+{
+  cm_vfloat_t i = cm_vsigmoid(_vclip(_vload_n(gi, n), clip));
+  cm_vfloat_t o = cm_vsigmoid(_vclip(_vload_n(go, n), clip));
+  cm_vfloat_t f = inputForget ? 1.0f - i : cm_vsigmoid(_vclip(_vload_n(gf, n), clip));
+  cm_vfloat_t ct = cm_vtanh(_vclip(_vload_n(gc, n), clip));
+  cm_vfloat_t cell = f * _vload_n(cb, n) + i * ct;
+  _vstore_n(cb, cell, n);
+  _vstore_n(hb, o * cm_vtanh(cell), n);
+}
+
+// Fused gates activations and cell update for one timestep.
+// gates holds the pre-activation of the 4 gates in the ONNX order (i, o, f, c) for every batch row.
+// h and c are updated in place.
+static void _lstm_cell(const float *gates, float *h, float *c, int batch, int hidden, float clip, bool inputForget)
+{
+  for (int b = 0; b != batch; b++)
+  {
+    const float *gi = gates + b * LSTM_GATE_COUNT * hidden;
+    const float *go = gi + hidden;
+    const float *gf = go + hidden;
+    const float *gc = gf + hidden;
+    float *hb = h + b * hidden;
+    float *cb = c + b * hidden;
+    int j = 0;
+    for (; j + CM_SIMD_WIDTH <= hidden; j += CM_SIMD_WIDTH)
+    {
+      _lstm_lanes(gi + j, go + j, gf + j, gc + j, cb + j, hb + j, CM_SIMD_WIDTH, clip, inputForget);
+    }
+    if (j != hidden)
+    {
+      _lstm_lanes(gi + j, go + j, gf + j, gc + j, cb + j, hb + j, hidden - j, clip, inputForget);
+    }
+  }
+}
+
+// the types of X, W, R and of the optional inputs, the half ones being computed in float.
+static inline bool _lstm_type(tensor_data_type_t type) { return type == TDT_FLOAT || cm_is_half(type); }
+
+// read n items of a tensor of the given type as floats.
+static void _lstm_load(tensor_data_type_t type, const void *src, float *dst, size_t n)
+{
+  if (!cm_to_float(type, src, dst, n))
+  {
+    cm_memcpy(dst, src, n * sizeof(float));
+  }
+}
+
+// write n floats of the state into an output of the given type.
+static void _lstm_store(tensor_data_type_t type, const float *src, void *dst, size_t n)
+{
+  if (!cm_from_float(type, src, dst, n))
+  {
+    cm_memcpy(dst, src, n * sizeof(float));
+  }
+}
+
+// X.Wt + bias for every timestep, with W packed when not null. The half operands are converted by tiles.
+static bool _lstm_projection(tensor_data_type_t type, int m, int n, int k, const void *x, const void *w, const float *packed, float *c, const float *bias)
+{
+  switch (type)
+  {
+  case TDT_FLOAT16:
+    return packed ? cm_hgemm_packed(m, n, k, (const cm_half_t *)x, k, packed, c, n, bias, false)
+                  : cm_hgemm_nt(m, n, k, (const cm_half_t *)x, k, (const cm_half_t *)w, k, c, n, bias, false);
+  case TDT_BFLOAT16:
+    return packed ? cm_bgemm_packed(m, n, k, (const cm_bfloat16_t *)x, k, packed, c, n, bias, false)
+                  : cm_bgemm_nt(m, n, k, (const cm_bfloat16_t *)x, k, (const cm_bfloat16_t *)w, k, c, n, bias, false);
+  default:
+    if (packed)
+    {
+      cm_sgemm_packed(m, n, k, (const float *)x, k, packed, c, n, bias, false);
+    }
+    else
+    {
+      cm_sgemm_nt(m, n, k, (const float *)x, k, (const float *)w, k, c, n, bias, false);
+    }
+    return true;
+  }
+}
+
+LSTM ::~LSTM()
+{
+  if (!this->_packedExternal)
+  {
+    cm_free(this->_packedW);
+    cm_free(this->_packedR);
+    cm_free(this->_packedBias);
+  }
+}
+
+void LSTM ::_getPackedSizes(size_t *w, size_t *r, size_t *bias)
+{
+  Tensor *tw = this->Opsc[LSTM_W_INDEX]->GetPayloadInfos();
+  Tensor *tr = this->Opsc[LSTM_R_INDEX]->GetPayloadInfos();
+  size_t directions = tw->Shape[0];
+  int gatesSize = (int)tw->Shape[1];
+  *w = directions * cm_sgemm_packed_size(gatesSize, (int)tw->Shape[2]);
+  *r = directions * cm_sgemm_packed_size(gatesSize, (int)tr->Shape[2]);
+  *bias = directions * gatesSize;
+}
+
+size_t LSTM ::SavePacked(void *buffer)
+{
+  if (!this->_packedW || !this->_packedR)
+  {
+    return 0;
+  }
+  size_t w, r, bias;
+  this->_getPackedSizes(&w, &r, &bias);
+  bias = this->_packedBias ? bias : 0;
+  if (buffer)
+  {
+    float *p = (float *)buffer;
+    cm_memcpy(p, this->_packedW, w * sizeof(float));
+    cm_memcpy(p + w, this->_packedR, r * sizeof(float));
+    if (bias)
+    {
+      cm_memcpy(p + w + r, this->_packedBias, bias * sizeof(float));
+    }
+  }
+  return (w + r + bias) * sizeof(float);
+}
+
+bool LSTM ::LoadPacked(const void *data, size_t size)
+{
+  if (!this->_hasInput(LSTM_W_INDEX) || !this->_hasInput(LSTM_R_INDEX) || this->_packedW)
+  {
+    return false;
+  }
+  Tensor *tw = this->Opsc[LSTM_W_INDEX]->GetPayloadInfos();
+  Tensor *tr = this->Opsc[LSTM_R_INDEX]->GetPayloadInfos();
+  if (!_lstm_type(tw->Type) || tr->Type != tw->Type || tw->Dimension != 3 || tr->Dimension != 3)
+  {
+    return false;
+  }
+  size_t w, r, bias;
+  this->_getPackedSizes(&w, &r, &bias);
+  // the folded bias is saved only when B is an initializer.
+  bias = size == (w + r + bias) * sizeof(float) ? bias : 0;
+  if (size != (w + r + bias) * sizeof(float))
+  {
+    return false;
+  }
+  const float *p = (const float *)data;
+  this->_packedW = (float *)p;
+  this->_packedR = (float *)(p + w);
+  this->_packedBias = bias ? (float *)(p + w + r) : nullptr;
+  this->_packedExternal = true;
+  return true;
+}
+
+bool LSTM ::Prepack()
+{
+  if (!this->_hasInput(LSTM_W_INDEX) || !this->_hasInput(LSTM_R_INDEX))
+  {
+    return true;
+  }
+  Tensor *w = this->Opsc[LSTM_W_INDEX]->GetPayloadInfos();
+  Tensor *r = this->Opsc[LSTM_R_INDEX]->GetPayloadInfos();
+  // weights are runtime inputs, nothing to prepare.
+  if (!w->Data || !r->Data || !_lstm_type(w->Type) || r->Type != w->Type || w->Dimension != 3 || r->Dimension != 3)
+  {
+    return true;
+  }
+
+  int directions = (int)w->Shape[0];
+  int gatesSize = (int)w->Shape[1];
+  int inputSize = (int)w->Shape[2];
+  int hidden = (int)r->Shape[2];
+  size_t wSize = cm_sgemm_packed_size(gatesSize, inputSize);
+  size_t rSize = cm_sgemm_packed_size(gatesSize, hidden);
+
+  this->_packedW = (float *)cm_malloc(directions * wSize * sizeof(float));
+  this->_packedR = (float *)cm_malloc(directions * rSize * sizeof(float));
+  if (!this->_packedW || !this->_packedR)
+  {
+    return false;
+  }
+  // the half weights are packed as floats, so they are converted once here rather than at every step.
+  bool half = cm_is_half(w->Type);
+  float *converted = half ? (float *)cm_malloc((size_t)gatesSize * max(inputSize, hidden) * sizeof(float)) : nullptr;
+  if (half && !converted)
+  {
+    return false;
+  }
+  size_t elementSize = half ? sizeof(cm_half_t) : sizeof(float);
+  for (int d = 0; d != directions; d++)
+  {
+    const void *wd = (const cm_byte_t *)w->Data + (size_t)d * gatesSize * inputSize * elementSize;
+    const void *rd = (const cm_byte_t *)r->Data + (size_t)d * gatesSize * hidden * elementSize;
+    if (half)
+    {
+      cm_to_float(w->Type, wd, converted, (size_t)gatesSize * inputSize);
+      wd = converted;
+    }
+    cm_sgemm_pack_b(gatesSize, inputSize, (const float *)wd, inputSize, this->_packedW + d * wSize);
+    if (half)
+    {
+      cm_to_float(r->Type, rd, converted, (size_t)gatesSize * hidden);
+      rd = converted;
+    }
+    cm_sgemm_pack_b(gatesSize, hidden, (const float *)rd, hidden, this->_packedR + d * rSize);
+  }
+  cm_free(converted);
+
+  if (this->_hasInput(LSTM_B_INDEX))
+  {
+    Tensor *b = this->Opsc[LSTM_B_INDEX]->GetPayloadInfos();
+    if (b->Data && b->Type == w->Type && b->Dimension == 2)
+    {
+      this->_packedBias = (float *)cm_malloc(directions * 2 * gatesSize * sizeof(float));
+      if (!this->_packedBias)
+      {
+        return false;
+      }
+      _lstm_load(b->Type, b->Data, this->_packedBias, (size_t)directions * 2 * gatesSize);
+      // Wb + Rb folded in place, the first half of the buffer is then the bias of every direction.
+      for (int d = 0; d != directions; d++)
+      {
+        const float *bd = this->_packedBias + (size_t)d * 2 * gatesSize;
+        for (int j = 0; j != gatesSize; j++)
+        {
+          this->_packedBias[d * gatesSize + j] = bd[j] + bd[gatesSize + j];
+        }
+      }
+    }
+  }
+  return true;
+}
+
+bool LSTM ::InferShapes(Tensor **infos)
+{
+  Tensor *x = this->_inferredInput(infos, LSTM_X_INDEX);
+  Tensor *w = this->_inferredInput(infos, LSTM_W_INDEX);
+  Tensor *r = this->_inferredInput(infos, LSTM_R_INDEX);
+  // sequence_lens and the peepholes are not supported, the model is rejected rather than computed without them.
+  if (!x || !w || !r || this->_hasInput(LSTM_SEQUENCE_LENS_INDEX) || this->_hasInput(LSTM_P_INDEX) || this->Opsc.Count() > LSTM_P_INDEX + 1)
+  {
+    return false;
+  }
+  if (!_lstm_type(x->Type) || w->Type != x->Type || r->Type != x->Type || x->Dimension != 3 || w->Dimension != 3 || r->Dimension != 3)
+  {
+    return false;
+  }
+  uint64_t directions = w->Shape[0];
+  uint64_t hidden = this->HiddenSize ? (uint64_t)this->HiddenSize : r->Shape[2];
+  if (directions != (this->Direction == LSTMDirection::BIDIRECTIONAL ? 2u : 1u) ||
+      w->Shape[1] != LSTM_GATE_COUNT * hidden || w->Shape[2] != x->Shape[2] ||
+      r->Shape[1] != LSTM_GATE_COUNT * hidden || r->Shape[2] != hidden)
+  {
+    return false;
+  }
+  // Y is [seq_length, num_directions, batch_size, hidden_size], Y_h and Y_c are [num_directions, batch_size, hidden_size].
+  uint64_t yShape[4] = {x->Shape[0], directions, x->Shape[1], hidden};
+  return this->_inferOutput(infos, LSTM_Y_INDEX, yShape, 4, x->Type) &&
+         this->_inferOutput(infos, LSTM_Y_H_INDEX, yShape + 1, 3, x->Type) &&
+         this->_inferOutput(infos, LSTM_Y_C_INDEX, yShape + 1, 3, x->Type);
+}
+
+// a given optional input must hold a tensor of the type of X and of the given shape, a blank one is null.
+static bool _lstm_optional(Tensor *t, bool given, tensor_data_type_t type, const uint64_t *shape, int dimension)
+{
+  if (!given)
+  {
+    return true;
+  }
+  if (!t || t->Type != type || t->Dimension != dimension)
+  {
+    return false;
+  }
+  for (int i = 0; i != dimension; i++)
+  {
+    if (t->Shape[i] != shape[i])
+    {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool LSTM ::Activate(ActivationContext *ctx)
+{
+  Tensor *x = this->_getValue(ctx, LSTM_X_INDEX);
+  Tensor *w = this->_getValue(ctx, LSTM_W_INDEX);
+  Tensor *r = this->_getValue(ctx, LSTM_R_INDEX);
+  if (!x || !w || !r || !_lstm_type(x->Type) || w->Type != x->Type || r->Type != x->Type || x->Dimension != 3 ||
+      this->_hasInput(LSTM_SEQUENCE_LENS_INDEX) || this->_hasInput(LSTM_P_INDEX))
+  {
+    return false;
+  }
+
+  // the optional inputs B, initial_h and initial_c are read by index, the blank ones are null slots.
+  Tensor *b = this->_getValue(ctx, LSTM_B_INDEX);
+  Tensor *h0 = this->_getValue(ctx, LSTM_INITIAL_H_INDEX);
+  Tensor *c0 = this->_getValue(ctx, LSTM_INITIAL_C_INDEX);
+
+  int seqLength = (int)x->Shape[0];
+  int batch = (int)x->Shape[1];
+  int inputSize = (int)x->Shape[2];
+  int directions = (int)w->Shape[0];
+  int hidden = this->HiddenSize ? this->HiddenSize : (int)r->Shape[2];
+  int gatesSize = LSTM_GATE_COUNT * hidden;
+
+  if (directions != (this->Direction == LSTMDirection::BIDIRECTIONAL ? 2 : 1) ||
+      (int)w->Shape[1] != gatesSize || (int)w->Shape[2] != inputSize ||
+      (int)r->Shape[1] != gatesSize || (int)r->Shape[2] != hidden)
+  {
+    return false;
+  }
+  uint64_t bShape[2] = {(uint64_t)directions, 2 * (uint64_t)gatesSize};
+  uint64_t stateShape[3] = {(uint64_t)directions, (uint64_t)batch, (uint64_t)hidden};
+  tensor_data_type_t type = x->Type;
+  if (!_lstm_optional(b, this->_hasInput(LSTM_B_INDEX), type, bShape, 2) ||
+      !_lstm_optional(h0, this->_hasInput(LSTM_INITIAL_H_INDEX), type, stateShape, 3) ||
+      !_lstm_optional(c0, this->_hasInput(LSTM_INITIAL_C_INDEX), type, stateShape, 3))
+  {
+    return false;
+  }
+
+  // the working memory is allocated once for all the timesteps: the input projection for the whole sequence, Wb and Rb
+  // then their sum, the hidden and cell states, and the float copy of a half R which is not packed.
+  IMemoryManagerPtr mm = ctx->GetEngine()->GetMemoryManager();
+  size_t projectionSize = (size_t)seqLength * batch * gatesSize;
+  size_t stateSize = (size_t)batch * hidden;
+  size_t elementSize = cm_is_half(type) ? sizeof(cm_half_t) : sizeof(float);
+  size_t convertedSize = cm_is_half(type) && !this->_packedR ? (size_t)gatesSize * hidden : 0;
+  float *workspace = (float *)mm->Malloc((projectionSize + 2 * gatesSize + 2 * stateSize + convertedSize) * sizeof(float));
+  if (!workspace)
+  {
+    return false;
+  }
+  float *projection = workspace;
+  float *bias = projection + projectionSize;
+  float *h = bias + 2 * gatesSize;
+  float *c = h + stateSize;
+  float *converted = c + stateSize;
+
+  TensorRefPtr outputs[LSTM_OUTPUT_COUNT] = {nullptr, nullptr, nullptr};
+  int outputCount = min(this->Onsc.Count(), LSTM_OUTPUT_COUNT);
+  uint64_t yShape[4] = {(uint64_t)seqLength, (uint64_t)directions, (uint64_t)batch, (uint64_t)hidden};
+  for (int i = 0; i != outputCount; i++)
+  {
+    outputs[i] = i == LSTM_Y_INDEX ? ctx->CreateOutputRef(this, yShape, 4, type, i) : ctx->CreateOutputRef(this, yShape + 1, 3, type, i);
+    if (!outputs[i])
+    {
+      goto _error;
+    }
+  }
+
+  {
+    cm_byte_t *y = outputs[LSTM_Y_INDEX] ? (cm_byte_t *)outputs[LSTM_Y_INDEX]->Value.Data : nullptr;
+    bool inputForget = this->InputForget != 0;
+
+    for (int d = 0; d != directions; d++)
+    {
+      const void *wd = (const cm_byte_t *)w->Data + (size_t)d * gatesSize * inputSize * elementSize;
+      const float *rd = (const float *)r->Data + (size_t)d * gatesSize * hidden;
+      bool reverse = this->Direction == LSTMDirection::REVERSE || d == 1;
+
+      const float *pw = this->_packedW ? this->_packedW + d * cm_sgemm_packed_size(gatesSize, inputSize) : nullptr;
+      const float *pr = this->_packedR ? this->_packedR + d * cm_sgemm_packed_size(gatesSize, hidden) : nullptr;
+      const float *db = nullptr;
+
+      // Wb and Rb are always summed, so we fold them once.
+      if (this->_packedBias)
+      {
+        db = this->_packedBias + d * gatesSize;
+      }
+      else if (b)
+      {
+        _lstm_load(type, (const cm_byte_t *)b->Data + (size_t)d * 2 * gatesSize * elementSize, bias, 2 * (size_t)gatesSize);
+        for (int j = 0; j != gatesSize; j++)
+        {
+          bias[j] += bias[gatesSize + j];
+        }
+        db = bias;
+      }
+
+      // X.Wt + B for every timestep as a single matrix product.
+      if (!_lstm_projection(type, seqLength * batch, gatesSize, inputSize, x->Data, wd, pw, projection, db))
+      {
+        goto _error;
+      }
+      // the recurrent product runs at every step, so a half R is converted once per direction.
+      if (!pr && cm_is_half(type))
+      {
+        cm_to_float(type, (const cm_byte_t *)r->Data + (size_t)d * gatesSize * hidden * elementSize, converted, (size_t)gatesSize * hidden);
+        rd = converted;
+      }
+
+      if (h0)
+      {
+        _lstm_load(type, (const cm_byte_t *)h0->Data + d * stateSize * elementSize, h, stateSize);
+      }
+      else
+      {
+        cm_memset(h, 0, stateSize * sizeof(float));
+      }
+      if (c0)
+      {
+        _lstm_load(type, (const cm_byte_t *)c0->Data + d * stateSize * elementSize, c, stateSize);
+      }
+      else
+      {
+        cm_memset(c, 0, stateSize * sizeof(float));
+      }
+
+      for (int s = 0; s != seqLength; s++)
+      {
+        int t = reverse ? seqLength - 1 - s : s;
+        float *gates = projection + (size_t)t * batch * gatesSize;
+        // gates += Ht-1.Rt
+        if (pr)
+        {
+          cm_sgemm_packed(batch, gatesSize, hidden, h, hidden, pr, gates, gatesSize, nullptr, true);
+        }
+        else
+        {
+          cm_sgemm_nt(batch, gatesSize, hidden, h, hidden, rd, hidden, gates, gatesSize, nullptr, true);
+        }
+        _lstm_cell(gates, h, c, batch, hidden, this->Clip, inputForget);
+        if (y)
+        {
+          _lstm_store(type, h, y + ((size_t)t * directions + d) * stateSize * elementSize, stateSize);
+        }
+      }
+
+      if (outputs[LSTM_Y_H_INDEX])
+      {
+        _lstm_store(type, h, (cm_byte_t *)outputs[LSTM_Y_H_INDEX]->Value.Data + d * stateSize * elementSize, stateSize);
+      }
+      if (outputs[LSTM_Y_C_INDEX])
+      {
+        _lstm_store(type, c, (cm_byte_t *)outputs[LSTM_Y_C_INDEX]->Value.Data + d * stateSize * elementSize, stateSize);
+      }
+    }
+  }
+
+  mm->Free(workspace);
+  return ctx->Forward(this, outputs, outputCount);
+
+_error:
+  for (int i = 0; i != LSTM_OUTPUT_COUNT; i++)
+  {
+    ctx->DiscardOutputRef(outputs[i]);
+  }
+  mm->Free(workspace);
+  return false;
+}
+
+bool LSTM ::TrySetAtt(const char *n, Att_value_t v)
+{
+  if (strcmp(n, "hidden_size") == 0)
+  {
+    this->HiddenSize = (int)v.i;
+    return true;
+  }
+  if (strcmp(n, "direction") == 0)
+  {
+    this->Direction = strcmp(v.s, "reverse") == 0 ? LSTMDirection::REVERSE : strcmp(v.s, "bidirectional") == 0 ? LSTMDirection::BIDIRECTIONAL
+                                                                                                               : LSTMDirection::FORWARD;
+    return this->Direction != LSTMDirection::FORWARD || strcmp(v.s, "forward") == 0;
+  }
+  if (strcmp(n, "clip") == 0)
+  {
+    this->Clip = v.f;
+    return true;
+  }
+  if (strcmp(n, "input_forget") == 0)
+  {
+    this->InputForget = (int)v.i;
+    return true;
+  }
+  // only the default layout, with the sequence first, is supported.
+  if (strcmp(n, "layout") == 0)
+  {
+    return v.i == 0;
+  }
+  // activations, activation_alpha and activation_beta are not supported, the default activations are always used.
+  return false;
+}
+
+void LSTM ::GetAtts(AttWriter *writer)
+{
+  Att_value_t v;
+  v.i = this->HiddenSize;
+  writer->Write("hidden_size", AttKind::INT, v);
+  v.s = this->Direction == LSTMDirection::REVERSE ? "reverse" : this->Direction == LSTMDirection::BIDIRECTIONAL ? "bidirectional"
+                                                                                                                 : "forward";
+  writer->Write("direction", AttKind::STRING, v);
+  v.f = this->Clip;
+  writer->Write("clip", AttKind::FLOAT, v);
+  v.i = this->InputForget;
+  writer->Write("input_forget", AttKind::INT, v);
+}
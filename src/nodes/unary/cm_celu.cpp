@@ -2,6 +2,7 @@
 
 #include "cm_graph.hpp"
 #include "nodes/unary/cm_celu.hpp"
+#include "math/cm_vmath.hpp"
 
 namespace CyanMycelium
 {
@@ -9,6 +10,16 @@ namespace CyanMycelium
 
   UNARY_FUNC_TEMPLATE_WITH_NODE(CELU)
 
+  // alpha is positive, so the exponential side is only kept for x <= 0.
+  template <>
+  void OP_FUNC_NAME(Celu)<float>(Tensor *x, Tensor *out, UnaryOperator *node)
+  {
+    float alpha = static_cast<Celu *>(node)->Alpha;
+    float inv = 1.0f / alpha;
+    cm_vmap(static_cast<float *>(x->Data), static_cast<float *>(out->Data), x->Count, [alpha, inv](cm_vfloat_t v)
+            { return v > 0.0f ? v : alpha * (cm_vexp(v * inv) - 1.0f); });
+  }
+
   // according to onnx documentation, Constrain input and output types to float32 tensors.
   UNARY_OP_ARRAY_IMPL(CELU,
                       nullptr,                         // Placeholder for TDT_UNDEFINED
@@ -0,0 +1,44 @@
+#include <cmath>
+
+#include "cm_graph.hpp"
+#include "nodes/unary/cm_elu.hpp"
+#include "math/cm_vmath.hpp"
+
+namespace CyanMycelium
+{
+#define ELU_CODE(x, n) (x < 0 ? (n)->Alpha * (exp(x) - 1) : x)
+
+  UNARY_FUNC_TEMPLATE_WITH_NODE(ELU)
+
+  template <>
+  void OP_FUNC_NAME(Elu)<float>(Tensor *x, Tensor *out, UnaryOperator *node)
+  {
+    float alpha = static_cast<Elu *>(node)->Alpha;
+    cm_vmap(static_cast<float *>(x->Data), static_cast<float *>(out->Data), x->Count, [alpha](cm_vfloat_t v)
+            { return v < 0.0f ? alpha * (cm_vexp(v) - 1.0f) : v; });
+  }
+
+  // according to onnx documentation, Constrain input and output types to float tensors.
+  UNARY_OP_ARRAY_IMPL(ELU,
+                      nullptr,                         // Placeholder for TDT_UNDEFINED
+                      UNARY_FUNCTION_PTR(ELU, float),  // Function for TDT_FLOAT
+                      nullptr,                         // Function for TDT_UINT8
+                      nullptr,                         // Function for TDT_INT8
+                      nullptr,                         // Function for TDT_UINT16
+                      nullptr,                         // Function for TDT_INT16
+                      nullptr,                         // Function for TDT_INT32
+                      nullptr,                         // Function for TDT_INT64
+                      nullptr,                         // Function for TDT_STRING
+                      nullptr,                         // Function for TDT_BOOL
+                      nullptr,                         // Function for TDT_FLOAT16
+                      UNARY_FUNCTION_PTR(ELU, double), // Function for TDT_DOUBLE
+                      nullptr,                         // Function for TDT_UINT32
+                      nullptr,                         // Function for TDT_UINT64
+                      nullptr,                         // Function for TDT_COMPLEX64
+                      nullptr,                         // Function for TDT_COMPLEX128
+                      nullptr,                         // Function for TDT_BFLOAT16
+                      nullptr,                         // Function for TDT_FLOAT8E4M3FN
+                      nullptr,                         // Function for TDT_FLOAT8E4M3FNUZ
+                      nullptr,                         // Function for TDT_FLOAT8E5M2
+                      nullptr);                        // Function for TDT_FLOAT8E5M2FNUZ
+}
\ No newline at end of file
@@ -0,0 +1,50 @@
+#include <cmath>
+
+#include "cm_graph.hpp"
+#include "nodes/unary/cm_gelu.hpp"
+#include "math/cm_vmath.hpp"
+
+namespace CyanMycelium
+{
+#define GELU_CODE(x, n) ((n)->Approximate ? 0.5 * x * (1 + tanh(0.797884560802865356 * (x + 0.044715 * x * x * x))) \
+                                         : 0.5 * x * (1 + erf(x * 0.707106781186547524)))
+
+  UNARY_FUNC_TEMPLATE_WITH_NODE(GELU)
+
+  template <>
+  void OP_FUNC_NAME(Gelu)<float>(Tensor *x, Tensor *out, UnaryOperator *node)
+  {
+    float *data = static_cast<float *>(x->Data);
+    float *res = static_cast<float *>(out->Data);
+    if (static_cast<Gelu *>(node)->Approximate)
+    {
+      cm_gelu_tanh(data, res, x->Count);
+      return;
+    }
+    cm_gelu(data, res, x->Count);
+  }
+
+  // according to onnx documentation, Constrain input and output types to float tensors.
+  UNARY_OP_ARRAY_IMPL(GELU,
+                      nullptr,                          // Placeholder for TDT_UNDEFINED
+                      UNARY_FUNCTION_PTR(GELU, float),  // Function for TDT_FLOAT
+                      nullptr,                          // Function for TDT_UINT8
+                      nullptr,                          // Function for TDT_INT8
+                      nullptr,                          // Function for TDT_UINT16
+                      nullptr,                          // Function for TDT_INT16
+                      nullptr,                          // Function for TDT_INT32
+                      nullptr,                          // Function for TDT_INT64
+                      nullptr,                          // Function for TDT_STRING
+                      nullptr,                          // Function for TDT_BOOL
+                      nullptr,                          // Function for TDT_FLOAT16
+                      UNARY_FUNCTION_PTR(GELU, double), // Function for TDT_DOUBLE
+                      nullptr,                          // Function for TDT_UINT32
+                      nullptr,                          // Function for TDT_UINT64
+                      nullptr,                          // Function for TDT_COMPLEX64
+                      nullptr,                          // Function for TDT_COMPLEX128
+                      nullptr,                          // Function for TDT_BFLOAT16
+                      nullptr,                          // Function for TDT_FLOAT8E4M3FN
+                      nullptr,                          // Function for TDT_FLOAT8E4M3FNUZ
+                      nullptr,                          // Function for TDT_FLOAT8E5M2
+                      nullptr);                         // Function for TDT_FLOAT8E5M2FNUZ
+}
\ No newline at end of file
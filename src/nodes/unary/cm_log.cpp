@@ -0,0 +1,43 @@
+#include <cmath>
+
+#include "cm_graph.hpp"
+#include "nodes/unary/cm_unary.hpp"
+#include "math/cm_vmath.hpp"
+
+namespace CyanMycelium
+{
+#define LOG_CODE(a) log(a)
+
+  UNARY_FUNC_TEMPLATE(LOG)
+
+  // the float tensors use the vectorized logarithm of cm_vmath.hpp.
+  template <>
+  void OP_FUNC_NAME(Log)<float>(Tensor *x, Tensor *out, UnaryOperator *node)
+  {
+    cm_log(static_cast<float *>(x->Data), static_cast<float *>(out->Data), x->Count);
+  }
+
+  // according to onnx documentation, Constrain input and output types to float tensors.
+  UNARY_OP_ARRAY_IMPL(LOG,
+                      nullptr,                         // Placeholder for TDT_UNDEFINED
+                      UNARY_FUNCTION_PTR(LOG, float),  // Function for TDT_FLOAT
+                      nullptr,                         // Function for TDT_UINT8
+                      nullptr,                         // Function for TDT_INT8
+                      nullptr,                         // Function for TDT_UINT16
+                      nullptr,                         // Function for TDT_INT16
+                      nullptr,                         // Function for TDT_INT32
+                      nullptr,                         // Function for TDT_INT64
+                      nullptr,                         // Function for TDT_STRING
+                      nullptr,                         // Function for TDT_BOOL
+                      nullptr,                         // Function for TDT_FLOAT16
+                      UNARY_FUNCTION_PTR(LOG, double), // Function for TDT_DOUBLE
+                      nullptr,                         // Function for TDT_UINT32
+                      nullptr,                         // Function for TDT_UINT64
+                      nullptr,                         // Function for TDT_COMPLEX64
+                      nullptr,                         // Function for TDT_COMPLEX128
+                      nullptr,                         // Function for TDT_BFLOAT16
+                      nullptr,                         // Function for TDT_FLOAT8E4M3FN
+                      nullptr,                         // Function for TDT_FLOAT8E4M3FNUZ
+                      nullptr,                         // Function for TDT_FLOAT8E5M2
+                      nullptr);                        // Function for TDT_FLOAT8E5M2FNUZ
+}
\ No newline at end of file
@@ -5,6 +5,7 @@ using namespace CyanMycelium;
 using namespace BlueSteelLadyBug;
 
 #define GRAPH_FIELD_NUMBER 7
+#define OPSET_IMPORT_FIELD_NUMBER 8
 #define NODE_FIELD_NUMBER 1
 #define INITIALIZER_FIELD_NUMBER 5
 #define INPUT_FIELD_NUMBER 11
@@ -41,8 +42,22 @@ using namespace BlueSteelLadyBug;
 #define TENSOR_DOUBLE_DATA_FIELD_NUMBER 10
 #define TENSOR_UINT64_DATA_FIELD_NUMBER 11
 
+#define OPSET_DOMAIN_FIELD_NUMBER 1
+#define OPSET_VERSION_FIELD_NUMBER 2
+// the name of the default domain, the one of the standard operators, which may also be left empty.
+#define OPSET_DEFAULT_DOMAIN "ai.onnx"
+
+#define TANNOTATION_TENSOR_NAME_FIELD_NUMBER 1
+#define TANNOTATION_PARAMETERS_FIELD_NUMBER 2
+#define STRING_ENTRY_KEY_FIELD_NUMBER 1
+#define STRING_ENTRY_VALUE_FIELD_NUMBER 2
+
+#define QUANTIZATION_SCALE_KEY "SCALE_TENSOR"
+#define QUANTIZATION_ZERO_POINT_KEY "ZERO_POINT_TENSOR"
+
 #define READ_FUNC_0(n) n(subReader)
 #define READ_FUNC_1(n, p) n(p, subReader)
+#define READ_FUNC_2(n, p, q) n(p, q, subReader)
 
 #define READ_SUB_MESSAGE(r, f, a)                   \
     PBReader *subReader = r->getSubMessageReader(); \
@@ -71,9 +86,43 @@ using namespace BlueSteelLadyBug;
 OnnxGraphBuilder ::OnnxGraphBuilder(int initialNodesCollectionSize, int initialLinkCollectionSize) : _nodes(max(initialNodesCollectionSize, CM_DEFAULT_COLLECTION_CAPACITY)),
                                                                                                      _links(max(initialLinkCollectionSize, CM_DEFAULT_COLLECTION_CAPACITY))
 {
+    this->_reader = nullptr;
+    this->_error = ONNX_GB_SUCCESS;
+    this->_arena = nullptr;
+    this->_arenaSize = 0;
+    this->_arenaUsed = 0;
+    this->_opset = 0;
+}
+
+OnnxGraphBuilder ::~OnnxGraphBuilder()
+{
+    // the graph was not built, the objects placed into the arena are destroyed before releasing it.
+    if (this->_arena)
+    {
+        for (int i = 0; i != this->_nodes.Count(); i++)
+        {
+            if (this->_inArena(this->_nodes[i]))
+            {
+                this->_nodes[i]->~Operator();
+            }
+        }
+        KeyValueCollection<Link *>::Iterator<KeyValue<Link *>> i = this->_links.GetIterator();
+        while (i.MoveNext())
+        {
+            Link *l = i.Current()->Value;
+            if (l && this->_inArena(l))
+            {
+                l->~Link();
+            }
+        }
+        cm_free(this->_arena);
+    }
 }
 
-OnnxGraphBuilder ::~OnnxGraphBuilder() {}
+static inline size_t _align(size_t size)
+{
+    return (size + ONNX_GB_ARENA_ALIGNMENT - 1) & ~(size_t)(ONNX_GB_ARENA_ALIGNMENT - 1);
+}
 
 OnnxGraphBuilder &OnnxGraphBuilder ::WithReader(PBReader *reader)
 {
@@ -85,6 +134,34 @@ Graph *OnnxGraphBuilder ::Build(Graph *target)
 {
     if (this->_reader)
     {
+        Operator *failed = nullptr;
+        // a first pass declares the links and sizes the arena, so every object of the graph is placed into a single block.
+        // A stream which cannot seek is read once, and the objects are allocated one by one.
+        if (this->_reader->getInput()->canSeek())
+        {
+            this->_arenaSize = 0;
+            this->_reader->save();
+            while (this->_arenaSize != (size_t)-1 && this->_reader->readTag())
+            {
+                if (this->_reader->getFieldNumber() == GRAPH_FIELD_NUMBER)
+                {
+                    READ_SUB_MESSAGE(this->_reader, READ_FUNC_0(_countGraph), this->_arenaSize = (size_t)-1)
+                    continue;
+                }
+                if (!this->_reader->skip())
+                {
+                    this->_arenaSize = (size_t)-1;
+                }
+            }
+            this->_reader->restore();
+            // the errors are reported by the second pass.
+            this->_error = ONNX_GB_SUCCESS;
+            this->_arenaSize = this->_arenaSize != (size_t)-1 ? this->_arenaSize + this->_links.Count() * _align(sizeof(Link)) : 0;
+            this->_arena = this->_arenaSize ? (lb_byte_t *)cm_malloc(this->_arenaSize) : nullptr;
+            this->_arenaSize = this->_arena ? this->_arenaSize : 0;
+            this->_arenaUsed = 0;
+        }
+
         while (this->_reader->readTag())
         {
             // skip every fields from the model and focus on graph.
@@ -93,18 +170,51 @@ Graph *OnnxGraphBuilder ::Build(Graph *target)
                 READ_SUB_MESSAGE(this->_reader, READ_FUNC_0(_readGraph), goto _error)
                 continue;
             }
+            if (this->_reader->getFieldNumber() == OPSET_IMPORT_FIELD_NUMBER)
+            {
+                READ_SUB_MESSAGE(this->_reader, READ_FUNC_0(_readOpsetImport), goto _error)
+                continue;
+            }
             __READ(this->_reader->skip(), goto _error);
         }
+        // the opsets come after the graph, a model without any keeps the semantic of the latest one.
+        for (int i = 0; this->_opset && i != this->_nodes.Count(); i++)
+        {
+            if (!this->_nodes[i]->SetOpset(this->_opset))
+            {
+                SET_ERROR_1(ONNX_GB_UNSUPPORTED_NODE, this->_nodes[i]->TypeName)
+                goto _error;
+            }
+        }
+        // every node is linked, the decomposed operators are rewritten and the chains of operators computed in a single pass
+        // are folded before preparing the constants.
+        this->_rewritePatterns();
+        this->_fuseNodes();
+        // every node is linked and every initializer is read, the operators may now prepare their constants.
+        for (int i = 0; i != this->_nodes.Count(); i++)
+        {
+            if (!this->_nodes[i]->Prepack())
+            {
+                SET_ERROR_1(ONNX_GB_SYSTEM_ERROR, "prepack")
+                goto _error;
+            }
+        }
         // copy the graph content
         target = target ? target : new Graph(this->_nodes.Count(), _links.Count());
         // 1 - nodes
         this->_nodes.GetIterator().To(&target->Nodes);
 
-        // 2 -> links
+        // 2 -> links, numbered by their position into the graph.
         KeyValueCollection<Link *>::Iterator<KeyValue<Link *>> i = this->_links.GetIterator();
         while (i.MoveNext())
         {
             KeyValue<Link *> *entry = i.Current();
+            // a name declared by the first pass may have no link.
+            if (!entry->Value)
+            {
+                continue;
+            }
+            entry->Value->Id = target->Links.Count();
             target->Links.Add(entry->Value);
             if (entry->Value->Oini == nullptr)
             {
@@ -122,6 +232,23 @@ Graph *OnnxGraphBuilder ::Build(Graph *target)
         target->Links.Trim();
         target->Inputs.Trim();
         target->Outputs.Trim();
+        target->AnalyzeInPlace();
+        if (!target->Compile())
+        {
+            SET_ERROR_1(ONNX_GB_SYSTEM_ERROR, "topology")
+            goto _error;
+        }
+        // the shapes which do not depend on runtime values are known, and checked, before the first inference.
+        if (target->InferShapes(&failed) < 0)
+        {
+            SET_ERROR_1(ONNX_GB_INVALID_SHAPE, failed ? failed->TypeName : "shape")
+            goto _error;
+        }
+        if (this->_arena)
+        {
+            target->SetArena(this->_arena, this->_arenaSize);
+            this->_arena = nullptr;
+        }
     }
     return target;
 _error:
@@ -174,6 +301,10 @@ bool OnnxGraphBuilder ::_readGraph(PBReader *reader)
             // For tensor 'a', it may have {'SCALE_TENSOR', 'a_scale'} and {'ZERO_POINT_TENSOR', 'a_zero_point'} annotated,
             // which means, tensor 'a_scale' and tensor 'a_zero_point' are scale and zero point of tensor 'a' in the model.
         case (QUANTIZATION_FIELD_NUMBER):
+        {
+            READ_SUB_MESSAGE(reader, READ_FUNC_1(_readQuantizationAnnotation, cache), goto _error)
+            continue;
+        }
         default:
         {
             __READ(reader->skip(), goto _error)
@@ -185,6 +316,193 @@ _error:
     return false;
 }
 
+bool OnnxGraphBuilder ::_countGraph(PBReader *reader)
+{
+    char cache[CM_KEY_MAX_LENGTH];
+    while (reader->readTag())
+    {
+        switch (reader->getFieldNumber())
+        {
+        case (NODE_FIELD_NUMBER):
+        {
+            READ_SUB_MESSAGE(reader, READ_FUNC_1(_countNode, cache), return false)
+            continue;
+        }
+        case (INITIALIZER_FIELD_NUMBER):
+        {
+            READ_SUB_MESSAGE(reader, READ_FUNC_1(_countInitializer, cache), return false)
+            continue;
+        }
+        case (INPUT_FIELD_NUMBER):
+        case (OUTPUT_FIELD_NUMBER):
+        case (VALUE_INFO_FIELD_NUMBER):
+        {
+            READ_SUB_MESSAGE(reader, READ_FUNC_1(_countNames, cache), return false)
+            continue;
+        }
+        case (QUANTIZATION_FIELD_NUMBER):
+        {
+            READ_SUB_MESSAGE(reader, READ_FUNC_1(_countQuantizationAnnotation, cache), return false)
+            continue;
+        }
+        default:
+        {
+            __READ(reader->skip(), return false)
+        }
+        }
+    }
+    return true;
+}
+
+bool OnnxGraphBuilder ::_countNode(char *cache, PBReader *reader)
+{
+    while (reader->readTag())
+    {
+        switch (reader->getFieldNumber())
+        {
+        case (NODE_TYPE_FIELD_NUMBER):
+        {
+            __READ(reader->readValue_s(cache, CM_KEY_MAX_LENGTH), return false)
+            size_t size = NodeRegistry ::SizeOf(cache);
+            // the second pass reports the unsupported node.
+            if (!size)
+            {
+                return false;
+            }
+            this->_arenaSize += _align(size);
+            break;
+        }
+        case (NODE_INPUT_FIELD_NUMBER):
+        case (NODE_OUTPUT_FIELD_NUMBER):
+        {
+            __READ(reader->readValue_s(cache, CM_KEY_MAX_LENGTH), return false)
+            if (cache[0])
+            {
+                this->_declareLink(cache);
+            }
+            break;
+        }
+        default:
+        {
+            __READ(reader->skip(), return false)
+            break;
+        }
+        }
+    }
+    return true;
+}
+
+// the value infos, only the name matters.
+bool OnnxGraphBuilder ::_countNames(char *cache, PBReader *reader)
+{
+    while (reader->readTag())
+    {
+        if (reader->getFieldNumber() == VINFOS_NAME_FIELD_NUMBER)
+        {
+            __READ(reader->readValue_s(cache, CM_KEY_MAX_LENGTH), return false)
+            this->_declareLink(cache);
+            continue;
+        }
+        __READ(reader->skip(), return false)
+    }
+    return true;
+}
+
+bool OnnxGraphBuilder ::_countInitializer(char *cache, PBReader *reader)
+{
+    lb_uint64_t shape[TENSOR_MAX_DIMENSION];
+    int count = 0;
+    lb_uint32_t type;
+    while (reader->readTag())
+    {
+        switch (reader->getFieldNumber())
+        {
+        case TENSOR_DIM_FIELD_NUMBER:
+        {
+            if (count < TENSOR_MAX_DIMENSION)
+            {
+                __READ(reader->readValue(shape + count), return false)
+                count++;
+                continue;
+            }
+            __READ(reader->skip(), return false)
+            continue;
+        }
+        case TENSOR_DATA_TYPE_FIELD_NUMBER:
+        {
+            __READ(reader->readValue(&type), return false)
+            TensorInfos t(shape, count, (tensor_data_type_t)type);
+            this->_arenaSize += _align(t.Size);
+            continue;
+        }
+        case TENSOR_NAME_FIELD_NUMBER:
+        {
+            __READ(reader->readValue_s(cache, CM_KEY_MAX_LENGTH), return false)
+            this->_declareLink(cache);
+            continue;
+        }
+        default:
+        {
+            __READ(reader->skip(), return false)
+        }
+        }
+    }
+    return true;
+}
+
+bool OnnxGraphBuilder ::_countQuantizationAnnotation(char *cache, PBReader *reader)
+{
+    char value[CM_KEY_MAX_LENGTH];
+    bool named = false;
+    while (reader->readTag())
+    {
+        switch (reader->getFieldNumber())
+        {
+        case TANNOTATION_TENSOR_NAME_FIELD_NUMBER:
+        {
+            __READ(reader->readValue_s(cache, CM_KEY_MAX_LENGTH), return false)
+            this->_declareLink(cache);
+            named = true;
+            continue;
+        }
+        case TANNOTATION_PARAMETERS_FIELD_NUMBER:
+        {
+            READ_SUB_MESSAGE(reader, READ_FUNC_2(_readStringEntry, cache, value), return false)
+            if (named && (strcmp(cache, QUANTIZATION_SCALE_KEY) == 0 || strcmp(cache, QUANTIZATION_ZERO_POINT_KEY) == 0))
+            {
+                this->_declareLink(value);
+            }
+            continue;
+        }
+        default:
+        {
+            __READ(reader->skip(), return false)
+        }
+        }
+    }
+    return true;
+}
+
+void OnnxGraphBuilder ::_declareLink(const char *name)
+{
+    if (this->_links.IndexOf(name) < 0)
+    {
+        this->_links.Set(name, nullptr);
+    }
+}
+
+void *OnnxGraphBuilder ::_fromArena(size_t size)
+{
+    size = _align(size);
+    if (this->_arenaUsed + size > this->_arenaSize)
+    {
+        return nullptr;
+    }
+    void *p = this->_arena + this->_arenaUsed;
+    this->_arenaUsed += size;
+    return p;
+}
+
 bool OnnxGraphBuilder ::_readNode(char *cache, PBReader *reader)
 {
     // we need to conduct a first pass read of the node to find the TYPE,
@@ -209,8 +527,11 @@ bool OnnxGraphBuilder ::_readNode(char *cache, PBReader *reader)
         return false;
     }
 
+    n->Id = this->_nodes.Count();
     this->_nodes.Add(n);
 
+    // the blank inputs read so far, which become null slots when a given input follows them.
+    int blanks = 0;
     // parse name & specifics attributes
     while (reader->readTag())
     {
@@ -220,6 +541,9 @@ bool OnnxGraphBuilder ::_readNode(char *cache, PBReader *reader)
         {
             // NOTE : Avoid creating a sub reader by using position based parse pattern
             Att_value_t value;
+            char text[CM_KEY_MAX_LENGTH];
+            lb_uint64_t ints[CM_ATT_INTS_MAX_COUNT];
+            size_t intsCount = 0;
             lb_uint64_t size;
             __READ(reader->readLength(&size, false), return false)
             lb_uint64_t end = reader->getPosition() + size;
@@ -244,6 +568,39 @@ bool OnnxGraphBuilder ::_readNode(char *cache, PBReader *reader)
                     __READ(reader->readValue(&value.i), return false)
                     break;
                 }
+                case (4):
+                {
+                    __READ(reader->readValue_s(text, CM_KEY_MAX_LENGTH), return false)
+                    value.s = text;
+                    break;
+                }
+                case (8):
+                {
+                    // repeated ints are usually not packed, but both encodings are valid.
+                    if (reader->getWireType() == PB_LEN)
+                    {
+                        size_t count;
+                        if (!reader->readPacked(ints + intsCount, PB_VARINT, CM_ATT_INTS_MAX_COUNT - intsCount, &count))
+                        {
+                            SET_ERROR_1(ONNX_GB_UNSUPPORTED_ATTRIBUTE, cache)
+                            return false;
+                        }
+                        intsCount += count;
+                    }
+                    else
+                    {
+                        if (intsCount == CM_ATT_INTS_MAX_COUNT)
+                        {
+                            SET_ERROR_1(ONNX_GB_UNSUPPORTED_ATTRIBUTE, cache)
+                            return false;
+                        }
+                        __READ(reader->readValue(ints + intsCount), return false)
+                        intsCount++;
+                    }
+                    value.ints.v = (const cm_int64_t *)ints;
+                    value.ints.n = (int)intsCount;
+                    break;
+                }
                 default:
                 {
                     __READ(reader->skip(), return false)
@@ -263,14 +620,19 @@ bool OnnxGraphBuilder ::_readNode(char *cache, PBReader *reader)
         case (NODE_INPUT_FIELD_NUMBER):
         {
             __READ(reader->readValue_s(cache, CM_KEY_MAX_LENGTH), return false)
-            // some inputs in ONNX can be left blank to separate topics
+            // some inputs in ONNX can be left blank to separate topics, the next ones keep their index.
             if (!cache[0])
             {
+                blanks++;
                 break;
             }
             Link *l = this->_getOrCreateLink(cache);
             if (l)
             {
+                for (Link *blank = nullptr; blanks; blanks--)
+                {
+                    n->Opsc.Add(blank);
+                }
                 l->Ofin = n;
                 n->Opsc.Add(l);
             }
@@ -363,6 +725,18 @@ bool OnnxGraphBuilder ::_readValueInfos(char *cache, BlueSteelLadyBug ::PBReader
     }                                               \
     __READ(reader->readValue(d + i++), goto _error);
 
+// narrow a varint decoded integer to the item size of the tensor, items are little endian.
+static bool _setIntegerData(Tensor &t, int i, lb_uint64_t v)
+{
+    if ((size_t)i >= t.Count)
+    {
+        return false;
+    }
+    size_t itemSize = t.Size / t.Count;
+    cm_memcpy((lb_byte_t *)t.Data + i * itemSize, &v, itemSize);
+    return true;
+}
+
 /// @brief reading Tensor as initializer. Basically, initializer has a field index of 5, which is
 /// make them arise after node read but before input, output and value_info.
 /// so we may need to read the shape and the data.
@@ -391,7 +765,8 @@ bool OnnxGraphBuilder ::_readInitializer(char *cache, BlueSteelLadyBug ::PBReade
         {
             __READ(reader->readValue(&type), goto _error)
             t.Set(shape, count, (tensor_data_type_t)type);
-            t.Data = this->_malloc(t.Size);
+            t.Data = this->_fromArena(t.Size);
+            t.Data = t.Data ? t.Data : this->_malloc(t.Size);
             continue;
         }
 
@@ -400,8 +775,35 @@ bool OnnxGraphBuilder ::_readInitializer(char *cache, BlueSteelLadyBug ::PBReade
             READ_TENSOR_DATA_0(lb_float_t)
             continue;
         }
-        case TENSOR_STRING_DATA_FIELD_NUMBER:
+        // int32_data holds one varint per item for the int32, int16, int8, uint16, uint8 and bool types,
+        // which is the usual encoding of the small quantization parameters. int64_data holds the int64 items.
+        case TENSOR_INT32_DATA_FIELD_NUMBER:
         case TENSOR_INT64_DATA_FIELD_NUMBER:
+        {
+            if (!t.Data || !t.Count)
+            {
+                SET_ERROR_0(ONNX_GB_UNSUPPORTED_TENSOR_DATA_TYPE)
+                goto _error;
+            }
+            if (reader->getWireType() == PB_LEN)
+            {
+                size_t n = 0;
+                lb_uint64_t *values = (lb_uint64_t *)this->_malloc((t.Count - i) * sizeof(lb_uint64_t));
+                bool res = values && reader->readPacked(values, PB_VARINT, t.Count - i, &n);
+                for (size_t j = 0; res && j != n; j++)
+                {
+                    res = _setIntegerData(t, i++, values[j]);
+                }
+                this->_free(values);
+                __READ(res, goto _error)
+                continue;
+            }
+            lb_uint64_t value;
+            __READ(reader->readValue(&value), goto _error)
+            __READ(_setIntegerData(t, i++, value), goto _error)
+            continue;
+        }
+        case TENSOR_STRING_DATA_FIELD_NUMBER:
         {
             SET_ERROR_0(ONNX_GB_UNSUPPORTED_TENSOR_DATA_TYPE)
             __READ(reader->skip(), goto _error)
@@ -421,6 +823,16 @@ bool OnnxGraphBuilder ::_readInitializer(char *cache, BlueSteelLadyBug ::PBReade
             break;
         }
         case TENSOR_RAW_DATA_FIELD_NUMBER:
+        {
+            // raw little endian bytes, the usual encoding of the half precision weights.
+            if (!t.Data)
+            {
+                SET_ERROR_0(ONNX_GB_UNSUPPORTED_TENSOR_DATA_TYPE)
+                goto _error;
+            }
+            __READ(reader->readValue_s((lb_byte_t *)t.Data, (int)t.Size), goto _error)
+            continue;
+        }
         case TENSOR_DOUBLE_DATA_FIELD_NUMBER:
         case TENSOR_UINT64_DATA_FIELD_NUMBER:
         {
@@ -437,7 +849,7 @@ bool OnnxGraphBuilder ::_readInitializer(char *cache, BlueSteelLadyBug ::PBReade
     return true;
 
 _error:
-    if (t.Data)
+    if (t.Data && !this->_inArena(t.Data))
     {
         // clean memory.
         this->_free(t.Data);
@@ -445,6 +857,109 @@ _error:
     return false;
 }
 
+// Binds a tensor to its quantization parameters, {'SCALE_TENSOR', 'a_scale'} and {'ZERO_POINT_TENSOR', 'a_zero_point'}.
+// The annotations are read after the nodes and the initializers, so the links usually exist already.
+bool OnnxGraphBuilder ::_readQuantizationAnnotation(char *cache, BlueSteelLadyBug ::PBReader *reader)
+{
+    char value[CM_KEY_MAX_LENGTH];
+    Link *link = nullptr;
+    while (reader->readTag())
+    {
+        switch (reader->getFieldNumber())
+        {
+        case TANNOTATION_TENSOR_NAME_FIELD_NUMBER:
+        {
+            __READ(reader->readValue_s(cache, CM_KEY_MAX_LENGTH), return false)
+            link = this->_getOrCreateLink(cache);
+            continue;
+        }
+        case TANNOTATION_PARAMETERS_FIELD_NUMBER:
+        {
+            READ_SUB_MESSAGE(reader, READ_FUNC_2(_readStringEntry, cache, value), return false)
+            // NOTE : the tensor name is declared first, so it is known when reading the parameters.
+            if (!link)
+            {
+                continue;
+            }
+            if (strcmp(cache, QUANTIZATION_SCALE_KEY) == 0)
+            {
+                link->Quantization.Scale = this->_getOrCreateLink(value);
+            }
+            else if (strcmp(cache, QUANTIZATION_ZERO_POINT_KEY) == 0)
+            {
+                link->Quantization.ZeroPoint = this->_getOrCreateLink(value);
+            }
+            continue;
+        }
+        default:
+        {
+            __READ(reader->skip(), return false)
+        }
+        }
+    }
+    return true;
+}
+
+bool OnnxGraphBuilder ::_readOpsetImport(BlueSteelLadyBug ::PBReader *reader)
+{
+    char domain[CM_KEY_MAX_LENGTH];
+    lb_int64_t version = 0;
+    domain[0] = 0;
+    while (reader->readTag())
+    {
+        switch (reader->getFieldNumber())
+        {
+        case OPSET_DOMAIN_FIELD_NUMBER:
+        {
+            __READ(reader->readValue_s(domain, CM_KEY_MAX_LENGTH), return false)
+            continue;
+        }
+        case OPSET_VERSION_FIELD_NUMBER:
+        {
+            __READ(reader->readValue(&version), return false)
+            continue;
+        }
+        default:
+        {
+            __READ(reader->skip(), return false)
+        }
+        }
+    }
+    // the opsets of the other domains do not change the standard operators.
+    if (!domain[0] || strcmp(domain, OPSET_DEFAULT_DOMAIN) == 0)
+    {
+        this->_opset = (int)version;
+    }
+    return true;
+}
+
+bool OnnxGraphBuilder ::_readStringEntry(char *key, char *value, BlueSteelLadyBug ::PBReader *reader)
+{
+    key[0] = 0;
+    value[0] = 0;
+    while (reader->readTag())
+    {
+        switch (reader->getFieldNumber())
+        {
+        case STRING_ENTRY_KEY_FIELD_NUMBER:
+        {
+            __READ(reader->readValue_s(key, CM_KEY_MAX_LENGTH), return false)
+            continue;
+        }
+        case STRING_ENTRY_VALUE_FIELD_NUMBER:
+        {
+            __READ(reader->readValue_s(value, CM_KEY_MAX_LENGTH), return false)
+            continue;
+        }
+        default:
+        {
+            __READ(reader->skip(), return false)
+        }
+        }
+    }
+    return true;
+}
+
 bool OnnxGraphBuilder ::_readTensorType(TensorInfos *t, BlueSteelLadyBug ::PBReader *reader)
 {
     lb_uint32_t type;
@@ -483,33 +998,26 @@ bool OnnxGraphBuilder ::_readTensorShape(TensorInfos *t, BlueSteelLadyBug ::PBRe
         {
         case SHAPE_DIM_FIELD_NUMBER:
         {
-            lb_uint64_t length;
-            __READ(reader->readLength(&length, false), return false)
-            if (length == 0)
+            if (count == TENSOR_MAX_DIMENSION)
             {
-                // In ONNX, when you encounter a dimension (dim) that is empty or has a size of 0 within the valueInfo for an output,
-                // it typically signifies that the dimension size is unknown or variable at the graph's construction time.
-                // This is often used when the exact size of the dimension depends on runtime factors or dynamic input data,
-                // and it's not predetermined during the graph's creation.
-                SET_ERROR_0(ONNX_GB_UNSUPPORTED_TENSOR_UNKNOWN_DIM);
+                SET_ERROR_0(ONNX_GB_UNSUPPORTED_TENSOR_DIM);
                 return false;
             }
+            lb_uint64_t length;
+            __READ(reader->readLength(&length, false), return false)
+            // a symbolic dimension (dim_param), or a dimension without any value, is only known at runtime.
+            // The graph is then specialized for the shapes of the inputs by the ShapePlan of each inference.
+            shape[count] = TENSOR_DYNAMIC_DIM;
             lb_uint64_t end = reader->getPosition() + length;
-            do
+            while (reader->getPosition() < end)
             {
                 __READ(reader->readTag(), return false)
                 switch (reader->getFieldNumber())
                 {
                 case DIM_VALUE_FIELD_NUMBER:
                 {
-                    if (count < TENSOR_MAX_DIMENSION)
-                    {
-                        __READ(reader->readValue(shape + count), return false)
-                        count++;
-                        continue;
-                    }
-                    SET_ERROR_0(ONNX_GB_UNSUPPORTED_TENSOR_DIM);
-                    return false;
+                    __READ(reader->readValue(shape + count), return false)
+                    continue;
                 }
                 default:
                 {
@@ -517,7 +1025,8 @@ bool OnnxGraphBuilder ::_readTensorShape(TensorInfos *t, BlueSteelLadyBug ::PBRe
                     break;
                 }
                 }
-            } while (reader->getPosition() < end);
+            }
+            count++;
             continue;
         }
         default:
@@ -534,12 +1043,116 @@ bool OnnxGraphBuilder ::_readTensorShape(TensorInfos *t, BlueSteelLadyBug ::PBRe
 
 Operator *OnnxGraphBuilder ::_createNode(const char *typeName)
 {
-    return NodeRegistry ::ForName(typeName);
+    size_t size = NodeRegistry ::SizeOf(typeName);
+    return NodeRegistry ::ForName(typeName, size ? this->_fromArena(size) : nullptr);
 }
 
 Link *OnnxGraphBuilder ::_createLink()
 {
-    return new Link();
+    void *p = this->_fromArena(sizeof(Link));
+    return p ? new (p) Link() : new Link();
+}
+
+int OnnxGraphBuilder ::_readersOf(Link *l, Operator **readers, int capacity)
+{
+    // a link only keeps its last reader, the others are found by their inputs.
+    int count = 0;
+    for (int i = 0; i != this->_nodes.Count(); i++)
+    {
+        for (int j = 0; j != this->_nodes[i]->Opsc.Count(); j++)
+        {
+            if (this->_nodes[i]->Opsc[j] == l)
+            {
+                if (count < capacity)
+                {
+                    readers[count] = this->_nodes[i];
+                }
+                count++;
+                break;
+            }
+        }
+    }
+    return count;
+}
+
+int OnnxGraphBuilder ::_destroyNode(Operator *op)
+{
+    int index = -1;
+    for (int i = 0; i != this->_nodes.Count(); i++)
+    {
+        if (this->_nodes[i] == op)
+        {
+            this->_nodes.RemoveAt(i);
+            index = i;
+            break;
+        }
+    }
+    if (this->_inArena(op))
+    {
+        op->~Operator();
+    }
+    else
+    {
+        delete op;
+    }
+    return index;
+}
+
+void OnnxGraphBuilder ::_destroyLink(Link *l)
+{
+    for (int k = 0; k != this->_links.Count(); k++)
+    {
+        if (this->_links[k].Value == l)
+        {
+            // the name is kept without link, as the names declared by the first pass.
+            this->_links[k].Value = nullptr;
+            break;
+        }
+    }
+    // the data of an initializer is allocated when the arena is full.
+    void *data = l->GetPayloadInfos()->Data;
+    if (data && !this->_inArena(data))
+    {
+        this->_free(data);
+    }
+    if (this->_inArena(l))
+    {
+        l->~Link();
+    }
+    else
+    {
+        delete l;
+    }
+}
+
+void OnnxGraphBuilder ::_fuseNodes()
+{
+    for (int i = 0; i < this->_nodes.Count(); i++)
+    {
+        Operator *op = this->_nodes[i];
+        // an operator may fold a chain of operators, one after the other.
+        while (op->Onsc.Count() == 1)
+        {
+            Link *l = op->Onsc[0];
+            Operator *next = l->Ofin;
+            if (!next || next->Opsc.Count() != 1 || next->Onsc.Count() != 1 || this->_readersOf(l) != 1 || !op->Fuse(next))
+            {
+                break;
+            }
+            // op produces the output of next, which is released with the link between them.
+            Link *out = next->Onsc[0];
+            out->Oini = op;
+            op->Onsc[0] = out;
+            int j = this->_destroyNode(next);
+            i -= j < i;
+            this->_destroyLink(l);
+        }
+    }
+    // the nodes are numbered by their position.
+    for (int i = 0; i != this->_nodes.Count(); i++)
+    {
+        this->_nodes[i]->Id = i;
+    }
 }
 
 Link *OnnxGraphBuilder ::_getOrCreateLink(const char *name)
@@ -548,7 +1161,6 @@ Link *OnnxGraphBuilder ::_getOrCreateLink(const char *name)
     if (!l)
     {
         l = this->_createLink();
-        l->Id = this->_links.Count();
         this->_links.Set(name, l);
     }
     return l;
@@ -0,0 +1,411 @@
+#include "onnx/cm_onnx_graph_builder.hpp"
+#include "nodes/cm_nodes_registry.hpp"
+#include "nodes/math/cm_reduce.hpp"
+#include "nodes/nn/cm_softmax.hpp"
+#include "nodes/nn/cm_layer_norm.hpp"
+
+using namespace CyanMycelium;
+
+// the largest number of operators replaced by a pattern.
+#define PATTERN_MAX_NODES 10
+
+static inline bool _is(Operator *op, const char *typeName)
+{
+    return op && op->TypeName && strcmp(op->TypeName, typeName) == 0;
+}
+
+/// @brief true if op is of the given type, with the given inputs and a single output.
+static bool _is(Operator *op, const char *typeName, Link *a, Link *b = nullptr)
+{
+    int count = b ? 2 : 1;
+    return _is(op, typeName) && op->Onsc.Count() == 1 && op->Opsc.Count() == count && op->Opsc[0] == a && (!b || op->Opsc[1] == b);
+}
+
+/// @brief the other input of a binary operator reading l, or null.
+static Link *_otherInput(Operator *op, Link *l)
+{
+    if (op->Opsc.Count() != 2 || op->Onsc.Count() != 1)
+    {
+        return nullptr;
+    }
+    return op->Opsc[0] == l ? op->Opsc[1] : op->Opsc[1] == l ? op->Opsc[0]
+                                                             : nullptr;
+}
+
+/// @brief the value of an initializer holding a single float.
+static bool _getScalar(Link *l, float *value)
+{
+    Tensor *t = l ? l->GetPayloadInfos() : nullptr;
+    if (!t || !t->Data || t->Count != 1 || t->Type != TDT_FLOAT)
+    {
+        return false;
+    }
+    *value = *(float *)t->Data;
+    return true;
+}
+
+/// @brief the sorted axes of a ReduceXXX operator keeping the dimensions, the non negative ones being counted from the end
+/// when the rank of x is known.
+/// @return the number of axes, or 0 if they cannot be known at load time.
+static int _getAxes(Operator *op, Link *x, int *axes)
+{
+    ReduceOperator *r = (ReduceOperator *)op;
+    if (!r->KeepDims || op->Onsc.Count() != 1)
+    {
+        return 0;
+    }
+    int count = r->AxesCount;
+    for (int i = 0; i != count; i++)
+    {
+        axes[i] = r->Axes[i];
+    }
+    if (op->Opsc.Count() > REDUCE_AXES_INDEX)
+    {
+        Tensor *t = op->Opsc[REDUCE_AXES_INDEX]->GetPayloadInfos();
+        if (!t->Data || t->Type != TDT_INT64)
+        {
+            return 0;
+        }
+        count = min((int)t->Count, TENSOR_MAX_DIMENSION);
+        for (int i = 0; i != count; i++)
+        {
+            axes[i] = (int)((cm_int64_t *)t->Data)[i];
+        }
+    }
+    Tensor *infos = x->GetPayloadInfos();
+    int rank = infos->Type != TDT_UNDEFINED ? infos->Dimension : 0;
+    for (int i = 0; i != count; i++)
+    {
+        axes[i] = axes[i] >= 0 && rank ? axes[i] - rank : axes[i];
+        for (int j = i; j > 0 && axes[j] < axes[j - 1]; j--)
+        {
+            int a = axes[j];
+            axes[j] = axes[j - 1];
+            axes[j - 1] = a;
+        }
+    }
+    return count;
+}
+
+/// @brief true if op computes d * d, as Mul(d, d) or Pow(d, 2).
+static bool _isSquare(Operator *op, Link *d)
+{
+    float exponent;
+    return _is(op, "Mul", d, d) || (_is(op, "Pow") && op->Opsc.Count() == 2 && op->Opsc[0] == d && _getScalar(op->Opsc[1], &exponent) && exponent == 2.0f);
+}
+
+static bool _sameAxes(const int *a, int aCount, const int *b, int bCount)
+{
+    if (aCount != bCount)
+    {
+        return false;
+    }
+    for (int i = 0; i != aCount; i++)
+    {
+        if (a[i] != b[i])
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+void OnnxGraphBuilder ::_rewritePatterns()
+{
+    for (int i = 0; i < this->_nodes.Count(); i++)
+    {
+        // the patterns start with their first reduction, the rewritten operator takes its place.
+        Operator *op = this->_nodes[i];
+        if (_is(op, "ReduceMax"))
+        {
+            this->_rewriteSoftmax(op);
+        }
+        else if (_is(op, "ReduceMean"))
+        {
+            this->_rewriteLayerNorm(op);
+        }
+    }
+}
+
+// Softmax:    m = ReduceMax(x), d = Sub(x, m), e = Exp(d), s = ReduceSum(e), y = Div(e, s)
+// LogSoftmax: m = ReduceMax(x), d = Sub(x, m), e = Exp(d), s = ReduceSum(e), y = Sub(d, Log(s))
+// the reductions keep the dimensions over the same single axis.
+bool OnnxGraphBuilder ::_rewriteSoftmax(Operator *reduceMax)
+{
+    Operator *nodes[PATTERN_MAX_NODES];
+    Operator *readers[2];
+    int axes[TENSOR_MAX_DIMENSION];
+    int sumAxes[TENSOR_MAX_DIMENSION];
+    if (reduceMax->Opsc.Count() == 0)
+    {
+        return false;
+    }
+    Link *x = reduceMax->Opsc[0];
+    if (_getAxes(reduceMax, x, axes) != 1 || this->_readersOf(reduceMax->Onsc[0], readers, 1) != 1)
+    {
+        return false;
+    }
+    Link *m = reduceMax->Onsc[0];
+    Operator *sub = readers[0];
+    if (!_is(sub, "Sub", x, m))
+    {
+        return false;
+    }
+    // d is also read by the last Sub of LogSoftmax.
+    Link *d = sub->Onsc[0];
+    int dReaders = this->_readersOf(d, readers, 2);
+    if (dReaders == 0 || dReaders > 2)
+    {
+        return false;
+    }
+    Operator *exp = _is(readers[0], "Exp", d) ? readers[0] : dReaders == 2 && _is(readers[1], "Exp", d) ? readers[1]
+                                                                                                        : nullptr;
+    Operator *logSub = dReaders == 2 ? readers[exp == readers[0]] : nullptr;
+    if (!exp)
+    {
+        return false;
+    }
+    Link *e = exp->Onsc[0];
+    int eReaders = this->_readersOf(e, readers, 2);
+    if (eReaders == 0 || eReaders > 2)
+    {
+        return false;
+    }
+    Operator *sum = _is(readers[0], "ReduceSum") ? readers[0] : eReaders == 2 && _is(readers[1], "ReduceSum") ? readers[1]
+                                                                                                             : nullptr;
+    if (!sum || sum->Opsc[0] != e || !_sameAxes(axes, 1, sumAxes, _getAxes(sum, x, sumAxes)))
+    {
+        return false;
+    }
+    Link *s = sum->Onsc[0];
+    int count = 0;
+    nodes[count++] = reduceMax;
+    nodes[count++] = sub;
+    nodes[count++] = exp;
+    nodes[count++] = sum;
+    if (!logSub)
+    {
+        Operator *div = eReaders == 2 ? readers[sum == readers[0]] : nullptr;
+        if (!_is(div, "Div", e, s) || this->_readersOf(s) != 1)
+        {
+            return false;
+        }
+        nodes[count++] = div;
+        Operator *softmax = this->_replaceNodes("Softmax", nodes, count, &x, 1, div->Onsc[0]);
+        if (softmax)
+        {
+            ((SoftmaxOperator *)softmax)->Axis = axes[0];
+        }
+        return softmax != nullptr;
+    }
+
+    if (eReaders != 1 || this->_readersOf(s, readers, 1) != 1 || !_is(readers[0], "Log", s))
+    {
+        return false;
+    }
+    Operator *log = readers[0];
+    Link *l = log->Onsc[0];
+    if (!_is(logSub, "Sub", d, l) || this->_readersOf(l) != 1)
+    {
+        return false;
+    }
+    nodes[count++] = log;
+    nodes[count++] = logSub;
+    Operator *logSoftmax = this->_replaceNodes("LogSoftmax", nodes, count, &x, 1, logSub->Onsc[0]);
+    if (logSoftmax)
+    {
+        ((SoftmaxOperator *)logSoftmax)->Axis = axes[0];
+    }
+    return logSoftmax != nullptr;
+}
+
+// mu = ReduceMean(x), d = Sub(x, mu), v = ReduceMean(Pow(d, 2) or Mul(d, d)), n = Div(d, Sqrt(Add(v, epsilon))),
+// then the optional y = Add(Mul(n, scale), b). The reductions keep the dimensions over the same trailing axes.
+bool OnnxGraphBuilder ::_rewriteLayerNorm(Operator *mean)
+{
+    Operator *nodes[PATTERN_MAX_NODES];
+    Operator *readers[2];
+    int axes[TENSOR_MAX_DIMENSION];
+    int varianceAxes[TENSOR_MAX_DIMENSION];
+    if (mean->Opsc.Count() == 0)
+    {
+        return false;
+    }
+    Link *x = mean->Opsc[0];
+    int axesCount = _getAxes(mean, x, axes);
+    // the normalized axes are the last ones, counted from the end.
+    if (!axesCount || axes[axesCount - 1] != -1 || axes[0] != -axesCount || this->_readersOf(mean->Onsc[0], readers, 1) != 1)
+    {
+        return false;
+    }
+    Link *mu = mean->Onsc[0];
+    Operator *sub = readers[0];
+    if (!_is(sub, "Sub", x, mu))
+    {
+        return false;
+    }
+    Link *d = sub->Onsc[0];
+    if (this->_readersOf(d, readers, 2) != 2)
+    {
+        return false;
+    }
+    Operator *square = _isSquare(readers[0], d) ? readers[0] : readers[1];
+    Operator *div = square == readers[0] ? readers[1] : readers[0];
+    if (!_isSquare(square, d))
+    {
+        return false;
+    }
+    if (this->_readersOf(square->Onsc[0], readers, 1) != 1 || !_is(readers[0], "ReduceMean", square->Onsc[0]) ||
+        !_sameAxes(axes, axesCount, varianceAxes, _getAxes(readers[0], x, varianceAxes)))
+    {
+        return false;
+    }
+    Operator *variance = readers[0];
+    float epsilon;
+    if (this->_readersOf(variance->Onsc[0], readers, 1) != 1 || !_is(readers[0], "Add") || !_getScalar(_otherInput(readers[0], variance->Onsc[0]), &epsilon))
+    {
+        return false;
+    }
+    Operator *add = readers[0];
+    if (this->_readersOf(add->Onsc[0], readers, 1) != 1 || !_is(readers[0], "Sqrt", add->Onsc[0]))
+    {
+        return false;
+    }
+    Operator *sqrt = readers[0];
+    if (this->_readersOf(sqrt->Onsc[0]) != 1 || !_is(div, "Div", d, sqrt->Onsc[0]))
+    {
+        return false;
+    }
+    int count = 0;
+    nodes[count++] = mean;
+    nodes[count++] = sub;
+    nodes[count++] = square;
+    nodes[count++] = variance;
+    nodes[count++] = add;
+    nodes[count++] = sqrt;
+    nodes[count++] = div;
+
+    // the affine transform is folded when its parameters are initializers matching the normalized axes.
+    Link *inputs[3] = {x, nullptr, nullptr};
+    int inputCount = 1;
+    Link *y = div->Onsc[0];
+    Tensor *infos = x->GetPayloadInfos();
+    for (int i = 0; i != 2; i++)
+    {
+        const char *typeName = i == 0 ? "Mul" : "Add";
+        if (this->_readersOf(y, readers, 1) != 1 || !_is(readers[0], typeName))
+        {
+            break;
+        }
+        Link *p = _otherInput(readers[0], y);
+        Tensor *t = p ? p->GetPayloadInfos() : nullptr;
+        bool fits = t && t->Data && t->Type == TDT_FLOAT && t->Dimension <= axesCount;
+        for (int k = 1; fits && infos->Type != TDT_UNDEFINED && !infos->IsDynamic() && k <= axesCount; k++)
+        {
+            uint64_t size = k <= t->Dimension ? t->Shape[t->Dimension - k] : 1;
+            fits = size == infos->Shape[infos->Dimension - k];
+        }
+        if (!fits)
+        {
+            break;
+        }
+        nodes[count++] = readers[0];
+        inputs[inputCount++] = p;
+        y = readers[0]->Onsc[0];
+    }
+
+    LayerNormalization *norm = (LayerNormalization *)this->_replaceNodes("LayerNormalization", nodes, count, inputs, inputCount, y);
+    if (norm)
+    {
+        norm->Axis = axes[0];
+        norm->Epsilon = epsilon;
+    }
+    return norm != nullptr;
+}
+
+Operator *OnnxGraphBuilder ::_replaceNodes(const char *typeName, Operator **nodes, int count, Link **inputs, int inputCount, Link *output)
+{
+    size_t size = NodeRegistry ::SizeOf(typeName);
+    if (!size)
+    {
+        return nullptr;
+    }
+    // the links read by the pattern which are not inputs of the new operator, the initializers like the axes or epsilon
+    // are only released when nobody else reads them.
+    Link *links[PATTERN_MAX_NODES * 2];
+    int linkCount = 0;
+    for (int i = 0; i != count; i++)
+    {
+        for (int j = 0; j != nodes[i]->Opsc.Count(); j++)
+        {
+            Link *l = nodes[i]->Opsc[j];
+            if (!l)
+            {
+                continue;
+            }
+            bool kept = false;
+            for (int k = 0; k != inputCount; k++)
+            {
+                kept |= inputs[k] == l;
+            }
+            for (int k = 0; k != linkCount; k++)
+            {
+                kept |= links[k] == l;
+            }
+            if (!kept && linkCount < PATTERN_MAX_NODES * 2)
+            {
+                links[linkCount++] = l;
+            }
+        }
+    }
+
+    // the first operator is replaced in the nodes, and its memory is reused when the arena holds it.
+    Operator *first = nodes[0];
+    int index = -1;
+    for (int i = 0; i != this->_nodes.Count(); i++)
+    {
+        if (this->_nodes[i] == first)
+        {
+            index = i;
+            break;
+        }
+    }
+    bool reuse = this->_inArena(first) && size <= NodeRegistry ::SizeOf(first->TypeName);
+    if (this->_inArena(first))
+    {
+        first->~Operator();
+    }
+    else
+    {
+        delete first;
+    }
+    Operator *op = NodeRegistry ::ForName(typeName, reuse ? (void *)first : nullptr);
+    this->_nodes[index] = op;
+    for (int i = 1; i != count; i++)
+    {
+        this->_destroyNode(nodes[i]);
+    }
+
+    for (int i = 0; i != inputCount; i++)
+    {
+        op->Opsc.Add(inputs[i]);
+        // a link only keeps its last reader.
+        for (int j = 0; j != count; j++)
+        {
+            if (inputs[i]->Ofin == nodes[j])
+            {
+                inputs[i]->Ofin = op;
+            }
+        }
+    }
+    op->Onsc.Add(output);
+    output->Oini = op;
+    for (int i = 0; i != linkCount; i++)
+    {
+        if (!this->_readersOf(links[i]))
+        {
+            this->_destroyLink(links[i]);
+        }
+    }
+    return op;
+}
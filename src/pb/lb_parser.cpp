@@ -3,7 +3,7 @@
 using namespace BlueSteelLadyBug;
 
 template <typename T>
-bool PBReader::_readPacked(T *v, WireType wt)
+bool PBReader::_readPacked(T *v, WireType wt, size_t max, size_t *count)
 {
     if (_status.wireType != PB_LEN)
     {
@@ -17,17 +17,23 @@ bool PBReader::_readPacked(T *v, WireType wt)
     _invalidateLengthReaded();
     size_t pos = getPosition();
     size_t end = pos + size;
+    size_t n = 0;
     if (pos < end)
     {
         do
         {
-            if (!_readValue(v, wt))
+            if (n == max || !_readValue(v, wt))
             {
                 return false;
             }
             v++;
+            n++;
         } while (getPosition() < end);
     }
+    if (count)
+    {
+        *count = n;
+    }
     return true;
 }
 
@@ -245,7 +251,9 @@ bool PBReader::_readValue(lb_int64_t *v, WireType wt)
     {
     case PB_VARINT:
     {
-        return _readSVarint(v);
+        // int64 fields are plain varints, negative values are encoded as 10 bytes two's complement.
+        // Only sint64 fields use the zigzag encoding.
+        return _readVarint((lb_uint64_t *)v);
     }
     case PB_64BIT:
     {
@@ -491,6 +499,11 @@ bool PBReader::readPacked(lb_uint64_t *v, WireType wt)
     return _readPacked<lb_uint64_t>(v, wt);
 }
 
+bool PBReader::readPacked(lb_uint64_t *v, WireType wt, size_t max, size_t *count)
+{
+    return _readPacked<lb_uint64_t>(v, wt, max, count);
+}
+
 bool PBReader::readPacked(lb_float_t *v)
 {
     return _readPacked<lb_float_t>(v, PB_32BIT);